@@ -15,10 +15,22 @@
 #  - machine: Para manejar pines y PWM.
 #  - utime: Para manejar tiempos y retardos.
 #  - math: Utilizada para realizar cálculos matemáticos necesarios para generar las formas de onda.
+#  - rp2, uctypes, array: Canales de DMA que copian un periodo precalculado de ciclos de trabajo al
+#    registro de comparación del PWM, al ritmo del fin de ciclo (DREQ de wrap) del propio PWM.
+#  - siggen (opcional): Módulo nativo de micropython/siggen con el motor de síntesis del firmware en C.
+#    Si el firmware lo incluye y DAC_PIN_BASE no es None, las muestras las produce el DMA hacia el
+#    DAC de 8 bits en GP(DAC_PIN_BASE)..GP(DAC_PIN_BASE + 7) y este script solo atiende la interfaz.
+#    Los pines del DAC no deben coincidir con los del teclado ni con el botón.
+#
+#  - uasyncio: Tareas cooperativas para el teclado, la entrada de parámetros, la salida y el estado.
 #
 #  @section notes Notas
 #  - Este generador de señales implementa metodologías tanto de sondeo como de interrupción.
 #    El sondeo para el teclado y la interrupción para el botón.
+#  - El teclado, la entrada de parámetros, la salida y los mensajes de estado son tareas de uasyncio
+#    que nunca bloquean: la señal sigue saliendo con los valores anteriores mientras se teclean los
+#    nuevos, que se aplican juntos al confirmar la frecuencia. El mensaje de estado incluye la
+#    latencia del bucle de eventos (retraso de una tarea que duerme LATENCY_PERIOD_MS).
 #  - Los valores predeterminados pueden modificarse con fines de prueba.
 #
 #  @section todo Por hacer
@@ -30,9 +42,22 @@
 #  @section copyright Copyright
 #  - Copyright (C) Sin licencia.
 
-from machine import Pin, PWM
+from machine import Pin, PWM, mem32
+import machine
 import utime
 import math
+import array
+import uctypes
+import rp2
+import uasyncio as asyncio
+
+try:
+    import siggen
+except ImportError:
+    siggen = None
+
+## Primer GPIO del DAC de 8 bits para el módulo nativo siggen; None usa la salida PWM en Python
+DAC_PIN_BASE = None
 
 ## Configuración de pines para las columnas y las filas del teclado matricial
 cols_pins = [2, 3, 4, 5]
@@ -54,9 +79,41 @@ key_map = [
     ['*', '0', '#', 'D']
 ]
 
-## Configuración inicial para la señal PWM
-pwm = PWM(Pin(15))
-pwm.freq(10)  # Frecuencia de 10 Hz inicial
+## Pin de la señal PWM y registros de su slice (CSR, DIV, CTR, CC y TOP cada 4 bytes)
+PWM_PIN = 15
+PWM_SLICE = (PWM_PIN >> 1) & 7
+PWM_BASE = 0x40050000 + 0x14 * PWM_SLICE
+PWM_DIV = PWM_BASE + 0x04
+PWM_CC = PWM_BASE + 0x0C
+PWM_TOP = PWM_BASE + 0x10
+## DREQ del fin de ciclo del slice 0; los demás slices siguen en orden
+DREQ_PWM_WRAP0 = 24
+## Registros del DMA: bloque de 0x40 bytes por canal, alias de READ_ADDR que dispara el canal y aborto
+DMA_BASE = 0x50000000
+DMA_READ_ADDR_TRIG = 0x3C
+DMA_CHAN_ABORT = DMA_BASE + 0x444
+
+## Puntos por periodo: el máximo es el de la versión anterior (un punto por grado)
+MAX_POINTS = 360
+MIN_POINTS = 8
+## TOP mínimo buscado al elegir los puntos (resolución de 8 bits) y mínimo absoluto
+PWM_MIN_TOP = 255
+PWM_FLOOR_TOP = 15
+
+## Configuración inicial para la señal PWM; TOP y el divisor se reprograman en start_pwm_output()
+pwm = PWM(Pin(PWM_PIN))
+pwm.freq(100000)
+pwm.duty_u16(0)
+
+## Un periodo de ciclos de trabajo (16 bits, el DMA escribe ambas mitades de CC) y la dirección
+#  de inicio que el canal de control vuelve a cargar en el canal de datos al terminar cada periodo
+wave_buffer = array.array('H', [0] * MAX_POINTS)
+wave_restart = array.array('I', [uctypes.addressof(wave_buffer)])
+dma_data = rp2.DMA()
+dma_ctrl = rp2.DMA()
+## Puntos por periodo y frecuencia lograda de la configuración en curso
+pwm_points = 0
+achieved_frequency = 0
 
 ## Valores iniciales
 amplitude = 1000  # Amplitud inicial de 1000 mV
@@ -65,6 +122,21 @@ frequency = 10    # Frecuencia inicial de 10 Hz
 wave_forms = ['sine', 'triangle', 'sawtooth', 'square']
 current_waveform_index = 0  # Índice inicial para la forma de onda
 
+## Periodo de barrido del teclado (ms); una tecla se acepta cuando aparece en dos barridos seguidos
+KEYPAD_SCAN_MS = 20
+## Periodo de la tarea que mide la latencia del bucle de eventos (ms)
+LATENCY_PERIOD_MS = 10
+## Periodo de los mensajes de estado (ms)
+STATUS_PERIOD_MS = 5000
+
+## Aviso a la tarea de salida: cambió la forma de onda (desde la interrupción) o los parámetros
+output_flag = asyncio.ThreadSafeFlag()
+## Teclas aceptadas por el barrido, pendientes de consumir por la entrada de parámetros
+pressed_keys = []
+key_event = asyncio.Event()
+## Latencia del bucle de eventos desde el último mensaje de estado (µs)
+loop_latency = {'count': 0, 'total': 0, 'max': 0}
+
 ## Botón para cambiar la forma de onda
 button = Pin(16, Pin.IN, Pin.PULL_DOWN)
 
@@ -74,32 +146,53 @@ def button_press_handler(pin):
     global current_waveform_index, wave_forms
     current_waveform_index = (current_waveform_index + 1) % len(wave_forms)
     print("Cambio de forma de onda a:", wave_forms[current_waveform_index])
+    output_flag.set()
 
 button.irq(trigger=Pin.IRQ_RISING, handler=button_press_handler)
 
-## Lee el teclado matricial y devuelve la tecla presionada
+## Barre una vez el teclado matricial sin esperas y devuelve la tecla presionada, o None
 def read_keypad():
     for col_num, col in enumerate(cols):
         col.value(0)
         for row_num, row in enumerate(rows):
             if not row.value():
-                utime.sleep_ms(20)
-                if not row.value():
-                    col.value(1)
-                    return key_map[row_num][col_num]
+                col.value(1)
+                return key_map[row_num][col_num]
         col.value(1)
     return None
 
+## Tarea que barre el teclado cada KEYPAD_SCAN_MS. El antirrebote compara dos barridos seguidos
+#  en lugar de esperar dentro del barrido, y cada pulsación se entrega una sola vez.
+async def keypad_task():
+    last = None
+    stable = None
+    while True:
+        key = read_keypad()
+        if key == last and key != stable:
+            stable = key
+            if key is not None:
+                pressed_keys.append(key)
+                key_event.set()
+        last = key
+        await asyncio.sleep_ms(KEYPAD_SCAN_MS)
+
+## Espera la próxima tecla aceptada por keypad_task()
+async def next_key():
+    while not pressed_keys:
+        key_event.clear()
+        await key_event.wait()
+    return pressed_keys.pop(0)
+
 ## Solicita entrada numérica del usuario
 #  @param prompt Texto a mostrar al usuario.
 #  @param min_val Valor mínimo aceptable.
 #  @param max_val Valor máximo aceptable.
-def get_numeric_input(prompt, min_val, max_val):
+async def get_numeric_input(prompt, min_val, max_val):
     print(prompt)
     value = ''
     while True:
-        key = read_keypad()
-        if key and key.isdigit():
+        key = await next_key()
+        if key.isdigit():
             value += key
             print(value)  # Echo the digit
         elif key == 'D' and value:  # Complete on 'D' press
@@ -109,47 +202,148 @@ def get_numeric_input(prompt, min_val, max_val):
                 value = ''  # Reset value if out of range
             else:
                 return numeric_value
-        utime.sleep(0.1)
 
-## Configura los parámetros iniciales utilizando el teclado
-def setup_parameters():
+## Configura los parámetros utilizando el teclado. Los tres valores se aplican juntos al final,
+#  para que la salida nunca combine valores viejos y nuevos.
+async def setup_parameters():
     global amplitude, dc_offset, frequency
-    amplitude = get_numeric_input("Ingrese la amplitud (100-2500 mV): ", 100, 2500)
-    dc_offset = get_numeric_input("Ingrese el desplazamiento de CC (50-1250 mV): ", 50, 1250)
-    frequency = get_numeric_input("Ingrese la frecuencia (1-12000000 Hz): ", 1, 12000000)
-
-## Genera la forma de onda basada en los parámetros configurados
-def generate_wave():
-    global pwm, amplitude, dc_offset, frequency, current_waveform_index, wave_forms
-    safe_frequency = max(frequency, 1)
-    step = 0
-    while step < 360:
-        wave_form = wave_forms[current_waveform_index]
-        if wave_form == 'sine':
-            duty = amplitude * (math.sin(math.radians(step)) / 2 + 0.5) + dc_offset
-        elif wave_form == 'triangle':
-            duty = (2 * amplitude / math.pi) * math.asin(math.sin(math.radians(step))) + dc_offset
-        elif wave_form == 'sawtooth':
-            duty = ((-2 * amplitude / math.pi) * math.atan(1/math.tan(math.radians(step / 2)))) + dc_offset
-        elif wave_form == 'square':
-            duty = amplitude if step < 180 else 0
-            duty += dc_offset
-        pwm.duty_u16(int((duty / 3300) * 65535))
-        step += 360 / safe_frequency
-        utime.sleep_us(int(1000000 / safe_frequency / 360))
-
-## Función principal que configura los parámetros y ejecuta el bucle de generación de señales
-def main():
-    setup_parameters()
-    last_time_printed = utime.time()
+    new_amplitude = await get_numeric_input("Ingrese la amplitud (100-2500 mV): ", 100, 2500)
+    new_offset = await get_numeric_input("Ingrese el desplazamiento de CC (50-1250 mV): ", 50, 1250)
+    new_frequency = await get_numeric_input("Ingrese la frecuencia (1-12000000 Hz): ", 1, 12000000)
+    amplitude, dc_offset, frequency = new_amplitude, new_offset, new_frequency
+    output_flag.set()
+
+## Tarea de entrada de parámetros: vuelve a pedir los valores cada vez que se confirman
+async def entry_task():
     while True:
-        generate_wave()
-        current_time = utime.time()
-        if current_time - last_time_printed >= 1:
-            print("Amplitud: {} mV, Desplazamiento DC: {} mV, Frecuencia: {} Hz, Forma de onda: {}".format(
-                amplitude, dc_offset, frequency, wave_forms[current_waveform_index]))
-            last_time_printed = current_time
-        utime.sleep(0.1)
+        await setup_parameters()
+
+## Calcula el nivel de la forma de onda en mV para un ángulo, con las mismas fórmulas que el
+#  bucle original. El diente de sierra usa la forma cerrada de atan(1/tan(x/2)), que vale
+#  pi/2 - x/2, para no dividir por cero en 0°.
+#  @param wave_form Nombre de la forma de onda.
+#  @param step Ángulo en grados, de 0 a 360.
+def wave_level(wave_form, step):
+    if wave_form == 'sine':
+        return amplitude * (math.sin(math.radians(step)) / 2 + 0.5) + dc_offset
+    elif wave_form == 'triangle':
+        return (2 * amplitude / math.pi) * math.asin(math.sin(math.radians(step))) + dc_offset
+    elif wave_form == 'sawtooth':
+        return amplitude * (step / 180 - 1) + dc_offset
+    return (amplitude if step < 180 else 0) + dc_offset
+
+## Elige los puntos por periodo, TOP y el divisor del PWM para una frecuencia. Se usan tantos
+#  puntos como permita una resolución de PWM_MIN_TOP + 1 niveles; el divisor es fraccional en
+#  dieciseisavos, igual que el registro DIV.
+#  @param freq Frecuencia pedida en Hz.
+#  @return (puntos, top, divisor en 1/16, frecuencia lograda en Hz).
+def plan_pwm(freq):
+    sys_clk = machine.freq()
+    points = sys_clk // ((PWM_MIN_TOP + 1) * freq)
+    points = max(MIN_POINTS, min(MAX_POINTS, points))
+    cycles16 = sys_clk * 16 // (freq * points)
+    div16 = max(16, (cycles16 + 65535) // 65536)
+    top = max(PWM_FLOOR_TOP, cycles16 // div16 - 1)
+    return points, top, div16, sys_clk * 16 / (div16 * (top + 1) * points)
+
+## Rellena el búfer con un periodo de la forma de onda actual, escalado al TOP del PWM
+#  @param points Puntos por periodo.
+#  @param top Valor de TOP del PWM.
+def fill_wave_buffer(points, top):
+    wave_form = wave_forms[current_waveform_index]
+    for i in range(points):
+        level = int(wave_level(wave_form, i * 360 / points) / 3300 * (top + 1))
+        wave_buffer[i] = max(0, min(top + 1, level))
+
+## Detiene los dos canales de DMA
+def stop_pwm_output():
+    dma_ctrl.active(0)
+    dma_data.active(0)
+    mem32[DMA_CHAN_ABORT] = (1 << dma_data.channel) | (1 << dma_ctrl.channel)
+    while mem32[DMA_CHAN_ABORT]:
+        pass
+
+## Programa el PWM y los canales de DMA para la frecuencia y la forma de onda actuales. El canal
+#  de datos copia un punto por ciclo de PWM al registro CC y al terminar el periodo encadena al
+#  canal de control, que reescribe su dirección de lectura y lo vuelve a disparar.
+#  @return Frecuencia lograda en Hz.
+def start_pwm_output():
+    global pwm_points, achieved_frequency
+    points, top, div16, achieved = plan_pwm(max(frequency, 1))
+    stop_pwm_output()
+    fill_wave_buffer(points, top)
+    mem32[PWM_TOP] = top
+    mem32[PWM_DIV] = div16
+    dma_data.config(read=wave_buffer, write=PWM_CC, count=points,
+                    ctrl=dma_data.pack_ctrl(size=1, inc_read=True, inc_write=False,
+                                            treq_sel=DREQ_PWM_WRAP0 + PWM_SLICE,
+                                            chain_to=dma_ctrl.channel))
+    dma_ctrl.config(read=wave_restart, write=DMA_BASE + 0x40 * dma_data.channel + DMA_READ_ADDR_TRIG,
+                    count=1, ctrl=dma_ctrl.pack_ctrl(size=2, inc_read=False, inc_write=False),
+                    trigger=True)
+    pwm_points = points
+    achieved_frequency = achieved
+    return achieved
+
+## Aplica los parámetros actuales a la salida. Con el módulo nativo se pasan todos a siggen.set();
+#  con el PWM solo se reprograma el DMA si cambió la frecuencia, y si no basta con reescribir el
+#  búfer que el DMA está recorriendo.
+#  @param full Reprogramar la salida completa.
+def apply_output(full):
+    if siggen is not None and DAC_PIN_BASE is not None:
+        siggen.set(waveform=wave_forms[current_waveform_index], amplitude=amplitude,
+                   offset=dc_offset, frequency=frequency)
+        if full:
+            siggen.start(DAC_PIN_BASE)
+    elif full:
+        start_pwm_output()
+    else:
+        fill_wave_buffer(pwm_points, mem32[PWM_TOP])
+
+## Tarea de salida: arranca con los valores iniciales y aplica cada cambio avisado por output_flag
+async def output_task():
+    apply_output(True)
+    applied_frequency = frequency
+    while True:
+        await output_flag.wait()
+        apply_output(frequency != applied_frequency)
+        applied_frequency = frequency
+
+## Tarea que mide cuánto se retrasa el bucle de eventos en despertar una tarea dormida
+async def latency_task():
+    while True:
+        start = utime.ticks_us()
+        await asyncio.sleep_ms(LATENCY_PERIOD_MS)
+        lag = max(0, utime.ticks_diff(utime.ticks_us(), start) - LATENCY_PERIOD_MS * 1000)
+        loop_latency['count'] += 1
+        loop_latency['total'] += lag
+        loop_latency['max'] = max(loop_latency['max'], lag)
+
+## Tarea que imprime el estado y la latencia del bucle, y reinicia las estadísticas
+async def status_task():
+    while True:
+        await asyncio.sleep_ms(STATUS_PERIOD_MS)
+        if siggen is not None and DAC_PIN_BASE is not None:
+            achieved = "{} Hz".format(frequency)
+        else:
+            achieved = "{:.3f} Hz, {} puntos".format(achieved_frequency, pwm_points)
+        count = loop_latency['count']
+        print("Amplitud: {} mV, Desplazamiento DC: {} mV, Frecuencia: {} Hz (lograda {}), Forma de onda: {}".format(
+            amplitude, dc_offset, frequency, achieved, wave_forms[current_waveform_index]))
+        print("Latencia del bucle: prom {} us, max {} us ({} muestras)".format(
+            loop_latency['total'] // count if count else 0, loop_latency['max'], count))
+        loop_latency['count'] = loop_latency['total'] = loop_latency['max'] = 0
+
+## Función principal que lanza las tareas; la salida empieza con los valores iniciales
+async def run():
+    asyncio.create_task(output_task())
+    asyncio.create_task(keypad_task())
+    asyncio.create_task(latency_task())
+    asyncio.create_task(status_task())
+    await entry_task()
+
+def main():
+    asyncio.run(run())
 
 if __name__ == '__main__':
     main()
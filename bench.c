@@ -0,0 +1,395 @@
+/**
+ * @file bench.c
+ *
+ * @brief Firmware de medición: ejecuta cada núcleo de síntesis, salida, intérprete y formateador
+ * en condiciones controladas e imprime un reporte legible por máquina por la consola USB.
+ *
+ * Todo corre en el núcleo 0 con el núcleo 1 detenido. Las pruebas de cálculo se ejecutan con las
+ * interrupciones deshabilitadas, BENCH_RUNS veces cada una, y se reporta la más rápida, que es la
+ * menos afectada por la caché XIP. La salida por PIO se mide en uso real (interrupciones activas)
+ * durante BENCH_PIO_MS, rellenando los bloques desde la interrupción del DMA.
+ *
+ * Cada resultado es una línea `@BENCH,<prueba>,<métrica>,<valor>` con el valor en decimal con
+ * tres decimales; el resto de la salida es texto libre. Las métricas son:
+ *  - cycles_per_sample, cycles_per_call, cycles_per_byte: ciclos del reloj del sistema.
+ *  - blocks_per_s: bloques de DAC_BLOCK_SAMPLES por segundo.
+ *  - max_sample_rate: muestras por segundo si el núcleo no hiciera otra cosa.
+ *  - load_pct: porcentaje del núcleo usado a la frecuencia de muestreo nominal.
+ *  - underruns: bloques repetidos por no rellenarse a tiempo.
+ *  - rejection_db: cuánto más abajo que la fundamental quedan las imágenes de una tabla remuestreada.
+ *  - max_input_rate: muestras de entrada por segundo que la cadena de interpolación podría subir.
+ *
+ * Las pruebas corren una vez, al conectarse la consola USB; para repetirlas se reinicia la placa.
+ * tools/bench_diff.py compara los reportes de dos compilaciones.
+ */
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include <math.h>
+#include <stdio.h>
+#include "siggen/arena.h"
+#include "siggen/crc32.h"
+#include "siggen/fixdec.h"
+#include "siggen/input_log.h"
+#include "siggen/interp_chain.h"
+#include "siggen/platform.h"
+#include "siggen/polyphase.h"
+#include "siggen/synth.h"
+#include "siggen/wavepack.h"
+#include "dac_out.h"
+#include "dac_sio.h"
+#include "stackmon.h"
+
+#define BENCH_PREFIX "@BENCH," ///< Prefijo de las líneas del reporte
+#define BENCH_RUNS 5 ///< Repeticiones de cada prueba de cálculo; se reporta la más rápida
+#define BENCH_BLOCKS 16 ///< Bloques de DAC_BLOCK_SAMPLES por repetición en las pruebas de síntesis y salida
+#define BENCH_CALLS 2000 ///< Llamadas por repetición en las pruebas de intérpretes y formateadores
+#define BENCH_CRC_BYTES 4096 ///< Bytes por repetición en la prueba de CRC-32
+#define BENCH_PIO_MS 1000 ///< Duración de la prueba de la salida por PIO
+#define BENCH_RESAMPLE_LEN 64 ///< Muestras de la tabla de la prueba del remuestreo
+#define BENCH_RESAMPLE_CYCLES 5 ///< Periodos de la tabla de la prueba del remuestreo
+#define BENCH_RESAMPLE_INC 19661 ///< Paso de la prueba del remuestreo en Q16.16 (0,3)
+#define BENCH_RESAMPLE_OUT 4096 ///< Muestras analizadas para medir las imágenes
+#define BENCH_CHAIN_IN (DAC_BLOCK_SAMPLES / 4) ///< Muestras de entrada de la prueba de la cadena de interpolación
+
+/**
+ * Función medida. Ejecuta la operación iterations veces.
+ */
+typedef void (*bench_fn)(void *ctx, uint32_t iterations);
+
+static uint32_t clk_hz; ///< Frecuencia del reloj del sistema
+static uint8_t bench_block[DAC_BLOCK_SAMPLES]; ///< Destino de la síntesis en las pruebas de cálculo
+static synth_t pio_synth; ///< Oscilador que rellena los bloques en la prueba de la salida por PIO
+static volatile uint32_t sink; ///< Evita que el compilador descarte resultados
+static unsigned results; ///< Líneas de resultado impresas
+static uint8_t resample_table[BENCH_RESAMPLE_LEN]; ///< Tabla de la prueba del remuestreo
+static uint8_t resample_out[BENCH_RESAMPLE_OUT]; ///< Salida analizada de la prueba del remuestreo
+static int16_t chain_in[BENCH_CHAIN_IN]; ///< Entrada de la prueba de la cadena de interpolación
+static int16_t chain_out[DAC_BLOCK_SAMPLES]; ///< Salida de la prueba de la cadena de interpolación
+
+static void report(const char *test, const char *metric, uint64_t milli) {
+    char value[FIXDEC_MAX_LEN];
+
+    fixdec_format(value, sizeof(value), (int64_t)milli, 3);
+    printf(BENCH_PREFIX "%s,%s,%s\n", test, metric, value);
+    results++;
+}
+
+/**
+ * Ciclos de la repetición más rápida de fn, con las interrupciones deshabilitadas.
+ */
+static uint64_t bench_cycles(bench_fn fn, void *ctx, uint32_t iterations) {
+    uint64_t best = UINT64_MAX;
+
+    fn(ctx, 1); // Calienta la caché XIP
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        uint32_t irq = save_and_disable_interrupts();
+        uint64_t t0 = time_us_64();
+        fn(ctx, iterations);
+        uint64_t elapsed = time_us_64() - t0;
+        restore_interrupts(irq);
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best * clk_hz / 1000000;
+}
+
+/**
+ * Reporta una prueba que produce muestras: ciclos por muestra, bloques por segundo y frecuencia
+ * de muestreo máxima.
+ */
+static void report_samples(const char *test, uint64_t cycles, uint32_t blocks) {
+    uint64_t samples = (uint64_t)blocks * DAC_BLOCK_SAMPLES;
+
+    if (!cycles) {
+        cycles = 1;
+    }
+    report(test, "cycles_per_sample", cycles * 1000 / samples);
+    report(test, "blocks_per_s", (uint64_t)clk_hz * blocks * 1000 / cycles);
+    report(test, "max_sample_rate", (uint64_t)clk_hz * samples / cycles * 1000);
+}
+
+static void run_synth(void *ctx, uint32_t iterations) {
+    synth_t *s = (synth_t *)ctx;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        synth_render(s, bench_block, DAC_BLOCK_SAMPLES);
+    }
+}
+
+static void bench_synth(void) {
+    static const struct {
+        Waveform waveform;
+        const char *test;
+    } waves[] = {
+        {SINE, "synth.sine"},
+        {SQUARE, "synth.square"},
+        {SAWTOOTH, "synth.sawtooth"},
+        {TRIANGULAR, "synth.triangular"},
+    };
+    synth_t s;
+
+    for (size_t i = 0; i < sizeof(waves) / sizeof(waves[0]); ++i) {
+        synth_init(&s, DAC_SAMPLE_RATE);
+        synth_set(&s, waves[i].waveform, 2000000, 1650000, 1000000);
+        report_samples(waves[i].test, bench_cycles(run_synth, &s, BENCH_BLOCKS), BENCH_BLOCKS);
+    }
+}
+
+static void run_sio(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        dac_backend_sio.acquire();
+        dac_backend_sio.commit();
+    }
+}
+
+/**
+ * Salida por CPU sin ritmo de muestreo (frecuencia 0): mide lo que cuesta escribir cada muestra
+ * en los pines a través de la interfaz de salida.
+ */
+static void bench_sio(void) {
+    dac_backend_sio.init(DAC_PIN, 0);
+    report_samples("backend.sio", bench_cycles(run_sio, NULL, BENCH_BLOCKS), BENCH_BLOCKS);
+    arena_reset(&arena_dac);
+}
+
+static void SIGGEN_HOT(pio_refill)(uint8_t *block) {
+    synth_render(&pio_synth, block, DAC_BLOCK_SAMPLES);
+}
+
+/**
+ * Salida por PIO y DMA a la frecuencia nominal, con la síntesis en la interrupción de fin de
+ * bloque. La frecuencia máxima es aquella a la que la interrupción ocuparía todo el núcleo.
+ */
+static void bench_pio(void) {
+    synth_init(&pio_synth, DAC_SAMPLE_RATE);
+    synth_set(&pio_synth, SINE, 2000000, 1650000, 1000000);
+    dac_out_init(DAC_PIN, DAC_SAMPLE_RATE);
+    dac_out_set_refill(pio_refill);
+
+    uint32_t blocks = dac_out_stats.blocks, underruns = dac_out_stats.underruns;
+    dac_out_isr_stats.count = 0;
+    dac_out_isr_stats.total_cycles = 0;
+    dac_out_isr_stats.max_cycles = 0;
+
+    dac_out_start();
+    sleep_ms(BENCH_PIO_MS);
+    dac_out_stop();
+
+    blocks = dac_out_stats.blocks - blocks;
+    underruns = dac_out_stats.underruns - underruns;
+    uint64_t isr_cycles = dac_out_isr_stats.total_cycles;
+    uint32_t isr_count = dac_out_isr_stats.count ? dac_out_isr_stats.count : 1;
+
+    report("backend.pio", "blocks_per_s", (uint64_t)blocks * 1000 * 1000 / BENCH_PIO_MS);
+    report("backend.pio", "underruns", (uint64_t)underruns * 1000);
+    report("backend.pio", "cycles_per_sample", isr_cycles * 1000 / ((uint64_t)isr_count * DAC_BLOCK_SAMPLES));
+    report("backend.pio", "load_pct", isr_cycles * 100 * 1000 / ((uint64_t)clk_hz * BENCH_PIO_MS / 1000));
+    report("backend.pio", "max_sample_rate",
+           isr_cycles ? (uint64_t)clk_hz * isr_count * DAC_BLOCK_SAMPLES / isr_cycles * 1000 : 0);
+}
+
+static void run_resample(void *ctx, uint32_t iterations) {
+    wavepack_player_t *p = (wavepack_player_t *)ctx;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        wavepack_player_render(p, bench_block, DAC_BLOCK_SAMPLES);
+    }
+}
+
+/**
+ * Amplitud de la componente de frecuencia f (ciclos por muestra) de la salida analizada, con
+ * ventana de Hann para que la fundamental no se derrame sobre las imágenes. Usa punto flotante:
+ * no forma parte de lo que se mide.
+ */
+static float tone_level(float f) {
+    const float two_pi = 6.2831853f;
+    float coef = 2.0f * cosf(two_pi * f), s1 = 0.0f, s2 = 0.0f;
+
+    for (int i = 0; i < BENCH_RESAMPLE_OUT; ++i) {
+        float w = 0.5f - 0.5f * cosf(two_pi * i / BENCH_RESAMPLE_OUT);
+        float s0 = w * ((float)resample_out[i] - 128.0f) + coef * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return sqrtf(s1 * s1 + s2 * s2 - coef * s1 * s2);
+}
+
+/**
+ * Reproducción de una tabla a paso fraccionario con cada nivel de calidad de polyphase.h: ciclos
+ * por muestra del reproductor y rechazo de las dos primeras imágenes de la tabla, a 1 - f y 1 + f
+ * de su frecuencia de muestreo, escaladas por el paso.
+ */
+static void bench_resample(void) {
+    static const char *const tests[POLYPHASE_QUALITIES] = {
+        "resample.off", "resample.low", "resample.mid", "resample.high",
+    };
+    const float two_pi = 6.2831853f;
+    float step = BENCH_RESAMPLE_INC / 65536.0f, f = (float)BENCH_RESAMPLE_CYCLES / BENCH_RESAMPLE_LEN;
+    wavepack_player_t p = {
+        .table = resample_table,
+        .table_len = BENCH_RESAMPLE_LEN,
+        .inc_int = BENCH_RESAMPLE_INC >> 16,
+        .inc_frac = BENCH_RESAMPLE_INC & 0xFFFF,
+    };
+
+    for (int i = 0; i < BENCH_RESAMPLE_LEN; ++i) {
+        resample_table[i] = (uint8_t)lroundf(128.0f + 100.0f * sinf(two_pi * f * i));
+    }
+    for (int q = 0; q < POLYPHASE_QUALITIES; ++q) {
+        wavepack_player_set_quality(&p, (polyphase_quality_t)q);
+        report_samples(tests[q], bench_cycles(run_resample, &p, BENCH_BLOCKS), BENCH_BLOCKS);
+
+        p.pos = 0;
+        p.frac = 0;
+        wavepack_player_render(&p, resample_out, BENCH_RESAMPLE_OUT);
+        float signal = tone_level(f * step);
+        float image = fmaxf(tone_level((1.0f - f) * step), tone_level((1.0f + f) * step));
+        float db = 20.0f * log10f(signal / fmaxf(image, 1e-3f));
+        report(tests[q], "rejection_db", (uint64_t)(db > 0.0f ? db * 1000.0f : 0.0f));
+    }
+}
+
+static void run_chain(void *ctx, uint32_t iterations) {
+    interp_chain_t *c = (interp_chain_t *)ctx;
+    uint32_t n = DAC_BLOCK_SAMPLES / c->factor;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        interp_chain_process(c, chain_in, n, chain_out);
+    }
+}
+
+/**
+ * Cadena de interpolación del audio USB con factores 4, 16 y 64: ciclos por muestra de salida y
+ * la frecuencia de entrada máxima que podría subir el núcleo, con bloques de DAC_BLOCK_SAMPLES
+ * muestras de salida.
+ */
+static void bench_chain(void) {
+    static const struct {
+        uint32_t factor;
+        const char *test;
+    } tests[] = {
+        {4, "chain.x4"},
+        {16, "chain.x16"},
+        {64, "chain.x64"},
+    };
+    const float two_pi = 6.2831853f;
+    interp_chain_t c;
+
+    for (int i = 0; i < BENCH_CHAIN_IN; ++i) {
+        chain_in[i] = (int16_t)lroundf(26000.0f * sinf(two_pi * 0.3125f * i));
+    }
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        interp_chain_init(&c, tests[i].factor);
+        uint64_t cycles = bench_cycles(run_chain, &c, BENCH_BLOCKS);
+        report_samples(tests[i].test, cycles, BENCH_BLOCKS);
+        report(tests[i].test, "max_input_rate",
+               (uint64_t)clk_hz * BENCH_BLOCKS * DAC_BLOCK_SAMPLES / tests[i].factor / (cycles ? cycles : 1) * 1000);
+        sink += (uint16_t)chain_out[DAC_BLOCK_SAMPLES - 1];
+    }
+}
+
+static const char *const fixdec_texts[] = {"1000", "-12.5", "0.001", "2500", "12000000", "1.234", "-0.5", "999.999"};
+#define FIXDEC_TEXTS (sizeof(fixdec_texts) / sizeof(fixdec_texts[0]))
+
+static void run_fixdec_parse(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    int64_t milli;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        fixdec_parse(fixdec_texts[i % FIXDEC_TEXTS], NULL, &milli);
+        sink += (uint32_t)milli;
+    }
+}
+
+static void run_fixdec_format(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    char buf[FIXDEC_MAX_LEN];
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        sink += fixdec_format(buf, sizeof(buf), (int64_t)i * 7919 - 5000000, 3);
+    }
+}
+
+static void run_input_log_parse(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    input_event_t ev;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        sink += input_log_parse("@EV,123456,22,1A\r\n", &ev);
+    }
+}
+
+static void run_input_log_format(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    input_event_t ev = { 123456, 22, 2, {'1', 'A'} };
+    char line[INPUT_LOG_LINE_MAX];
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        ev.t_ms = i;
+        sink += input_log_format(line, sizeof(line), &ev);
+    }
+}
+
+static void run_crc32(void *ctx, uint32_t iterations) {
+    (void)ctx;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        sink += crc32_compute(bench_block, sizeof(bench_block));
+    }
+}
+
+static void bench_text(void) {
+    static const struct {
+        const char *test;
+        bench_fn fn;
+    } tests[] = {
+        {"parse.fixdec", run_fixdec_parse},
+        {"format.fixdec", run_fixdec_format},
+        {"parse.input_log", run_input_log_parse},
+        {"format.input_log", run_input_log_format},
+    };
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        uint64_t cycles = bench_cycles(tests[i].fn, NULL, BENCH_CALLS);
+        report(tests[i].test, "cycles_per_call", cycles * 1000 / BENCH_CALLS);
+    }
+
+    uint64_t cycles = bench_cycles(run_crc32, NULL, BENCH_CRC_BYTES / sizeof(bench_block));
+    report("crc32", "cycles_per_byte", cycles * 1000 / BENCH_CRC_BYTES);
+}
+
+int main() {
+    stdio_init_all();
+    stackmon_init_core();
+    clk_hz = clock_get_hz(clk_sys);
+
+    while (!stdio_usb_connected()) {
+        sleep_ms(100);
+    }
+    sleep_ms(500);
+
+    printf("Mediciones del generador de señales.\n");
+    printf(BENCH_PREFIX "build,clk_sys_hz,%lu.000\n", (unsigned long)clk_hz);
+#ifdef SIGGEN_RAM_HOT_PATH
+    printf(BENCH_PREFIX "build,ram_hot_path,1.000\n");
+#else
+    printf(BENCH_PREFIX "build,ram_hot_path,0.000\n");
+#endif
+    bench_synth();
+    bench_sio();
+    bench_pio();
+    bench_resample();
+    bench_chain();
+    bench_text();
+    printf(BENCH_PREFIX "end,results,%u.000\n", results);
+    printf("Fin. Reinicie la placa para repetir.\n");
+
+    while (true) {
+        sleep_ms(1000);
+    }
+}
@@ -0,0 +1,362 @@
+/**
+ * @file console.c
+ *
+ * @brief Tarea que lee la consola USB sin bloquear e interpreta comandos.
+ */
+
+#include "console.h"
+#include "telemetry.h"
+#include "persist.h"
+#include "dac_out.h"
+#include "dac_sio.h"
+#include "stackmon.h"
+#include "irq_plan.h"
+#include "sync_start.h"
+#include "wave_store.h"
+#include "msc_disk.h"
+#include "usb_audio.h"
+#include "usb_bulk.h"
+#include "siggen/interp_chain.h"
+#include "siggen/trace.h"
+#include "hardware/clocks.h"
+#include "pico/stdlib.h"
+#include "pico/unique_id.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONSOLE_LINE_MAX 64 ///< Longitud máxima de una línea de comando
+
+static engine_t *console_engine; ///< Motor al que se entregan las teclas
+static sched_t *console_sched; ///< Planificador, para el reporte de tareas
+static task_t *console_self; ///< Tarea de la consola, para reprogramar el sondeo
+static char line[CONSOLE_LINE_MAX]; ///< Línea en construcción
+static int line_len; ///< Caracteres en line
+
+/**
+ * Entrada de la tabla de comandos.
+ */
+typedef struct {
+    const char *name; ///< Nombre del comando, sin el '!'
+    void (*fn)(const char *args); ///< Manejador; recibe el resto de la línea
+    const char *help; ///< Descripción de una línea
+} console_cmd_t;
+
+static void cmd_help(const char *args);
+
+static void print_text(void *ctx, const char *text) {
+    (void)ctx;
+    fputs(text, stdout);
+}
+
+static void cmd_stats(const char *args) {
+    sched_print_stats(console_sched, print_text, NULL);
+    if (strcmp(args, "keep") != 0) {
+        sched_reset_stats(console_sched);
+    }
+}
+
+static void cmd_status(const char *args) {
+    (void)args;
+    telemetry_print_status();
+}
+
+static void cmd_power(const char *args) {
+    (void)args;
+    telemetry_print_power();
+}
+
+static void cmd_mem(const char *args) {
+    (void)args;
+    telemetry_print_memory();
+}
+
+static void cmd_stack(const char *args) {
+    (void)args;
+    stackmon_print();
+}
+
+/**
+ * Sin argumentos imprime las prioridades y los histogramas de latencia y los reinicia.
+ * 'probe N' arranca la sonda con periodo de N uS y 'probe off' la detiene.
+ */
+static void cmd_irq(const char *args) {
+    if (strncmp(args, "probe", 5) == 0) {
+        const char *arg = args + 5;
+        while (*arg == ' ') {
+            ++arg;
+        }
+        if (strcmp(arg, "off") == 0) {
+            irq_probe_stop();
+        } else if (!irq_probe_start(*arg ? (uint32_t)strtoul(arg, NULL, 10) : 1000)) {
+            printf("No se pudo arrancar la sonda.\n");
+        }
+        return;
+    }
+    irq_plan_print();
+    printf("Variación máxima entre bloques: %lu us\n", (unsigned long)dac_out_stats.max_irq_jitter_us);
+    if (strcmp(args, "keep") != 0) {
+        irq_plan_reset_stats();
+        dac_out_reset_stats();
+    }
+}
+
+/**
+ * Sin argumentos detiene la traza, la vuelca y la vuelve a arrancar. 'on' y 'off' la arrancan o
+ * la detienen sin volcarla.
+ */
+static void cmd_trace(const char *args) {
+    if (strcmp(args, "on") == 0) {
+        trace_start();
+    } else if (strcmp(args, "off") == 0) {
+        trace_stop();
+    } else {
+        trace_stop();
+        trace_dump(clock_get_hz(clk_sys), print_text, NULL);
+        trace_start();
+    }
+}
+
+/**
+ * Identifica la placa para host/gds_ctl: "@ID,<número de serie de la flash>,<programa>".
+ */
+static void cmd_id(const char *args) {
+    char id[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+
+    (void)args;
+    pico_get_unique_board_id_string(id, sizeof(id));
+    printf("@ID,%s,%s\n", id, CONSOLE_PROGRAM_NAME);
+}
+
+/**
+ * Responde "@PONG,<args>". Como los comandos se ejecutan en orden, la respuesta marca que
+ * terminaron todos los anteriores; host/gds_ctl la usa para medir la latencia de cada uno.
+ */
+static void cmd_ping(const char *args) {
+    printf("@PONG,%s\n", args);
+}
+
+static void cmd_tel(const char *args) {
+    (void)args;
+    telemetry_print_record();
+}
+
+static void cmd_tele(const char *args) {
+    telemetry_set_enabled(strcmp(args, "0") != 0 && strcmp(args, "off") != 0);
+}
+
+static void cmd_arm(const char *args) {
+    (void)args;
+    sync_start_request();
+    printf("Armando: la salida arranca en el próximo flanco de subida de GP%u.\n", SYNC_TRIGGER_PIN);
+}
+
+static void cmd_fire(const char *args) {
+    (void)args;
+    sync_start_fire();
+}
+
+static void cmd_sync(const char *args) {
+    (void)args;
+    sync_start_print_record();
+}
+
+/**
+ * Sin argumentos informa la imagen de formas de onda de la flash; con un número reproduce esa
+ * secuencia, y con "off" vuelve a la síntesis.
+ */
+static void cmd_wave(const char *args) {
+    if (!args[0]) {
+        wave_store_print();
+    } else if (strcmp(args, "off") == 0) {
+        wave_store_select(-1);
+    } else if (!wave_store_select(atoi(args))) {
+        printf("No hay una secuencia %s en la imagen.\n", args);
+    }
+}
+
+/**
+ * Sin argumentos informa la última importación del disco USB; "codes" o "norm" eligen cómo se leen
+ * los valores de los CSV que se copien después.
+ */
+static void cmd_drive(const char *args) {
+    if (strcmp(args, "codes") == 0) {
+        msc_disk_set_codes(true);
+    } else if (strcmp(args, "norm") == 0) {
+        msc_disk_set_codes(false);
+    } else if (args[0]) {
+        printf("Uso: !drive [codes|norm]\n");
+        return;
+    }
+    msc_disk_print();
+}
+
+/**
+ * Estado del parlante USB: nivel de la cola, corrección de la deriva y costo del remuestreo, en
+ * una línea para leer y otra para programas (@AUDIO).
+ */
+static void cmd_audio(const char *args) {
+    (void)args;
+    usb_audio_print();
+    usb_audio_print_record();
+}
+
+/**
+ * Sin argumentos informa las tramas recibidas por la interfaz bulk y por la consola; con "cdc" la
+ * consola pasa a recibir tramas en binario (usb_bulk.h) después de responder "@BINARY".
+ */
+static void cmd_bulk(const char *args) {
+    if (strcmp(args, "cdc") == 0) {
+        printf("@BINARY\n");
+        usb_bulk_cdc_start();
+    } else if (args[0]) {
+        printf("Uso: !bulk [cdc]\n");
+    } else {
+        usb_bulk_print();
+    }
+}
+
+/**
+ * Filtro de los pasos fraccionarios de la imagen de formas de onda y del remuestreo del audio USB:
+ * "off" (la muestra más cercana en las tablas, interpolación lineal en el audio), "low", "mid" o
+ * "high". Sin argumentos informa el elegido.
+ */
+static void cmd_interp(const char *args) {
+    static polyphase_quality_t quality = POLYPHASE_NEAREST;
+
+    if (args[0] && !polyphase_quality_parse(args, &quality)) {
+        printf("Uso: !interp [off|low|mid|high]\n");
+        return;
+    }
+    wave_store_set_quality(quality);
+    usb_audio_set_quality(quality);
+
+    const polyphase_bank_t *bank = polyphase_bank(quality);
+    if (bank) {
+        printf("Remuestreo polifásico de calidad %s: %u coeficientes por fase%s, imágenes a -%u dB.\n",
+               polyphase_quality_name(quality), bank->taps, bank->lerp ? " con interpolación entre fases" : "",
+               bank->image_db);
+    } else {
+        printf("Remuestreo sin filtro: la muestra más cercana en las tablas, interpolación lineal en el audio.\n");
+    }
+}
+
+/**
+ * Factor de la cadena de interpolación que sube el audio USB antes del remuestreo: potencia de 2
+ * entre 1 (sin cadena) e INTERP_CHAIN_MAX_FACTOR. Sin argumentos informa el pedido y el efectivo,
+ * que se reduce si la frecuencia del flujo por el factor llega a la del DAC.
+ */
+static void cmd_chain(const char *args) {
+    static uint32_t factor = 1;
+
+    if (args[0]) {
+        char *end;
+        unsigned long value = strtoul(args, &end, 10);
+        if (*end || !usb_audio_set_chain((uint32_t)value)) {
+            printf("Uso: !chain [1|2|4|...|%d]\n", INTERP_CHAIN_MAX_FACTOR);
+            return;
+        }
+        factor = (uint32_t)value;
+    }
+    printf("Cadena de interpolación: x%lu pedido, x%lu en uso (se aplica en el próximo bloque de audio).\n",
+           (unsigned long)factor, (unsigned long)usb_audio_chain_factor());
+}
+
+static void cmd_save(const char *args) {
+    (void)args;
+    persist_save(console_engine);
+    printf("Parámetros guardados.\n");
+}
+
+/**
+ * Mide las formas de escribir una muestra por CPU. Con la salida por SIO (DAC_BACKEND=sio) se
+ * niega: las escrituras llegarían a los pines y corromperían la señal.
+ */
+static void cmd_dacbench(const char *args) {
+    (void)args;
+    if (!dac_sio_bench(DAC_PIN)) {
+        printf("La salida por SIO está en uso: la medición escribiría sobre los pines del DAC.\n");
+    }
+}
+
+static const console_cmd_t commands[] = {
+    {"help", cmd_help, "Lista los comandos"},
+    {"stats", cmd_stats, "Tiempos de ejecución y latencias por tarea ('keep' no reinicia)"},
+    {"status", cmd_status, "Parámetros actuales"},
+    {"power", cmd_power, "Ciclo de trabajo y despertares por segundo de cada núcleo"},
+    {"mem", cmd_mem, "Uso y máximo de cada arena de memoria, pilas e interrupciones"},
+    {"stack", cmd_stack, "Nivel máximo de las pilas y peor tiempo de cada interrupción"},
+    {"irq", cmd_irq, "Prioridades y latencia de interrupciones ('keep', 'probe N|off')"},
+    {"trace", cmd_trace, "Vuelca la traza para tools/trace_to_chrome.py ('on', 'off')"},
+    {"id", cmd_id, "Identificador de la placa (@ID)"},
+    {"ping", cmd_ping, "Responde @PONG con los argumentos, después de los comandos anteriores"},
+    {"tel", cmd_tel, "Telemetría en una línea para máquinas (@TEL)"},
+    {"tele", cmd_tele, "Reporte periódico de telemetría: on|off"},
+    {"arm", cmd_arm, "Rellena los bloques y arranca la salida en el flanco del disparo compartido"},
+    {"fire", cmd_fire, "Produce el flanco del disparo compartido (una sola placa por línea)"},
+    {"sync", cmd_sync, "Estado y mediciones del último arranque sincronizado (@SYNC)"},
+    {"wave", cmd_wave, "Imagen de formas de onda: secuencias, 'N' reproduce la secuencia N, 'off'"},
+    {"drive", cmd_drive, "Última copia al disco USB (@IMPORT); 'codes' o 'norm' para los CSV"},
+    {"audio", cmd_audio, "Parlante USB: cola, corrección de la deriva y ciclos del remuestreo (@AUDIO)"},
+    {"bulk", cmd_bulk, "Tramas de la interfaz bulk (@BULK); 'cdc' recibe tramas por la consola"},
+    {"interp", cmd_interp, "Filtro de los pasos fraccionarios de tablas y audio: off|low|mid|high"},
+    {"chain", cmd_chain, "Factor de la cadena de interpolación del audio USB: 1|2|4|...|64"},
+    {"save", cmd_save, "Guarda los parámetros en flash"},
+    {"dacbench", cmd_dacbench, "Muestras por segundo: gpio_put() bit a bit frente a SIO"},
+};
+
+static void cmd_help(const char *args) {
+    (void)args;
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i) {
+        printf("!%-8s %s\n", commands[i].name, commands[i].help);
+    }
+}
+
+static void run_command(char *cmd) {
+    char *args = strchr(cmd, ' ');
+
+    if (args) {
+        *args++ = '\0';
+    } else {
+        args = cmd + strlen(cmd);
+    }
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i) {
+        if (strcmp(cmd, commands[i].name) == 0) {
+            commands[i].fn(args);
+            return;
+        }
+    }
+    printf("Comando desconocido: !%s\n", cmd);
+}
+
+void console_init(engine_t *e, sched_t *s, task_t *self) {
+    console_engine = e;
+    console_sched = s;
+    console_self = self;
+    line_len = 0;
+}
+
+/**
+ * Lee todos los caracteres disponibles sin esperar. Las teclas se entregan al motor al llegar;
+ * los comandos se ejecutan al recibir el fin de línea. En modo binario (!bulk cdc) lo que llega es
+ * de usb_bulk.c.
+ */
+void console_task(void *ctx) {
+    (void)ctx;
+    int c;
+
+    while (!usb_bulk_cdc_active() && (c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c == '\r' || c == '\n') {
+            line[line_len] = '\0';
+            if (line_len > 0 && line[0] == '!') {
+                run_command(line + 1);
+            }
+            line_len = 0;
+        } else if (line_len == 0 && c != '!') {
+            engine_handle_input(console_engine, (char)c);
+        } else if (line_len < CONSOLE_LINE_MAX - 1) {
+            line[line_len++] = (char)c;
+        }
+    }
+    sched_wake_at(console_self, time_us_32() + CONSOLE_POLL_US);
+}
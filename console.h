@@ -0,0 +1,22 @@
+/**
+ * @file console.h
+ *
+ * @brief Intérprete de la consola USB. Las líneas que empiezan con '!' son comandos; cualquier otro
+ * carácter se entrega al motor como si se hubiera presionado en el teclado (por ejemplo
+ * "A1500D" fija la amplitud en 1500 mV).
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "siggen/engine.h"
+#include "siggen/sched.h"
+
+#define CONSOLE_POLL_US 10000 ///< Periodo de sondeo de la consola USB (uS)
+#define CONSOLE_PROGRAM_NAME "signal_gen" ///< Nombre del programa que informa !id
+
+void console_init(engine_t *e, sched_t *s, task_t *self);
+
+void console_task(void *ctx);
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file dac_backend.h
+ *
+ * @brief Interfaz común de las salidas al DAC de 8 bits.
+ *
+ * El núcleo de síntesis pide un bloque con acquire(), lo rellena y lo entrega con commit(). Cada
+ * salida decide qué significa eso: la de PIO y DMA (dac_out.h) devuelve NULL en acquire() mientras
+ * los dos bloques esperan su envío, y commit() solo los marca como listos; la de CPU por SIO
+ * (dac_sio.h) siempre tiene un bloque disponible y commit() lo escribe en los pines al ritmo de la
+ * frecuencia de muestreo antes de volver. Los contadores de ambas van a dac_out_stats.
+ */
+
+#ifndef DAC_BACKEND_H
+#define DAC_BACKEND_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+#define DAC_PIN 0 ///< Primer GPIO del DAC; los 8 bits ocupan DAC_PIN..DAC_PIN+7
+
+/**
+ * Salida al DAC. Todas las funciones se llaman desde el núcleo de síntesis.
+ */
+typedef struct {
+    const char *name; ///< Nombre corto para los reportes
+    uint32_t sample_rate; ///< Frecuencia de muestreo con la que se inicializa (Hz)
+    void (*init)(uint pin_base, uint32_t sample_rate); ///< Configura los pines y el hardware
+    void (*start)(void); ///< Arranca la salida cuando acquire() devuelve NULL por primera vez
+    uint8_t *(*acquire)(void); ///< Próximo bloque de DAC_BLOCK_SAMPLES muestras a rellenar, o NULL
+    void (*commit)(void); ///< Entrega el bloque obtenido con acquire()
+    void (*stop)(void); ///< Detiene la salida y libera los bloques; NULL si no hace falta
+    void (*start_armed)(uint trigger_pin); ///< Como start(), pero en el próximo flanco de subida de trigger_pin; NULL si no se admite
+} dac_backend_t;
+
+extern const dac_backend_t dac_backend_pio; ///< PIO y DMA con doble búfer (dac_out.c)
+extern const dac_backend_t dac_backend_sio; ///< CPU, un registro de SIO por muestra (dac_sio.c)
+
+#endif
@@ -0,0 +1,315 @@
+/**
+ * @file dac_out.c
+ *
+ * @brief Implementación de la salida por PIO y DMA. Debe inicializarse desde el núcleo que va a
+ * rellenar los bloques, porque la interrupción DMA_IRQ_1 se habilita en el núcleo que llama a
+ * dac_out_init().
+ */
+
+#include "dac_out.h"
+#include "dac_backend.h"
+#include "siggen/platform.h"
+#include "siggen/arena.h"
+#include "siggen/trace.h"
+#include "stackmon.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/sync.h"
+#include "dac_out.pio.h"
+#include <assert.h>
+
+#define DAC_RING_BITS 10 ///< log2 del tamaño en bytes de cada bloque (DAC_BLOCK_SAMPLES)
+#define DAC_LEAD_WORDS 9 ///< Palabras por delante de la salida al terminar un bloque: el FIFO unido (8) y el OSR
+
+static uint8_t *dac_buffers[2]; ///< Bloques de muestras, alineados a su tamaño para el modo anillo
+static int dma_chan[2]; ///< Canales de DMA, uno por bloque
+static PIO dac_pio = pio0; ///< PIO que maneja los pines del DAC
+static uint dac_sm; ///< Máquina de estados de la salida
+static uint dac_offset; ///< Dirección del programa en la memoria de instrucciones
+static volatile uint32_t free_mask; ///< Bit i en 1: el bloque i ya se envió y puede rellenarse
+static int next_fill; ///< Próximo bloque a rellenar, en orden de reproducción
+static uint32_t block_period_us; ///< Duración nominal de un bloque
+static uint32_t last_irq_us; ///< Instante de la última interrupción de fin de bloque
+static uint32_t acquire_us; ///< Instante en que se entregó el bloque en curso
+static dac_out_refill_fn refill_fn; ///< Si no es NULL, rellena los bloques desde la interrupción
+static uint32_t cycles_per_sample; ///< Ciclos del reloj del sistema por muestra (parte entera)
+static uint32_t block_period_q8; ///< Ciclos del reloj del sistema por bloque, en Q8 (exacto: el divisor del PIO es Q8)
+static uint32_t boundary_q8; ///< SysTick del próximo fin de bloque nominal, en Q8 (el SysTick << 8 da la vuelta en 32 bits)
+static bool boundary_valid; ///< boundary_q8 está anclado a la salida en curso
+
+dac_out_stats_t dac_out_stats;
+isr_stats_t dac_out_isr_stats = { .name = "dma" };
+lat_hist_t dac_out_irq_latency = { .name = "dma" };
+
+ARENA_DEFINE(arena_dac, "dac", 2 * DAC_BLOCK_SAMPLES, DAC_BLOCK_SAMPLES);
+
+static_assert((1u << DAC_RING_BITS) == DAC_BLOCK_SAMPLES, "DAC_RING_BITS no coincide con DAC_BLOCK_SAMPLES");
+
+/**
+ * Registra la latencia de un fin de bloque: los ciclos entre el fin de bloque nominal y entry, el
+ * SysTick a la entrada de la rutina. Los fines de bloque los marca el PIO, exactamente cada
+ * block_period_q8 ciclos, así que la grilla se calcula una vez por arranque y no acumula error.
+ * Después de un arranque armado el instante del flanco no se conoce en este núcleo: la grilla se
+ * ancla en la primera interrupción, con la latencia que deja estimar el canal encadenado (las
+ * palabras que ya transfirió, cuatro muestras de resolución). Las variaciones siguientes tienen
+ * resolución de ciclo.
+ * @param next Canal arrancado por el encadenamiento al terminar el bloque.
+ */
+static inline void SIGGEN_HOT(record_latency)(uint32_t entry, int next) {
+    uint32_t entry_q8 = entry << 8;
+
+    if (!boundary_valid) {
+        uint32_t sent = DAC_BLOCK_SAMPLES / 4 - dma_hw->ch[dma_chan[next]].transfer_count;
+        boundary_q8 = entry_q8 + (sent * 4 * cycles_per_sample << 8);
+        boundary_valid = true;
+    }
+    // El SysTick cuenta hacia abajo: la entrada es posterior al fin de bloque si su valor es menor
+    int32_t late_q8 = (int32_t)(boundary_q8 - entry_q8);
+    lat_hist_add(&dac_out_irq_latency, late_q8 > 0 ? (uint32_t)late_q8 >> 8 : 0);
+    boundary_q8 -= block_period_q8;
+}
+
+/**
+ * Ancla la grilla de fines de bloque al arranque de la máquina de estados, que ocurre en entry
+ * (SysTick). El primer bloque termina de transferirse cuando al PIO le faltan DAC_LEAD_WORDS
+ * palabras por sacar; los siguientes, un bloque después cada uno.
+ */
+static void anchor_boundaries(uint32_t entry) {
+    uint32_t first_q8 = block_period_q8 - block_period_q8 / (DAC_BLOCK_SAMPLES / 4) * DAC_LEAD_WORDS;
+
+    boundary_q8 = (entry << 8) - first_q8;
+    boundary_valid = true;
+}
+
+/**
+ * Fin de bloque en cualquiera de los dos canales. Si el bloque todavía estaba libre, el DMA lo
+ * volvió a enviar sin datos nuevos.
+ */
+static void SIGGEN_HOT(dac_out_dma_irq)() {
+    uint32_t start = isr_stats_begin();
+    TRACE_BEGIN(TRACE_ID_DMA_IRQ);
+    uint32_t now = time_us_32();
+
+    if (last_irq_us) {
+        int32_t jitter = (int32_t)(now - last_irq_us - block_period_us);
+        uint32_t magnitude = jitter < 0 ? -jitter : jitter;
+        if (magnitude > dac_out_stats.max_irq_jitter_us) {
+            dac_out_stats.max_irq_jitter_us = magnitude;
+        }
+    }
+    last_irq_us = now;
+
+    for (int i = 0; i < 2; ++i) {
+        if (dma_channel_get_irq1_status(dma_chan[i])) {
+            record_latency(start, 1 - i);
+            dma_channel_acknowledge_irq1(dma_chan[i]);
+            if (free_mask & (1u << i)) {
+                dac_out_stats.underruns++;
+            }
+            free_mask |= 1u << i;
+            dac_out_stats.blocks++;
+            if (refill_fn) {
+                uint32_t render_start = time_us_32();
+                TRACE_BEGIN(TRACE_ID_REFILL);
+                refill_fn(dac_buffers[i]);
+                TRACE_END(TRACE_ID_REFILL);
+                free_mask &= ~(1u << i);
+                uint32_t render = time_us_32() - render_start;
+                if (render > dac_out_stats.max_render_us) {
+                    dac_out_stats.max_render_us = render;
+                }
+            }
+        }
+    }
+    TRACE_COUNTER(TRACE_ID_FREE_BLOCKS, (free_mask & 1) + (free_mask >> 1));
+    TRACE_END(TRACE_ID_DMA_IRQ);
+    isr_stats_end(&dac_out_isr_stats, start);
+}
+
+/**
+ * Carga el programa PIO y configura los dos canales de DMA. Ambos bloques quedan libres para
+ * que se rellenen antes de dac_out_start().
+ */
+void dac_out_init(uint pin_base, uint32_t sample_rate) {
+    for (int i = 0; i < 2; ++i) {
+        dac_buffers[i] = arena_alloc(&arena_dac, DAC_BLOCK_SAMPLES, DAC_BLOCK_SAMPLES);
+        if (!dac_buffers[i]) {
+            panic("arena dac agotada");
+        }
+    }
+
+    dac_offset = pio_add_program(dac_pio, &dac_out_program);
+    dac_sm = pio_claim_unused_sm(dac_pio, true);
+    dac_out_program_init(dac_pio, dac_sm, dac_offset, pin_base, sample_rate);
+
+    dma_chan[0] = dma_claim_unused_channel(true);
+    dma_chan[1] = dma_claim_unused_channel(true);
+    for (int i = 0; i < 2; ++i) {
+        dma_channel_config c = dma_channel_get_default_config(dma_chan[i]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_ring(&c, false, DAC_RING_BITS);
+        channel_config_set_dreq(&c, pio_get_dreq(dac_pio, dac_sm, true));
+        channel_config_set_chain_to(&c, dma_chan[1 - i]);
+        dma_channel_configure(dma_chan[i], &c, &dac_pio->txf[dac_sm], dac_buffers[i],
+                              DAC_BLOCK_SAMPLES / 4, false);
+        dma_channel_set_irq1_enabled(dma_chan[i], true);
+    }
+    irq_set_exclusive_handler(DMA_IRQ_1, dac_out_dma_irq);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    free_mask = 3;
+    next_fill = 0;
+    block_period_us = (uint32_t)((uint64_t)DAC_BLOCK_SAMPLES * 1000000 / sample_rate);
+    // Mismo divisor que dac_out_program_init(): una muestra por ciclo de la máquina de estados
+    uint32_t div_q8 = (uint32_t)(((uint64_t)clock_get_hz(clk_sys) << 8) / sample_rate);
+    cycles_per_sample = div_q8 >> 8;
+    block_period_q8 = DAC_BLOCK_SAMPLES * div_q8;
+    last_irq_us = 0;
+}
+
+/**
+ * Hace que la interrupción de fin de bloque rellene el bloque recién enviado llamando a fn, en
+ * lugar de dejarlo libre para dac_out_acquire(). Sirve cuando no hay un núcleo dedicado a la
+ * síntesis (por ejemplo, el módulo de MicroPython). Debe llamarse antes de dac_out_start().
+ */
+void dac_out_set_refill(dac_out_refill_fn fn) {
+    refill_fn = fn;
+}
+
+/**
+ * Apunta los dos canales al principio de sus bloques y, en el modo de relleno desde la
+ * interrupción, rellena los dos bloques.
+ */
+static void rewind_blocks(void) {
+    for (int i = 0; i < 2; ++i) {
+        dma_channel_set_read_addr(dma_chan[i], dac_buffers[i], false);
+        dma_channel_set_trans_count(dma_chan[i], DAC_BLOCK_SAMPLES / 4, false);
+        if (refill_fn) {
+            refill_fn(dac_buffers[i]);
+            free_mask &= ~(1u << i);
+        }
+    }
+    next_fill = 0;
+    last_irq_us = 0;
+    boundary_valid = false;
+}
+
+/**
+ * Arranca la máquina de estados y el primer canal de DMA. En el modo de relleno desde la
+ * interrupción, los dos bloques se rellenan antes de arrancar. La máquina se reinicia y vacía el
+ * OSR antes de saltar a start, así que las muestras que dac_out_stop() dejó sin enviar no salen.
+ */
+void dac_out_start(void) {
+    rewind_blocks();
+    pio_sm_restart(dac_pio, dac_sm);
+    pio_sm_clkdiv_restart(dac_pio, dac_sm);
+    pio_sm_exec(dac_pio, dac_sm, pio_encode_out(pio_null, 32));
+    pio_sm_exec(dac_pio, dac_sm, pio_encode_jmp(dac_offset + dac_out_offset_start));
+    uint32_t irq = save_and_disable_interrupts();
+    anchor_boundaries(systick_hw->cvr);
+    pio_sm_set_enabled(dac_pio, dac_sm, true);
+    dma_channel_start(dma_chan[0]);
+    restore_interrupts(irq);
+}
+
+/**
+ * Como dac_out_start(), pero la primera muestra sale en el primer flanco de subida de
+ * trigger_pin. El DMA llena el FIFO enseguida y la máquina de estados espera el flanco en el
+ * hardware (la entrada armed de dac_out.pio), así que el arranque no depende de la CPU: cae entre
+ * dos y tres muestras después del flanco, según la fase del divisor de reloj. Al arrancar, la
+ * máquina levanta su indicador de IRQ; dac_out_armed_started() lo consulta.
+ *
+ * Debe llamarse con la salida detenida (después de dac_out_init() o dac_out_stop()) y con los dos
+ * bloques ya rellenos.
+ */
+void dac_out_start_armed(uint trigger_pin) {
+    rewind_blocks();
+    pio_sm_set_in_pins(dac_pio, dac_sm, trigger_pin);
+    pio_sm_restart(dac_pio, dac_sm);
+    pio_sm_clkdiv_restart(dac_pio, dac_sm);
+    pio_interrupt_clear(dac_pio, dac_sm);
+    pio_sm_exec(dac_pio, dac_sm, pio_encode_jmp(dac_offset + dac_out_offset_armed));
+    pio_sm_set_enabled(dac_pio, dac_sm, true);
+    dma_channel_start(dma_chan[0]);
+}
+
+/**
+ * Consulta y borra el indicador que levanta la máquina de estados al arrancar después de
+ * dac_out_start_armed(). Se puede llamar desde cualquier núcleo.
+ * @return true si la salida arrancó desde la última consulta.
+ */
+bool dac_out_armed_started(void) {
+    if (!pio_interrupt_get(dac_pio, dac_sm)) {
+        return false;
+    }
+    pio_interrupt_clear(dac_pio, dac_sm);
+    return true;
+}
+
+/**
+ * Detiene el DMA y la máquina de estados. Los pines conservan la última muestra enviada. Los
+ * bloques quedan libres, el primero en rellenarse vuelve a ser el primero, y dac_out_start()
+ * vuelve a arrancar desde él.
+ */
+void dac_out_stop(void) {
+    // Se quita el encadenamiento antes de abortar para que un canal no vuelva a disparar al otro
+    for (int i = 0; i < 2; ++i) {
+        hw_write_masked(&dma_hw->ch[dma_chan[i]].al1_ctrl, dma_chan[i] << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB,
+                        DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS);
+    }
+    dma_channel_abort(dma_chan[0]);
+    dma_channel_abort(dma_chan[1]);
+    for (int i = 0; i < 2; ++i) {
+        hw_write_masked(&dma_hw->ch[dma_chan[i]].al1_ctrl, dma_chan[1 - i] << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB,
+                        DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS);
+    }
+    dma_channel_acknowledge_irq1(dma_chan[0]);
+    dma_channel_acknowledge_irq1(dma_chan[1]);
+    pio_sm_set_enabled(dac_pio, dac_sm, false);
+    pio_sm_clear_fifos(dac_pio, dac_sm);
+    free_mask = 3;
+    next_fill = 0;
+}
+
+/**
+ * Devuelve el próximo bloque a rellenar, o NULL si los dos bloques están pendientes de envío.
+ */
+uint8_t *SIGGEN_HOT(dac_out_acquire)(void) {
+    if (!(free_mask & (1u << next_fill))) {
+        return NULL;
+    }
+    acquire_us = time_us_32();
+    return dac_buffers[next_fill];
+}
+
+/**
+ * Marca como listo para enviar el bloque obtenido con dac_out_acquire().
+ */
+void SIGGEN_HOT(dac_out_commit)(void) {
+    uint32_t irq = save_and_disable_interrupts();
+    free_mask &= ~(1u << next_fill);
+    restore_interrupts(irq);
+    next_fill ^= 1;
+
+    uint32_t render = time_us_32() - acquire_us;
+    if (render > dac_out_stats.max_render_us) {
+        dac_out_stats.max_render_us = render;
+    }
+}
+
+/**
+ * Reinicia los máximos de tiempo de relleno y de variación entre interrupciones.
+ */
+void dac_out_reset_stats(void) {
+    dac_out_stats.max_render_us = 0;
+    dac_out_stats.max_irq_jitter_us = 0;
+}
+
+const dac_backend_t dac_backend_pio = {
+    "pio", DAC_SAMPLE_RATE, dac_out_init, dac_out_start, dac_out_acquire, dac_out_commit, dac_out_stop,
+    dac_out_start_armed,
+};
@@ -0,0 +1,72 @@
+/**
+ * @file dac_out.h
+ *
+ * @brief Salida de muestras al DAC por PIO y DMA con doble búfer.
+ *
+ * Dos canales de DMA encadenados se alternan entre dos bloques de muestras; cada uno usa el modo
+ * anillo sobre su propio bloque, así que al terminar su dirección de lectura vuelve al inicio sin
+ * intervención de la CPU. La interrupción de fin de bloque (el equivalente a la media
+ * transferencia del conjunto) solo marca el bloque como libre; el núcleo de síntesis lo rellena y
+ * vuelve a dormir con WFE.
+ *
+ * Con dac_out_start_armed() la salida queda lista con los dos bloques cargados y arranca en el
+ * hardware en el flanco de subida de un pin de disparo, para arrancar varias placas a la vez.
+ */
+
+#ifndef DAC_OUT_H
+#define DAC_OUT_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "siggen/arena.h"
+#include "stackmon.h"
+#include "siggen/lat_hist.h"
+
+#define DAC_SAMPLE_RATE 1000000 ///< Frecuencia de muestreo de la salida (Hz)
+#define DAC_BLOCK_SAMPLES 1024 ///< Muestras por bloque; potencia de 2 para el modo anillo del DMA
+
+/**
+ * Contadores de la salida, actualizados desde la interrupción del DMA.
+ */
+typedef struct {
+    volatile uint32_t blocks; ///< Bloques enviados al DAC
+    volatile uint32_t underruns; ///< Bloques repetidos porque no se rellenaron a tiempo
+    volatile uint32_t max_render_us; ///< Peor tiempo entre dac_out_acquire() y dac_out_commit()
+    volatile uint32_t max_irq_jitter_us; ///< Peor desviación del intervalo entre interrupciones de fin de bloque respecto al nominal
+} dac_out_stats_t;
+
+extern dac_out_stats_t dac_out_stats;
+
+extern isr_stats_t dac_out_isr_stats; ///< Tiempos de la interrupción de fin de bloque
+
+extern lat_hist_t dac_out_irq_latency; ///< Ciclos desde el fin de un bloque hasta la entrada a la interrupción
+
+/**
+ * Arena de los bloques de muestras de la salida activa (dos bloques de DAC_BLOCK_SAMPLES).
+ */
+extern arena_t arena_dac;
+
+/**
+ * Función que rellena un bloque completo de DAC_BLOCK_SAMPLES muestras.
+ */
+typedef void (*dac_out_refill_fn)(uint8_t *block);
+
+void dac_out_init(uint pin_base, uint32_t sample_rate);
+
+void dac_out_set_refill(dac_out_refill_fn fn);
+
+void dac_out_start(void);
+
+void dac_out_start_armed(uint trigger_pin);
+
+bool dac_out_armed_started(void);
+
+void dac_out_stop(void);
+
+uint8_t *dac_out_acquire(void);
+
+void dac_out_commit(void);
+
+void dac_out_reset_stats(void);
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file dac_sio.c
+ *
+ * @brief Implementación de la salida por SIO y de su medición frente al bucle bit a bit.
+ */
+
+#include "dac_sio.h"
+#include "dac_out.h"
+#include "siggen/arena.h"
+#include "siggen/par_out.h"
+#include "siggen/platform.h"
+#include "hardware/gpio.h"
+#include "hardware/structs/sio.h"
+#include <stdio.h>
+
+#define DAC_SIO_BENCH_SAMPLES 65536 ///< Muestras escritas por cada método en dac_sio_bench()
+#define DAC_SIO_BENCH_BLOCK 256 ///< Muestras por bloque en la medición a través de par_out
+
+/**
+ * Ubicación del DAC en el registro de SIO, calculada una vez por pin base.
+ */
+typedef struct {
+    uint shift; ///< Pin base del DAC
+    uint32_t mask; ///< Pines del DAC
+} sio_pins_t;
+
+static sio_pins_t sio_pins; ///< Pines de la salida
+static uint8_t *sio_block; ///< Único bloque, tomado de arena_dac; se escribe completo en commit()
+static par_out_t sio_out; ///< Ritmo de muestreo y contadores de muestras atrasadas
+static uint32_t acquire_us; ///< Instante en que se entregó el bloque en curso
+
+/**
+ * Escribe una muestra: el XOR con la salida actual, limitado a la máscara, invierte exactamente
+ * los bits que cambian, sin tocar los demás pines.
+ */
+static void SIGGEN_HOT(dac_sio_put)(void *ctx, uint8_t value) {
+    const sio_pins_t *pins = (const sio_pins_t *)ctx;
+    sio_hw->gpio_togl = (sio_hw->gpio_out ^ ((uint32_t)value << pins->shift)) & pins->mask;
+}
+
+/**
+ * La escritura original: un gpio_put() por bit, del menos al más significativo.
+ */
+static void dac_loop_put(uint pin_base, uint8_t value) {
+    for (int i = 0; i < 8; i++) {
+        gpio_put(pin_base + i, (value >> i) & 1);
+    }
+}
+
+static uint32_t clock_us(void) {
+    return time_us_32();
+}
+
+/**
+ * Configura los 8 pines como salidas de SIO y el ritmo de muestreo.
+ */
+void dac_sio_init(uint pin_base, uint32_t sample_rate) {
+    sio_block = arena_alloc(&arena_dac, DAC_BLOCK_SAMPLES, 4);
+    if (!sio_block) {
+        panic("arena dac agotada");
+    }
+    sio_pins.shift = pin_base;
+    sio_pins.mask = 0xFFu << pin_base;
+    gpio_init_mask(sio_pins.mask);
+    gpio_set_dir_out_masked(sio_pins.mask);
+    par_out_init(&sio_out, dac_sio_put, &sio_pins, clock_us, sample_rate);
+}
+
+static void dac_sio_start(void) {
+}
+
+static uint8_t *SIGGEN_HOT(dac_sio_acquire)(void) {
+    acquire_us = time_us_32();
+    return sio_block;
+}
+
+/**
+ * Escribe el bloque completo. Un bloque con alguna muestra atrasada se cuenta como repetido en
+ * dac_out_stats, para que la telemetría sea comparable con la salida por PIO.
+ */
+static void SIGGEN_HOT(dac_sio_commit)(void) {
+    uint32_t render = time_us_32() - acquire_us;
+    uint32_t late = sio_out.late;
+
+    if (render > dac_out_stats.max_render_us) {
+        dac_out_stats.max_render_us = render;
+    }
+    par_out_write_block(&sio_out, sio_block, DAC_BLOCK_SAMPLES);
+    dac_out_stats.blocks++;
+    if (sio_out.late != late) {
+        dac_out_stats.underruns++;
+    }
+}
+
+const dac_backend_t dac_backend_sio = {
+    "sio", DAC_SIO_SAMPLE_RATE, dac_sio_init, dac_sio_start, dac_sio_acquire, dac_sio_commit, NULL, NULL,
+};
+
+static void bench_report(const char *name, uint32_t elapsed_us) {
+    printf("%-14s %6lu ns/muestra, max %5lu kmuestras/s\n", name,
+           (unsigned long)((uint64_t)elapsed_us * 1000 / DAC_SIO_BENCH_SAMPLES),
+           elapsed_us ? (unsigned long)((uint64_t)DAC_SIO_BENCH_SAMPLES * 1000 / elapsed_us) : 0);
+}
+
+/**
+ * Mide la frecuencia de muestreo máxima de cada forma de escribir una muestra: el bucle de
+ * gpio_put() original, la escritura única por SIO y la misma a través de par_out sin ritmo
+ * (costo de la interfaz incluido). Las interrupciones quedan habilitadas, como en uso normal.
+ *
+ * Las escrituras van a los pines del DAC. Con la salida por PIO los pines están a cargo del PIO,
+ * así que no llegan a ellos pero cuestan lo mismo, y la medición puede correr en el núcleo 0 con
+ * la salida activa. Con la salida por SIO los pines son de SIO: la medición cambiaría la señal y
+ * competiría con el XOR de dac_sio_commit() en el núcleo 1, así que no se hace.
+ * @return false si la salida por SIO está en uso y no se midió nada.
+ */
+bool dac_sio_bench(uint pin_base) {
+    static uint8_t block[DAC_SIO_BENCH_BLOCK];
+    sio_pins_t pins = { pin_base, 0xFFu << pin_base };
+    par_out_t raw;
+    uint32_t t0;
+
+    if (sio_block) {
+        return false;
+    }
+
+    t0 = time_us_32();
+    for (uint32_t i = 0; i < DAC_SIO_BENCH_SAMPLES; ++i) {
+        dac_loop_put(pin_base, (uint8_t)i);
+    }
+    bench_report("gpio_put x8", time_us_32() - t0);
+
+    t0 = time_us_32();
+    for (uint32_t i = 0; i < DAC_SIO_BENCH_SAMPLES; ++i) {
+        dac_sio_put(&pins, (uint8_t)i);
+    }
+    bench_report("sio", time_us_32() - t0);
+
+    for (uint32_t i = 0; i < DAC_SIO_BENCH_BLOCK; ++i) {
+        block[i] = (uint8_t)i;
+    }
+    par_out_init(&raw, dac_sio_put, &pins, clock_us, 0);
+    t0 = time_us_32();
+    for (uint32_t i = 0; i < DAC_SIO_BENCH_SAMPLES / DAC_SIO_BENCH_BLOCK; ++i) {
+        par_out_write_block(&raw, block, DAC_SIO_BENCH_BLOCK);
+    }
+    bench_report("sio+par_out", time_us_32() - t0);
+    return true;
+}
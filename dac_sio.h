@@ -0,0 +1,25 @@
+/**
+ * @file dac_sio.h
+ *
+ * @brief Salida al DAC por CPU escribiendo los 8 bits con una sola operación de SIO.
+ *
+ * El write_dac() original llamaba ocho veces a gpio_put(), de modo que cada muestra costaba
+ * decenas de ciclos y los bits cambiaban en instantes distintos. Aquí la máscara y el
+ * desplazamiento del pin base se calculan una vez y cada muestra es una escritura al registro
+ * GPIO_OUT_XOR de SIO: los ocho pines cambian en el mismo ciclo para cualquier pin base contiguo.
+ * El ritmo de muestreo lo lleva siggen/par_out.c con el temporizador de microsegundos.
+ */
+
+#ifndef DAC_SIO_H
+#define DAC_SIO_H
+
+#include "dac_backend.h"
+#include <stdbool.h>
+
+#define DAC_SIO_SAMPLE_RATE 250000 ///< Frecuencia de muestreo de la salida por CPU (Hz)
+
+void dac_sio_init(uint pin_base, uint32_t sample_rate);
+
+bool dac_sio_bench(uint pin_base);
+
+#endif
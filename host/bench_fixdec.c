@@ -0,0 +1,124 @@
+/**
+ * @file bench_fixdec.c
+ *
+ * @brief Compara siggen/fixdec.c contra strtof() y snprintf("%.2f") y verifica la ida y vuelta.
+ *
+ * Primero recorre todos los valores en milésimas entre -RANGO y RANGO: cada valor se formatea
+ * con tres decimales y se vuelve a interpretar, y debe dar el mismo entero; con dos decimales se
+ * compara contra el redondeo calculado con enteros. Después mide el tiempo por conversión de cada
+ * implementación sobre los mismos valores.
+ *
+ * Uso: bench_fixdec [RANGO]   (por defecto 20000000, es decir ±20000.000)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include "../siggen/fixdec.h"
+
+#define BENCH_VALUES 1000000 ///< Valores por medición
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Redondeo de referencia a dos decimales (la mitad se aleja del cero), en centésimas.
+ */
+static int64_t round_centi(int64_t milli) {
+    return milli >= 0 ? (milli + 5) / 10 : -((-milli + 5) / 10);
+}
+
+static int verify(int64_t range) {
+    char buf[FIXDEC_MAX_LEN];
+    unsigned long errors = 0;
+
+    for (int64_t v = -range; v <= range; ++v) {
+        int64_t back;
+        const char *end;
+
+        fixdec_format(buf, sizeof(buf), v, 3);
+        if (!fixdec_parse(buf, &end, &back) || *end != '\0' || back != v) {
+            if (errors++ < 10) {
+                fprintf(stderr, "ida y vuelta: %lld -> \"%s\" -> %lld\n", (long long)v, buf, (long long)back);
+            }
+        }
+
+        fixdec_format(buf, sizeof(buf), v, 2);
+        if (!fixdec_parse(buf, NULL, &back) || back != round_centi(v) * 10) {
+            if (errors++ < 10) {
+                fprintf(stderr, "redondeo: %lld -> \"%s\"\n", (long long)v, buf);
+            }
+        }
+    }
+    printf("verificación: %lld valores, %lu errores\n", (long long)(2 * range + 1), errors);
+    return errors != 0;
+}
+
+int main(int argc, char **argv) {
+    int64_t range = 20000000;
+    static char texts[BENCH_VALUES][FIXDEC_MAX_LEN];
+    static int64_t values[BENCH_VALUES];
+    char buf[FIXDEC_MAX_LEN];
+    volatile int64_t sink_i = 0;
+    volatile float sink_f = 0;
+    double t0, t_fix_parse, t_strtof, t_fix_format, t_printf;
+
+    if (argc > 1) {
+        char *end;
+
+        errno = 0;
+        range = strtoll(argv[1], &end, 10);
+        if (argc > 2 || end == argv[1] || *end != '\0' || errno == ERANGE || range <= 0) {
+            fprintf(stderr, "Uso: %s [RANGO]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int status = verify(range);
+
+    srand(1);
+    for (int i = 0; i < BENCH_VALUES; ++i) {
+        values[i] = (int64_t)(rand() % 250000000);
+        fixdec_format(texts[i], sizeof(texts[i]), values[i], 2);
+    }
+
+    t0 = now_s();
+    for (int i = 0; i < BENCH_VALUES; ++i) {
+        int64_t v;
+        fixdec_parse(texts[i], NULL, &v);
+        sink_i += v;
+    }
+    t_fix_parse = now_s() - t0;
+
+    t0 = now_s();
+    for (int i = 0; i < BENCH_VALUES; ++i) {
+        sink_f += strtof(texts[i], NULL);
+    }
+    t_strtof = now_s() - t0;
+
+    t0 = now_s();
+    for (int i = 0; i < BENCH_VALUES; ++i) {
+        sink_i += fixdec_format(buf, sizeof(buf), values[i], 2);
+    }
+    t_fix_format = now_s() - t0;
+
+    t0 = now_s();
+    for (int i = 0; i < BENCH_VALUES; ++i) {
+        sink_i += snprintf(buf, sizeof(buf), "%.2f", values[i] / 1000.0f);
+    }
+    t_printf = now_s() - t0;
+
+    printf("fixdec_parse        %7.1f ns/valor\n", t_fix_parse * 1e9 / BENCH_VALUES);
+    printf("strtof              %7.1f ns/valor (%.1fx)\n", t_strtof * 1e9 / BENCH_VALUES, t_strtof / t_fix_parse);
+    printf("fixdec_format       %7.1f ns/valor\n", t_fix_format * 1e9 / BENCH_VALUES);
+    printf("snprintf(\"%%.2f\")    %7.1f ns/valor (%.1fx)\n", t_printf * 1e9 / BENCH_VALUES, t_printf / t_fix_format);
+    return status;
+}
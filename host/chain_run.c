@@ -0,0 +1,142 @@
+/**
+ * @file chain_run.c
+ *
+ * @brief Mide en la máquina anfitriona el costo y el rechazo de imágenes de la cadena de
+ * interpolación de siggen/interp_chain.h con cada factor.
+ *
+ * Un tono de 16 bits de FREQ Hz muestreado a ENTRADA Hz entra a la cadena en bloques de BLOQUE
+ * muestras (48 = un paquete del audio USB a 48 kHz). Para cada factor se informa:
+ *  - Los nanosegundos por muestra de salida y por muestra de entrada, de la mejor de cinco
+ *    repeticiones, y la frecuencia de entrada máxima que podría procesar un núcleo como este.
+ *  - La ganancia del tono, que muestra la caída en la banda de paso (el CIC, ya compensado).
+ *  - El rechazo: cuánto más abajo que el tono queda la peor de sus imágenes, en k * ENTRADA ± FREQ
+ *    para k = 1 .. factor - 1, medidas con Goertzel y ventana de Hann.
+ *
+ * Cada resultado es además una línea "@CHAIN,<factor>,<ns por muestra de salida>,<entrada máxima
+ * Hz>,<ganancia dB>,<rechazo dB>" por la salida estándar. Termina con error si el rechazo de algún
+ * factor queda debajo de RUN_MIN_DB con el tono en la banda de paso de diseño.
+ *
+ * Uso: chain_run [-i ENTRADA] [-f FREQ] [-b BLOQUE] [-n MUESTRAS]
+ *  - -i ENTRADA  Frecuencia de muestreo de la entrada (Hz, por defecto 48000).
+ *  - -f FREQ     Frecuencia del tono (Hz, por defecto 15000).
+ *  - -b BLOQUE   Muestras de entrada por llamada (por defecto 48).
+ *  - -n MUESTRAS Muestras de entrada analizadas (por defecto 4096).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "../siggen/interp_chain.h"
+
+#define RUN_PI 3.14159265358979323846
+#define RUN_REPEATS 5 ///< Repeticiones de la medición del costo; se informa la más rápida
+#define RUN_AMPLITUDE 26000 ///< Amplitud del tono, con margen para la compensación del CIC
+#define RUN_PASSBAND 0.375 ///< Banda de paso de diseño, en fracción de la frecuencia de entrada
+#define RUN_MIN_DB 55 ///< Rechazo mínimo admitido con el tono en la banda de paso de diseño
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Amplitud de la componente de frecuencia f (ciclos por muestra) de x, con ventana de Hann; una
+ * sinusoide de amplitud A da A * n / 4.
+ */
+static double tone_level(const int16_t *x, size_t n, double f) {
+    double coef = 2 * cos(2 * RUN_PI * f), s1 = 0, s2 = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        double s0 = (0.5 - 0.5 * cos(2 * RUN_PI * i / n)) * x[i] + coef * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return sqrt(s1 * s1 + s2 * s2 - coef * s1 * s2);
+}
+
+/**
+ * Pasa todo el tono por la cadena en bloques de block muestras.
+ */
+static void run(interp_chain_t *c, const int16_t *in, size_t n, size_t block, int16_t *out) {
+    for (size_t i = 0; i < n; i += block) {
+        size_t len = n - i < block ? n - i : block;
+        out += interp_chain_process(c, in + i, len, out);
+    }
+}
+
+int main(int argc, char **argv) {
+    double in_rate = 48000, tone_hz = 15000;
+    size_t block = 48, samples = 4096;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:f:b:n:")) != -1) {
+        switch (opt) {
+            case 'i': in_rate = atof(optarg); break;
+            case 'f': tone_hz = atof(optarg); break;
+            case 'b': block = (size_t)atol(optarg); break;
+            case 'n': samples = (size_t)atol(optarg); break;
+            default:
+                fprintf(stderr, "Uso: %s [-i ENTRADA] [-f FREQ] [-b BLOQUE] [-n MUESTRAS]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (in_rate <= 0 || tone_hz <= 0 || tone_hz >= in_rate / 2 || !block || samples < 256) {
+        fprintf(stderr, "El tono tiene que estar por debajo de la mitad de la frecuencia de entrada\n");
+        return 2;
+    }
+
+    double f = tone_hz / in_rate;
+    int16_t *in = malloc(samples * sizeof(*in));
+    int16_t *out = malloc(samples * INTERP_CHAIN_MAX_FACTOR * sizeof(*out));
+    bool in_band = f <= RUN_PASSBAND, ok = true;
+
+    for (size_t i = 0; i < samples; ++i) {
+        in[i] = (int16_t)lrint(RUN_AMPLITUDE * sin(2 * RUN_PI * f * i));
+    }
+    fprintf(stderr, "Tono de %.0f Hz a %.0f Hz (%.3f de la frecuencia de entrada), bloques de %zu muestras\n", tone_hz,
+            in_rate, f, block);
+    fprintf(stderr, "%6s %12s %12s %16s %10s %10s\n", "factor", "ns/salida", "ns/entrada", "entrada máx Hz",
+            "ganancia", "rechazo");
+
+    for (uint32_t factor = 2; factor <= INTERP_CHAIN_MAX_FACTOR; factor *= 2) {
+        interp_chain_t c;
+        double best = 1e9;
+
+        for (int r = 0; r < RUN_REPEATS; ++r) {
+            interp_chain_init(&c, factor);
+            double t0 = now_s();
+            run(&c, in, samples, block, out);
+            best = fmin(best, now_s() - t0);
+        }
+        double ns_out = best * 1e9 / ((double)samples * factor), ns_in = ns_out * factor;
+
+        // Se descarta el arranque, mientras las etapas se llenan
+        size_t skip = 64 * factor, n = samples * factor - skip;
+        const int16_t *x = out + skip;
+        double signal = tone_level(x, n, f / factor), image = 0;
+        for (uint32_t k = 1; k < factor; ++k) {
+            image = fmax(image, tone_level(x, n, (k - f) / factor));
+            image = fmax(image, tone_level(x, n, (k + f) / factor));
+        }
+        double gain_db = 20 * log10(signal / (RUN_AMPLITUDE * n / 4.0));
+        double rejection_db = 20 * log10(signal / fmax(image, 1e-9));
+        bool low = in_band && rejection_db < RUN_MIN_DB;
+
+        fprintf(stderr, "%6u %12.2f %12.2f %16.0f %+10.2f %10.1f%s\n", factor, ns_out, ns_in, 1e9 / ns_in, gain_db,
+                rejection_db, low ? "  POR DEBAJO DEL MÍNIMO" : "");
+        printf("@CHAIN,%u,%.2f,%.0f,%.2f,%.1f\n", factor, ns_out, 1e9 / ns_in, gain_db, rejection_db);
+        ok = ok && !low;
+    }
+
+    free(in);
+    free(out);
+    return ok ? 0 : 1;
+}
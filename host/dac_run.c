@@ -0,0 +1,275 @@
+/**
+ * @file dac_run.c
+ *
+ * @brief Corre la salida completa del firmware (síntesis → DMA → PIO → pines del DAC) sobre la
+ * placa simulada de hal_sim.h y mide su comportamiento en el tiempo.
+ *
+ * Compila el mismo dac_out.c del firmware contra los encabezados de host/hal/, así que los dos
+ * canales de DMA encadenados, el modo anillo, el DREQ del FIFO y la interrupción de fin de bloque
+ * son los del código real. El bucle principal hace lo mismo que core1_main(): pide un bloque con
+ * acquire(), lo sintetiza con siggen/synth.c, lo entrega con commit(), arranca la salida la
+ * primera vez que no hay bloques libres y espera la próxima interrupción. Con -w la síntesis de
+ * cada bloque ocupa esa cantidad de ciclos del reloj simulado, para buscar el punto en que
+ * aparecen bloques repetidos; con -i los bloques se rellenan desde la interrupción, como en el
+ * módulo de MicroPython. Con -a la salida arranca armada (dac_out_start_armed()) y el disparo
+ * sube en el ciclo indicado; se informa cuántos ciclos pasan desde el flanco hasta la primera
+ * muestra, para ver el efecto de la fase del divisor sobre el desfase entre placas.
+ *
+ * Cada muestra que sale por los pines se compara con la sintetizada (hasta el primer bloque
+ * repetido, que desfasa la comparación) y se mide el intervalo entre muestras. Al final se
+ * informan los contadores de dac_out_stats, el histograma de latencia de la interrupción y la
+ * velocidad de la simulación.
+ *
+ * Uso: dac_run [-c HZ] [-s SEGUNDOS] [-l CICLOS] [-w CICLOS] [-i] [-a CICLO] [-t ARCHIVO]
+ *  - -c HZ        Reloj del sistema (por defecto 125000000).
+ *  - -s SEGUNDOS  Tiempo simulado (por defecto 2).
+ *  - -l CICLOS    Latencia de la interrupción (por defecto 15, la del Cortex-M0+).
+ *  - -w CICLOS    Ciclos que tarda la síntesis de un bloque (por defecto 0).
+ *  - -i           Rellenar los bloques desde la interrupción (dac_out_set_refill()).
+ *  - -a CICLO     Arranque armado; el disparo (SYNC_TRIGGER_PIN) sube en ese ciclo.
+ *  - -t ARCHIVO   Escribir en ARCHIVO la traza de la síntesis y de la interrupción del DMA, con el
+ *                 reloj simulado, para tools/trace_to_chrome.py. Requiere compilar con make TRACE=1.
+ *                 Los anillos guardan los últimos eventos: con -s corto se ve el arranque.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "hal_sim.h"
+#include "../dac_backend.h"
+#include "../dac_out.h"
+#include "../sync_start.h"
+#include "../siggen/synth.h"
+#include "../siggen/trace.h"
+
+#define EXPECTED_BLOCKS 4 ///< Bloques sintetizados que esperan salir por los pines
+
+/**
+ * Estado de la verificación de las muestras.
+ */
+typedef struct {
+    uint8_t expected[EXPECTED_BLOCKS * DAC_BLOCK_SAMPLES]; ///< Muestras sintetizadas, en orden
+    uint64_t rendered; ///< Muestras sintetizadas
+    uint64_t emitted; ///< Muestras que salieron por los pines
+    uint64_t checked; ///< Muestras comparadas
+    uint64_t errors; ///< Muestras distintas de la sintetizada
+    uint64_t first_cycle, last_cycle; ///< Ciclos de la primera y la última muestra
+    uint64_t min_interval, max_interval; ///< Intervalos extremos entre muestras
+} check_t;
+
+static check_t check = { .min_interval = UINT64_MAX };
+static synth_t synth;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void render(uint8_t *block) {
+    synth_render(&synth, block, DAC_BLOCK_SAMPLES);
+    memcpy(&check.expected[check.rendered % (EXPECTED_BLOCKS * DAC_BLOCK_SAMPLES)], block, DAC_BLOCK_SAMPLES);
+    check.rendered += DAC_BLOCK_SAMPLES;
+}
+
+/**
+ * Después de cada ciclo en que avanzó una máquina: si la de la salida terminó un OUT PINS, hay
+ * una muestra nueva en los pines.
+ */
+static void observe(void *ctx) {
+    const pio_sim_sm_t *sm = &hal_sim_pio[0].sm[0];
+
+    (void)ctx;
+    if (!sm->retired || (sm->last_instr & 0xE0E0) != 0x6000) {
+        return;
+    }
+    uint64_t cycle = hal_sim_cycle();
+    if (!check.emitted) {
+        check.first_cycle = cycle;
+    } else {
+        uint64_t interval = cycle - check.last_cycle;
+        if (interval < check.min_interval) {
+            check.min_interval = interval;
+        }
+        if (interval > check.max_interval) {
+            check.max_interval = interval;
+        }
+    }
+    check.last_cycle = cycle;
+
+    if (!dac_out_stats.underruns && check.emitted < check.rendered) {
+        uint8_t value = (uint8_t)(pio_sim_pins(&hal_sim_pio[0]) >> DAC_PIN);
+        uint8_t expected = check.expected[check.emitted % (EXPECTED_BLOCKS * DAC_BLOCK_SAMPLES)];
+        if (value != expected && check.errors++ < 10) {
+            fprintf(stderr, "muestra %llu: %u, se esperaba %u\n", (unsigned long long)check.emitted, value, expected);
+        }
+        check.checked++;
+    }
+    check.emitted++;
+}
+
+static void print_text(void *ctx, const char *text) {
+    fputs(text, ctx);
+}
+
+/**
+ * Lleva el reloj de la traza al ciclo simulado, fuera de las interrupciones (dentro lo hace
+ * hal_sim_run()).
+ */
+static void trace_sync(void) {
+#if SIGGEN_TRACE
+    trace_sim_clock = (uint32_t)hal_sim_cycle();
+#endif
+}
+
+int main(int argc, char **argv) {
+    uint32_t clk_hz = 125000000, irq_latency = 15, render_cycles = 0;
+    double seconds = 2.0;
+    uint64_t trigger_cycle = 0;
+    bool refill = false, armed = false;
+    FILE *trace_file = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:s:l:w:ia:t:")) != -1) {
+        switch (opt) {
+            case 'c': clk_hz = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 's': seconds = strtod(optarg, NULL); break;
+            case 'l': irq_latency = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'w': render_cycles = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'i': refill = true; break;
+            case 'a':
+                armed = true;
+                trigger_cycle = strtoull(optarg, NULL, 10);
+                break;
+            case 't':
+                if (!SIGGEN_TRACE) {
+                    fprintf(stderr, "%s: -t requiere compilar con make TRACE=1\n", argv[0]);
+                    return 2;
+                }
+                if (trace_file) {
+                    fclose(trace_file);
+                }
+                if (!(trace_file = fopen(optarg, "w"))) {
+                    perror(optarg);
+                    return 2;
+                }
+                break;
+            default:
+                fprintf(stderr, "Uso: %s [-c HZ] [-s SEGUNDOS] [-l CICLOS] [-w CICLOS] [-i] [-a CICLO] [-t ARCHIVO]\n",
+                        argv[0]);
+                if (trace_file) {
+                    fclose(trace_file);
+                }
+                return 2;
+        }
+    }
+    if (clk_hz < dac_backend_pio.sample_rate || seconds <= 0) {
+        fprintf(stderr, "%s: parámetros inválidos\n", argv[0]);
+        if (trace_file) {
+            fclose(trace_file);
+        }
+        return 2;
+    }
+
+    const dac_backend_t *dac = &dac_backend_pio;
+    uint64_t end = (uint64_t)(seconds * clk_hz);
+    bool started = false;
+    double t0 = now_s();
+
+    hal_sim_init(clk_hz, irq_latency);
+#if SIGGEN_TRACE
+    // Todo lo que simula dac_run corre en el núcleo 1 del firmware
+    trace_sim_core = 1;
+    trace_sim_clock_hz = clk_hz;
+    trace_sync();
+#endif
+    if (trace_file) {
+        trace_start();
+    }
+    hal_sim_set_observer(observe, NULL);
+    synth_init(&synth, dac->sample_rate);
+    synth_set(&synth, SINE, 2000000, 1650000, 1000000);
+    dac->init(DAC_PIN, dac->sample_rate);
+
+    if (refill) {
+        dac_out_set_refill(render);
+        if (armed) {
+            dac->start_armed(SYNC_TRIGGER_PIN);
+            hal_sim_run(trigger_cycle < end ? trigger_cycle : end, false);
+            hal_sim_pio[0].pins_in |= 1u << SYNC_TRIGGER_PIN;
+        } else {
+            dac->start();
+        }
+        hal_sim_run(end, false);
+    }
+    while (!refill && hal_sim_cycle() < end) {
+        uint8_t *block = dac->acquire();
+
+        if (!block) {
+            if (!started) {
+                if (armed) {
+                    dac->start_armed(SYNC_TRIGGER_PIN);
+                } else {
+                    dac->start();
+                }
+                started = true;
+                continue;
+            }
+            if (armed && !(hal_sim_pio[0].pins_in & (1u << SYNC_TRIGGER_PIN))) {
+                // Ninguna interrupción llega antes del arranque: se avanza hasta el flanco
+                hal_sim_run(trigger_cycle < end ? trigger_cycle : end, false);
+                hal_sim_pio[0].pins_in |= 1u << SYNC_TRIGGER_PIN;
+                continue;
+            }
+            hal_sim_run(end, true);
+            continue;
+        }
+        trace_sync();
+        TRACE_BEGIN(TRACE_ID_RENDER);
+        render(block);
+        if (render_cycles) {
+            hal_sim_run(hal_sim_cycle() + render_cycles, false);
+        }
+        trace_sync();
+        TRACE_END(TRACE_ID_RENDER);
+        dac->commit();
+    }
+
+    double elapsed = now_s() - t0;
+    if (trace_file) {
+        trace_stop();
+        trace_dump(clk_hz, print_text, trace_file);
+        fclose(trace_file);
+    }
+    double simulated = (double)hal_sim_cycle() / clk_hz;
+    printf("simulado=%.3f s muestras=%llu verificadas=%llu errores=%llu\n", simulated,
+           (unsigned long long)check.emitted, (unsigned long long)check.checked, (unsigned long long)check.errors);
+    printf("bloques=%lu repetidos=%lu max_irq_jitter=%lu us max_render=%lu us\n", (unsigned long)dac_out_stats.blocks,
+           (unsigned long)dac_out_stats.underruns, (unsigned long)dac_out_stats.max_irq_jitter_us,
+           (unsigned long)dac_out_stats.max_render_us);
+    printf("intervalo (ciclos): min=%llu medio=%.3f max=%llu esperado=%.3f\n",
+           (unsigned long long)check.min_interval,
+           check.emitted > 1 ? (double)(check.last_cycle - check.first_cycle) / (check.emitted - 1) : 0.0,
+           (unsigned long long)check.max_interval, (double)clk_hz / dac->sample_rate);
+    if (armed) {
+        bool flagged = dac_out_armed_started();
+        if (check.emitted && check.first_cycle >= trigger_cycle) {
+            uint64_t latency = check.first_cycle - trigger_cycle;
+            printf("arranque armado: flanco en el ciclo %llu, primera muestra en el %llu: %llu ciclos (%.2f muestras)%s\n",
+                   (unsigned long long)trigger_cycle, (unsigned long long)check.first_cycle,
+                   (unsigned long long)latency, (double)latency * dac->sample_rate / clk_hz,
+                   flagged ? "" : ", sin el aviso de IRQ");
+        } else {
+            printf("arranque armado: %s\n", check.emitted ? "salieron muestras antes del flanco" : "no arrancó");
+            check.errors++;
+        }
+    }
+    printf("latencia de la interrupción (ciclos, desde el fin de bloque):\n");
+    lat_hist_print(&dac_out_irq_latency, print_text, stdout);
+    printf("simulación: %.3f s en %.3f s, %.1fx tiempo real\n", simulated, elapsed, simulated / elapsed);
+    return check.errors != 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file dma_sim.c
+ *
+ * @brief Implementación del modelo de DMA. Las referencias son a la sección 2.5 (DMA) del RP2040
+ * Datasheet.
+ */
+
+#include "dma_sim.h"
+#include <string.h>
+
+/// Transferencias máximas por llamada a dma_sim_service(), para que dos canales sin DREQ
+/// encadenados entre sí no dejen a la simulación en un ciclo infinito
+#define DMA_SIM_MAX_PER_SERVICE 65536
+
+void dma_sim_init(dma_sim_t *dma, const dma_sim_port_t *port) {
+    memset(dma, 0, sizeof(*dma));
+    if (port) {
+        dma->port = *port;
+    }
+}
+
+/**
+ * Fija la cuenta que se carga en cada disparo, como escribir TRANS_COUNT (o AL1_TRANS_COUNT_TRIG
+ * si trigger es true).
+ */
+void dma_sim_set_trans_count(dma_sim_t *dma, unsigned ch, uint32_t count, bool trigger) {
+    dma->ch[ch].trans_count_reload = count;
+    if (trigger) {
+        dma_sim_trigger(dma, ch);
+    }
+}
+
+/**
+ * Dispara un canal: carga la cuenta y queda ocupado hasta terminarla. Un canal deshabilitado (sin
+ * EN) o con cuenta 0 no arranca.
+ */
+void dma_sim_trigger(dma_sim_t *dma, unsigned ch) {
+    dma_sim_channel_t *c = &dma->ch[ch];
+
+    if (!(c->ctrl & DMA_SIM_CTRL_EN) || !c->trans_count_reload) {
+        return;
+    }
+    c->transfer_count = c->trans_count_reload;
+    c->ctrl |= DMA_SIM_CTRL_BUSY;
+}
+
+/**
+ * Detiene un canal sin completar su transferencia, como CHAN_ABORT: no interrumpe ni dispara al
+ * canal encadenado.
+ */
+void dma_sim_abort(dma_sim_t *dma, unsigned ch) {
+    dma->ch[ch].ctrl &= ~DMA_SIM_CTRL_BUSY;
+}
+
+/**
+ * Siguiente dirección después de una transferencia de size bytes. Con anillo de ring_bits solo
+ * cambian los ring_bits bits bajos, así que la dirección vuelve al inicio del bloque alineado.
+ */
+static inline uintptr_t next_addr(uintptr_t addr, unsigned size, unsigned ring_bits) {
+    uintptr_t next = addr + size;
+
+    if (ring_bits) {
+        uintptr_t mask = ((uintptr_t)1 << ring_bits) - 1;
+        next = (addr & ~mask) | (next & mask);
+    }
+    return next;
+}
+
+static void transfer(dma_sim_t *dma, unsigned ch) {
+    dma_sim_channel_t *c = &dma->ch[ch];
+    unsigned size = 1u << ((c->ctrl >> DMA_SIM_CTRL_DATA_SIZE_LSB) & 3);
+    unsigned ring_bits = (c->ctrl >> DMA_SIM_CTRL_RING_SIZE_LSB) & 0xF;
+    bool ring_write = c->ctrl & DMA_SIM_CTRL_RING_SEL;
+    uint32_t value = 0;
+
+    if (!dma->port.read || !dma->port.read(dma->port.ctx, c->read_addr, &value, size)) {
+        memcpy(&value, (const void *)c->read_addr, size);
+    }
+    if (!dma->port.write || !dma->port.write(dma->port.ctx, c->write_addr, value, size)) {
+        memcpy((void *)c->write_addr, &value, size);
+    }
+    if (c->ctrl & DMA_SIM_CTRL_INCR_READ) {
+        c->read_addr = next_addr(c->read_addr, size, ring_write ? 0 : ring_bits);
+    }
+    if (c->ctrl & DMA_SIM_CTRL_INCR_WRITE) {
+        c->write_addr = next_addr(c->write_addr, size, ring_write ? ring_bits : 0);
+    }
+    c->transfers++;
+
+    if (--c->transfer_count) {
+        return;
+    }
+    c->ctrl &= ~DMA_SIM_CTRL_BUSY;
+    c->completions++;
+    if (!(c->ctrl & DMA_SIM_CTRL_IRQ_QUIET)) {
+        dma->intr |= 1u << ch;
+    }
+    unsigned chain = (c->ctrl >> DMA_SIM_CTRL_CHAIN_TO_LSB) & 0xF;
+    if (chain != ch && chain < DMA_SIM_CHANNELS) {
+        dma_sim_trigger(dma, chain);
+    }
+}
+
+/**
+ * Hace las transferencias que permiten los DREQ en el ciclo actual, alternando entre los canales
+ * ocupados como el árbitro del hardware. Un canal disparado por encadenamiento empieza en la
+ * misma llamada.
+ * @return Transferencias hechas.
+ */
+unsigned dma_sim_service(dma_sim_t *dma) {
+    unsigned done = 0;
+    bool progress = true;
+
+    while (progress && done < DMA_SIM_MAX_PER_SERVICE) {
+        progress = false;
+        for (unsigned ch = 0; ch < DMA_SIM_CHANNELS; ++ch) {
+            const dma_sim_channel_t *c = &dma->ch[ch];
+            if (!(c->ctrl & DMA_SIM_CTRL_BUSY)) {
+                continue;
+            }
+            unsigned treq = (c->ctrl >> DMA_SIM_CTRL_TREQ_SEL_LSB) & 0x3F;
+            if (treq != DMA_SIM_DREQ_FORCE && (!dma->port.dreq || !dma->port.dreq(dma->port.ctx, treq))) {
+                continue;
+            }
+            transfer(dma, ch);
+            progress = true;
+            done++;
+        }
+    }
+    return done;
+}
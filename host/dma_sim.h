@@ -0,0 +1,105 @@
+/**
+ * @file dma_sim.h
+ *
+ * @brief Modelo de los canales de DMA del RP2040 para las herramientas de la máquina anfitriona.
+ *
+ * Cada canal tiene los registros que usa el firmware, con la misma disposición de bits en CTRL
+ * que el hardware (DMA_CH0_CTRL_TRIG_*): dirección de lectura y de escritura, cuenta de
+ * transferencias, tamaño de 1, 2 o 4 bytes, incremento de cada dirección, modo anillo sobre la
+ * lectura o la escritura, encadenamiento, DREQ, IRQ_QUIET y BUSY. Como en el hardware, escribir la
+ * cuenta con dma_sim_set_trans_count() fija el valor que se recarga en cada disparo, y el registro
+ * transfer_count muestra lo que falta del disparo en curso; así un canal reencadenado vuelve a
+ * transferir la cuenta completa. Al terminar, el canal pone su bit en intr (salvo con IRQ_QUIET) y
+ * dispara al canal de chain_to si no es él mismo.
+ *
+ * Las direcciones son punteros de la máquina anfitriona. Las lecturas y escrituras que caen en
+ * un periférico simulado (por ejemplo, el FIFO TX de una máquina de pio_sim) las resuelve el
+ * puerto; el resto va a la memoria. dma_sim_service() hace todas las transferencias que los DREQ
+ * permiten en el ciclo actual: el ancho de banda del bus y la latencia de unos pocos ciclos entre
+ * el DREQ y la escritura no se modelan, y un canal sin DREQ (DMA_SIM_DREQ_FORCE) termina en el
+ * mismo ciclo en que se dispara.
+ */
+
+#ifndef DMA_SIM_H
+#define DMA_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DMA_SIM_CHANNELS 12 ///< Canales del RP2040
+
+#define DMA_SIM_CTRL_EN (1u << 0) ///< Canal habilitado
+#define DMA_SIM_CTRL_DATA_SIZE_LSB 2 ///< Tamaño: 0 = byte, 1 = media palabra, 2 = palabra
+#define DMA_SIM_CTRL_INCR_READ (1u << 4) ///< Incrementar la dirección de lectura
+#define DMA_SIM_CTRL_INCR_WRITE (1u << 5) ///< Incrementar la dirección de escritura
+#define DMA_SIM_CTRL_RING_SIZE_LSB 6 ///< log2 del tamaño del anillo en bytes (0 = sin anillo)
+#define DMA_SIM_CTRL_RING_SEL (1u << 10) ///< El anillo se aplica a la escritura en lugar de la lectura
+#define DMA_SIM_CTRL_CHAIN_TO_LSB 11 ///< Canal que se dispara al terminar (el mismo = ninguno)
+#define DMA_SIM_CTRL_TREQ_SEL_LSB 15 ///< DREQ que marca el ritmo
+#define DMA_SIM_CTRL_IRQ_QUIET (1u << 21) ///< No interrumpir al terminar
+#define DMA_SIM_CTRL_BUSY (1u << 24) ///< Transferencia en curso (solo lectura)
+
+#define DMA_SIM_DREQ_FORCE 0x3F ///< Sin DREQ: transferir sin esperar
+
+/**
+ * Registros de un canal.
+ */
+typedef struct {
+    uintptr_t read_addr; ///< Próxima dirección de lectura
+    uintptr_t write_addr; ///< Próxima dirección de escritura
+    uint32_t transfer_count; ///< Transferencias que faltan en el disparo en curso
+    union {
+        uint32_t ctrl; ///< CTRL, con los bits de DMA_SIM_CTRL_*
+        uint32_t al1_ctrl; ///< El mismo registro con el nombre del alias sin disparo del SDK
+    };
+    uint32_t trans_count_reload; ///< Cuenta que se carga en cada disparo
+    uint64_t transfers; ///< Transferencias hechas desde dma_sim_init()
+    uint64_t completions; ///< Disparos terminados
+} dma_sim_channel_t;
+
+/**
+ * Conexión del DMA con los periféricos simulados.
+ */
+typedef struct {
+    void *ctx; ///< Contexto para las funciones
+    bool (*dreq)(void *ctx, unsigned dreq); ///< El periférico acepta o entrega otra transferencia
+    bool (*write)(void *ctx, uintptr_t addr, uint32_t value, unsigned size); ///< true si addr es de un periférico y la escritura se hizo
+    bool (*read)(void *ctx, uintptr_t addr, uint32_t *value, unsigned size); ///< true si addr es de un periférico y la lectura se hizo
+} dma_sim_port_t;
+
+/**
+ * Controlador de DMA.
+ */
+typedef struct {
+    dma_sim_channel_t ch[DMA_SIM_CHANNELS]; ///< Canales
+    uint32_t intr; ///< Fin de transferencia pendiente, un bit por canal
+    uint32_t inte0, inte1; ///< Canales habilitados en DMA_IRQ_0 y DMA_IRQ_1
+    dma_sim_port_t port; ///< Periféricos
+} dma_sim_t;
+
+void dma_sim_init(dma_sim_t *dma, const dma_sim_port_t *port);
+
+void dma_sim_set_trans_count(dma_sim_t *dma, unsigned ch, uint32_t count, bool trigger);
+
+void dma_sim_trigger(dma_sim_t *dma, unsigned ch);
+
+void dma_sim_abort(dma_sim_t *dma, unsigned ch);
+
+unsigned dma_sim_service(dma_sim_t *dma);
+
+/**
+ * El canal tiene una transferencia en curso.
+ */
+static inline bool dma_sim_busy(const dma_sim_t *dma, unsigned ch) {
+    return dma->ch[ch].ctrl & DMA_SIM_CTRL_BUSY;
+}
+
+/**
+ * Canales con el fin de transferencia pendiente en DMA_IRQ_0 (irq = 0) o DMA_IRQ_1 (irq = 1),
+ * como el registro INTS.
+ */
+static inline uint32_t dma_sim_ints(const dma_sim_t *dma, unsigned irq) {
+    return dma->intr & (irq ? dma->inte1 : dma->inte0);
+}
+
+#endif
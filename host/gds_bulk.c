@@ -0,0 +1,716 @@
+/**
+ * @file gds_bulk.c
+ *
+ * @brief Cliente del protocolo de tramas binarias (siggen/bulk_proto.h): carga tablas en el
+ * generador y mide la latencia y el caudal por la interfaz bulk, por la consola CDC o contra el
+ * receptor en el mismo proceso.
+ *
+ * Transportes:
+ *  - Por defecto, la interfaz bulk del generador (usb_bulk.h) con libusb. El Makefile compila este
+ *    camino solo si pkg-config encuentra libusb-1.0.
+ *  - Con -d, la consola CDC: se envía "!bulk cdc", se espera "@BINARY" y las mismas tramas van por
+ *    el puerto serie en modo crudo. Sirve para comparar el caudal de los dos caminos con -s.
+ *  - Con -L, el receptor de siggen/bulk_proto.c en este proceso, detrás de un endpoint simulado
+ *    que reparte cada escritura en paquetes de 64 bytes como el USB de velocidad completa (termina
+ *    la transferencia con un paquete corto o al completarla, y falla si un paquete no entra) y con
+ *    un destino que ofrece ventanas de página como wave_store.c. Sin operaciones ejecuta una prueba
+ *    del protocolo: tramas de largo, banderas y trozos de escritura aleatorios cuyas tablas tienen
+ *    que llegar intactas, y tramas con CRC incorrecto, encabezado inválido, operación desconocida y
+ *    tabla demasiado grande, después de las cuales el receptor tiene que seguir respondiendo.
+ *
+ * Cada trama espera su respuesta antes de la siguiente. Al final se envía END (la consola vuelve al
+ * modo texto). El caudal se informa medido en el host, de la primera escritura a la última
+ * respuesta, y según el dispositivo, sumando el tiempo de cada trama desde el encabezado hasta el
+ * último byte.
+ *
+ * Uso: gds_bulk [-d PUERTO | -L] [-p N] [-s MB] [-c BYTES] [-n] [-t ARCHIVO [-k] [-r HZ]] [-q SEMILLA]
+ *  - -d PUERTO  Usar la consola CDC de PUERTO (por ejemplo /dev/ttyACM0).
+ *  - -L         Usar el receptor en el mismo proceso.
+ *  - -p N       Enviar N tramas PING e informar la latencia de ida y vuelta.
+ *  - -s MB      Enviar MB megabytes en tramas SINK e informar el caudal.
+ *  - -c BYTES   Carga por trama SINK (por defecto 65536).
+ *  - -n         Sin CRC de la carga (el dispositivo no lo calcula).
+ *  - -t ARCHIVO Convertir un CSV o WAV (siggen/wave_import.h) y cargarlo como tabla, que queda sonando.
+ *  - -k         Los valores del CSV son códigos del DAC.
+ *  - -r HZ      Frecuencia de muestreo de la tabla (por defecto la del WAV; 0 = una muestra por muestra de salida).
+ *  - -q SEMILLA Semilla de la prueba de -L (por defecto 1).
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef GDS_BULK_LIBUSB
+#include <libusb.h>
+#endif
+#include "../siggen/bulk_proto.h"
+#include "../siggen/crc32.h"
+#include "../siggen/wave_import.h"
+
+#define BULK_VID 0x2E8A ///< USB_DEV_VID de usb_dev.h
+#define BULK_PID 0x000A ///< USB_DEV_PID de usb_dev.h
+#define BULK_TIMEOUT_MS 5000 ///< Espera máxima de cada escritura y respuesta
+#define BULK_WRITE_CHUNK (64 * 1024) ///< Bytes por escritura de la carga (múltiplo de 64)
+#define LOOP_PAGE 256 ///< Página de la flash que imita el destino de -L
+#define LOOP_TABLE_OFFSET 64 ///< Posición de la tabla en la primera página, como WAVE_STORE_IMPORT_TABLE
+#define LOOP_TABLE_MAX (512 * 1024 - 80) ///< Muestras que entran en el destino de -L
+#define LOOP_REPLIES 8 ///< Respuestas pendientes del receptor de -L
+
+/**
+ * Tabla del receptor de -L.
+ */
+typedef struct {
+    uint8_t data[LOOP_TABLE_MAX]; ///< Muestras
+    size_t count; ///< Muestras recibidas
+    bool done; ///< La última trama TABLE terminó bien
+} loop_table_t;
+
+typedef struct transport transport_t;
+
+/**
+ * Camino hasta el receptor.
+ */
+struct transport {
+    const char *name; ///< Nombre para los reportes
+    bool (*send)(transport_t *t, const uint8_t *data, size_t len); ///< Una escritura (una transferencia USB)
+    bool (*recv)(transport_t *t, bulk_reply_t *reply); ///< Espera la próxima respuesta
+    int fd; ///< Consola
+#ifdef GDS_BULK_LIBUSB
+    libusb_context *usb; ///< Contexto de libusb
+    libusb_device_handle *dev; ///< Generador
+    uint8_t ep_out, ep_in; ///< Endpoints de la interfaz bulk
+#endif
+    // -L
+    bulk_proto_t *proto; ///< Receptor
+    uint8_t *armed; ///< Transferencia programada por el receptor, o NULL
+    size_t armed_len; ///< Su largo
+    size_t armed_got; ///< Bytes recibidos en ella
+    bulk_reply_t replies[LOOP_REPLIES]; ///< Respuestas sin leer
+    unsigned reply_head, reply_tail; ///< Cola de respuestas
+    unsigned overflows; ///< Paquetes que no entraban en la transferencia programada
+};
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t now_us(void) {
+    return (uint32_t)(uint64_t)(now_s() * 1e6);
+}
+
+// --- Receptor en el mismo proceso (-L) ---
+
+static bool loop_begin(void *ctx, const bulk_header_t *head) {
+    loop_table_t *tab = (loop_table_t *)ctx;
+
+    tab->count = 0;
+    tab->done = false;
+    return head->len != 0;
+}
+
+/**
+ * Como wave_store_import_window(): lo que falta de la página en curso, acotado a lo que entra.
+ */
+static uint8_t *loop_window(void *ctx, size_t *len) {
+    loop_table_t *tab = (loop_table_t *)ctx;
+    size_t page_free = LOOP_PAGE - (LOOP_TABLE_OFFSET + tab->count) % LOOP_PAGE;
+    size_t room = LOOP_TABLE_MAX - tab->count;
+
+    *len = page_free < room ? page_free : room;
+    return tab->data + tab->count;
+}
+
+static void loop_commit(void *ctx, size_t len) {
+    ((loop_table_t *)ctx)->count += len;
+}
+
+static bool loop_end(void *ctx, const bulk_header_t *head, bool ok) {
+    (void)head;
+    ((loop_table_t *)ctx)->done = ok;
+    return ok;
+}
+
+static const bulk_target_t loop_target = {
+    .begin = loop_begin,
+    .window = loop_window,
+    .commit = loop_commit,
+    .end = loop_end,
+};
+
+/**
+ * Un paquete llega al endpoint simulado: se copia en la transferencia programada, que termina al
+ * completarse o con un paquete corto.
+ */
+static void loop_packet(transport_t *t, const uint8_t *data, size_t len) {
+    if (!t->armed) {
+        t->armed = bulk_proto_rx_buf(t->proto, &t->armed_len);
+        t->armed_got = 0;
+    }
+    if (len > t->armed_len - t->armed_got) {
+        t->overflows++;
+        len = t->armed_len - t->armed_got;
+    }
+    memcpy(t->armed + t->armed_got, data, len);
+    t->armed_got += len;
+    if (t->armed_got == t->armed_len || len < BULK_PACKET_SIZE) {
+        t->armed = NULL;
+        if (bulk_proto_rx_done(t->proto, t->armed_got, now_us())) {
+            t->replies[t->reply_head++ % LOOP_REPLIES] = t->proto->last;
+        }
+    }
+}
+
+static bool loop_send(transport_t *t, const uint8_t *data, size_t len) {
+    for (size_t pos = 0; pos < len; pos += BULK_PACKET_SIZE) {
+        loop_packet(t, data + pos, len - pos < BULK_PACKET_SIZE ? len - pos : BULK_PACKET_SIZE);
+    }
+    return true;
+}
+
+static bool loop_recv(transport_t *t, bulk_reply_t *reply) {
+    if (t->reply_tail == t->reply_head) {
+        return false;
+    }
+    *reply = t->replies[t->reply_tail++ % LOOP_REPLIES];
+    return true;
+}
+
+// --- Consola CDC (-d) ---
+
+/**
+ * Espera hasta timeout_ms a que el puerto tenga datos.
+ */
+static bool tty_wait(int fd, int timeout_ms) {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    return poll(&pfd, 1, timeout_ms) > 0;
+}
+
+static bool tty_send(transport_t *t, const uint8_t *data, size_t len) {
+    while (len) {
+        ssize_t n = write(t->fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("write");
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Busca la magia de la respuesta en lo que llega; lo anterior (texto de la consola) se descarta.
+ */
+static bool tty_recv(transport_t *t, bulk_reply_t *reply) {
+    uint8_t buf[BULK_REPLY_LEN];
+    size_t have = 0;
+    double deadline = now_s() + BULK_TIMEOUT_MS / 1000.0;
+
+    while (now_s() < deadline) {
+        if (!tty_wait(t->fd, 100)) {
+            continue;
+        }
+        ssize_t n = read(t->fd, buf + have, have < 4 ? 1 : sizeof(buf) - have);
+        if (n <= 0) {
+            continue;
+        }
+        have += (size_t)n;
+        if (have <= 4 && buf[have - 1] != (uint8_t)(BULK_REPLY_MAGIC >> (8 * (have - 1)))) {
+            // El byte que no coincide puede ser el principio de la magia
+            have = buf[have - 1] == (uint8_t)BULK_REPLY_MAGIC;
+            buf[0] = (uint8_t)BULK_REPLY_MAGIC;
+        } else if (have == sizeof(buf)) {
+            return bulk_reply_parse(buf, reply);
+        }
+    }
+    return false;
+}
+
+/**
+ * Abre la consola en modo crudo y la pasa a modo binario.
+ */
+static bool tty_open(transport_t *t, const char *path) {
+    struct termios tio;
+    char line[128];
+    size_t len = 0;
+    double deadline;
+
+    t->fd = open(path, O_RDWR | O_NOCTTY);
+    if (t->fd < 0) {
+        perror(path);
+        return false;
+    }
+    if (tcgetattr(t->fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(t->fd, TCSANOW, &tio);
+        tcflush(t->fd, TCIFLUSH);
+    }
+    // El fin de línea previo termina cualquier línea a medias que haya dejado otro programa
+    if (!tty_send(t, (const uint8_t *)"\n!bulk cdc\n", 11)) {
+        return false;
+    }
+    deadline = now_s() + BULK_TIMEOUT_MS / 1000.0;
+    while (now_s() < deadline) {
+        char c;
+        if (!tty_wait(t->fd, 100) || read(t->fd, &c, 1) != 1) {
+            continue;
+        }
+        if (c == '\n' || c == '\r') {
+            line[len] = '\0';
+            if (strcmp(line, "@BINARY") == 0) {
+                t->send = tty_send;
+                t->recv = tty_recv;
+                t->name = "consola";
+                return true;
+            }
+            len = 0;
+        } else if (len < sizeof(line) - 1) {
+            line[len++] = c;
+        }
+    }
+    fprintf(stderr, "%s: la consola no pasó a modo binario (¿firmware sin !bulk?)\n", path);
+    return false;
+}
+
+// --- Interfaz bulk con libusb ---
+
+#ifdef GDS_BULK_LIBUSB
+static bool usb_send(transport_t *t, const uint8_t *data, size_t len) {
+    int done = 0;
+    int r = libusb_bulk_transfer(t->dev, t->ep_out, (unsigned char *)data, (int)len, &done, BULK_TIMEOUT_MS);
+
+    if (r != 0 || (size_t)done != len) {
+        fprintf(stderr, "libusb: %s\n", libusb_error_name(r));
+        return false;
+    }
+    return true;
+}
+
+static bool usb_recv(transport_t *t, bulk_reply_t *reply) {
+    uint8_t buf[BULK_PACKET_SIZE];
+    int got = 0;
+    int r = libusb_bulk_transfer(t->dev, t->ep_in, buf, sizeof(buf), &got, BULK_TIMEOUT_MS);
+
+    return r == 0 && got == BULK_REPLY_LEN && bulk_reply_parse(buf, reply);
+}
+
+/**
+ * Abre el generador y toma su interfaz de clase 0xFF.
+ */
+static bool usb_open(transport_t *t) {
+    struct libusb_config_descriptor *config;
+    int itf = -1;
+
+    if (libusb_init(&t->usb) != 0) {
+        fprintf(stderr, "libusb: no se pudo iniciar\n");
+        return false;
+    }
+    t->dev = libusb_open_device_with_vid_pid(t->usb, BULK_VID, BULK_PID);
+    if (!t->dev) {
+        fprintf(stderr, "No se encontró el generador %04x:%04x (¿permisos?)\n", BULK_VID, BULK_PID);
+        return false;
+    }
+    if (libusb_get_active_config_descriptor(libusb_get_device(t->dev), &config) != 0) {
+        return false;
+    }
+    for (int i = 0; i < config->bNumInterfaces && itf < 0; ++i) {
+        const struct libusb_interface_descriptor *d = &config->interface[i].altsetting[0];
+        if (d->bInterfaceClass != LIBUSB_CLASS_VENDOR_SPEC || d->bNumEndpoints != 2) {
+            continue;
+        }
+        itf = d->bInterfaceNumber;
+        for (int e = 0; e < 2; ++e) {
+            uint8_t addr = d->endpoint[e].bEndpointAddress;
+            if (addr & LIBUSB_ENDPOINT_IN) {
+                t->ep_in = addr;
+            } else {
+                t->ep_out = addr;
+            }
+        }
+    }
+    libusb_free_config_descriptor(config);
+    if (itf < 0) {
+        fprintf(stderr, "El generador no tiene la interfaz bulk (firmware anterior)\n");
+        return false;
+    }
+    if (libusb_claim_interface(t->dev, itf) != 0) {
+        fprintf(stderr, "No se pudo tomar la interfaz %d\n", itf);
+        return false;
+    }
+    t->send = usb_send;
+    t->recv = usb_recv;
+    t->name = "bulk";
+    return true;
+}
+#endif
+
+// --- Tramas ---
+
+/**
+ * Envía una trama: el encabezado en una escritura y la carga en escrituras de chunk bytes.
+ */
+static bool send_frame(transport_t *t, uint8_t op, uint16_t seq, const uint8_t *data, size_t len, uint32_t arg,
+                       bool crc, size_t chunk) {
+    uint8_t hdr[BULK_HEADER_LEN];
+    bulk_header_t head = {
+        .op = op,
+        .flags = crc ? BULK_FLAG_CRC : 0,
+        .seq = seq,
+        .len = (uint32_t)len,
+        .arg = arg,
+        .crc = crc ? crc32_compute(data, len) : 0,
+    };
+
+    bulk_header_pack(hdr, &head);
+    if (!t->send(t, hdr, sizeof(hdr))) {
+        return false;
+    }
+    for (size_t pos = 0; pos < len; pos += chunk) {
+        if (!t->send(t, data + pos, len - pos < chunk ? len - pos : chunk)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Envía una trama y espera su respuesta.
+ * @return false si no hubo respuesta o no corresponde a la trama.
+ */
+static bool transact(transport_t *t, uint8_t op, uint16_t seq, const uint8_t *data, size_t len, uint32_t arg,
+                     bool crc, size_t chunk, bulk_reply_t *reply) {
+    if (!send_frame(t, op, seq, data, len, arg, crc, chunk)) {
+        return false;
+    }
+    if (!t->recv(t, reply)) {
+        fprintf(stderr, "%s: sin respuesta a la trama %u\n", t->name, seq);
+        return false;
+    }
+    if (reply->seq != seq && reply->status != BULK_ERR_HEADER) {
+        fprintf(stderr, "%s: respuesta a la trama %u en lugar de la %u\n", t->name, reply->seq, seq);
+        return false;
+    }
+    return true;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * PING: latencia de ida y vuelta de una trama sin carga.
+ */
+static bool run_ping(transport_t *t, unsigned count, uint16_t *seq) {
+    double *lat = malloc(count * sizeof(double));
+    double sum = 0;
+    bulk_reply_t reply;
+
+    for (unsigned i = 0; i < count; ++i) {
+        double t0 = now_s();
+        if (!transact(t, BULK_OP_PING, (*seq)++, NULL, 0, 0, false, 1, &reply)) {
+            free(lat);
+            return false;
+        }
+        lat[i] = (now_s() - t0) * 1e6;
+        sum += lat[i];
+    }
+    qsort(lat, count, sizeof(double), cmp_double);
+    printf("%s: %u PING, latencia mínima %.0f us, mediana %.0f us, máxima %.0f us, media %.0f us\n", t->name, count,
+           lat[0], lat[count / 2], lat[count - 1], sum / count);
+    free(lat);
+    return true;
+}
+
+/**
+ * SINK: caudal con tramas de chunk bytes que el dispositivo descarta.
+ */
+static bool run_sink(transport_t *t, double megabytes, size_t frame, bool crc, uint16_t *seq) {
+    uint64_t total = (uint64_t)(megabytes * 1e6);
+    uint8_t *data = malloc(frame);
+    uint64_t sent = 0, device_us = 0;
+    unsigned frames = 0;
+    bulk_reply_t reply;
+
+    for (size_t i = 0; i < frame; ++i) {
+        data[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+    double t0 = now_s();
+    while (sent < total) {
+        size_t len = total - sent < frame ? (size_t)(total - sent) : frame;
+        if (!transact(t, BULK_OP_SINK, (*seq)++, data, len, 0, crc, BULK_WRITE_CHUNK, &reply)) {
+            free(data);
+            return false;
+        }
+        if (reply.status != BULK_OK || reply.count != len) {
+            fprintf(stderr, "%s: SINK %s, %u de %zu bytes\n", t->name, bulk_status_name(reply.status), reply.count, len);
+            free(data);
+            return false;
+        }
+        sent += len;
+        device_us += reply.elapsed_us;
+        frames++;
+    }
+    double secs = now_s() - t0;
+    printf("%s: %.2f MB en %u tramas de %zu bytes%s, %.3f s: %.0f kB/s (dispositivo %.0f kB/s)\n", t->name,
+           sent / 1e6, frames, frame, crc ? " con CRC" : "", secs, sent / secs / 1e3,
+           device_us ? sent * 1e3 / device_us : 0.0);
+    free(data);
+    return true;
+}
+
+/**
+ * Códigos convertidos del archivo de -t.
+ */
+typedef struct {
+    uint8_t *codes; ///< Códigos
+    size_t count; ///< Códigos en codes
+    size_t cap; ///< Capacidad de codes
+} codes_t;
+
+static void collect(void *ctx, const uint8_t *codes, size_t count) {
+    codes_t *c = (codes_t *)ctx;
+
+    if (c->count + count > c->cap) {
+        c->cap = (c->count + count) * 2;
+        c->codes = realloc(c->codes, c->cap);
+    }
+    memcpy(c->codes + c->count, codes, count);
+    c->count += count;
+}
+
+/**
+ * TABLE: convierte el archivo y lo carga como tabla.
+ * @param rate Frecuencia de muestreo de la tabla, o -1 para tomar la del WAV.
+ */
+static bool run_table(transport_t *t, const char *path, bool codes_csv, long rate, bool crc, uint16_t *seq) {
+    FILE *f = fopen(path, "rb");
+    static wave_import_t parser;
+    codes_t out = { 0 };
+    uint8_t buf[4096];
+    size_t n;
+    bulk_reply_t reply;
+
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    n = fread(buf, 1, sizeof(buf), f);
+    wave_import_init(&parser, wave_import_detect(buf, n < WAVE_IMPORT_DETECT_LEN ? n : WAVE_IMPORT_DETECT_LEN),
+                     codes_csv, collect, &out);
+    if (parser.format == WAVE_IMPORT_NONE) {
+        fprintf(stderr, "%s: no es CSV ni WAV\n", path);
+        fclose(f);
+        return false;
+    }
+    do {
+        wave_import_feed(&parser, buf, n);
+    } while ((n = fread(buf, 1, sizeof(buf), f)) > 0);
+    fclose(f);
+    wave_import_status_t status = wave_import_finish(&parser);
+    if (status != WAVE_IMPORT_END || !out.count) {
+        fprintf(stderr, "%s: %s, %zu muestras\n", path, wave_import_status_name(status), out.count);
+        free(out.codes);
+        return false;
+    }
+
+    uint32_t arg = rate >= 0 ? (uint32_t)rate : parser.sample_rate;
+    double t0 = now_s();
+    bool ok = transact(t, BULK_OP_TABLE, (*seq)++, out.codes, out.count, arg, crc, BULK_WRITE_CHUNK, &reply);
+    double secs = now_s() - t0;
+    if (ok) {
+        printf("%s: %s, %zu muestras a %u Hz: %s en %.3f s (%.0f kB/s; dispositivo %u us)\n", t->name, path, out.count,
+               arg, bulk_status_name(reply.status), secs, out.count / secs / 1e3, reply.elapsed_us);
+        ok = reply.status == BULK_OK;
+    }
+    free(out.codes);
+    return ok;
+}
+
+/**
+ * Prueba del protocolo contra el receptor en el mismo proceso.
+ */
+static bool self_test(transport_t *t, loop_table_t *tab, unsigned seed) {
+    size_t max_len = 40000;
+    uint8_t *data = malloc(LOOP_TABLE_MAX + 1000);
+    uint16_t seq = 1;
+    unsigned frames = 0, failures = 0;
+    uint64_t table_bytes = 0;
+    bulk_reply_t reply;
+
+    srand(seed);
+    for (size_t i = 0; i < LOOP_TABLE_MAX + 1000; ++i) {
+        data[i] = (uint8_t)rand();
+    }
+#define CHECK(cond, ...)                                                                   \
+    do {                                                                                   \
+        if (!(cond)) {                                                                     \
+            fprintf(stderr, "trama %u: ", seq - 1);                                        \
+            fprintf(stderr, __VA_ARGS__);                                                  \
+            fprintf(stderr, "\n");                                                         \
+            failures++;                                                                    \
+        }                                                                                  \
+    } while (0)
+
+    // Tramas válidas, con trozos de escritura de cualquier largo: los cortos terminan la
+    // transferencia a mitad de la carga y desalinean las ventanas del destino
+    for (unsigned i = 0; i < 300; ++i) {
+        uint8_t op = rand() % 8 == 0 ? BULK_OP_PING : rand() % 2 ? BULK_OP_SINK : BULK_OP_TABLE;
+        size_t len = op == BULK_OP_PING ? 0 : 1 + (size_t)rand() % max_len;
+        size_t chunk = rand() % 3 == 0 ? BULK_PACKET_SIZE * (1 + (size_t)rand() % 64) : 1 + (size_t)rand() % 3000;
+        size_t offset = (size_t)rand() % 1000;
+        bool crc = rand() % 4 != 0;
+
+        frames++;
+        if (!transact(t, op, seq++, data + offset, len, 0, crc, chunk, &reply)) {
+            failures++;
+            break;
+        }
+        CHECK(reply.status == BULK_OK, "%s", bulk_status_name(reply.status));
+        CHECK(reply.count == len, "%u de %zu bytes", reply.count, len);
+        CHECK(!crc || reply.crc == crc32_compute(data + offset, len), "CRC %08x", reply.crc);
+        if (op == BULK_OP_TABLE) {
+            CHECK(tab->done && tab->count == len && memcmp(tab->data, data + offset, len) == 0, "tabla distinta");
+            table_bytes += len;
+        }
+    }
+
+    // CRC incorrecto: la tabla se descarta
+    {
+        uint8_t hdr[BULK_HEADER_LEN];
+        bulk_header_t head = { BULK_OP_TABLE, BULK_FLAG_CRC, seq++, 1000, 0, crc32_compute(data, 1000) ^ 1 };
+        bulk_header_pack(hdr, &head);
+        frames++;
+        t->send(t, hdr, sizeof(hdr));
+        t->send(t, data, 1000);
+        CHECK(t->recv(t, &reply) && reply.status == BULK_ERR_CRC && !tab->done, "CRC incorrecto aceptado");
+    }
+
+    // Encabezado inválido, operación desconocida y tabla demasiado grande; después el receptor
+    // tiene que seguir respondiendo
+    frames++;
+    t->send(t, data, BULK_HEADER_LEN);
+    seq++;
+    CHECK(t->recv(t, &reply) && reply.status == BULK_ERR_HEADER, "encabezado inválido aceptado");
+    frames++;
+    CHECK(transact(t, 9, seq++, data, 5000, 0, true, 700, &reply) && reply.status == BULK_ERR_OP && reply.count == 5000,
+          "operación desconocida: %s", bulk_status_name(reply.status));
+    frames++;
+    CHECK(transact(t, BULK_OP_TABLE, seq++, data, LOOP_TABLE_MAX + 1000, 0, true, BULK_WRITE_CHUNK, &reply) &&
+          reply.status == BULK_ERR_FULL && !tab->done, "tabla demasiado grande: %s", bulk_status_name(reply.status));
+    frames++;
+    CHECK(transact(t, BULK_OP_PING, seq++, NULL, 0, 0, false, 1, &reply) && reply.status == BULK_OK,
+          "sin respuesta después de los errores");
+    CHECK(t->overflows == 0, "%u paquetes no entraron en la transferencia programada", t->overflows);
+#undef CHECK
+
+    printf("%u tramas, %.1f MB de tablas, %.1f%% copiado por el búfer intermedio, %u paquetes desbordados: %s\n",
+           frames, table_bytes / 1e6, table_bytes ? t->proto->bounced_bytes * 100.0 / table_bytes : 0.0, t->overflows,
+           failures ? "FALLÓ" : "bien");
+    free(data);
+    return failures == 0;
+}
+
+int main(int argc, char **argv) {
+    static transport_t t;
+    static bulk_proto_t proto;
+    static loop_table_t table;
+    const char *port = NULL, *table_path = NULL;
+    bool loopback = false, crc = true, codes_csv = false, ok = true;
+    unsigned pings = 0, seed = 1;
+    double megabytes = 0;
+    size_t frame = 65536;
+    long rate = -1;
+    uint16_t seq = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:Lp:s:c:nt:kr:q:")) != -1) {
+        switch (opt) {
+            case 'd': port = optarg; break;
+            case 'L': loopback = true; break;
+            case 'p': pings = (unsigned)atoi(optarg); break;
+            case 's': megabytes = atof(optarg); break;
+            case 'c': frame = (size_t)atol(optarg); break;
+            case 'n': crc = false; break;
+            case 't': table_path = optarg; break;
+            case 'k': codes_csv = true; break;
+            case 'r': rate = atol(optarg); break;
+            case 'q': seed = (unsigned)atoi(optarg); break;
+            default:
+                fprintf(stderr, "Uso: %s [-d PUERTO | -L] [-p N] [-s MB] [-c BYTES] [-n] [-t ARCHIVO [-k] [-r HZ]] "
+                                "[-q SEMILLA]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (!frame) {
+        frame = 1;
+    }
+
+    if (loopback) {
+        bulk_proto_init(&proto, false);
+        bulk_proto_set_target(&proto, BULK_OP_TABLE, &loop_target, &table);
+        t.proto = &proto;
+        t.send = loop_send;
+        t.recv = loop_recv;
+        t.name = "local";
+    } else if (port) {
+        if (!tty_open(&t, port)) {
+            return 1;
+        }
+    } else {
+#ifdef GDS_BULK_LIBUSB
+        if (!usb_open(&t)) {
+            return 1;
+        }
+#else
+        fprintf(stderr, "Compilado sin libusb: usar -d PUERTO o -L\n");
+        return 2;
+#endif
+    }
+
+    if (loopback && !pings && megabytes <= 0 && !table_path) {
+        ok = self_test(&t, &table, seed);
+    }
+    if (ok && pings) {
+        ok = run_ping(&t, pings, &seq);
+    }
+    if (ok && megabytes > 0) {
+        ok = run_sink(&t, megabytes, frame, crc, &seq);
+    }
+    if (ok && table_path) {
+        ok = run_table(&t, table_path, codes_csv, rate, crc, &seq);
+    }
+    if (loopback && (pings || megabytes > 0 || table_path)) {
+        printf("local: %llu bytes de carga, %llu copiados por el búfer intermedio\n", (unsigned long long)proto.bytes,
+               (unsigned long long)proto.bounced_bytes);
+    }
+
+    bulk_reply_t reply;
+    transact(&t, BULK_OP_END, seq, NULL, 0, 0, false, 1, &reply);
+#ifdef GDS_BULK_LIBUSB
+    if (t.dev) {
+        libusb_close(t.dev);
+        libusb_exit(t.usb);
+    }
+#endif
+    if (t.fd > 0) {
+        close(t.fd);
+    }
+    return ok ? 0 : 1;
+}
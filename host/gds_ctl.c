@@ -0,0 +1,771 @@
+/**
+ * @file gds_ctl.c
+ *
+ * @brief Opera muchos generadores a la vez por la consola USB: descubre las placas, les envía
+ * comandos en paralelo con E/S asíncrona (epoll) y agrega su telemetría.
+ *
+ * Cada placa se abre como un puerto serie sin bloqueo y se identifica con !id (respuesta "@ID,").
+ * Los comandos son líneas de consola: teclas como "A1500D" o comandos como "!status". Después de
+ * cada uno se envía "!ping N"; como la consola ejecuta las líneas en orden, la respuesta "@PONG,N"
+ * marca que el comando N terminó y da su latencia de ida y vuelta. Cada placa tiene hasta VENTANA
+ * comandos en vuelo, y todas avanzan a la vez en un solo hilo. Al final se informa, por placa, la
+ * cantidad de comandos y su latencia (mínima, percentiles del histograma de siggen/lat_hist.h,
+ * máxima y media), y el total de comandos por segundo entre todas las placas.
+ *
+ * Con -t se consulta "!tel" a todas las placas una vez por segundo y se imprime la suma de los
+ * bloques enviados y repetidos, y al final el último estado de cada placa. Sin comandos ni -t, las
+ * líneas se leen de la entrada estándar y cada una se envía a todas las placas, para usarlo como
+ * proceso de fondo alimentado por una tubería.
+ *
+ * Con -S o -X, después de los comandos se hace un arranque sincronizado (sync_start.h): !arm a
+ * todas las placas, espera a que todas queden armadas, !fire a la primera (con -S) o espera un
+ * disparo externo (con -X), y junta las líneas @SYNC de !sync. Se informa, por placa, el tiempo
+ * hasta quedar armada y hasta el arranque desde !arm, los ciclos desde el flanco hasta la primera
+ * muestra y el desfase respecto de la placa que arrancó primero.
+ *
+ * Sin -d ni -F se abren todos los /dev/ttyACM*. Con -F se arrancan PLACAS generadores simulados
+ * (host/gds_fake, en el mismo directorio que este programa) detrás de pseudoterminales, para probar
+ * todo en una sola máquina.
+ *
+ * Uso: gds_ctl [-d DISPOSITIVO]... [-F PLACAS] [-n REPETICIONES] [-w VENTANA] [-t SEGUNDOS] [-S | -X SEGUNDOS]
+ *              [-q] [comando...]
+ *  - -d DISPOSITIVO  Puerto de una placa; se puede repetir.
+ *  - -F PLACAS       Agregar PLACAS generadores simulados.
+ *  - -n REPETICIONES Enviar la lista de comandos esta cantidad de veces (por defecto 1).
+ *  - -w VENTANA      Comandos en vuelo por placa (por defecto 8, máximo 64).
+ *  - -t SEGUNDOS     Consultar la telemetría durante SEGUNDOS después de los comandos.
+ *  - -S              Arranque sincronizado con el disparo de la primera placa.
+ *  - -X SEGUNDOS     Arranque sincronizado con un disparo externo, esperándolo hasta SEGUNDOS.
+ *  - -q              No imprimir las respuestas de las placas.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "../siggen/lat_hist.h"
+
+#define CTL_MAX_BOARDS 256 ///< Placas por ejecución
+#define CTL_WINDOW_MAX 64 ///< Máximo de comandos en vuelo por placa
+#define CTL_OUT_MAX 8192 ///< Salida pendiente por placa
+#define CTL_ID_TIMEOUT_US 2000000 ///< Espera de la respuesta a !id
+#define CTL_CMD_TIMEOUT_US 5000000 ///< Espera de una respuesta @PONG antes de dar la placa por perdida
+#define CTL_TEL_PERIOD_US 1000000 ///< Periodo de la consulta de telemetría
+#define CTL_SYNC_POLL_US 50000 ///< Periodo de la consulta !sync mientras se espera un estado
+#define CTL_SYNC_ARM_TIMEOUT_US 2000000 ///< Espera del armado, y del arranque con el disparo propio
+
+typedef enum {
+    BOARD_PROBING, ///< Se envió !id y se espera @ID
+    BOARD_READY, ///< Identificada; recibe comandos
+    BOARD_FAILED, ///< No respondió o se desconectó
+} board_state_t;
+
+/**
+ * Telemetría de una placa, de la última línea @TEL.
+ */
+typedef struct {
+    bool valid; ///< Se recibió al menos una línea
+    long amplitude_uv; ///< Amplitud (uV)
+    long dc_offset_uv; ///< Desplazamiento DC (uV)
+    unsigned long long frequency_millihz; ///< Frecuencia (mHz)
+    int waveform; ///< Forma de onda
+    unsigned long blocks; ///< Bloques enviados al DAC
+    unsigned long underruns; ///< Bloques repetidos
+} board_tel_t;
+
+/**
+ * Arranque sincronizado de una placa, de la última línea @SYNC.
+ */
+typedef struct {
+    unsigned replies; ///< Líneas @SYNC recibidas
+    char state[16]; ///< Estado, con los nombres de sync_start.c
+    unsigned long arm_us; ///< Desde !arm hasta quedar armada
+    unsigned long start_us; ///< Desde !arm hasta el flanco
+    unsigned long cycles; ///< Ciclos desde el flanco hasta el arranque
+    unsigned long clk_hz; ///< Reloj del sistema
+    unsigned long sample_rate; ///< Frecuencia de muestreo
+} board_sync_t;
+
+/**
+ * Una placa conectada.
+ */
+typedef struct {
+    char path[64]; ///< Dispositivo
+    int fd; ///< Descriptor del puerto
+    board_state_t state; ///< Estado
+    char id[40]; ///< Identificador informado por @ID
+    char in[512]; ///< Línea recibida en construcción
+    size_t in_len; ///< Bytes en in
+    char out[CTL_OUT_MAX]; ///< Salida pendiente
+    size_t out_len; ///< Bytes en out
+    unsigned sent; ///< Comandos enviados
+    unsigned done; ///< Comandos terminados (@PONG recibido)
+    uint64_t sent_us[CTL_WINDOW_MAX]; ///< Instante de envío de cada comando en vuelo
+    uint64_t waiting_since_us; ///< Desde cuándo espera una respuesta
+    lat_hist_t latency; ///< Latencia de los comandos (uS)
+    uint64_t latency_total_us; ///< Suma de latencias, para la media
+    uint32_t latency_min_us; ///< Menor latencia
+    board_tel_t tel; ///< Última telemetría
+    board_sync_t sync; ///< Último arranque sincronizado
+} board_t;
+
+static board_t boards[CTL_MAX_BOARDS];
+static int board_count;
+static int epoll_fd;
+static bool quiet;
+static unsigned window = 8;
+
+/// Comandos que se envían a todas las placas, en orden
+static char **queue;
+static unsigned queue_len, queue_cap;
+static bool queue_closed; ///< No se agregarán más comandos
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static void queue_add(const char *cmd) {
+    if (queue_len == queue_cap) {
+        queue_cap = queue_cap ? 2 * queue_cap : 64;
+        queue = realloc(queue, queue_cap * sizeof(*queue));
+    }
+    queue[queue_len++] = strdup(cmd);
+}
+
+static void board_fail(board_t *b, const char *why) {
+    if (b->state == BOARD_FAILED) {
+        return;
+    }
+    fprintf(stderr, "%s (%s): %s\n", b->path, b->id[0] ? b->id : "sin identificar", why);
+    b->state = BOARD_FAILED;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, b->fd, NULL);
+    close(b->fd);
+}
+
+/**
+ * Envía lo pendiente que acepte el puerto y pide EPOLLOUT si queda algo.
+ */
+static void board_flush(board_t *b) {
+    size_t sent = 0;
+
+    while (sent < b->out_len) {
+        ssize_t n = write(b->fd, b->out + sent, b->out_len - sent);
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            board_fail(b, strerror(errno));
+            return;
+        }
+        if (n <= 0) {
+            break;
+        }
+        sent += (size_t)n;
+    }
+    memmove(b->out, b->out + sent, b->out_len - sent);
+    b->out_len -= sent;
+
+    struct epoll_event ev = { EPOLLIN | (b->out_len ? EPOLLOUT : 0), { .ptr = b } };
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, b->fd, &ev);
+}
+
+static bool board_send(board_t *b, const char *text) {
+    size_t len = strlen(text);
+
+    if (b->out_len + len > sizeof(b->out)) {
+        return false;
+    }
+    memcpy(b->out + b->out_len, text, len);
+    b->out_len += len;
+    return true;
+}
+
+/**
+ * Envía comandos de la cola mientras haya lugar en la ventana.
+ */
+static void board_pump(board_t *b) {
+    while (b->state == BOARD_READY && b->sent < queue_len && b->sent - b->done < window) {
+        char ping[32];
+        const char *cmd = queue[b->sent];
+
+        snprintf(ping, sizeof(ping), "!ping %u\n", b->sent);
+        if (b->out_len + strlen(cmd) + 1 + strlen(ping) > sizeof(b->out)) {
+            break;
+        }
+        if (b->sent == b->done) {
+            b->waiting_since_us = now_us();
+        }
+        board_send(b, cmd);
+        board_send(b, "\n");
+        board_send(b, ping);
+        b->sent_us[b->sent % CTL_WINDOW_MAX] = now_us();
+        b->sent++;
+    }
+    if (b->state != BOARD_FAILED) {
+        board_flush(b);
+    }
+}
+
+static void handle_line(board_t *b, char *line) {
+    if (strncmp(line, "@ID,", 4) == 0) {
+        char *end = strchr(line + 4, ',');
+        if (end) {
+            *end = '\0';
+        }
+        snprintf(b->id, sizeof(b->id), "%s", line + 4);
+        if (b->state == BOARD_PROBING) {
+            b->state = BOARD_READY;
+            b->latency.name = b->id;
+            board_pump(b);
+        }
+    } else if (strncmp(line, "@PONG,", 6) == 0) {
+        unsigned seq = (unsigned)strtoul(line + 6, NULL, 10);
+        // Solo cuentan las respuestas en orden; las de otra ejecución se ignoran
+        if (b->state == BOARD_READY && seq == b->done && seq < b->sent) {
+            uint64_t now = now_us();
+            uint32_t latency = (uint32_t)(now - b->sent_us[seq % CTL_WINDOW_MAX]);
+            lat_hist_add(&b->latency, latency);
+            b->latency_total_us += latency;
+            if (!b->done || latency < b->latency_min_us) {
+                b->latency_min_us = latency;
+            }
+            b->done++;
+            b->waiting_since_us = now;
+            board_pump(b);
+        }
+    } else if (strncmp(line, "@TEL,", 5) == 0) {
+        board_tel_t t = { .valid = true };
+        if (sscanf(line + 5, "%ld,%ld,%llu,%d,%lu,%lu", &t.amplitude_uv, &t.dc_offset_uv, &t.frequency_millihz,
+                   &t.waveform, &t.blocks, &t.underruns) == 6) {
+            b->tel = t;
+        }
+    } else if (strncmp(line, "@SYNC,", 6) == 0) {
+        board_sync_t t = { .replies = b->sync.replies + 1 };
+        if (sscanf(line + 6, "%15[^,],%lu,%lu,%lu,%lu,%lu", t.state, &t.arm_us, &t.start_us, &t.cycles, &t.clk_hz,
+                   &t.sample_rate) == 6) {
+            b->sync = t;
+        }
+    } else if (!quiet && line[0]) {
+        printf("[%s] %s\n", b->id[0] ? b->id : b->path, line);
+    }
+}
+
+static void board_read(board_t *b) {
+    char buf[1024];
+    ssize_t n;
+
+    while ((n = read(b->fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; ++i) {
+            char c = buf[i];
+            if (c == '\n') {
+                b->in[b->in_len] = '\0';
+                handle_line(b, b->in);
+                b->in_len = 0;
+            } else if (c != '\r' && b->in_len < sizeof(b->in) - 1) {
+                b->in[b->in_len++] = c;
+            }
+        }
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        board_fail(b, n == 0 ? "desconectada" : strerror(errno));
+    }
+}
+
+/**
+ * Abre una placa en modo crudo, descarta lo que haya en el búfer de entrada y le envía !id. El
+ * fin de línea previo termina cualquier línea a medias que haya dejado otro programa.
+ */
+static void board_open(const char *path) {
+    board_t *b;
+    struct termios tio;
+
+    if (board_count == CTL_MAX_BOARDS) {
+        fprintf(stderr, "%s: demasiadas placas\n", path);
+        return;
+    }
+    b = &boards[board_count];
+    memset(b, 0, sizeof(*b));
+    snprintf(b->path, sizeof(b->path), "%s", path);
+    b->fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (b->fd < 0) {
+        perror(path);
+        return;
+    }
+    if (tcgetattr(b->fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(b->fd, TCSANOW, &tio);
+        tcflush(b->fd, TCIFLUSH);
+    }
+    b->state = BOARD_PROBING;
+    b->latency.name = b->path;
+    board_count++;
+
+    struct epoll_event ev = { EPOLLIN, { .ptr = b } };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, b->fd, &ev);
+    board_send(b, "\n!id\n");
+    board_flush(b);
+}
+
+/**
+ * Arranca gds_fake con count placas y abre cada una.
+ * @return Descriptor de la tubería que mantiene vivo a gds_fake (cerrarlo lo termina), o -1.
+ */
+static int spawn_fake(const char *argv0, int count, pid_t *pid) {
+    char path[1024], arg[16];
+    const char *slash = strrchr(argv0, '/');
+    int to_child[2], from_child[2];
+
+    snprintf(path, sizeof(path), "%.*sgds_fake", slash ? (int)(slash - argv0 + 1) : 0, argv0);
+    if (!slash) {
+        snprintf(path, sizeof(path), "./gds_fake");
+    }
+    snprintf(arg, sizeof(arg), "%d", count);
+    if (pipe(to_child) != 0 || pipe(from_child) != 0) {
+        perror("pipe");
+        return -1;
+    }
+    *pid = fork();
+    if (*pid == 0) {
+        dup2(to_child[0], STDIN_FILENO);
+        dup2(from_child[1], STDOUT_FILENO);
+        close(to_child[1]);
+        close(from_child[0]);
+        execl(path, path, "-n", arg, (char *)NULL);
+        perror(path);
+        _exit(127);
+    }
+    close(to_child[0]);
+    close(from_child[1]);
+
+    FILE *f = fdopen(from_child[0], "r");
+    char line[256];
+    for (int i = 0; i < count && fgets(line, sizeof(line), f); ++i) {
+        line[strcspn(line, "\r\n")] = '\0';
+        board_open(line);
+    }
+    fclose(f);
+    return to_child[1];
+}
+
+/**
+ * Atiende los eventos de E/S durante como mucho timeout_ms. La entrada estándar, si se lee,
+ * agrega una línea a la cola por cada línea recibida.
+ */
+static void poll_once(int timeout_ms) {
+    struct epoll_event events[64];
+    int n = epoll_wait(epoll_fd, events, 64, timeout_ms);
+
+    for (int i = 0; i < n; ++i) {
+        board_t *b = events[i].data.ptr;
+        if (!b) {
+            static char pending[256];
+            static size_t pending_len;
+            char buf[256];
+            ssize_t len = read(STDIN_FILENO, buf, sizeof(buf));
+            if (len <= 0) {
+                queue_closed = true;
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, STDIN_FILENO, NULL);
+                continue;
+            }
+            for (ssize_t k = 0; k < len; ++k) {
+                if (buf[k] == '\n') {
+                    pending[pending_len] = '\0';
+                    if (pending_len) {
+                        queue_add(pending);
+                    }
+                    pending_len = 0;
+                } else if (buf[k] != '\r' && pending_len < sizeof(pending) - 1) {
+                    pending[pending_len++] = buf[k];
+                }
+            }
+            for (int k = 0; k < board_count; ++k) {
+                board_pump(&boards[k]);
+            }
+            continue;
+        }
+        if (b->state == BOARD_FAILED) {
+            continue;
+        }
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            board_read(b);
+        }
+        if (b->state != BOARD_FAILED && (events[i].events & EPOLLOUT)) {
+            board_flush(b);
+        }
+    }
+}
+
+static int count_state(board_state_t state) {
+    int count = 0;
+    for (int i = 0; i < board_count; ++i) {
+        count += boards[i].state == state;
+    }
+    return count;
+}
+
+/**
+ * Todas las placas activas terminaron la cola y no llegarán más comandos.
+ */
+static bool commands_done(void) {
+    if (!queue_closed) {
+        return false;
+    }
+    for (int i = 0; i < board_count; ++i) {
+        if (boards[i].state == BOARD_READY && boards[i].done < queue_len) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void check_timeouts(void) {
+    uint64_t now = now_us();
+
+    for (int i = 0; i < board_count; ++i) {
+        board_t *b = &boards[i];
+        if (b->state == BOARD_READY && b->sent > b->done && now - b->waiting_since_us > CTL_CMD_TIMEOUT_US) {
+            board_fail(b, "no responde a los comandos");
+        }
+    }
+}
+
+/**
+ * Consulta la telemetría durante seconds segundos e imprime la suma de cada ronda.
+ */
+static void run_telemetry(unsigned seconds) {
+    uint64_t start = now_us(), next = start;
+
+    for (unsigned round = 0; round <= seconds;) {
+        uint64_t now = now_us();
+        if (now < next) {
+            poll_once((int)((next - now + 999) / 1000));
+            continue;
+        }
+        if (round) {
+            unsigned long blocks = 0, underruns = 0;
+            int reporting = 0;
+            for (int i = 0; i < board_count; ++i) {
+                if (boards[i].state == BOARD_READY && boards[i].tel.valid) {
+                    blocks += boards[i].tel.blocks;
+                    underruns += boards[i].tel.underruns;
+                    reporting++;
+                }
+            }
+            printf("tel t=%us placas=%d/%d bloques=%lu repetidos=%lu\n", round, reporting, count_state(BOARD_READY),
+                   blocks, underruns);
+            fflush(stdout);
+        }
+        if (round++ == seconds) {
+            break;
+        }
+        for (int i = 0; i < board_count; ++i) {
+            if (boards[i].state == BOARD_READY && board_send(&boards[i], "!tel\n")) {
+                board_flush(&boards[i]);
+            }
+        }
+        next += CTL_TEL_PERIOD_US;
+    }
+}
+
+static void send_all(const char *text) {
+    for (int i = 0; i < board_count; ++i) {
+        if (boards[i].state == BOARD_READY && board_send(&boards[i], text)) {
+            board_flush(&boards[i]);
+        }
+    }
+}
+
+/**
+ * Consulta !sync hasta que todas las placas informen uno de los estados de la lista separada por
+ * comas, o hasta timeout_us.
+ * @return true si todas llegaron.
+ */
+static bool wait_sync(const char *states, uint64_t timeout_us) {
+    uint64_t deadline = now_us() + timeout_us;
+
+    for (;;) {
+        unsigned replies[CTL_MAX_BOARDS];
+        for (int i = 0; i < board_count; ++i) {
+            replies[i] = boards[i].sync.replies;
+        }
+        send_all("!sync\n");
+        uint64_t round_end = now_us() + CTL_SYNC_POLL_US;
+        bool all = true;
+        do {
+            poll_once(5);
+            all = true;
+            for (int i = 0; i < board_count; ++i) {
+                all &= boards[i].state != BOARD_READY || boards[i].sync.replies != replies[i];
+            }
+        } while (!all && now_us() < round_end);
+
+        bool reached = true;
+        for (int i = 0; i < board_count; ++i) {
+            const board_t *b = &boards[i];
+            if (b->state == BOARD_READY) {
+                size_t len = strlen(b->sync.state);
+                const char *p = strstr(states, b->sync.state);
+                reached &= len && p && (p == states || p[-1] == ',') && (p[len] == '\0' || p[len] == ',');
+            }
+        }
+        if (reached) {
+            return true;
+        }
+        if (now_us() >= deadline) {
+            return false;
+        }
+        while (now_us() < round_end) {
+            poll_once(5);
+        }
+    }
+}
+
+/**
+ * Arranque sincronizado de todas las placas. Con external_s en 0 el flanco lo produce la primera
+ * placa; si no, se espera un disparo externo durante external_s segundos.
+ */
+static void run_sync(unsigned external_s) {
+    send_all("!arm\n");
+    if (!wait_sync("armed,unsupported", CTL_SYNC_ARM_TIMEOUT_US)) {
+        printf("sincronismo: no todas las placas quedaron armadas\n");
+    }
+    if (!external_s) {
+        for (int i = 0; i < board_count; ++i) {
+            if (boards[i].state == BOARD_READY) {
+                board_send(&boards[i], "!fire\n");
+                board_flush(&boards[i]);
+                break;
+            }
+        }
+    } else {
+        printf("sincronismo: esperando el disparo externo (%u s)\n", external_s);
+        fflush(stdout);
+    }
+    wait_sync("started,late,missed,unsupported", external_s ? external_s * 1000000ull : CTL_SYNC_ARM_TIMEOUT_US);
+}
+
+/**
+ * Informa el arranque de cada placa. El desfase se mide respecto de la que tardó menos desde el
+ * flanco hasta la primera muestra; como todas ven el mismo flanco, es la diferencia entre sus
+ * arranques.
+ */
+static void print_sync_report(void) {
+    double min_ns = -1, max_ns = 0, sample_ns = 0;
+    int started = 0, ready = 0;
+
+    for (int i = 0; i < board_count; ++i) {
+        const board_sync_t *t = &boards[i].sync;
+        if (boards[i].state != BOARD_READY) {
+            continue;
+        }
+        ready++;
+        if (strcmp(t->state, "started") == 0 && t->clk_hz) {
+            double ns = t->cycles * 1e9 / t->clk_hz;
+            min_ns = min_ns < 0 || ns < min_ns ? ns : min_ns;
+            max_ns = ns > max_ns ? ns : max_ns;
+            sample_ns = t->sample_rate ? 1e9 / t->sample_rate : 0;
+            started++;
+        }
+    }
+    printf("%-18s %-11s %10s %12s %13s %12s\n", "placa", "estado", "armado(us)", "arranque(us)", "flanco(ciclos)",
+           "desfase(ns)");
+    for (int i = 0; i < board_count; ++i) {
+        const board_t *b = &boards[i];
+        if (b->state != BOARD_READY) {
+            continue;
+        }
+        if (strcmp(b->sync.state, "started") == 0 && b->sync.clk_hz) {
+            printf("%-18s %-11s %10lu %12lu %13lu %12.0f\n", b->id, b->sync.state, b->sync.arm_us, b->sync.start_us,
+                   b->sync.cycles, b->sync.cycles * 1e9 / b->sync.clk_hz - min_ns);
+        } else {
+            printf("%-18s %-11s %10lu %12s %13s %12s\n", b->id, b->sync.state[0] ? b->sync.state : "?",
+                   b->sync.arm_us, "-", "-", "-");
+        }
+    }
+    if (started) {
+        printf("sincronismo: arrancaron %d de %d placas, desfase máximo %.0f ns (%.2f muestras)\n", started, ready,
+               max_ns - min_ns, sample_ns > 0 ? (max_ns - min_ns) / sample_ns : 0.0);
+    } else {
+        printf("sincronismo: no arrancó ninguna de %d placas\n", ready);
+    }
+}
+
+static void print_report(unsigned seconds_tel, double elapsed_s) {
+    static const char *const waveform_names[] = {"seno", "cuadrada", "sierra", "triangular"};
+    lat_hist_t all = { .name = "todas" };
+    unsigned long total = 0;
+    int identified = 0;
+    uint64_t total_us = 0;
+
+    printf("%-18s %-14s %8s %8s %8s %8s %8s %9s\n", "placa", "dispositivo", "comandos", "min", "p50<=", "p99<=",
+           "max", "media(us)");
+    for (int i = 0; i < board_count; ++i) {
+        const board_t *b = &boards[i];
+        const char *dev = strrchr(b->path, '/') ? strrchr(b->path, '/') + 1 : b->path;
+        if (!b->id[0]) {
+            continue;
+        }
+        identified++;
+        printf("%-18s %-14s %8u %8lu %8lu %8lu %8lu %9.1f%s\n", b->id, dev, b->done,
+               (unsigned long)b->latency_min_us, (unsigned long)lat_hist_percentile(&b->latency, 50),
+               (unsigned long)lat_hist_percentile(&b->latency, 99), (unsigned long)b->latency.max,
+               b->done ? (double)b->latency_total_us / b->done : 0.0, b->state == BOARD_FAILED ? "  PERDIDA" : "");
+        for (int k = 0; k < LAT_HIST_BINS; ++k) {
+            all.bins[k] += b->latency.bins[k];
+        }
+        all.count += b->latency.count;
+        if (b->latency.max > all.max) {
+            all.max = b->latency.max;
+        }
+        total += b->done;
+        total_us += b->latency_total_us;
+    }
+    printf("total: placas=%d identificadas=%d perdidas=%d comandos=%lu en %.3f s, %.0f comandos/s, "
+           "latencia p50<=%lu p99<=%lu max=%lu media=%.1f us\n",
+           board_count, identified, count_state(BOARD_FAILED), total, elapsed_s, elapsed_s > 0 ? total / elapsed_s : 0.0,
+           (unsigned long)lat_hist_percentile(&all, 50), (unsigned long)lat_hist_percentile(&all, 99),
+           (unsigned long)all.max, total ? (double)total_us / total : 0.0);
+
+    if (!seconds_tel) {
+        return;
+    }
+    printf("%-18s %10s %10s %14s %-10s %10s %9s\n", "placa", "ampl(uV)", "dc(uV)", "frec(mHz)", "forma", "bloques",
+           "repetidos");
+    for (int i = 0; i < board_count; ++i) {
+        const board_t *b = &boards[i];
+        if (b->tel.valid) {
+            printf("%-18s %10ld %10ld %14llu %-10s %10lu %9lu\n", b->id, b->tel.amplitude_uv, b->tel.dc_offset_uv,
+                   b->tel.frequency_millihz,
+                   b->tel.waveform >= 0 && b->tel.waveform < 4 ? waveform_names[b->tel.waveform] : "?",
+                   b->tel.blocks, b->tel.underruns);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *usage = "Uso: %s [-d DISPOSITIVO]... [-F PLACAS] [-n REPETICIONES] [-w VENTANA] [-t SEGUNDOS] "
+                        "[-S | -X SEGUNDOS] [-q] [comando...]\n";
+    const char *devices[CTL_MAX_BOARDS];
+    int device_count = 0, fake_count = 0, repeat = 1, fake_pipe = -1, opt;
+    unsigned seconds_tel = 0, sync_external_s = 0;
+    bool sync = false;
+    pid_t fake_pid = 0;
+
+    while ((opt = getopt(argc, argv, "d:F:n:w:t:SX:q")) != -1) {
+        switch (opt) {
+            case 'd':
+                if (device_count < CTL_MAX_BOARDS) {
+                    devices[device_count++] = optarg;
+                }
+                break;
+            case 'F': fake_count = atoi(optarg); break;
+            case 'n': repeat = atoi(optarg); break;
+            case 'w': window = (unsigned)atoi(optarg); break;
+            case 't': seconds_tel = (unsigned)atoi(optarg); break;
+            case 'S': sync = true; break;
+            case 'X':
+                sync = true;
+                sync_external_s = (unsigned)atoi(optarg);
+                break;
+            case 'q': quiet = true; break;
+            default: fprintf(stderr, usage, argv[0]); return 2;
+        }
+    }
+    if (repeat < 1 || window < 1 || window > CTL_WINDOW_MAX || fake_count < 0 || (sync && sync_external_s > 3600)) {
+        fprintf(stderr, usage, argv[0]);
+        return 2;
+    }
+
+    epoll_fd = epoll_create1(0);
+    for (int i = 0; i < device_count; ++i) {
+        board_open(devices[i]);
+    }
+    if (fake_count) {
+        fake_pipe = spawn_fake(argv[0], fake_count, &fake_pid);
+    }
+    if (!device_count && !fake_count) {
+        glob_t g;
+        if (glob("/dev/ttyACM*", 0, NULL, &g) == 0) {
+            for (size_t i = 0; i < g.gl_pathc; ++i) {
+                board_open(g.gl_pathv[i]);
+            }
+            globfree(&g);
+        }
+    }
+    if (!board_count) {
+        fprintf(stderr, "%s: no se encontraron placas\n", argv[0]);
+        return 1;
+    }
+
+    // Descubrimiento: las placas que no responden a !id se descartan
+    uint64_t deadline = now_us() + CTL_ID_TIMEOUT_US;
+    while (count_state(BOARD_PROBING) && now_us() < deadline) {
+        poll_once(10);
+    }
+    for (int i = 0; i < board_count; ++i) {
+        if (boards[i].state == BOARD_PROBING) {
+            board_fail(&boards[i], "no responde a !id");
+        }
+    }
+    printf("placas: %d de %d\n", count_state(BOARD_READY), board_count);
+    fflush(stdout);
+
+    // Comandos: de los argumentos, o de la entrada estándar si no hay argumentos, -t ni -S
+    for (int r = 0; r < repeat; ++r) {
+        for (int i = optind; i < argc; ++i) {
+            queue_add(argv[i]);
+        }
+    }
+    if (optind < argc || seconds_tel || sync) {
+        queue_closed = true;
+    } else {
+        struct epoll_event ev = { EPOLLIN, { .ptr = NULL } };
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &ev) != 0) {
+            // Un archivo común no admite epoll: se lee completo de una vez
+            char line[256];
+            while (fgets(line, sizeof(line), stdin)) {
+                line[strcspn(line, "\r\n")] = '\0';
+                if (line[0]) {
+                    queue_add(line);
+                }
+            }
+            queue_closed = true;
+        }
+    }
+
+    uint64_t start = now_us();
+    for (int i = 0; i < board_count; ++i) {
+        board_pump(&boards[i]);
+    }
+    while (!commands_done()) {
+        poll_once(100);
+        check_timeouts();
+    }
+    double elapsed = (now_us() - start) / 1e6;
+
+    if (sync) {
+        run_sync(sync_external_s);
+    }
+    if (seconds_tel) {
+        run_telemetry(seconds_tel);
+    }
+    print_report(seconds_tel, elapsed);
+    if (sync) {
+        print_sync_report();
+    }
+
+    if (fake_pipe >= 0) {
+        close(fake_pipe);
+        waitpid(fake_pid, NULL, 0);
+    }
+    return count_state(BOARD_FAILED) ? 1 : 0;
+}
@@ -0,0 +1,298 @@
+/**
+ * @file gds_fake.c
+ *
+ * @brief Generadores simulados detrás de pseudoterminales, para probar host/gds_ctl sin placas.
+ *
+ * Crea PLACAS pares de pseudoterminales, imprime la ruta del lado esclavo de cada uno (una por
+ * línea, como /dev/ttyACM0 para una placa real) y atiende todos en un solo proceso con epoll. Cada
+ * placa tiene su propio motor (siggen/engine.c, el mismo del firmware) y responde a la consola
+ * como console.c: los caracteres sueltos son teclas, y las líneas que empiezan con '!' son
+ * comandos. Se implementan los que usa gds_ctl (!id, !ping, !tel, !arm, !fire, !sync) y !status y
+ * !help; los demás responden "Comando desconocido", como en el firmware. Los bloques enviados al
+ * DAC se deducen del tiempo transcurrido. La salida usa fin de línea CRLF, como stdio por USB en la
+ * Pico.
+ *
+ * Todas las placas del proceso comparten la línea del disparo: !fire en cualquiera arranca las que
+ * estén armadas. Cada una informa un arranque entre dos y tres muestras después del flanco, con la
+ * fase del divisor al azar, como la máquina de estados de dac_out.pio.
+ *
+ * El proceso termina cuando se cierra su entrada estándar (gds_ctl -F mantiene abierta una
+ * tubería mientras lo usa) o con SIGTERM.
+ *
+ * Uso: gds_fake [-n PLACAS] [-l US]
+ *  - -n PLACAS  Cantidad de placas (por defecto 4).
+ *  - -l US      Demora antes de atender cada comando (por defecto 0). Las placas comparten el
+ *               proceso, así que la demora de una retrasa a las demás: sirve para ver la
+ *               latencia en los reportes, no para medir la concurrencia.
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "../siggen/engine.h"
+
+#define FAKE_MAX_BOARDS 256 ///< Placas por proceso
+#define FAKE_LINE_MAX 64 ///< Longitud máxima de una línea de comando, como CONSOLE_LINE_MAX
+#define FAKE_OUT_MAX 16384 ///< Salida pendiente por placa; lo que no entra se descarta, como stdio por USB
+#define FAKE_BLOCK_US 1024 ///< Duración de un bloque del DAC (DAC_BLOCK_SAMPLES a DAC_SAMPLE_RATE)
+#define FAKE_CLK_HZ 125000000 ///< Reloj del sistema que informa @SYNC
+#define FAKE_SAMPLE_RATE 1000000 ///< Frecuencia de muestreo que informa @SYNC
+#define FAKE_CYCLES_PER_SAMPLE (FAKE_CLK_HZ / FAKE_SAMPLE_RATE)
+
+/**
+ * Una placa simulada.
+ */
+typedef struct {
+    int master; ///< Lado maestro del pseudoterminal
+    int slave; ///< Lado esclavo, abierto para que el maestro no vea un cierre cuando gds_ctl lo cierra
+    char id[24]; ///< Identificador que informa !id
+    engine_t engine; ///< Motor del generador
+    char line[FAKE_LINE_MAX]; ///< Línea en construcción
+    int line_len; ///< Caracteres en line
+    char out[FAKE_OUT_MAX]; ///< Salida pendiente
+    size_t out_len; ///< Bytes en out
+    uint64_t start_us; ///< Arranque, para contar los bloques
+    const char *sync_state; ///< Estado del arranque sincronizado, con los nombres de sync_start.c
+    uint64_t arm_request_us; ///< Instante de !arm
+    unsigned long sync_start_us; ///< Desde !arm hasta el flanco
+    unsigned long sync_cycles; ///< Ciclos desde el flanco hasta el arranque
+} fake_board_t;
+
+static fake_board_t boards[FAKE_MAX_BOARDS];
+static int board_count;
+static int epoll_fd;
+static unsigned line_delay_us;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+/**
+ * Agrega texto a la salida de la placa, con "\r\n" en lugar de "\n".
+ */
+static void board_write(fake_board_t *b, const char *text) {
+    for (const char *p = text; *p; ++p) {
+        if (b->out_len + 2 > sizeof(b->out)) {
+            break;
+        }
+        if (*p == '\n') {
+            b->out[b->out_len++] = '\r';
+        }
+        b->out[b->out_len++] = *p;
+    }
+}
+
+static void board_printf(fake_board_t *b, const char *fmt, ...) {
+    char text[256];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    board_write(b, text);
+}
+
+static void engine_output(void *ctx, const char *text) {
+    board_write((fake_board_t *)ctx, text);
+}
+
+/**
+ * Envía toda la salida pendiente que acepte el pseudoterminal y pide EPOLLOUT si queda algo.
+ */
+static void board_flush(fake_board_t *b) {
+    size_t sent = 0;
+
+    while (sent < b->out_len) {
+        ssize_t n = write(b->master, b->out + sent, b->out_len - sent);
+        if (n <= 0) {
+            break;
+        }
+        sent += (size_t)n;
+    }
+    memmove(b->out, b->out + sent, b->out_len - sent);
+    b->out_len -= sent;
+
+    struct epoll_event ev = { EPOLLIN | (b->out_len ? EPOLLOUT : 0), { .ptr = b } };
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, b->master, &ev);
+}
+
+static void run_command(fake_board_t *b, char *cmd) {
+    static const char *const waveform_names[] = {"Seno", "Cuadrada", "Diente de sierra", "Triangular"};
+    engine_t *e = &b->engine;
+    char *args = strchr(cmd, ' ');
+
+    if (args) {
+        *args++ = '\0';
+    } else {
+        args = cmd + strlen(cmd);
+    }
+    if (strcmp(cmd, "id") == 0) {
+        board_printf(b, "@ID,%s,gds_fake\n", b->id);
+    } else if (strcmp(cmd, "ping") == 0) {
+        board_printf(b, "@PONG,%s\n", args);
+    } else if (strcmp(cmd, "tel") == 0) {
+        board_printf(b, "@TEL,%ld,%ld,%llu,%d,%lu,0\n", (long)e->amplitude_uv, (long)e->dc_offset_uv,
+                     (unsigned long long)e->frequency_millihz, (int)e->waveform,
+                     (unsigned long)((now_us() - b->start_us) / FAKE_BLOCK_US));
+    } else if (strcmp(cmd, "arm") == 0) {
+        b->sync_state = "armed";
+        b->arm_request_us = now_us();
+        b->sync_start_us = 0;
+        b->sync_cycles = 0;
+        board_write(b, "Armando: la salida arranca en el próximo flanco de subida de GP15.\n");
+    } else if (strcmp(cmd, "fire") == 0) {
+        uint64_t now = now_us();
+        for (int i = 0; i < board_count; ++i) {
+            fake_board_t *other = &boards[i];
+            if (strcmp(other->sync_state, "armed") == 0) {
+                other->sync_state = "started";
+                other->sync_start_us = (unsigned long)(now - other->arm_request_us);
+                other->sync_cycles = 2 * FAKE_CYCLES_PER_SAMPLE + 1 + (unsigned long)(rand() % FAKE_CYCLES_PER_SAMPLE);
+                other->start_us = now;
+            }
+        }
+    } else if (strcmp(cmd, "sync") == 0) {
+        board_printf(b, "@SYNC,%s,0,%lu,%lu,%u,%u\n", b->sync_state, b->sync_start_us, b->sync_cycles, FAKE_CLK_HZ,
+                     FAKE_SAMPLE_RATE);
+    } else if (strcmp(cmd, "status") == 0) {
+        board_printf(b, "Amplitud: %ld uV, Desplazamiento DC: %ld uV, Frecuencia: %llu mHz, Forma de onda: %s\n",
+                     (long)e->amplitude_uv, (long)e->dc_offset_uv, (unsigned long long)e->frequency_millihz,
+                     waveform_names[e->waveform]);
+    } else if (strcmp(cmd, "help") == 0) {
+        board_write(b, "!id       Identificador de la placa (@ID)\n!ping     Responde @PONG con los argumentos\n"
+                       "!tel      Telemetría en una línea (@TEL)\n!arm      Arranca en el flanco del disparo\n"
+                       "!fire     Produce el flanco del disparo\n!sync     Último arranque sincronizado (@SYNC)\n"
+                       "!status   Parámetros actuales\n");
+    } else {
+        board_printf(b, "Comando desconocido: !%s\n", cmd);
+    }
+}
+
+/**
+ * Lee lo que llegó a la placa y lo interpreta como console_task().
+ */
+static void board_read(fake_board_t *b) {
+    char buf[512];
+    ssize_t n;
+
+    while ((n = read(b->master, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; ++i) {
+            char c = buf[i];
+            if (c == '\r' || c == '\n') {
+                b->line[b->line_len] = '\0';
+                if (b->line_len > 0 && b->line[0] == '!') {
+                    if (line_delay_us) {
+                        usleep(line_delay_us);
+                    }
+                    run_command(b, b->line + 1);
+                }
+                b->line_len = 0;
+            } else if (b->line_len == 0 && c != '!') {
+                engine_handle_input(&b->engine, c);
+            } else if (b->line_len < FAKE_LINE_MAX - 1) {
+                b->line[b->line_len++] = c;
+            }
+        }
+    }
+    board_flush(b);
+}
+
+/**
+ * Crea el pseudoterminal de una placa en modo crudo.
+ * @return 0 si pudo crearlo.
+ */
+static int board_open(fake_board_t *b, int index) {
+    struct termios tio;
+
+    b->master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (b->master < 0 || grantpt(b->master) != 0 || unlockpt(b->master) != 0) {
+        perror("posix_openpt");
+        return -1;
+    }
+    b->slave = open(ptsname(b->master), O_RDWR | O_NOCTTY);
+    if (b->slave < 0) {
+        perror(ptsname(b->master));
+        return -1;
+    }
+    tcgetattr(b->slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(b->slave, TCSANOW, &tio);
+
+    snprintf(b->id, sizeof(b->id), "FAKE%08X", 0xE6000000u + (unsigned)index);
+    engine_init(&b->engine, engine_output, b);
+    b->line_len = 0;
+    b->out_len = 0;
+    b->start_us = now_us();
+    b->sync_state = "idle";
+
+    struct epoll_event ev = { EPOLLIN, { .ptr = b } };
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, b->master, &ev);
+}
+
+int main(int argc, char **argv) {
+    int count = 4, opt;
+
+    while ((opt = getopt(argc, argv, "n:l:")) != -1) {
+        switch (opt) {
+            case 'n': count = atoi(optarg); break;
+            case 'l': line_delay_us = (unsigned)strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Uso: %s [-n PLACAS] [-l US]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (count < 1 || count > FAKE_MAX_BOARDS) {
+        fprintf(stderr, "%s: entre 1 y %d placas\n", argv[0], FAKE_MAX_BOARDS);
+        return 2;
+    }
+
+    epoll_fd = epoll_create1(0);
+    for (int i = 0; i < count; ++i) {
+        if (board_open(&boards[i], i) != 0) {
+            return 1;
+        }
+        printf("%s\n", ptsname(boards[i].master));
+    }
+    board_count = count;
+    fflush(stdout);
+
+    struct epoll_event ev = { EPOLLIN, { .ptr = NULL } };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &ev);
+
+    for (;;) {
+        struct epoll_event events[64];
+        int n = epoll_wait(epoll_fd, events, 64, -1);
+
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            return 1;
+        }
+        for (int i = 0; i < n; ++i) {
+            fake_board_t *b = events[i].data.ptr;
+            if (!b) {
+                char buf[256];
+                if (read(STDIN_FILENO, buf, sizeof(buf)) <= 0) {
+                    return 0;
+                }
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                board_read(b);
+            } else {
+                board_flush(b);
+            }
+        }
+    }
+}
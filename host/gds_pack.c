@@ -0,0 +1,963 @@
+/**
+ * @file gds_pack.c
+ *
+ * @brief Compilador de imágenes wavepack (siggen/wavepack.h) a partir de CSV, WAV o una
+ * descripción JSON, con salida opcional en UF2 para grabarla arrastrando el archivo a la Pico.
+ *
+ * Las entradas se leen por bloques y las muestras se escriben a un archivo temporal a medida que
+ * se convierten, así que el tamaño de las entradas no está limitado por la memoria; solo los pasos
+ * de las secuencias quedan en memoria. Al final se escriben el encabezado, el directorio, las
+ * tablas y las secuencias en un solo recorrido, hacia la imagen y hacia el UF2 a la vez, y se
+ * informa el caudal de la conversión.
+ *
+ * Entradas:
+ *  - CSV y WAV: se reconocen por su contenido y se convierten con siggen/wave_import.h, como en
+ *    la Pico. Del CSV se toma la columna -c (por defecto la última, así que sirven tanto una
+ *    columna de valores como pares "tiempo,valor") y se ignoran las líneas en las que no es un
+ *    número, como los títulos; los valores van de -1 a 1 (o son códigos del DAC de 0 a 255 con
+ *    -k). Del WAV se toma el canal -c (por defecto el primero).
+ *  - JSON: un objeto con "sample_rate", "tables" y "sequences". Cada tabla es un objeto con
+ *    "csv" o "wav" (ruta relativa al JSON, con "column" y "codes" opcionales), "samples" (códigos
+ *    del DAC) o "values" (de -1 a 1). Cada secuencia es un arreglo de pasos con "table" (índice),
+ *    el ritmo como "rate" (muestras de la tabla por muestra de salida, por defecto 1) o "hz"
+ *    (recorridos de la tabla por segundo), y la duración como "samples", "ms" o "cycles"
+ *    (recorridos de la tabla); sin duración, el paso dura hasta que se elija otra secuencia.
+ *
+ * Por cada CSV o WAV, y por cada tabla de un JSON sin "sequences", se agrega una secuencia de un
+ * solo paso que recorre la tabla a ritmo 1 sin fin.
+ *
+ * Uso: gds_pack -o IMAGEN [-u UF2] [-b DIRECCIÓN] [-m BYTES] [-r HZ] [-c COLUMNA] [-k] entrada...
+ *      gds_pack -t IMAGEN [-n MUESTRAS]
+ *  - -o IMAGEN     Imagen a escribir ("-" para la salida estándar).
+ *  - -u UF2        Escribir también la imagen como UF2.
+ *  - -b DIRECCIÓN  Dirección del UF2 (por defecto 0x1017F000, WAVE_STORE_ADDR con 2 MB de flash).
+ *  - -m BYTES      Tamaño máximo de la imagen (por defecto 524288 con -u, WAVE_STORE_SIZE).
+ *  - -r HZ         Frecuencia de muestreo de la imagen (por defecto 1000000, o la del JSON).
+ *  - -c COLUMNA    Columna de los CSV o canal de los WAV (desde 0; por defecto la última columna y
+ *                  el primer canal).
+ *  - -k            Los valores de los CSV son códigos del DAC.
+ *  - -t IMAGEN     Validar una imagen, listar su contenido y medir la reproducción de cada
+ *                  secuencia con MUESTRAS muestras (por defecto 16000000).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "../siggen/crc32.h"
+#include "../siggen/wave_import.h"
+#include "../siggen/wavepack.h"
+
+#define PACK_IO_SIZE 65536 ///< Bytes por lectura o escritura
+#define PACK_DEFAULT_RATE 1000000 ///< Frecuencia de muestreo por defecto (Hz), la del firmware
+#define PACK_DEFAULT_BASE 0x1017F000u ///< WAVE_STORE_ADDR con PICO_FLASH_SIZE_BYTES de 2 MB
+#define PACK_STORE_SIZE (512 * 1024) ///< WAVE_STORE_SIZE
+#define PACK_TOKEN_MAX 512 ///< Largo máximo de una cadena o número de JSON
+#define PACK_RENDER_BLOCK 1024 ///< Muestras por llamada en la medición de -t, como DAC_BLOCK_SAMPLES
+
+#define UF2_MAGIC_START0 0x0A324655u
+#define UF2_MAGIC_START1 0x9E5D5157u
+#define UF2_MAGIC_END 0x0AB16F30u
+#define UF2_FLAG_FAMILY 0x00002000u ///< El último campo del encabezado es la familia
+#define UF2_FAMILY_RP2040 0xE48BFF56u
+#define UF2_PAYLOAD 256 ///< Bytes de la imagen por bloque, lo que espera el cargador de la Pico
+
+/**
+ * Lector por bloques de un archivo, con el número de línea para los mensajes de error.
+ */
+typedef struct {
+    FILE *file; ///< Archivo
+    const char *path; ///< Nombre, para los mensajes
+    uint8_t buf[PACK_IO_SIZE]; ///< Datos leídos
+    size_t len; ///< Bytes válidos en buf
+    size_t pos; ///< Próximo byte de buf
+    unsigned line; ///< Línea en curso
+} reader_t;
+
+/**
+ * Paso de una secuencia tal como se describió; se convierte a wavepack_step_t al final, cuando ya
+ * se conocen todas las tablas. Los campos negativos no se indicaron.
+ */
+typedef struct {
+    long table; ///< Índice de la tabla
+    double rate; ///< Muestras de la tabla por muestra de salida
+    double hz; ///< Recorridos de la tabla por segundo
+    double samples; ///< Duración en muestras de salida
+    double ms; ///< Duración en milisegundos
+    double cycles; ///< Duración en recorridos de la tabla
+} step_spec_t;
+
+/**
+ * Secuencia en construcción.
+ */
+typedef struct {
+    step_spec_t *steps; ///< Pasos
+    uint32_t count; ///< Pasos usados
+    uint32_t capacity; ///< Pasos reservados
+} sequence_t;
+
+/**
+ * Imagen en construcción. Las tablas van al archivo temporal spool, cada una alineada a
+ * WAVEPACK_ALIGN; sus offset son relativos al principio de spool hasta que se escribe la imagen.
+ */
+typedef struct {
+    uint32_t sample_rate; ///< Frecuencia de muestreo
+    int column; ///< Columna de los CSV y canal de los WAV, o WAVE_IMPORT_LAST
+    bool codes; ///< Los CSV traen códigos del DAC
+    FILE *spool; ///< Tablas ya convertidas
+    uint64_t spool_size; ///< Bytes en spool
+    wavepack_chunk_t tables[WAVEPACK_MAX_ENTRIES]; ///< Entradas de las tablas
+    uint32_t table_count; ///< Tablas
+    sequence_t sequences[WAVEPACK_MAX_ENTRIES]; ///< Secuencias
+    uint32_t sequence_count; ///< Secuencias
+    uint8_t out[PACK_IO_SIZE]; ///< Muestras de la tabla en curso que faltan escribir
+    size_t out_len; ///< Bytes en out
+    uint64_t bytes_in; ///< Bytes leídos de las entradas
+    uint64_t samples; ///< Muestras convertidas
+} pack_t;
+
+/**
+ * Destino de la imagen: el archivo y, si se pidió, el UF2.
+ */
+typedef struct {
+    FILE *image; ///< Imagen
+    FILE *uf2; ///< UF2, o NULL
+    uint32_t base; ///< Dirección del primer byte en el UF2
+    uint8_t block[UF2_PAYLOAD]; ///< Datos del bloque UF2 en curso
+    uint32_t fill; ///< Bytes en block
+    uint32_t block_no; ///< Bloque UF2 en curso
+    uint32_t block_count; ///< Bloques UF2 en total
+} sink_t;
+
+static pack_t pack;
+
+static void fail(const char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    fputs("gds_pack: ", stderr);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    exit(1);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void reader_open(reader_t *r, const char *path) {
+    r->file = fopen(path, "rb");
+    if (!r->file) {
+        fail("%s: %s", path, strerror(errno));
+    }
+    r->path = path;
+    r->len = 0;
+    r->pos = 0;
+    r->line = 1;
+}
+
+static void reader_close(reader_t *r) {
+    fclose(r->file);
+}
+
+/**
+ * Próximo byte sin consumirlo, o EOF.
+ */
+static inline int reader_peek(reader_t *r) {
+    if (r->pos == r->len) {
+        r->len = fread(r->buf, 1, sizeof(r->buf), r->file);
+        r->pos = 0;
+        pack.bytes_in += r->len;
+        if (!r->len) {
+            return EOF;
+        }
+    }
+    return r->buf[r->pos];
+}
+
+static inline int reader_get(reader_t *r) {
+    int c = reader_peek(r);
+
+    if (c != EOF) {
+        r->pos++;
+        if (c == '\n') {
+            r->line++;
+        }
+    }
+    return c;
+}
+
+/**
+ * Lee hasta len bytes.
+ * @return Bytes leídos; menos que len solo al final del archivo.
+ */
+static size_t reader_read(reader_t *r, void *data, size_t len) {
+    uint8_t *dst = (uint8_t *)data;
+    size_t done = 0;
+
+    while (done < len && reader_peek(r) != EOF) {
+        size_t chunk = r->len - r->pos < len - done ? r->len - r->pos : len - done;
+        memcpy(dst + done, r->buf + r->pos, chunk);
+        r->pos += chunk;
+        done += chunk;
+    }
+    return done;
+}
+
+static void reader_error(const reader_t *r, const char *msg) {
+    fail("%s:%u: %s", r->path, r->line, msg);
+}
+
+/**
+ * Código del DAC para un valor de -1 a 1 (o para un código, con codes), recortado al rango.
+ */
+static inline uint8_t to_code(double value, bool codes) {
+    double code = codes ? value : (value + 1.0) * 127.5;
+
+    if (!(code > 0.0)) {
+        return 0;
+    }
+    return code >= 255.0 ? 255 : (uint8_t)lround(code);
+}
+
+static void spool_write(const void *data, size_t len) {
+    if (fwrite(data, 1, len, pack.spool) != len) {
+        fail("no se pudo escribir el archivo temporal: %s", strerror(errno));
+    }
+    pack.spool_size += len;
+}
+
+static void table_flush(void) {
+    wavepack_chunk_t *c = &pack.tables[pack.table_count];
+
+    c->crc = crc32_update(c->crc, pack.out, pack.out_len);
+    spool_write(pack.out, pack.out_len);
+    pack.out_len = 0;
+}
+
+static void table_begin(void) {
+    if (pack.table_count + pack.sequence_count >= WAVEPACK_MAX_ENTRIES) {
+        fail("más de %d tablas y secuencias", WAVEPACK_MAX_ENTRIES);
+    }
+    wavepack_chunk_t *c = &pack.tables[pack.table_count];
+    c->type = WAVEPACK_TABLE;
+    c->offset = (uint32_t)pack.spool_size;
+    c->count = 0;
+    c->crc = 0;
+}
+
+static inline void table_put(uint8_t code) {
+    wavepack_chunk_t *c = &pack.tables[pack.table_count];
+
+    if (c->count == UINT32_MAX) {
+        fail("la tabla %u tiene demasiadas muestras", pack.table_count);
+    }
+    pack.out[pack.out_len++] = code;
+    c->count++;
+    if (pack.out_len == sizeof(pack.out)) {
+        table_flush();
+    }
+}
+
+/**
+ * Cierra la tabla en curso y la rellena hasta WAVEPACK_ALIGN. El relleno no entra en el CRC.
+ */
+static void table_end(const char *source) {
+    static const uint8_t pad[WAVEPACK_ALIGN];
+    wavepack_chunk_t *c = &pack.tables[pack.table_count];
+
+    table_flush();
+    if (!c->count) {
+        fail("%s: la tabla no tiene muestras", source);
+    }
+    spool_write(pad, (WAVEPACK_ALIGN - c->count % WAVEPACK_ALIGN) % WAVEPACK_ALIGN);
+    if (pack.spool_size > UINT32_MAX) {
+        fail("las tablas superan los 4 GB");
+    }
+    pack.samples += c->count;
+    pack.table_count++;
+}
+
+static sequence_t *sequence_add(void) {
+    if (pack.table_count + pack.sequence_count >= WAVEPACK_MAX_ENTRIES) {
+        fail("más de %d tablas y secuencias", WAVEPACK_MAX_ENTRIES);
+    }
+    sequence_t *s = &pack.sequences[pack.sequence_count++];
+    memset(s, 0, sizeof(*s));
+    return s;
+}
+
+static step_spec_t *step_add(sequence_t *s) {
+    if (s->count == s->capacity) {
+        s->capacity = s->capacity ? 2 * s->capacity : 8;
+        s->steps = realloc(s->steps, s->capacity * sizeof(*s->steps));
+        if (!s->steps) {
+            fail("sin memoria");
+        }
+    }
+    step_spec_t *step = &s->steps[s->count++];
+    *step = (step_spec_t){ .table = -1, .rate = -1, .hz = -1, .samples = -1, .ms = -1, .cycles = -1 };
+    return step;
+}
+
+/**
+ * Secuencia de un paso que recorre la tabla index a ritmo 1 sin fin.
+ */
+static void default_sequence(uint32_t index) {
+    step_add(sequence_add())->table = index;
+}
+
+static void import_sink(void *ctx, const uint8_t *codes, size_t count) {
+    (void)ctx;
+    for (size_t i = 0; i < count; ++i) {
+        table_put(codes[i]);
+    }
+}
+
+/**
+ * Agrega una tabla con un CSV o un WAV, reconocido por su contenido. La conversión es la de
+ * siggen/wave_import.h, la misma que hace la Pico con lo que se copia a su disco USB, así que un
+ * archivo da la misma tabla por cualquier camino.
+ * @param column Campo del CSV o canal del WAV, o WAVE_IMPORT_LAST.
+ */
+static void read_table(const char *path, int column, bool codes) {
+    reader_t *r = malloc(sizeof(*r));
+    wave_import_t *p = malloc(sizeof(*p));
+    uint8_t head[WAVE_IMPORT_DETECT_LEN];
+
+    if (!r || !p) {
+        fail("sin memoria");
+    }
+    reader_open(r, path);
+    size_t len = reader_read(r, head, sizeof(head));
+    wave_import_format_t format = wave_import_detect(head, len);
+    if (format == WAVE_IMPORT_NONE) {
+        fail("%s: no es un CSV ni un WAV", path);
+    }
+    wave_import_init(p, format, codes, import_sink, NULL);
+    wave_import_set_column(p, column);
+    table_begin();
+    wave_import_feed(p, head, len);
+    while (p->status == WAVE_IMPORT_RUNNING && reader_peek(r) != EOF) {
+        wave_import_feed(p, r->buf + r->pos, r->len - r->pos);
+        r->pos = r->len;
+    }
+    if (wave_import_finish(p) != WAVE_IMPORT_END) {
+        fail("%s: %s", path, wave_import_status_name(p->status));
+    }
+    reader_close(r);
+    free(r);
+    free(p);
+    table_end(path);
+}
+
+/**
+ * Saltea los espacios y devuelve el próximo carácter de un JSON sin consumirlo.
+ */
+static int json_peek(reader_t *r) {
+    int c;
+
+    while ((c = reader_peek(r)) == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        reader_get(r);
+    }
+    return c;
+}
+
+static void json_expect(reader_t *r, char expected) {
+    if (json_peek(r) != expected) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "se esperaba '%c'", expected);
+        reader_error(r, msg);
+    }
+    reader_get(r);
+}
+
+/**
+ * Consume una coma antes del próximo elemento de un objeto o arreglo.
+ * @return false al llegar a close.
+ */
+static bool json_next(reader_t *r, char close, bool first) {
+    int c = json_peek(r);
+
+    if (c == close) {
+        reader_get(r);
+        return false;
+    }
+    if (!first) {
+        json_expect(r, ',');
+    }
+    return true;
+}
+
+static void json_string(reader_t *r, char *out, size_t size) {
+    size_t len = 0;
+    int c;
+
+    json_expect(r, '"');
+    while ((c = reader_get(r)) != '"') {
+        if (c == EOF || c == '\n') {
+            reader_error(r, "cadena sin terminar");
+        }
+        if (c == '\\') {
+            c = reader_get(r);
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u':
+                    // Las rutas y claves del formato son ASCII; el resto no se traduce
+                    for (int i = 0; i < 4; ++i) {
+                        reader_get(r);
+                    }
+                    c = '?';
+                    break;
+                default: break;
+            }
+        }
+        if (len + 1 >= size) {
+            reader_error(r, "cadena demasiado larga");
+        }
+        out[len++] = (char)c;
+    }
+    out[len] = '\0';
+}
+
+static double json_number(reader_t *r) {
+    char token[64], *end;
+    size_t len = 0;
+    int c = json_peek(r);
+
+    while ((c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' || (c >= '0' && c <= '9')) &&
+           len + 1 < sizeof(token)) {
+        token[len++] = (char)reader_get(r);
+        c = reader_peek(r);
+    }
+    token[len] = '\0';
+    double value = strtod(token, &end);
+    if (!len || *end) {
+        reader_error(r, "se esperaba un número");
+    }
+    return value;
+}
+
+static bool json_bool(reader_t *r) {
+    char word[8];
+    size_t len = 0;
+
+    json_peek(r);
+    while (len + 1 < sizeof(word) && reader_peek(r) >= 'a' && reader_peek(r) <= 'z') {
+        word[len++] = (char)reader_get(r);
+    }
+    word[len] = '\0';
+    if (strcmp(word, "true") && strcmp(word, "false")) {
+        reader_error(r, "se esperaba true o false");
+    }
+    return word[0] == 't';
+}
+
+static void json_skip(reader_t *r) {
+    char text[PACK_TOKEN_MAX];
+    int c = json_peek(r);
+
+    if (c == '"') {
+        json_string(r, text, sizeof(text));
+    } else if (c == '{' || c == '[') {
+        char close = c == '{' ? '}' : ']';
+        reader_get(r);
+        for (bool first = true; json_next(r, close, first); first = false) {
+            if (close == '}') {
+                json_string(r, text, sizeof(text));
+                json_expect(r, ':');
+            }
+            json_skip(r);
+        }
+    } else if (c == 't' || c == 'f') {
+        json_bool(r);
+    } else if (c == 'n') {
+        for (int i = 0; i < 4; ++i) {
+            reader_get(r);
+        }
+    } else {
+        json_number(r);
+    }
+}
+
+/**
+ * Ruta de un archivo nombrado en el JSON base, relativa a su directorio.
+ */
+static void json_path(char *out, size_t size, const char *base, const char *name) {
+    const char *slash = strrchr(base, '/');
+
+    if (name[0] == '/' || !slash) {
+        snprintf(out, size, "%s", name);
+    } else {
+        snprintf(out, size, "%.*s/%s", (int)(slash - base + 1), base, name);
+    }
+}
+
+static void json_table(reader_t *r) {
+    char key[32], name[PACK_TOKEN_MAX], path[PACK_TOKEN_MAX + 256];
+    bool codes = pack.codes, inline_data = false;
+    int column = pack.column;
+
+    name[0] = '\0';
+    json_expect(r, '{');
+    for (bool first = true; json_next(r, '}', first); first = false) {
+        json_string(r, key, sizeof(key));
+        json_expect(r, ':');
+        if (!strcmp(key, "csv") || !strcmp(key, "wav")) {
+            json_string(r, name, sizeof(name));
+        } else if (!strcmp(key, "column")) {
+            double value = json_number(r);
+            if (!(value >= 0 && value <= INT16_MAX)) {
+                reader_error(r, "\"column\" tiene que ser un número desde 0");
+            }
+            column = (int)value;
+        } else if (!strcmp(key, "codes")) {
+            codes = json_bool(r);
+        } else if (!strcmp(key, "samples") || !strcmp(key, "values")) {
+            // Las muestras en línea se convierten mientras se leen
+            bool raw = key[0] == 's';
+            if (inline_data) {
+                reader_error(r, "la tabla ya tiene muestras");
+            }
+            inline_data = true;
+            table_begin();
+            json_expect(r, '[');
+            for (bool first_value = true; json_next(r, ']', first_value); first_value = false) {
+                table_put(to_code(json_number(r), raw));
+            }
+            table_end(r->path);
+        } else {
+            json_skip(r);
+        }
+    }
+    if (inline_data == !!name[0]) {
+        reader_error(r, "cada tabla necesita uno de \"csv\", \"wav\", \"samples\" o \"values\"");
+    }
+    if (name[0]) {
+        json_path(path, sizeof(path), r->path, name);
+        read_table(path, column, codes);
+    }
+}
+
+static void json_sequence(reader_t *r) {
+    char key[32];
+    sequence_t *s = sequence_add();
+
+    json_expect(r, '[');
+    for (bool first = true; json_next(r, ']', first); first = false) {
+        step_spec_t *step = step_add(s);
+        json_expect(r, '{');
+        for (bool first_key = true; json_next(r, '}', first_key); first_key = false) {
+            json_string(r, key, sizeof(key));
+            json_expect(r, ':');
+            double *field = !strcmp(key, "rate")      ? &step->rate
+                            : !strcmp(key, "hz")      ? &step->hz
+                            : !strcmp(key, "samples") ? &step->samples
+                            : !strcmp(key, "ms")      ? &step->ms
+                            : !strcmp(key, "cycles")  ? &step->cycles
+                                                      : NULL;
+            if (!strcmp(key, "table")) {
+                step->table = (long)json_number(r);
+            } else if (field) {
+                *field = json_number(r);
+                if (*field < 0) {
+                    reader_error(r, "los pasos no admiten valores negativos");
+                }
+            } else {
+                json_skip(r);
+            }
+        }
+        if (step->table < 0) {
+            reader_error(r, "el paso no indica \"table\"");
+        }
+    }
+    if (!s->count) {
+        reader_error(r, "secuencia vacía");
+    }
+}
+
+/**
+ * Agrega las tablas y secuencias de un JSON.
+ * @return Frecuencia de muestreo indicada, o 0.
+ */
+static uint32_t read_json(const char *path) {
+    reader_t *r = malloc(sizeof(*r));
+    char key[32];
+    uint32_t first_table = pack.table_count, first_sequence = pack.sequence_count, sample_rate = 0;
+    bool sequences = false;
+
+    if (!r) {
+        fail("sin memoria");
+    }
+    reader_open(r, path);
+    json_expect(r, '{');
+    for (bool first = true; json_next(r, '}', first); first = false) {
+        json_string(r, key, sizeof(key));
+        json_expect(r, ':');
+        if (!strcmp(key, "sample_rate")) {
+            double rate = json_number(r);
+            if (rate < 1 || rate > UINT32_MAX) {
+                reader_error(r, "sample_rate fuera de rango");
+            }
+            sample_rate = (uint32_t)rate;
+        } else if (!strcmp(key, "tables")) {
+            json_expect(r, '[');
+            for (bool first_entry = true; json_next(r, ']', first_entry); first_entry = false) {
+                json_table(r);
+            }
+        } else if (!strcmp(key, "sequences")) {
+            sequences = true;
+            json_expect(r, '[');
+            for (bool first_seq = true; json_next(r, ']', first_seq); first_seq = false) {
+                json_sequence(r);
+            }
+        } else {
+            json_skip(r);
+        }
+    }
+    if (json_peek(r) != EOF) {
+        reader_error(r, "texto después del objeto");
+    }
+    reader_close(r);
+    free(r);
+
+    // Los índices de tabla son relativos al JSON
+    for (uint32_t i = first_sequence; i < pack.sequence_count; ++i) {
+        for (uint32_t k = 0; k < pack.sequences[i].count; ++k) {
+            step_spec_t *step = &pack.sequences[i].steps[k];
+            if (step->table >= (long)(pack.table_count - first_table)) {
+                fail("%s: la secuencia %u usa la tabla %ld, que no existe", path, i - first_sequence, step->table);
+            }
+            step->table += first_table;
+        }
+    }
+    if (!sequences) {
+        for (uint32_t i = first_table; i < pack.table_count; ++i) {
+            default_sequence(i);
+        }
+    }
+    return sample_rate;
+}
+
+/**
+ * Convierte un paso descrito a su forma en la imagen.
+ */
+static wavepack_step_t resolve_step(const step_spec_t *spec, uint32_t sequence) {
+    uint32_t len = pack.tables[spec->table].count;
+    double inc = spec->hz >= 0 ? spec->hz * len / pack.sample_rate : spec->rate >= 0 ? spec->rate : 1.0;
+    double samples = spec->samples >= 0 ? spec->samples
+                     : spec->ms >= 0    ? spec->ms * pack.sample_rate / 1000.0
+                     : spec->cycles >= 0 && inc > 0 ? spec->cycles * len / inc
+                                                    : 0;
+    double phase_inc = round(inc * 65536.0);
+
+    if (phase_inc < 1 || phase_inc > UINT32_MAX) {
+        fail("secuencia %u: el ritmo %g no se puede representar en Q16.16", sequence, inc);
+    }
+    if (round(samples) > UINT32_MAX) {
+        fail("secuencia %u: el paso dura más de %u muestras", sequence, UINT32_MAX);
+    }
+    // Una duración de 0 muestras significa "sin fin", así que un paso pedido muy corto dura 1
+    bool timed = spec->samples >= 0 || spec->ms >= 0 || spec->cycles >= 0;
+    uint32_t duration = (uint32_t)round(samples);
+    return (wavepack_step_t){
+        .table = (uint16_t)spec->table,
+        .phase_inc = (uint32_t)phase_inc,
+        .samples = timed && !duration ? 1 : duration,
+    };
+}
+
+static void uf2_flush(sink_t *s) {
+    uint32_t block[128] = {
+        UF2_MAGIC_START0, UF2_MAGIC_START1, UF2_FLAG_FAMILY, s->base + s->block_no * UF2_PAYLOAD, UF2_PAYLOAD,
+        s->block_no, s->block_count, UF2_FAMILY_RP2040,
+    };
+
+    memcpy(&block[8], s->block, UF2_PAYLOAD);
+    block[127] = UF2_MAGIC_END;
+    if (fwrite(block, sizeof(block), 1, s->uf2) != 1) {
+        fail("no se pudo escribir el UF2: %s", strerror(errno));
+    }
+    memset(s->block, 0, sizeof(s->block));
+    s->fill = 0;
+    s->block_no++;
+}
+
+static void sink_write(sink_t *s, const void *data, size_t len) {
+    const uint8_t *src = (const uint8_t *)data;
+
+    if (fwrite(data, 1, len, s->image) != len) {
+        fail("no se pudo escribir la imagen: %s", strerror(errno));
+    }
+    while (s->uf2 && len) {
+        size_t chunk = UF2_PAYLOAD - s->fill < len ? UF2_PAYLOAD - s->fill : len;
+        memcpy(s->block + s->fill, src, chunk);
+        s->fill += (uint32_t)chunk;
+        src += chunk;
+        len -= chunk;
+        if (s->fill == UF2_PAYLOAD) {
+            uf2_flush(s);
+        }
+    }
+}
+
+/**
+ * Escribe la imagen completa: encabezado, directorio, tablas (copiadas del archivo temporal) y
+ * secuencias.
+ * @return Bytes de la imagen.
+ */
+static uint32_t write_image(sink_t *sink, uint64_t max_size) {
+    static wavepack_chunk_t dir[WAVEPACK_MAX_ENTRIES];
+    static wavepack_step_t steps[PACK_IO_SIZE / sizeof(wavepack_step_t)];
+    uint32_t entries = pack.table_count + pack.sequence_count;
+    uint64_t data_start = sizeof(wavepack_header_t) + entries * sizeof(wavepack_chunk_t);
+    uint64_t size = data_start + pack.spool_size;
+
+    // Directorio: las tablas pasan a posiciones absolutas y las secuencias van después
+    for (uint32_t i = 0; i < pack.table_count; ++i) {
+        dir[i] = pack.tables[i];
+        dir[i].offset += (uint32_t)data_start;
+    }
+    for (uint32_t i = 0; i < pack.sequence_count; ++i) {
+        const sequence_t *seq = &pack.sequences[i];
+        wavepack_chunk_t *c = &dir[pack.table_count + i];
+        c->type = WAVEPACK_SEQUENCE;
+        c->offset = (uint32_t)size;
+        c->count = seq->count;
+        c->crc = 0;
+        for (uint32_t k = 0; k < seq->count; ++k) {
+            wavepack_step_t step = resolve_step(&seq->steps[k], i);
+            c->crc = crc32_update(c->crc, &step, sizeof(step));
+        }
+        size += (uint64_t)seq->count * sizeof(wavepack_step_t);
+        if (size > UINT32_MAX) {
+            break;
+        }
+    }
+    if (size > max_size) {
+        fail("la imagen ocupa %llu bytes y el máximo es %llu", (unsigned long long)size, (unsigned long long)max_size);
+    }
+
+    wavepack_header_t header = {
+        .magic = WAVEPACK_MAGIC,
+        .version = WAVEPACK_VERSION,
+        .header_size = sizeof(wavepack_header_t),
+        .image_size = (uint32_t)size,
+        .sample_rate = pack.sample_rate,
+        .table_count = (uint16_t)pack.table_count,
+        .sequence_count = (uint16_t)pack.sequence_count,
+    };
+    header.crc = crc32_update(crc32_update(0, &header, offsetof(wavepack_header_t, crc)), dir,
+                              entries * sizeof(wavepack_chunk_t));
+
+    sink->block_count = (uint32_t)((size + UF2_PAYLOAD - 1) / UF2_PAYLOAD);
+    sink_write(sink, &header, sizeof(header));
+    sink_write(sink, dir, entries * sizeof(wavepack_chunk_t));
+
+    rewind(pack.spool);
+    for (uint64_t left = pack.spool_size; left;) {
+        size_t chunk = left < PACK_IO_SIZE ? (size_t)left : PACK_IO_SIZE;
+        if (fread(pack.out, 1, chunk, pack.spool) != chunk) {
+            fail("no se pudo leer el archivo temporal");
+        }
+        sink_write(sink, pack.out, chunk);
+        left -= chunk;
+    }
+
+    for (uint32_t i = 0; i < pack.sequence_count; ++i) {
+        const sequence_t *seq = &pack.sequences[i];
+        for (uint32_t k = 0; k < seq->count;) {
+            uint32_t n = 0;
+            while (k < seq->count && n < sizeof(steps) / sizeof(steps[0])) {
+                steps[n++] = resolve_step(&seq->steps[k++], i);
+            }
+            sink_write(sink, steps, n * sizeof(wavepack_step_t));
+        }
+    }
+    if (sink->uf2 && sink->fill) {
+        uf2_flush(sink);
+    }
+    return (uint32_t)size;
+}
+
+/**
+ * Valida una imagen, lista su contenido y mide la reproducción de cada secuencia.
+ */
+static int check_image(const char *path, uint64_t bench_samples) {
+    FILE *f = fopen(path, "rb");
+    uint8_t block[PACK_RENDER_BLOCK];
+    wavepack_t image;
+    wavepack_player_t player;
+
+    if (!f) {
+        fail("%s: %s", path, strerror(errno));
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    // malloc devuelve memoria alineada de sobra para WAVEPACK_ALIGN
+    uint8_t *data = malloc(size > 0 ? (size_t)size : 1);
+    if (!data || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        fail("%s: no se pudo leer", path);
+    }
+    fclose(f);
+
+    double t0 = now_s();
+    wavepack_result_t result = wavepack_open(&image, data, (size_t)size, true);
+    double t_open = now_s() - t0;
+    if (result != WAVEPACK_OK) {
+        printf("%s: %s (entrada %u)\n", path, wavepack_result_name(result), image.bad_entry);
+        return 1;
+    }
+    const wavepack_header_t *h = image.header;
+    printf("%s: %u bytes, %u Hz, %u tablas, %u secuencias; validada en %.3f ms (%.1f MB/s)\n", path,
+           h->image_size, h->sample_rate, h->table_count, h->sequence_count, t_open * 1e3,
+           h->image_size / t_open / 1e6);
+    for (uint32_t i = 0; i < h->table_count; ++i) {
+        printf("  tabla %u: %u muestras en 0x%08X\n", i, image.dir[i].count, image.dir[i].offset);
+    }
+    for (uint32_t i = 0; i < h->sequence_count; ++i) {
+        uint32_t count;
+        const wavepack_step_t *steps = wavepack_sequence(&image, i, &count);
+        printf("  secuencia %u: %u pasos\n", i, count);
+        for (uint32_t k = 0; k < count && k < 8; ++k) {
+            printf("    tabla %u, ritmo %.6f, %u muestras%s\n", steps[k].table, steps[k].phase_inc / 65536.0,
+                   steps[k].samples, steps[k].samples ? "" : " (sin fin)");
+        }
+        if (count > 8) {
+            printf("    ...\n");
+        }
+
+        uint32_t hash = 0;
+        wavepack_player_init(&player, &image, i);
+        t0 = now_s();
+        for (uint64_t done = 0; done < bench_samples; done += sizeof(block)) {
+            wavepack_player_render(&player, block, sizeof(block));
+            hash = hash * 31 + block[0];
+        }
+        double t = now_s() - t0;
+        printf("    reproducción: %.1f Mmuestras/s (%.2f ns por muestra, hash %08X)\n", bench_samples / t / 1e6,
+               t * 1e9 / bench_samples, hash);
+    }
+    free(data);
+    return 0;
+}
+
+static bool has_suffix(const char *name, const char *suffix) {
+    size_t len = strlen(name), slen = strlen(suffix);
+
+    if (len < slen) {
+        return false;
+    }
+    for (size_t i = 0; i < slen; ++i) {
+        char c = name[len - slen + i];
+        if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != suffix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *usage = "Uso: %s -o IMAGEN [-u UF2] [-b DIRECCIÓN] [-m BYTES] [-r HZ] [-c COLUMNA] [-k] entrada...\n"
+                        "     %s -t IMAGEN [-n MUESTRAS]\n";
+    const char *image_path = NULL, *uf2_path = NULL, *check_path = NULL;
+    unsigned long long max_size = 0, bench_samples = 16000000;
+    unsigned long base = PACK_DEFAULT_BASE, rate = 0;
+    int opt;
+
+    pack.column = WAVE_IMPORT_LAST;
+    while ((opt = getopt(argc, argv, "o:u:b:m:r:c:kt:n:")) != -1) {
+        switch (opt) {
+            case 'o': image_path = optarg; break;
+            case 'u': uf2_path = optarg; break;
+            case 'b': base = strtoul(optarg, NULL, 0); break;
+            case 'm': max_size = strtoull(optarg, NULL, 0); break;
+            case 'r': rate = strtoul(optarg, NULL, 0); break;
+            case 'c': {
+                char *end;
+                long column = strtol(optarg, &end, 10);
+                if (end == optarg || *end || column < 0 || column > INT16_MAX) {
+                    fprintf(stderr, usage, argv[0], argv[0]);
+                    return 2;
+                }
+                pack.column = (int)column;
+                break;
+            }
+            case 'k': pack.codes = true; break;
+            case 't': check_path = optarg; break;
+            case 'n': bench_samples = strtoull(optarg, NULL, 0); break;
+            default: fprintf(stderr, usage, argv[0], argv[0]); return 2;
+        }
+    }
+    if (check_path) {
+        return check_image(check_path, bench_samples ? bench_samples : 1);
+    }
+    if (!image_path || optind >= argc || base % UF2_PAYLOAD || rate > UINT32_MAX) {
+        fprintf(stderr, usage, argv[0], argv[0]);
+        return 2;
+    }
+    if (!max_size) {
+        max_size = uf2_path ? PACK_STORE_SIZE : UINT32_MAX;
+    }
+
+    pack.spool = tmpfile();
+    if (!pack.spool) {
+        fail("no se pudo crear el archivo temporal: %s", strerror(errno));
+    }
+    double t0 = now_s();
+    uint32_t json_rate = 0;
+    for (int i = optind; i < argc; ++i) {
+        if (has_suffix(argv[i], ".json")) {
+            uint32_t r = read_json(argv[i]);
+            json_rate = r ? r : json_rate;
+        } else {
+            read_table(argv[i], pack.column, pack.codes);
+            default_sequence(pack.table_count - 1);
+        }
+    }
+    pack.sample_rate = rate ? (uint32_t)rate : json_rate ? json_rate : PACK_DEFAULT_RATE;
+
+    sink_t sink = { .base = (uint32_t)base };
+    sink.image = strcmp(image_path, "-") ? fopen(image_path, "wb") : stdout;
+    if (!sink.image) {
+        fail("%s: %s", image_path, strerror(errno));
+    }
+    if (uf2_path) {
+        sink.uf2 = fopen(uf2_path, "wb");
+        if (!sink.uf2) {
+            fail("%s: %s", uf2_path, strerror(errno));
+        }
+    }
+    uint32_t size = write_image(&sink, max_size);
+    if (fclose(sink.image) || (sink.uf2 && fclose(sink.uf2))) {
+        fail("no se pudo cerrar la salida: %s", strerror(errno));
+    }
+    double t = now_s() - t0;
+
+    fprintf(stderr, "imagen: %u bytes, %u tablas, %u secuencias, %u Hz\n", size, pack.table_count,
+            pack.sequence_count, pack.sample_rate);
+    if (uf2_path) {
+        fprintf(stderr, "uf2: %u bloques desde 0x%08lX\n", sink.block_count, base);
+    }
+    fprintf(stderr, "entrada: %.1f MB, %llu muestras en %.3f s (%.1f MB/s, %.1f Mmuestras/s)\n", pack.bytes_in / 1e6,
+            (unsigned long long)pack.samples, t, pack.bytes_in / t / 1e6, pack.samples / t / 1e6);
+    return 0;
+}
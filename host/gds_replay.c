@@ -0,0 +1,229 @@
+/**
+ * @file gds_replay.c
+ *
+ * @brief Simulador en la máquina anfitriona que reproduce sesiones registradas por el firmware.
+ *
+ * Lee archivos de consola capturados con el firmware compilado con INPUT_LOG_ENABLED=1, extrae
+ * las líneas `@EV,...` y las entrega al mismo motor (siggen/engine.c) que corre en la Pico. El
+ * reloj es virtual: cada evento fija el instante actual, por lo que la reproducción es determinista
+ * y no espera el tiempo real entre pulsaciones. Para cada sesión se imprime un resumen con la
+ * cantidad de eventos, los aceptados por el antirrebote, el tiempo simulado, la aceleración
+ * respecto al tiempo real y un hash FNV-1a de la salida, útil para comparar miles de sesiones.
+ *
+ * Uso: gds_replay [-q] [-o DIR] [-r N] [-t ARCHIVO] registro...
+ *  - -q          No imprimir la salida capturada del motor.
+ *  - -o DIR      Guardar la salida capturada de cada sesión en DIR/<registro>.out.
+ *  - -r N        Reproducir cada sesión N veces y verificar que el hash no cambie.
+ *  - -t ARCHIVO  Agregar a ARCHIVO la traza de cada sesión, con el reloj virtual en uS, para
+ *                tools/trace_to_chrome.py. Requiere compilar con make TRACE=1.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "../siggen/engine.h"
+#include "../siggen/input_log.h"
+#include "../siggen/trace.h"
+
+/**
+ * Destino de la salida del motor durante una reproducción.
+ */
+typedef struct {
+    FILE *file; ///< Archivo donde se copia la salida, o NULL
+    uint64_t hash; ///< Hash FNV-1a de toda la salida
+} capture_t;
+
+/**
+ * Teclas del evento que se está reproduciendo. El barrido simulado devuelve lo que el barrido
+ * real encontró en la Pico.
+ */
+static int replay_scan(void *ctx, char *keys, int max) {
+    const input_event_t *ev = (const input_event_t *)ctx;
+    int count = ev->nkeys < max ? ev->nkeys : max;
+
+    memcpy(keys, ev->keys, count);
+    return count;
+}
+
+static void capture_output(void *ctx, const char *text) {
+    capture_t *cap = (capture_t *)ctx;
+
+    for (const char *p = text; *p; ++p) {
+        cap->hash ^= (uint8_t)*p;
+        cap->hash *= 1099511628211ULL;
+    }
+    if (cap->file) {
+        fputs(text, cap->file);
+    }
+}
+
+static uint64_t wall_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+/**
+ * Resultado de reproducir una sesión.
+ */
+typedef struct {
+    unsigned long events; ///< Eventos leídos
+    unsigned long accepted; ///< Eventos que superaron el antirrebote
+    uint32_t sim_ms; ///< Duración simulada (instante del último evento)
+    uint64_t hash; ///< Hash de la salida
+} replay_result_t;
+
+static int replay_file(const char *path, FILE *out, replay_result_t *res) {
+    FILE *in = fopen(path, "r");
+    char line[256];
+    engine_t engine;
+    capture_t cap = { out, 1469598103934665603ULL };
+    input_event_t ev;
+
+    if (!in) {
+        perror(path);
+        return -1;
+    }
+
+    memset(res, 0, sizeof(*res));
+    engine_init(&engine, capture_output, &cap);
+    while (fgets(line, sizeof(line), in)) {
+        if (!input_log_parse(line, &ev)) {
+            continue;
+        }
+        res->events++;
+#if SIGGEN_TRACE
+        trace_sim_clock = ev.t_ms * 1000;
+#endif
+        TRACE_BEGIN(TRACE_ID_ENGINE_INPUT);
+        if (engine_gpio_event(&engine, ev.t_ms, ev.gpio, replay_scan, &ev)) {
+            res->accepted++;
+        }
+        TRACE_END(TRACE_ID_ENGINE_INPUT);
+        res->sim_ms = ev.t_ms;
+    }
+    fclose(in);
+
+    res->hash = cap.hash;
+    return 0;
+}
+
+static void write_text(void *ctx, const char *text) {
+    fputs(text, (FILE *)ctx);
+}
+
+/**
+ * Abre DIR/<registro>.out para la salida capturada de la sesión.
+ * @param name Recibe el nombre del archivo, para borrarlo si la sesión falla.
+ */
+static FILE *open_capture(const char *dir, const char *path, char *name, size_t size) {
+    const char *base = strrchr(path, '/');
+
+    base = base ? base + 1 : path;
+    snprintf(name, size, "%s/%s.out", dir, base);
+    FILE *f = fopen(name, "w");
+    if (!f) {
+        perror(name);
+    }
+    return f;
+}
+
+int main(int argc, char **argv) {
+    const char *outdir = NULL;
+    FILE *trace_file = NULL;
+    int quiet = 0, repeat = 1, opt, status = 0;
+    unsigned long total_events = 0, sessions = 0;
+    uint64_t total_sim_ms = 0, start = wall_us();
+
+    while ((opt = getopt(argc, argv, "qo:r:t:")) != -1) {
+        switch (opt) {
+            case 'q': quiet = 1; break;
+            case 'o': outdir = optarg; break;
+            case 'r': repeat = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+            case 't':
+                if (!SIGGEN_TRACE) {
+                    fprintf(stderr, "%s: -t requiere compilar con make TRACE=1\n", argv[0]);
+                    return 2;
+                }
+                if (!(trace_file = fopen(optarg, "w"))) {
+                    perror(optarg);
+                    return 2;
+                }
+                break;
+            default:
+                fprintf(stderr, "Uso: %s [-q] [-o DIR] [-r N] [-t ARCHIVO] registro...\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Uso: %s [-q] [-o DIR] [-r N] [-t ARCHIVO] registro...\n", argv[0]);
+        return 2;
+    }
+
+    for (int i = optind; i < argc; ++i) {
+        replay_result_t res, again;
+        char out_name[1024];
+        FILE *out = quiet ? NULL : stdout;
+        uint64_t t0 = wall_us();
+
+        if (outdir && !(out = open_capture(outdir, argv[i], out_name, sizeof(out_name)))) {
+            status = 1;
+            continue;
+        }
+        if (trace_file) {
+            trace_start();
+        }
+        int failed = replay_file(argv[i], out, &res) != 0;
+        if (outdir) {
+            if (fclose(out) != 0 && !failed) {
+                perror(out_name);
+                failed = 1;
+            }
+            if (failed) {
+                remove(out_name);
+            }
+        }
+        if (failed) {
+            if (trace_file) {
+                trace_stop();
+            }
+            status = 1;
+            continue;
+        }
+        if (trace_file) {
+            trace_stop();
+            trace_dump(1000000, write_text, trace_file);
+        }
+        for (int r = 1; r < repeat; ++r) {
+            replay_file(argv[i], NULL, &again);
+            if (again.hash != res.hash) {
+                fprintf(stderr, "%s: la repetición %d no es determinista\n", argv[i], r);
+                status = 1;
+            }
+        }
+
+        double elapsed_us = (double)(wall_us() - t0) / repeat;
+        printf("%s: eventos=%lu aceptados=%lu simulado=%lu ms real=%.1f us aceleracion=%.0fx hash=%016llx\n",
+               argv[i], res.events, res.accepted, (unsigned long)res.sim_ms, elapsed_us,
+               elapsed_us > 0 ? res.sim_ms * 1000.0 / elapsed_us : 0.0, (unsigned long long)res.hash);
+
+        total_events += res.events;
+        total_sim_ms += res.sim_ms;
+        sessions++;
+    }
+
+    if (trace_file) {
+        fclose(trace_file);
+    }
+
+    double total_us = (double)(wall_us() - start);
+    printf("Total: sesiones=%lu eventos=%lu simulado=%llu ms real=%.0f us aceleracion=%.0fx\n",
+           sessions, total_events, (unsigned long long)total_sim_ms, total_us,
+           total_us > 0 ? total_sim_ms * 1000.0 * repeat / total_us : 0.0);
+    return status;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file dac_out.pio.h
+ *
+ * @brief dac_out.pio ensamblado a mano para compilar dac_out.c sobre la placa simulada, con la
+ * misma forma que la salida de `pioasm -o c-sdk`. La función de inicialización es la del bloque
+ * "% c-sdk" de dac_out.pio; si cambia el programa, hay que actualizar las dos copias.
+ */
+
+#ifndef HAL_DAC_OUT_PIO_H
+#define HAL_DAC_OUT_PIO_H
+
+#include "hardware/pio.h"
+
+#define dac_out_wrap_target 5
+#define dac_out_wrap 5
+
+#define dac_out_offset_armed 0u
+#define dac_out_offset_start 5u
+
+static const uint16_t dac_out_program_instructions[] = {
+    0xa0e3, //  0: mov    osr, null
+    0x6060, //  1: out    null, 32
+    0x2020, //  2: wait   0 pin, 0
+    0x20a0, //  3: wait   1 pin, 0
+    0xc010, //  4: irq    nowait 0 rel
+    //     .wrap_target
+    0x6008, //  5: out    pins, 8
+    //     .wrap
+};
+
+static const pio_program_t dac_out_program = {
+    .instructions = dac_out_program_instructions,
+    .length = 6,
+    .origin = -1,
+};
+
+static inline pio_sm_config dac_out_program_get_default_config(unsigned offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + dac_out_wrap_target, offset + dac_out_wrap);
+    return c;
+}
+
+#include "hardware/clocks.h"
+
+/**
+ * Configura la máquina de estados para sacar 8 bits consecutivos a partir de pin_base, a
+ * sample_rate muestras por segundo. Queda lista para el arranque normal.
+ */
+static inline void dac_out_program_init(PIO pio, uint sm, uint offset, uint pin_base, uint32_t sample_rate) {
+    pio_sm_config c = dac_out_program_get_default_config(offset);
+    uint32_t div_q8 = (uint32_t)(((uint64_t)clock_get_hz(clk_sys) << 8) / sample_rate);
+
+    sm_config_set_out_pins(&c, pin_base, 8);
+    sm_config_set_out_shift(&c, true, true, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv_int_frac(&c, (uint16_t)(div_q8 >> 8), (uint8_t)(div_q8 & 0xFF));
+
+    for (uint i = 0; i < 8; i++) {
+        pio_gpio_init(pio, pin_base + i);
+    }
+    pio_sm_set_consecutive_pindirs(pio, sm, pin_base, 8, true);
+    pio_sm_init(pio, sm, offset + dac_out_offset_start, &c);
+}
+
+#endif
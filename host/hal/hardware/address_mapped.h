@@ -0,0 +1,25 @@
+/**
+ * @file address_mapped.h
+ *
+ * @brief Reemplazo de hardware/address_mapped.h: las escrituras atómicas de bits son escrituras
+ * normales, porque el núcleo simulado es uno solo.
+ */
+
+#ifndef HAL_HARDWARE_ADDRESS_MAPPED_H
+#define HAL_HARDWARE_ADDRESS_MAPPED_H
+
+#include <stdint.h>
+
+static inline void hw_set_bits(volatile uint32_t *addr, uint32_t mask) {
+    *addr |= mask;
+}
+
+static inline void hw_clear_bits(volatile uint32_t *addr, uint32_t mask) {
+    *addr &= ~mask;
+}
+
+static inline void hw_write_masked(volatile uint32_t *addr, uint32_t values, uint32_t write_mask) {
+    *addr = (*addr & ~write_mask) | (values & write_mask);
+}
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * @file clocks.h
+ *
+ * @brief Reemplazo de hardware/clocks.h: todos los relojes valen lo que el reloj del sistema
+ * simulado.
+ */
+
+#ifndef HAL_HARDWARE_CLOCKS_H
+#define HAL_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+#include "hal_sim.h"
+
+enum clock_index { clk_gpout0 = 0, clk_ref = 4, clk_sys = 5, clk_peri = 6, clk_usb = 7, clk_adc = 8, clk_rtc = 9 };
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index) {
+    (void)clk_index;
+    return hal_sim_clk_sys_hz();
+}
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * @file dma.h
+ *
+ * @brief Reemplazo de hardware/dma.h sobre el controlador de dma_sim de la placa simulada. Las
+ * funciones tienen los nombres y la semántica de las del SDK; dma_hw->ch[n] da acceso a los
+ * registros de dma_sim_channel_t (read_addr, write_addr, transfer_count y al1_ctrl, el alias de
+ * CTRL sin disparo).
+ */
+
+#ifndef HAL_HARDWARE_DMA_H
+#define HAL_HARDWARE_DMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hal_sim.h"
+#include "hardware/address_mapped.h"
+
+#define dma_hw (&hal_sim_dma)
+
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB DMA_SIM_CTRL_CHAIN_TO_LSB
+#define DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS (0xFu << DMA_SIM_CTRL_CHAIN_TO_LSB)
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+
+void dma_channel_unclaim(unsigned channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->ctrl = (c->ctrl & ~(3u << DMA_SIM_CTRL_DATA_SIZE_LSB)) | ((uint32_t)size << DMA_SIM_CTRL_DATA_SIZE_LSB);
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->ctrl = incr ? c->ctrl | DMA_SIM_CTRL_INCR_READ : c->ctrl & ~DMA_SIM_CTRL_INCR_READ;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->ctrl = incr ? c->ctrl | DMA_SIM_CTRL_INCR_WRITE : c->ctrl & ~DMA_SIM_CTRL_INCR_WRITE;
+}
+
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, unsigned size_bits) {
+    c->ctrl = (c->ctrl & ~((0xFu << DMA_SIM_CTRL_RING_SIZE_LSB) | DMA_SIM_CTRL_RING_SEL)) |
+              (size_bits << DMA_SIM_CTRL_RING_SIZE_LSB) | (write ? DMA_SIM_CTRL_RING_SEL : 0);
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, unsigned dreq) {
+    c->ctrl = (c->ctrl & ~(0x3Fu << DMA_SIM_CTRL_TREQ_SEL_LSB)) | (dreq << DMA_SIM_CTRL_TREQ_SEL_LSB);
+}
+
+static inline void channel_config_set_chain_to(dma_channel_config *c, unsigned chain_to) {
+    c->ctrl = (c->ctrl & ~DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS) | (chain_to << DMA_SIM_CTRL_CHAIN_TO_LSB);
+}
+
+static inline void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet) {
+    c->ctrl = irq_quiet ? c->ctrl | DMA_SIM_CTRL_IRQ_QUIET : c->ctrl & ~DMA_SIM_CTRL_IRQ_QUIET;
+}
+
+static inline void channel_config_set_enable(dma_channel_config *c, bool enable) {
+    c->ctrl = enable ? c->ctrl | DMA_SIM_CTRL_EN : c->ctrl & ~DMA_SIM_CTRL_EN;
+}
+
+/**
+ * Configuración por defecto del SDK: habilitado, palabras, lectura incremental, sin anillo, sin
+ * encadenamiento (chain_to al mismo canal) y sin DREQ.
+ */
+static inline dma_channel_config dma_channel_get_default_config(unsigned channel) {
+    dma_channel_config c = { DMA_SIM_CTRL_EN | DMA_SIM_CTRL_INCR_READ };
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_chain_to(&c, channel);
+    channel_config_set_dreq(&c, DMA_SIM_DREQ_FORCE);
+    return c;
+}
+
+static inline void dma_channel_set_config(unsigned channel, const dma_channel_config *config, bool trigger) {
+    dma_hw->ch[channel].al1_ctrl = (dma_hw->ch[channel].al1_ctrl & DMA_SIM_CTRL_BUSY) | config->ctrl;
+    if (trigger) {
+        dma_sim_trigger(dma_hw, channel);
+    }
+}
+
+static inline void dma_channel_set_read_addr(unsigned channel, const volatile void *read_addr, bool trigger) {
+    dma_hw->ch[channel].read_addr = (uintptr_t)read_addr;
+    if (trigger) {
+        dma_sim_trigger(dma_hw, channel);
+    }
+}
+
+static inline void dma_channel_set_write_addr(unsigned channel, volatile void *write_addr, bool trigger) {
+    dma_hw->ch[channel].write_addr = (uintptr_t)write_addr;
+    if (trigger) {
+        dma_sim_trigger(dma_hw, channel);
+    }
+}
+
+static inline void dma_channel_set_trans_count(unsigned channel, uint32_t trans_count, bool trigger) {
+    dma_sim_set_trans_count(dma_hw, channel, trans_count, trigger);
+}
+
+static inline void dma_channel_configure(unsigned channel, const dma_channel_config *config, volatile void *write_addr,
+                                         const volatile void *read_addr, unsigned transfer_count, bool trigger) {
+    dma_channel_set_write_addr(channel, write_addr, false);
+    dma_channel_set_read_addr(channel, read_addr, false);
+    dma_channel_set_trans_count(channel, transfer_count, false);
+    dma_channel_set_config(channel, config, trigger);
+}
+
+static inline void dma_channel_start(unsigned channel) {
+    dma_sim_trigger(dma_hw, channel);
+}
+
+static inline void dma_channel_abort(unsigned channel) {
+    dma_sim_abort(dma_hw, channel);
+}
+
+static inline bool dma_channel_is_busy(unsigned channel) {
+    return dma_sim_busy(dma_hw, channel);
+}
+
+static inline void dma_channel_set_irq0_enabled(unsigned channel, bool enabled) {
+    dma_hw->inte0 = enabled ? dma_hw->inte0 | (1u << channel) : dma_hw->inte0 & ~(1u << channel);
+}
+
+static inline void dma_channel_set_irq1_enabled(unsigned channel, bool enabled) {
+    dma_hw->inte1 = enabled ? dma_hw->inte1 | (1u << channel) : dma_hw->inte1 & ~(1u << channel);
+}
+
+static inline bool dma_channel_get_irq0_status(unsigned channel) {
+    return dma_sim_ints(dma_hw, 0) & (1u << channel);
+}
+
+static inline bool dma_channel_get_irq1_status(unsigned channel) {
+    return dma_sim_ints(dma_hw, 1) & (1u << channel);
+}
+
+static inline void dma_channel_acknowledge_irq0(unsigned channel) {
+    dma_hw->intr &= ~(1u << channel);
+}
+
+static inline void dma_channel_acknowledge_irq1(unsigned channel) {
+    dma_hw->intr &= ~(1u << channel);
+}
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * @file irq.h
+ *
+ * @brief Reemplazo de hardware/irq.h para las interrupciones que genera la placa simulada (las
+ * del DMA). Las prioridades se aceptan pero no se modelan: hay un solo núcleo y una rutina a la
+ * vez.
+ */
+
+#ifndef HAL_HARDWARE_IRQ_H
+#define HAL_HARDWARE_IRQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hal_sim.h"
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+
+typedef void (*irq_handler_t)(void);
+
+static inline void irq_set_exclusive_handler(unsigned num, irq_handler_t handler) {
+    hal_sim_set_irq_handler(num, handler);
+}
+
+static inline void irq_set_enabled(unsigned num, bool enabled) {
+    hal_sim_set_irq_enabled(num, enabled);
+}
+
+static inline void irq_set_priority(unsigned num, uint8_t hardware_priority) {
+    (void)num;
+    (void)hardware_priority;
+}
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file pio.h
+ *
+ * @brief Reemplazo de hardware/pio.h sobre los bloques de pio_sim de la placa simulada. La
+ * configuración de una máquina (pio_sm_config) es directamente un pio_sim_config_t; las funciones
+ * tienen los nombres y la semántica de las del SDK que usan los programas del proyecto.
+ */
+
+#ifndef HAL_HARDWARE_PIO_H
+#define HAL_HARDWARE_PIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico.h"
+#include "hal_sim.h"
+
+typedef pio_hw_t *PIO;
+typedef pio_sim_config_t pio_sm_config;
+
+#define pio0 (&hal_sim_pio_hw[0])
+#define pio1 (&hal_sim_pio_hw[1])
+
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin; ///< Dirección fija, o -1 para cualquiera
+} pio_program_t;
+
+enum pio_fifo_join { PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX = 1, PIO_FIFO_JOIN_RX = 2 };
+enum pio_src_dest { pio_pins = 0, pio_x = 1, pio_y = 2, pio_null = 3, pio_pindirs = 4, pio_pc = 5, pio_isr = 6, pio_osr = 7 };
+
+/**
+ * pio_sim del bloque PIO.
+ */
+static inline pio_sim_t *pio_sim_of(PIO pio) {
+    return &hal_sim_pio[pio - hal_sim_pio_hw];
+}
+
+static inline unsigned pio_get_index(PIO pio) {
+    return (unsigned)(pio - hal_sim_pio_hw);
+}
+
+/**
+ * DREQ del FIFO TX o RX de una máquina: DREQ_PIO0_TX0 es 0 y cada bloque ocupa 8.
+ */
+static inline unsigned pio_get_dreq(PIO pio, unsigned sm, bool is_tx) {
+    return pio_get_index(pio) * 8 + (is_tx ? 0 : 4) + sm;
+}
+
+unsigned pio_add_program(PIO pio, const pio_program_t *program);
+
+int pio_claim_unused_sm(PIO pio, bool required);
+
+static inline pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config c;
+    pio_sim_config_default(&c);
+    return c;
+}
+
+static inline void sm_config_set_wrap(pio_sm_config *c, unsigned wrap_target, unsigned wrap) {
+    c->wrap_target = (uint8_t)wrap_target;
+    c->wrap = (uint8_t)wrap;
+}
+
+static inline void sm_config_set_out_pins(pio_sm_config *c, unsigned out_base, unsigned out_count) {
+    c->out_base = (uint8_t)out_base;
+    c->out_count = (uint8_t)out_count;
+}
+
+static inline void sm_config_set_set_pins(pio_sm_config *c, unsigned set_base, unsigned set_count) {
+    c->set_base = (uint8_t)set_base;
+    c->set_count = (uint8_t)set_count;
+}
+
+static inline void sm_config_set_in_pins(pio_sm_config *c, unsigned in_base) {
+    c->in_base = (uint8_t)in_base;
+}
+
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, unsigned sideset_base) {
+    c->sideset_base = (uint8_t)sideset_base;
+}
+
+static inline void sm_config_set_sideset(pio_sm_config *c, unsigned bit_count, bool optional, bool pindirs) {
+    c->sideset_bits = (uint8_t)bit_count;
+    c->sideset_opt = optional;
+    c->sideset_pindirs = pindirs;
+}
+
+static inline void sm_config_set_jmp_pin(pio_sm_config *c, unsigned pin) {
+    c->jmp_pin = (uint8_t)pin;
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, unsigned pull_threshold) {
+    c->out_shift_right = shift_right;
+    c->autopull = autopull;
+    c->pull_threshold = (uint8_t)(pull_threshold & 31);
+}
+
+static inline void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, unsigned push_threshold) {
+    c->in_shift_right = shift_right;
+    c->autopush = autopush;
+    c->push_threshold = (uint8_t)(push_threshold & 31);
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {
+    c->join_tx = join == PIO_FIFO_JOIN_TX;
+    c->join_rx = join == PIO_FIFO_JOIN_RX;
+}
+
+static inline void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac) {
+    c->clkdiv_q8 = (uint32_t)div_int << 8 | div_frac;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdiv_q8 = (uint32_t)(div * 256.0f);
+}
+
+static inline void pio_gpio_init(PIO pio, unsigned pin) {
+    (void)pio;
+    (void)pin;
+}
+
+static inline void pio_sm_set_consecutive_pindirs(PIO pio, unsigned sm, unsigned pin_base, unsigned pin_count, bool is_out) {
+    pio_sim_t *p = pio_sim_of(pio);
+    uint32_t mask = (pin_count >= 32 ? 0xFFFFFFFFu : (1u << pin_count) - 1) << pin_base;
+
+    (void)sm;
+    p->pindirs = is_out ? p->pindirs | mask : p->pindirs & ~mask;
+}
+
+static inline void pio_sm_init(PIO pio, unsigned sm, unsigned initial_pc, const pio_sm_config *config) {
+    pio_sim_sm_init(pio_sim_of(pio), sm, initial_pc, config);
+}
+
+static inline void pio_sm_set_enabled(PIO pio, unsigned sm, bool enabled) {
+    pio_sim_set_enabled(pio_sim_of(pio), sm, enabled);
+}
+
+static inline void pio_sm_exec(PIO pio, unsigned sm, unsigned instr) {
+    pio_sim_exec(pio_sim_of(pio), sm, (uint16_t)instr);
+}
+
+static inline void pio_sm_set_in_pins(PIO pio, unsigned sm, unsigned in_base) {
+    pio_sim_of(pio)->sm[sm].cfg.in_base = (uint8_t)in_base;
+}
+
+static inline void pio_sm_restart(PIO pio, unsigned sm) {
+    pio_sim_restart(pio_sim_of(pio), sm, false);
+}
+
+static inline void pio_sm_clkdiv_restart(PIO pio, unsigned sm) {
+    pio_sim_of(pio)->sm[sm].div_acc = 0;
+}
+
+/**
+ * JMP incondicional, como pio_encode_jmp() de hardware/pio_instructions.h.
+ */
+static inline unsigned pio_encode_jmp(unsigned addr) {
+    return addr & 0x1F;
+}
+
+/**
+ * OUT dest, count, como pio_encode_out() de hardware/pio_instructions.h.
+ */
+static inline unsigned pio_encode_out(enum pio_src_dest dest, unsigned count) {
+    return 0x6000u | ((unsigned)dest << 5) | (count & 0x1F);
+}
+
+static inline bool pio_interrupt_get(PIO pio, unsigned irq) {
+    return (pio_sim_of(pio)->irq >> irq) & 1;
+}
+
+static inline void pio_interrupt_clear(PIO pio, unsigned irq) {
+    pio_sim_of(pio)->irq &= (uint8_t)~(1u << irq);
+}
+
+static inline void pio_sm_clear_fifos(PIO pio, unsigned sm) {
+    pio_sim_sm_t *s = &pio_sim_of(pio)->sm[sm];
+    s->tx.level = 0;
+    s->rx.level = 0;
+}
+
+static inline void pio_sm_put(PIO pio, unsigned sm, uint32_t data) {
+    pio_sim_put(pio_sim_of(pio), sm, data);
+}
+
+static inline uint32_t pio_sm_get(PIO pio, unsigned sm) {
+    uint32_t data = 0;
+    pio_sim_get(pio_sim_of(pio), sm, &data);
+    return data;
+}
+
+#endif
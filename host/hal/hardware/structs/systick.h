@@ -0,0 +1,15 @@
+/**
+ * @file systick.h
+ *
+ * @brief Reemplazo de hardware/structs/systick.h: el SysTick del núcleo simulado, que sigue al
+ * reloj virtual.
+ */
+
+#ifndef HAL_HARDWARE_STRUCTS_SYSTICK_H
+#define HAL_HARDWARE_STRUCTS_SYSTICK_H
+
+#include "hal_sim.h"
+
+#define systick_hw (&hal_sim_systick)
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * @file sync.h
+ *
+ * @brief Reemplazo de hardware/sync.h: enmascara las interrupciones del núcleo simulado.
+ */
+
+#ifndef HAL_HARDWARE_SYNC_H
+#define HAL_HARDWARE_SYNC_H
+
+#include <stdint.h>
+#include "hal_sim.h"
+
+static inline uint32_t save_and_disable_interrupts(void) {
+    return hal_sim_disable_interrupts();
+}
+
+static inline void restore_interrupts(uint32_t status) {
+    hal_sim_restore_interrupts(status);
+}
+
+#endif
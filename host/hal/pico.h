@@ -0,0 +1,12 @@
+/**
+ * @file pico.h
+ *
+ * @brief Reemplazo de pico.h: los tipos básicos del SDK.
+ */
+
+#ifndef HAL_PICO_H
+#define HAL_PICO_H
+
+typedef unsigned int uint;
+
+#endif
@@ -0,0 +1,27 @@
+/**
+ * @file stdlib.h
+ *
+ * @brief Reemplazo de pico/stdlib.h para compilar código del firmware sobre hal_sim.h: tipos,
+ * panic() y el tiempo del reloj virtual.
+ */
+
+#ifndef HAL_PICO_STDLIB_H
+#define HAL_PICO_STDLIB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "pico.h"
+#include "hal_sim.h"
+
+#define panic hal_sim_panic
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)hal_sim_time_us();
+}
+
+static inline uint64_t time_us_64(void) {
+    return hal_sim_time_us();
+}
+
+#endif
@@ -0,0 +1,309 @@
+/**
+ * @file hal_sim.c
+ *
+ * @brief Implementación de la placa simulada: reparto de canales, máquinas y memoria de
+ * instrucciones, conexión del DMA con los FIFO de los PIO y el bucle que avanza el reloj.
+ */
+
+#include "hal_sim.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "../siggen/trace.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+pio_sim_t hal_sim_pio[HAL_SIM_PIO_COUNT];
+pio_hw_t hal_sim_pio_hw[HAL_SIM_PIO_COUNT];
+dma_sim_t hal_sim_dma;
+systick_hw_t hal_sim_systick;
+
+static uint32_t clk_sys_hz; ///< Reloj del sistema simulado
+static uint32_t irq_latency; ///< Ciclos desde que se levanta una interrupción hasta su rutina
+static void (*irq_handlers[HAL_SIM_IRQ_COUNT])(void); ///< Rutinas registradas
+static uint32_t irq_enabled; ///< Interrupciones habilitadas en el NVIC
+static bool irq_masked; ///< Interrupciones enmascaradas con save_and_disable_interrupts()
+static bool irq_raised; ///< Hay una interrupción levantada esperando su rutina
+static uint64_t irq_due; ///< Ciclo en que se atiende la interrupción levantada
+static uint32_t dma_claimed; ///< Canales de DMA en uso
+static uint8_t sm_claimed[HAL_SIM_PIO_COUNT]; ///< Máquinas en uso de cada bloque
+static uint32_t program_used[HAL_SIM_PIO_COUNT]; ///< Direcciones de instrucción ocupadas de cada bloque
+static hal_sim_observer_fn observer; ///< Se llama después de cada ciclo en que avanzó una máquina
+static void *observer_ctx; ///< Contexto del observador
+
+/**
+ * Bloque y máquina del FIFO en addr, si addr es uno de los registros de hal_sim_pio_hw.
+ */
+static bool fifo_at(uintptr_t addr, bool tx, unsigned *pio, unsigned *sm) {
+    for (unsigned i = 0; i < HAL_SIM_PIO_COUNT; ++i) {
+        uintptr_t base = (uintptr_t)(tx ? hal_sim_pio_hw[i].txf : hal_sim_pio_hw[i].rxf);
+        if (addr >= base && addr < base + sizeof(hal_sim_pio_hw[i].txf)) {
+            *pio = i;
+            *sm = (unsigned)(addr - base) / sizeof(uint32_t);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool port_dreq(void *ctx, unsigned dreq) {
+    (void)ctx;
+    if (dreq >= 8 * HAL_SIM_PIO_COUNT) {
+        return false;
+    }
+    const pio_sim_t *pio = &hal_sim_pio[dreq / 8];
+    return dreq & 4 ? pio_sim_rx_dreq(pio, dreq & 3) : pio_sim_tx_dreq(pio, dreq & 3);
+}
+
+static bool port_write(void *ctx, uintptr_t addr, uint32_t value, unsigned size) {
+    unsigned pio, sm;
+
+    (void)ctx;
+    (void)size;
+    if (!fifo_at(addr, true, &pio, &sm)) {
+        return false;
+    }
+    pio_sim_put(&hal_sim_pio[pio], sm, value);
+    return true;
+}
+
+static bool port_read(void *ctx, uintptr_t addr, uint32_t *value, unsigned size) {
+    unsigned pio, sm;
+
+    (void)ctx;
+    (void)size;
+    if (!fifo_at(addr, false, &pio, &sm)) {
+        return false;
+    }
+    pio_sim_get(&hal_sim_pio[pio], sm, value);
+    return true;
+}
+
+/**
+ * Reinicia la placa: PIO y DMA vacíos, sin interrupciones registradas y con el reloj en cero.
+ * @param clk_sys_hz_ Reloj del sistema (Hz).
+ * @param irq_latency_ Ciclos entre el pedido de una interrupción y su rutina (al menos 1); el
+ * Cortex-M0+ tarda 15 sin espera de memoria.
+ */
+void hal_sim_init(uint32_t clk_sys_hz_, uint32_t irq_latency_) {
+    static const dma_sim_port_t port = { NULL, port_dreq, port_write, port_read };
+
+    for (unsigned i = 0; i < HAL_SIM_PIO_COUNT; ++i) {
+        pio_sim_init(&hal_sim_pio[i]);
+        sm_claimed[i] = 0;
+        program_used[i] = 0;
+    }
+    memset(hal_sim_pio_hw, 0, sizeof(hal_sim_pio_hw));
+    dma_sim_init(&hal_sim_dma, &port);
+    clk_sys_hz = clk_sys_hz_;
+    irq_latency = irq_latency_ ? irq_latency_ : 1;
+    memset(irq_handlers, 0, sizeof(irq_handlers));
+    irq_enabled = 0;
+    irq_masked = false;
+    irq_raised = false;
+    dma_claimed = 0;
+    hal_sim_systick.cvr = 0xFFFFFF;
+}
+
+/**
+ * Registra una función que se llama después de cada ciclo en que avanzó alguna máquina de
+ * estados, por ejemplo para leer los pines.
+ */
+void hal_sim_set_observer(hal_sim_observer_fn fn, void *ctx) {
+    observer = fn;
+    observer_ctx = ctx;
+}
+
+uint64_t hal_sim_cycle(void) {
+    return hal_sim_pio[0].cycle;
+}
+
+uint32_t hal_sim_clk_sys_hz(void) {
+    return clk_sys_hz;
+}
+
+uint64_t hal_sim_time_us(void) {
+    return hal_sim_cycle() * 1000000 / clk_sys_hz;
+}
+
+/**
+ * Actualiza los relojes que leen las rutinas: el SysTick y, con SIGGEN_TRACE, el de la traza.
+ */
+static void update_systick(void) {
+    hal_sim_systick.cvr = (uint32_t)~hal_sim_cycle() & 0xFFFFFF;
+#if SIGGEN_TRACE
+    trace_sim_clock = (uint32_t)hal_sim_cycle();
+#endif
+}
+
+/**
+ * Interrupciones del DMA pedidas y habilitadas en el NVIC, como máscara de números de IRQ.
+ */
+static uint32_t pending_irqs(void) {
+    uint32_t pending = 0;
+
+    if (dma_sim_ints(&hal_sim_dma, 0)) {
+        pending |= 1u << DMA_IRQ_0;
+    }
+    if (dma_sim_ints(&hal_sim_dma, 1)) {
+        pending |= 1u << DMA_IRQ_1;
+    }
+    return pending & irq_enabled;
+}
+
+/**
+ * Avanza el reloj de todos los bloques PIO sin que ejecute ninguna máquina.
+ */
+static void skip_all(uint64_t cycles) {
+    while (cycles) {
+        uint32_t chunk = cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+        for (unsigned i = 0; i < HAL_SIM_PIO_COUNT; ++i) {
+            pio_sim_skip(&hal_sim_pio[i], chunk);
+        }
+        cycles -= chunk;
+    }
+}
+
+/**
+ * Simula hasta el ciclo until. En cada ciclo el DMA hace las transferencias que permiten los DREQ,
+ * se atienden las interrupciones vencidas y avanzan las máquinas; los ciclos en que ninguna
+ * máquina avanza y no vence ninguna interrupción se saltan de una vez.
+ * @param until Ciclo del reloj del sistema en que termina.
+ * @param wfe Volver después de la primera rutina de interrupción, como __wfe().
+ * @return true si volvió por una interrupción.
+ */
+bool hal_sim_run(uint64_t until, bool wfe) {
+    for (;;) {
+        uint64_t now = hal_sim_cycle();
+
+        dma_sim_service(&hal_sim_dma);
+        uint32_t pending = irq_masked ? 0 : pending_irqs();
+        if (!pending) {
+            irq_raised = false;
+        } else if (!irq_raised) {
+            irq_raised = true;
+            irq_due = now + irq_latency;
+        } else if (now >= irq_due) {
+            update_systick();
+            for (unsigned irq = 0; irq < HAL_SIM_IRQ_COUNT; ++irq) {
+                if ((pending & (1u << irq)) && irq_handlers[irq]) {
+                    irq_handlers[irq]();
+                }
+            }
+            // Si la rutina no reconoció la interrupción, vuelve a entrar después de otra latencia
+            irq_raised = false;
+            if (wfe) {
+                update_systick();
+                return true;
+            }
+            continue;
+        }
+        if (now >= until) {
+            break;
+        }
+
+        uint64_t target = irq_raised && irq_due < until ? irq_due : until;
+        uint32_t idle = UINT32_MAX;
+        for (unsigned i = 0; i < HAL_SIM_PIO_COUNT; ++i) {
+            uint32_t pio_idle = pio_sim_idle_cycles(&hal_sim_pio[i]);
+            if (pio_idle < idle) {
+                idle = pio_idle;
+            }
+        }
+        if (idle != UINT32_MAX && now + idle < target) {
+            skip_all(idle);
+            for (unsigned i = 0; i < HAL_SIM_PIO_COUNT; ++i) {
+                pio_sim_step(&hal_sim_pio[i]);
+            }
+            if (observer) {
+                observer(observer_ctx);
+            }
+        } else {
+            skip_all(target - now);
+        }
+    }
+    update_systick();
+    return false;
+}
+
+void hal_sim_set_irq_handler(unsigned irq, void (*handler)(void)) {
+    irq_handlers[irq] = handler;
+}
+
+void hal_sim_set_irq_enabled(unsigned irq, bool enabled) {
+    irq_enabled = enabled ? irq_enabled | (1u << irq) : irq_enabled & ~(1u << irq);
+}
+
+uint32_t hal_sim_disable_interrupts(void) {
+    uint32_t state = irq_masked;
+    irq_masked = true;
+    return state;
+}
+
+void hal_sim_restore_interrupts(uint32_t state) {
+    irq_masked = state;
+}
+
+void hal_sim_panic(const char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    fputs("panic: ", stderr);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    exit(3);
+}
+
+int dma_claim_unused_channel(bool required) {
+    for (unsigned ch = 0; ch < DMA_SIM_CHANNELS; ++ch) {
+        if (!(dma_claimed & (1u << ch))) {
+            dma_claimed |= 1u << ch;
+            return (int)ch;
+        }
+    }
+    if (required) {
+        hal_sim_panic("no hay canales de DMA libres");
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(unsigned channel) {
+    dma_claimed &= ~(1u << channel);
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    unsigned index = pio_get_index(pio);
+
+    for (unsigned sm = 0; sm < PIO_SIM_SM_COUNT; ++sm) {
+        if (!(sm_claimed[index] & (1u << sm))) {
+            sm_claimed[index] |= 1u << sm;
+            return (int)sm;
+        }
+    }
+    if (required) {
+        hal_sim_panic("no hay máquinas de estados libres en pio%u", index);
+    }
+    return -1;
+}
+
+/**
+ * Carga un programa en la dirección más alta libre (o en su origen fijo), como el SDK.
+ */
+unsigned pio_add_program(PIO pio, const pio_program_t *program) {
+    unsigned index = pio_get_index(pio);
+    uint32_t mask = program->length >= 32 ? 0xFFFFFFFFu : (1u << program->length) - 1;
+    int first = program->origin >= 0 ? program->origin : PIO_SIM_MEM_SIZE - program->length;
+    int last = program->origin >= 0 ? program->origin : 0;
+
+    for (int offset = first; offset >= last; --offset) {
+        if (!(program_used[index] & (mask << offset))) {
+            program_used[index] |= mask << offset;
+            pio_sim_load(&hal_sim_pio[index], program->instructions, program->length, (unsigned)offset);
+            return (unsigned)offset;
+        }
+    }
+    hal_sim_panic("no hay espacio para el programa en pio%u", index);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file hal_sim.h
+ *
+ * @brief Placa simulada sobre la que compila el código del firmware que usa PIO y DMA.
+ *
+ * Los encabezados de host/hal/ reemplazan a los del SDK de la Raspberry Pi Pico que usa dac_out.c
+ * (hardware/dma.h, hardware/pio.h, hardware/irq.h, ...): en lugar de registros del RP2040 operan
+ * sobre dos bloques de pio_sim, un controlador de dma_sim y un reloj del sistema virtual. Así el
+ * mismo dac_out.c del firmware corre en la máquina anfitriona, con sus canales encadenados, el
+ * modo anillo y la interrupción de fin de bloque.
+ *
+ * El tiempo avanza solo con hal_sim_run(), que simula un núcleo: entre llamadas el código del
+ * firmware corre en tiempo cero, y para representar su duración se avanza el reloj con
+ * hal_sim_run() (las interrupciones se atienden mientras tanto, como si interrumpieran a ese
+ * código). Las interrupciones del DMA se atienden irq_latency ciclos después de levantarse, si
+ * están habilitadas y no están enmascaradas con save_and_disable_interrupts(); la rutina también
+ * corre en tiempo cero.
+ */
+
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pio_sim.h"
+#include "dma_sim.h"
+
+#define HAL_SIM_PIO_COUNT 2 ///< Bloques PIO del RP2040
+#define HAL_SIM_IRQ_COUNT 32 ///< Interrupciones del NVIC
+
+/**
+ * Registros de un bloque PIO que el firmware usa por dirección: los FIFO, como destino u origen
+ * del DMA. Las escrituras y lecturas del DMA en estas direcciones van al pio_sim del bloque.
+ */
+typedef struct {
+    uint32_t txf[PIO_SIM_SM_COUNT]; ///< FIFO TX de cada máquina
+    uint32_t rxf[PIO_SIM_SM_COUNT]; ///< FIFO RX de cada máquina
+} pio_hw_t;
+
+/**
+ * SysTick del núcleo simulado, que cuenta hacia abajo en 24 bits como el que usa stackmon.h.
+ */
+typedef struct {
+    uint32_t cvr; ///< Valor actual
+} systick_hw_t;
+
+/**
+ * Función que se llama después de cada ciclo en que avanzó alguna máquina de estados.
+ */
+typedef void (*hal_sim_observer_fn)(void *ctx);
+
+extern pio_sim_t hal_sim_pio[HAL_SIM_PIO_COUNT]; ///< Estado de cada bloque PIO
+extern pio_hw_t hal_sim_pio_hw[HAL_SIM_PIO_COUNT]; ///< Direcciones de los FIFO de cada bloque
+extern dma_sim_t hal_sim_dma; ///< Controlador de DMA
+extern systick_hw_t hal_sim_systick; ///< SysTick del núcleo simulado
+
+void hal_sim_init(uint32_t clk_sys_hz, uint32_t irq_latency);
+
+void hal_sim_set_observer(hal_sim_observer_fn fn, void *ctx);
+
+bool hal_sim_run(uint64_t until, bool wfe);
+
+uint64_t hal_sim_cycle(void);
+
+uint32_t hal_sim_clk_sys_hz(void);
+
+uint64_t hal_sim_time_us(void);
+
+void hal_sim_set_irq_handler(unsigned irq, void (*handler)(void));
+
+void hal_sim_set_irq_enabled(unsigned irq, bool enabled);
+
+uint32_t hal_sim_disable_interrupts(void);
+
+void hal_sim_restore_interrupts(uint32_t state);
+
+void hal_sim_panic(const char *fmt, ...) __attribute__((noreturn, format(printf, 1, 2)));
+
+#endif
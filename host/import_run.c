@@ -0,0 +1,157 @@
+/**
+ * @file import_run.c
+ *
+ * @brief Ejecuta en la máquina anfitriona la conversión en flujo de siggen/wave_import.h que usa el
+ * disco USB de la Pico.
+ *
+ * Cada archivo se convierte tres veces: entregado de a sectores de 512 bytes, como llegan por USB,
+ * de a un byte y en trozos de largo aleatorio. Las tres deben dar los mismos códigos, porque la
+ * conversión no puede depender de dónde corta el USB; se informa el formato, las muestras, las
+ * líneas salteadas, un hash FNV-1a de los códigos y el caudal de la entrega por sectores.
+ *
+ * Uso: import_run [-k] [-s SEMILLA] [-o SALIDA] archivo...
+ *  - -k         Los valores de los CSV son códigos del DAC.
+ *  - -s SEMILLA Semilla de los largos aleatorios (por defecto 1).
+ *  - -o SALIDA  Escribir los códigos del último archivo, crudos, en SALIDA.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "../siggen/wave_import.h"
+
+#define RUN_SECTOR 512 ///< Bytes por sector del disco USB
+
+/**
+ * Resultado de una conversión.
+ */
+typedef struct {
+    uint64_t hash; ///< Hash FNV-1a de los códigos
+    FILE *out; ///< Copia de los códigos, o NULL
+} capture_t;
+
+static void capture(void *ctx, const uint8_t *codes, size_t count) {
+    capture_t *cap = (capture_t *)ctx;
+
+    for (size_t i = 0; i < count; ++i) {
+        cap->hash ^= codes[i];
+        cap->hash *= 1099511628211ULL;
+    }
+    if (cap->out) {
+        fwrite(codes, 1, count, cap->out);
+    }
+}
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Convierte data entregándola en trozos: de a chunk bytes, o de largo aleatorio si chunk es 0.
+ */
+static wave_import_status_t run(wave_import_t *p, const uint8_t *data, size_t len, size_t chunk, bool codes,
+                                capture_t *cap) {
+    wave_import_format_t format = wave_import_detect(data, len < WAVE_IMPORT_DETECT_LEN ? len : WAVE_IMPORT_DETECT_LEN);
+
+    cap->hash = 14695981039346656037ULL;
+    wave_import_init(p, format, codes, capture, cap);
+    for (size_t pos = 0; pos < len && p->status == WAVE_IMPORT_RUNNING;) {
+        size_t n = chunk ? chunk : 1 + (size_t)rand() % 1024;
+        n = n < len - pos ? n : len - pos;
+        wave_import_feed(p, data + pos, n);
+        pos += n;
+    }
+    return wave_import_finish(p);
+}
+
+static uint8_t *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    uint8_t *data;
+
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    data = malloc(size > 0 ? (size_t)size : 1);
+    if (!data || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len = (size_t)size;
+    return data;
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = NULL;
+    unsigned seed = 1;
+    bool codes = false;
+    int opt, failures = 0;
+
+    while ((opt = getopt(argc, argv, "ks:o:")) != -1) {
+        switch (opt) {
+            case 'k': codes = true; break;
+            case 's': seed = (unsigned)atoi(optarg); break;
+            case 'o': out_path = optarg; break;
+            default: fprintf(stderr, "Uso: %s [-k] [-s SEMILLA] [-o SALIDA] archivo...\n", argv[0]); return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Uso: %s [-k] [-s SEMILLA] [-o SALIDA] archivo...\n", argv[0]);
+        return 2;
+    }
+    srand(seed);
+
+    for (int i = optind; i < argc; ++i) {
+        size_t len;
+        uint8_t *data = read_file(argv[i], &len);
+        if (!data) {
+            fprintf(stderr, "%s: no se pudo leer\n", argv[i]);
+            failures++;
+            continue;
+        }
+
+        static wave_import_t p;
+        capture_t sector = { 0 }, byte = { 0 }, random = { 0 };
+        if (out_path && i == argc - 1) {
+            sector.out = fopen(out_path, "wb");
+        }
+        double t0 = now_s();
+        wave_import_status_t status = run(&p, data, len, RUN_SECTOR, codes, &sector);
+        double t = now_s() - t0;
+        uint32_t samples = p.samples, skipped = p.skipped, rate = p.sample_rate;
+        wave_import_format_t format = p.format;
+        run(&p, data, len, 1, codes, &byte);
+        uint32_t byte_samples = p.samples;
+        run(&p, data, len, 0, codes, &random);
+        bool same = byte.hash == sector.hash && random.hash == sector.hash && byte_samples == samples &&
+                    p.samples == samples;
+
+        printf("%s: %s, %s, %u muestras", argv[i], wave_import_format_name(format), wave_import_status_name(status),
+               samples);
+        if (rate) {
+            printf(" a %u Hz", rate);
+        }
+        if (skipped) {
+            printf(", %u líneas salteadas", skipped);
+        }
+        printf(", hash %016llx; %.1f MB/s, %.1f Mmuestras/s; trozos %s\n", (unsigned long long)sector.hash,
+               len / t / 1e6, samples / t / 1e6, same ? "iguales" : "DISTINTOS");
+        failures += !same || status != WAVE_IMPORT_END;
+        if (sector.out) {
+            fclose(sector.out);
+        }
+        free(data);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file pio_run.c
+ *
+ * @brief Ejecuta el programa de salida del DAC (dac_out.pio) en el emulador de PIO y verifica
+ * las muestras y su ritmo.
+ *
+ * Sintetiza una señal con siggen/synth.c, empaqueta cuatro muestras por palabra como las lee el
+ * DMA y las entrega al FIFO TX cada vez que su DREQ lo permite (un DMA ideal, sin latencia). La
+ * máquina se configura como dac_out_program_init(): 8 pines de OUT, desplazamiento a la derecha,
+ * autopull de 32 bits, FIFO unido y el divisor de reloj para la frecuencia de muestreo. Cada
+ * OUT terminado es una muestra; se compara con la sintetizada y se mide el intervalo en ciclos
+ * del reloj del sistema. Al final se informa la cantidad de errores, el intervalo mínimo, medio y
+ * máximo, los ciclos detenidos y la velocidad del emulador.
+ *
+ * Uso: pio_run [-c HZ] [-r HZ] [-n MUESTRAS] [-x PROGRAMA.hex]
+ *  - -c HZ        Reloj del sistema (por defecto 125000000).
+ *  - -r HZ        Frecuencia de muestreo (por defecto 1000000, DAC_SAMPLE_RATE).
+ *  - -n MUESTRAS  Muestras a emitir (por defecto 1048576).
+ *  - -x ARCHIVO   Usar otro programa, en el formato de `pioasm -o hex`, en lugar de dac_out; arranca
+ *                 en su primera instrucción.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include "pio_sim.h"
+#include "../siggen/synth.h"
+
+#define DAC_PIN_BASE 0 ///< Primer pin del DAC, como DAC_PIN en dac_backend.h
+#define RUN_BLOCK 1024 ///< Muestras sintetizadas por bloque
+
+/**
+ * dac_out.pio ensamblado. El arranque normal entra por DAC_OUT_START (`out pins, 8`, con
+ * .wrap_target y .wrap sobre esa instrucción); las anteriores son las del arranque armado.
+ */
+static const uint16_t dac_out_program[] = {
+    0xA0E3, 0x6060, 0x2020, 0x20A0, 0xC010, 0x6008,
+};
+
+#define DAC_OUT_START 5 ///< Dirección de la etiqueta start de dac_out.pio
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Lee un programa en el formato de `pioasm -o hex`: una instrucción en hexadecimal por línea.
+ * @return Cantidad de instrucciones, o 0 si hubo un error.
+ */
+static unsigned load_hex(const char *path, uint16_t *program) {
+    FILE *f = fopen(path, "r");
+    char line[32];
+    unsigned count = 0;
+
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), f) && count < PIO_SIM_MEM_SIZE) {
+        char *end;
+        unsigned long word = strtoul(line, &end, 16);
+        if (end != line) {
+            program[count++] = (uint16_t)word;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+int main(int argc, char **argv) {
+    uint32_t clk_hz = 125000000, rate = 1000000;
+    unsigned long total = 1u << 20;
+    uint16_t program[PIO_SIM_MEM_SIZE];
+    unsigned length = sizeof(dac_out_program) / sizeof(dac_out_program[0]);
+    unsigned start = DAC_OUT_START;
+    int opt;
+
+    memcpy(program, dac_out_program, sizeof(dac_out_program));
+    while ((opt = getopt(argc, argv, "c:r:n:x:")) != -1) {
+        switch (opt) {
+            case 'c': clk_hz = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'r': rate = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'n': total = strtoul(optarg, NULL, 10); break;
+            case 'x':
+                if (!(length = load_hex(optarg, program))) {
+                    return 2;
+                }
+                start = 0;
+                break;
+            default:
+                fprintf(stderr, "Uso: %s [-c HZ] [-r HZ] [-n MUESTRAS] [-x PROGRAMA.hex]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (!clk_hz || !rate || rate > clk_hz || !total) {
+        fprintf(stderr, "%s: parámetros inválidos\n", argv[0]);
+        return 2;
+    }
+    total = (total + RUN_BLOCK - 1) / RUN_BLOCK * RUN_BLOCK;
+
+    static pio_sim_t pio;
+    pio_sim_config_t cfg;
+
+    pio_sim_init(&pio);
+    pio_sim_load(&pio, program, length, 0);
+    pio_sim_config_default(&cfg);
+    cfg.wrap_target = (uint8_t)start;
+    cfg.wrap = (uint8_t)(length - 1);
+    cfg.out_base = DAC_PIN_BASE;
+    cfg.out_count = 8;
+    cfg.out_shift_right = true;
+    cfg.autopull = true;
+    cfg.pull_threshold = 32;
+    cfg.join_tx = true;
+    cfg.clkdiv_q8 = pio_sim_clkdiv_q8(clk_hz, rate);
+    pio_sim_sm_init(&pio, 0, start, &cfg);
+    pio.pindirs = 0xFFu << DAC_PIN_BASE;
+
+    synth_t synth;
+    static uint8_t block[RUN_BLOCK];
+    synth_init(&synth, rate);
+    synth_set(&synth, SINE, 2000000, 1650000, 1000000);
+
+    unsigned long fed = 0, emitted = 0, errors = 0;
+    unsigned fed_in_block = RUN_BLOCK;
+    uint64_t first_cycle = 0, last_cycle = 0, min_interval = UINT64_MAX, max_interval = 0;
+    uint8_t expected[RUN_BLOCK * 2];
+    unsigned expected_head = 0;
+    double t0 = now_s();
+
+    pio_sim_set_enabled(&pio, 0, true);
+    while (emitted < total) {
+        // DMA ideal: llena el FIFO mientras el DREQ esté activo
+        while (fed < total && pio_sim_tx_dreq(&pio, 0)) {
+            if (fed_in_block == RUN_BLOCK) {
+                synth_render(&synth, block, RUN_BLOCK);
+                memcpy(&expected[(fed % (2 * RUN_BLOCK))], block, RUN_BLOCK);
+                fed_in_block = 0;
+            }
+            uint32_t word = block[fed_in_block] | (uint32_t)block[fed_in_block + 1] << 8 |
+                            (uint32_t)block[fed_in_block + 2] << 16 | (uint32_t)block[fed_in_block + 3] << 24;
+            pio_sim_put(&pio, 0, word);
+            fed_in_block += 4;
+            fed += 4;
+        }
+
+        pio_sim_step_next(&pio);
+
+        const pio_sim_sm_t *sm = &pio.sm[0];
+        if (sm->retired && (sm->last_instr & 0xE0E0) == 0x6000) {
+            uint8_t value = (uint8_t)(pio_sim_pins(&pio) >> DAC_PIN_BASE);
+            if (value != expected[expected_head] && errors++ < 10) {
+                fprintf(stderr, "muestra %lu: %u, se esperaba %u\n", emitted, value, expected[expected_head]);
+            }
+            expected_head = (expected_head + 1) % (2 * RUN_BLOCK);
+            if (!emitted) {
+                first_cycle = pio.cycle;
+            } else {
+                uint64_t interval = pio.cycle - last_cycle;
+                if (interval < min_interval) {
+                    min_interval = interval;
+                }
+                if (interval > max_interval) {
+                    max_interval = interval;
+                }
+            }
+            last_cycle = pio.cycle;
+            emitted++;
+        }
+    }
+
+    double elapsed = now_s() - t0;
+    printf("muestras=%lu errores=%lu ciclos=%llu detenida=%llu\n", emitted, errors,
+           (unsigned long long)pio.cycle, (unsigned long long)pio.sm[0].stalls);
+    printf("intervalo (ciclos): min=%llu medio=%.3f max=%llu esperado=%.3f\n",
+           (unsigned long long)min_interval, emitted > 1 ? (double)(last_cycle - first_cycle) / (emitted - 1) : 0.0,
+           (unsigned long long)max_interval, (double)clk_hz / rate);
+    printf("emulador: %.1f Mciclos/s, %.1fx tiempo real\n", pio.cycle / elapsed / 1e6,
+           (double)pio.cycle / clk_hz / elapsed);
+    return errors != 0;
+}
@@ -0,0 +1,557 @@
+/**
+ * @file pio_sim.c
+ *
+ * @brief Implementación del emulador de PIO. Las referencias a la hoja de datos son a la sección
+ * 3.4 (conjunto de instrucciones) del RP2040 Datasheet.
+ */
+
+#include "pio_sim.h"
+#include <string.h>
+
+/**
+ * Resultado de ejecutar una instrucción.
+ */
+typedef enum {
+    EXEC_DONE, ///< Terminó; el pc avanza normalmente
+    EXEC_JUMPED, ///< Terminó y fijó el pc
+    EXEC_STALL, ///< No pudo terminar; se repite en el próximo ciclo
+} exec_result_t;
+
+static exec_result_t execute(pio_sim_t *pio, unsigned sm, uint16_t instr);
+
+static inline uint32_t rotl32(uint32_t v, unsigned n) {
+    n &= 31;
+    return n ? (v << n) | (v >> (32 - n)) : v;
+}
+
+static inline uint32_t rotr32(uint32_t v, unsigned n) {
+    n &= 31;
+    return n ? (v >> n) | (v << (32 - n)) : v;
+}
+
+static inline uint32_t low_mask(unsigned bits) {
+    return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+}
+
+static uint32_t bit_reverse(uint32_t v) {
+    uint32_t r = 0;
+    for (int i = 0; i < 32; ++i) {
+        r = (r << 1) | (v & 1);
+        v >>= 1;
+    }
+    return r;
+}
+
+/**
+ * Escribe count bits de value en los pines (o en sus direcciones) a partir de base, dando la
+ * vuelta en el pin 31 como el hardware.
+ */
+static void write_pins(uint32_t *target, unsigned base, unsigned count, uint32_t value) {
+    uint32_t mask = rotl32(low_mask(count), base);
+    *target = (*target & ~mask) | (rotl32(value, base) & mask);
+}
+
+static bool fifo_push(pio_sim_fifo_t *f, uint32_t word) {
+    if (f->level >= f->depth) {
+        return false;
+    }
+    f->data[(f->head + f->level) % (2 * PIO_SIM_FIFO_DEPTH)] = word;
+    f->level++;
+    return true;
+}
+
+static bool fifo_pop(pio_sim_fifo_t *f, uint32_t *word) {
+    if (!f->level) {
+        return false;
+    }
+    *word = f->data[f->head];
+    f->head = (f->head + 1) % (2 * PIO_SIM_FIFO_DEPTH);
+    f->level--;
+    return true;
+}
+
+/**
+ * Índice de IRQ de WAIT e IRQ: con el bit 4 (REL) los dos bits bajos se suman al número de la
+ * máquina, módulo 4.
+ */
+static inline unsigned irq_index(unsigned index, unsigned sm) {
+    return (index & 0x10) ? (index & 4) | ((index + sm) & 3) : index & 7;
+}
+
+void pio_sim_init(pio_sim_t *pio) {
+    memset(pio, 0, sizeof(*pio));
+}
+
+/**
+ * Copia un programa a la memoria a partir de offset, reubicando los destinos de JMP como lo hace
+ * pio_add_program().
+ * @return false si no cabe.
+ */
+bool pio_sim_load(pio_sim_t *pio, const uint16_t *program, unsigned length, unsigned offset) {
+    if (offset + length > PIO_SIM_MEM_SIZE) {
+        return false;
+    }
+    for (unsigned i = 0; i < length; ++i) {
+        uint16_t instr = program[i];
+        if ((instr & 0xE000) == 0) {
+            instr = (instr & ~0x1F) | ((instr + offset) & 0x1F);
+        }
+        pio->mem[offset + i] = instr;
+    }
+    return true;
+}
+
+/**
+ * Configuración por defecto del SDK: divisor 1, todo el programa como ciclo, desplazamientos a
+ * la derecha sin autopush ni autopull y umbrales de 32 bits.
+ */
+void pio_sim_config_default(pio_sim_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->clkdiv_q8 = 256;
+    cfg->wrap = PIO_SIM_MEM_SIZE - 1;
+    cfg->out_shift_right = true;
+    cfg->in_shift_right = true;
+    cfg->out_count = 32;
+}
+
+/**
+ * Divisor en 16.8 para que la máquina avance sm_hz veces por segundo, con el mismo cálculo que
+ * dac_out_program_init().
+ */
+uint32_t pio_sim_clkdiv_q8(uint32_t clk_sys_hz, uint32_t sm_hz) {
+    uint32_t div_q8 = (uint32_t)(((uint64_t)clk_sys_hz << 8) / sm_hz);
+    return div_q8 < 256 ? 256 : div_q8;
+}
+
+/**
+ * Configura una máquina, vacía sus FIFO y registros y la deja detenida en initial_pc.
+ */
+void pio_sim_sm_init(pio_sim_t *pio, unsigned sm, unsigned initial_pc, const pio_sim_config_t *cfg) {
+    pio_sim_sm_t *s = &pio->sm[sm];
+
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    if (!s->cfg.pull_threshold) {
+        s->cfg.pull_threshold = 32;
+    }
+    if (!s->cfg.push_threshold) {
+        s->cfg.push_threshold = 32;
+    }
+    if (s->cfg.clkdiv_q8 < 256) {
+        s->cfg.clkdiv_q8 = 256;
+    }
+    s->tx.depth = cfg->join_rx ? 0 : cfg->join_tx ? 2 * PIO_SIM_FIFO_DEPTH : PIO_SIM_FIFO_DEPTH;
+    s->rx.depth = cfg->join_tx ? 0 : cfg->join_rx ? 2 * PIO_SIM_FIFO_DEPTH : PIO_SIM_FIFO_DEPTH;
+    s->pc = (uint8_t)(initial_pc & 0x1F);
+    s->osr_count = 32;
+}
+
+void pio_sim_set_enabled(pio_sim_t *pio, unsigned sm, bool enabled) {
+    pio->sm[sm].enabled = enabled;
+}
+
+/**
+ * Fuerza la ejecución de una instrucción, como pio_sm_exec(). Con la máquina habilitada se
+ * ejecuta en su próximo ciclo; deshabilitada, en el acto (así fija el pc pio_sm_init()). Si se
+ * detiene, queda pendiente hasta que pueda terminar.
+ */
+void pio_sim_exec(pio_sim_t *pio, unsigned sm, uint16_t instr) {
+    if (!pio->sm[sm].enabled && execute(pio, sm, instr) != EXEC_STALL) {
+        return;
+    }
+    pio->sm[sm].exec_pending = true;
+    pio->sm[sm].exec_instr = instr;
+}
+
+/**
+ * Borra el estado interno de la máquina como SM_RESTART: contadores de desplazamiento, ISR,
+ * demora, espera de IRQ e instrucción forzada pendiente. Con CLKDIV_RESTART también reinicia la
+ * fase del divisor.
+ */
+void pio_sim_restart(pio_sim_t *pio, unsigned sm, bool clkdiv) {
+    pio_sim_sm_t *s = &pio->sm[sm];
+
+    s->isr = 0;
+    s->isr_count = 0;
+    s->osr_count = 0;
+    s->delay = 0;
+    s->irq_waiting = false;
+    s->exec_pending = false;
+    if (clkdiv) {
+        s->div_acc = 0;
+    }
+}
+
+/**
+ * Escribe una palabra en el FIFO TX, como lo haría la CPU o el DMA.
+ * @return false si el FIFO está lleno.
+ */
+bool pio_sim_put(pio_sim_t *pio, unsigned sm, uint32_t word) {
+    return fifo_push(&pio->sm[sm].tx, word);
+}
+
+/**
+ * Lee una palabra del FIFO RX.
+ * @return false si el FIFO está vacío.
+ */
+bool pio_sim_get(pio_sim_t *pio, unsigned sm, uint32_t *word) {
+    return fifo_pop(&pio->sm[sm].rx, word);
+}
+
+/**
+ * Recarga el OSR desde el FIFO TX si autopull está habilitado y se alcanzó el umbral.
+ */
+static void autopull(pio_sim_sm_t *s) {
+    if (s->cfg.autopull && s->osr_count >= s->cfg.pull_threshold && fifo_pop(&s->tx, &s->osr)) {
+        s->osr_count = 0;
+    }
+}
+
+static exec_result_t exec_wait(pio_sim_t *pio, unsigned sm, uint16_t instr) {
+    pio_sim_sm_t *s = &pio->sm[sm];
+    unsigned polarity = (instr >> 7) & 1;
+    unsigned index = instr & 0x1F;
+    unsigned bit;
+
+    switch ((instr >> 5) & 3) {
+        case 0: bit = (pio_sim_pins(pio) >> index) & 1; break;
+        case 1: bit = (pio_sim_pins(pio) >> ((s->cfg.in_base + index) & 31)) & 1; break;
+        case 2: {
+            unsigned irq = irq_index(index, sm);
+            bit = (pio->irq >> irq) & 1;
+            if (bit == polarity && polarity) {
+                pio->irq &= ~(1u << irq);
+            }
+            break;
+        }
+        default: return EXEC_DONE;
+    }
+    return bit == polarity ? EXEC_DONE : EXEC_STALL;
+}
+
+static exec_result_t exec_in(pio_sim_t *pio, unsigned sm, uint16_t instr) {
+    pio_sim_sm_t *s = &pio->sm[sm];
+    unsigned count = instr & 0x1F ? instr & 0x1F : 32;
+    unsigned total = s->isr_count + count > 32 ? 32 : s->isr_count + count;
+    uint32_t data;
+
+    if (s->cfg.autopush && total >= s->cfg.push_threshold && s->rx.level >= s->rx.depth) {
+        return EXEC_STALL;
+    }
+    switch ((instr >> 5) & 7) {
+        case 0: data = rotr32(pio_sim_pins(pio), s->cfg.in_base); break;
+        case 1: data = s->x; break;
+        case 2: data = s->y; break;
+        case 6: data = s->isr; break;
+        case 7: data = s->osr; break;
+        default: data = 0; break;
+    }
+    data &= low_mask(count);
+    if (count == 32) {
+        s->isr = data;
+    } else if (s->cfg.in_shift_right) {
+        s->isr = (s->isr >> count) | (data << (32 - count));
+    } else {
+        s->isr = (s->isr << count) | data;
+    }
+    s->isr_count = (uint8_t)total;
+    if (s->cfg.autopush && s->isr_count >= s->cfg.push_threshold) {
+        fifo_push(&s->rx, s->isr);
+        s->isr = 0;
+        s->isr_count = 0;
+    }
+    return EXEC_DONE;
+}
+
+static exec_result_t exec_out(pio_sim_t *pio, unsigned sm, uint16_t instr) {
+    pio_sim_sm_t *s = &pio->sm[sm];
+    unsigned count = instr & 0x1F ? instr & 0x1F : 32;
+    uint32_t data;
+
+    if (s->cfg.autopull && s->osr_count >= s->cfg.pull_threshold) {
+        if (!fifo_pop(&s->tx, &s->osr)) {
+            return EXEC_STALL;
+        }
+        s->osr_count = 0;
+    }
+    if (count == 32) {
+        data = s->osr;
+        s->osr = 0;
+    } else if (s->cfg.out_shift_right) {
+        data = s->osr & low_mask(count);
+        s->osr >>= count;
+    } else {
+        data = s->osr >> (32 - count);
+        s->osr <<= count;
+    }
+    s->osr_count = s->osr_count + count > 32 ? 32 : (uint8_t)(s->osr_count + count);
+
+    exec_result_t result = EXEC_DONE;
+    switch ((instr >> 5) & 7) {
+        case 0: write_pins(&pio->pins_out, s->cfg.out_base, s->cfg.out_count, data); break;
+        case 1: s->x = data; break;
+        case 2: s->y = data; break;
+        case 4: write_pins(&pio->pindirs, s->cfg.out_base, s->cfg.out_count, data); break;
+        case 5: s->pc = data & 0x1F; result = EXEC_JUMPED; break;
+        case 6: s->isr = data; s->isr_count = (uint8_t)count; break;
+        case 7: s->exec_pending = true; s->exec_instr = (uint16_t)data; break;
+        default: break;
+    }
+    // En el hardware la recarga por autopull ocurre en segundo plano, sin costar un ciclo
+    autopull(s);
+    return result;
+}
+
+static exec_result_t exec_push_pull(pio_sim_sm_t *s, uint16_t instr) {
+    bool block = (instr >> 5) & 1;
+
+    if (instr & 0x80) {
+        if ((instr & 0x40) && s->osr_count < s->cfg.pull_threshold) {
+            return EXEC_DONE;
+        }
+        if (s->cfg.autopull && s->osr_count == 0) {
+            return EXEC_DONE;
+        }
+        if (!fifo_pop(&s->tx, &s->osr)) {
+            if (block) {
+                return EXEC_STALL;
+            }
+            s->osr = s->x;
+        }
+        s->osr_count = 0;
+    } else {
+        if ((instr & 0x40) && s->isr_count < s->cfg.push_threshold) {
+            return EXEC_DONE;
+        }
+        if (s->rx.level >= s->rx.depth && block) {
+            return EXEC_STALL;
+        }
+        fifo_push(&s->rx, s->isr);
+        s->isr = 0;
+        s->isr_count = 0;
+    }
+    return EXEC_DONE;
+}
+
+static exec_result_t exec_mov(pio_sim_t *pio, pio_sim_sm_t *s, uint16_t instr) {
+    uint32_t data;
+
+    switch (instr & 7) {
+        case 0: data = rotr32(pio_sim_pins(pio), s->cfg.in_base); break;
+        case 1: data = s->x; break;
+        case 2: data = s->y; break;
+        case 5: {
+            const pio_sim_fifo_t *f = s->cfg.status_rx ? &s->rx : &s->tx;
+            data = f->level < s->cfg.status_n ? 0xFFFFFFFFu : 0;
+            break;
+        }
+        case 6: data = s->isr; break;
+        case 7: data = s->osr; break;
+        default: data = 0; break;
+    }
+    switch ((instr >> 3) & 3) {
+        case 1: data = ~data; break;
+        case 2: data = bit_reverse(data); break;
+        default: break;
+    }
+    switch ((instr >> 5) & 7) {
+        case 0: write_pins(&pio->pins_out, s->cfg.out_base, s->cfg.out_count, data); break;
+        case 1: s->x = data; break;
+        case 2: s->y = data; break;
+        case 4: s->exec_pending = true; s->exec_instr = (uint16_t)data; break;
+        case 5: s->pc = data & 0x1F; return EXEC_JUMPED;
+        case 6: s->isr = data; s->isr_count = 0; break;
+        case 7: s->osr = data; s->osr_count = 0; break;
+        default: break;
+    }
+    return EXEC_DONE;
+}
+
+static exec_result_t exec_irq(pio_sim_t *pio, unsigned sm, uint16_t instr) {
+    pio_sim_sm_t *s = &pio->sm[sm];
+    uint8_t bit = (uint8_t)(1u << irq_index(instr & 0x1F, sm));
+
+    if (instr & 0x40) {
+        pio->irq &= ~bit;
+        return EXEC_DONE;
+    }
+    if (!s->irq_waiting) {
+        pio->irq |= bit;
+        if (!(instr & 0x20)) {
+            return EXEC_DONE;
+        }
+        s->irq_waiting = true;
+        return EXEC_STALL;
+    }
+    if (pio->irq & bit) {
+        return EXEC_STALL;
+    }
+    s->irq_waiting = false;
+    return EXEC_DONE;
+}
+
+static exec_result_t exec_set(pio_sim_t *pio, pio_sim_sm_t *s, uint16_t instr) {
+    uint32_t data = instr & 0x1F;
+
+    switch ((instr >> 5) & 7) {
+        case 0: write_pins(&pio->pins_out, s->cfg.set_base, s->cfg.set_count, data); break;
+        case 1: s->x = data; break;
+        case 2: s->y = data; break;
+        case 4: write_pins(&pio->pindirs, s->cfg.set_base, s->cfg.set_count, data); break;
+        default: break;
+    }
+    return EXEC_DONE;
+}
+
+static exec_result_t execute(pio_sim_t *pio, unsigned sm, uint16_t instr) {
+    pio_sim_sm_t *s = &pio->sm[sm];
+
+    switch (instr >> 13) {
+        case 0: {
+            bool jump;
+            switch ((instr >> 5) & 7) {
+                case 0: jump = true; break;
+                case 1: jump = s->x == 0; break;
+                case 2: jump = s->x != 0; s->x--; break;
+                case 3: jump = s->y == 0; break;
+                case 4: jump = s->y != 0; s->y--; break;
+                case 5: jump = s->x != s->y; break;
+                case 6: jump = (pio_sim_pins(pio) >> s->cfg.jmp_pin) & 1; break;
+                default: jump = s->osr_count < s->cfg.pull_threshold; break;
+            }
+            if (!jump) {
+                return EXEC_DONE;
+            }
+            s->pc = instr & 0x1F;
+            return EXEC_JUMPED;
+        }
+        case 1: return exec_wait(pio, sm, instr);
+        case 2: return exec_in(pio, sm, instr);
+        case 3: return exec_out(pio, sm, instr);
+        case 4: return exec_push_pull(s, instr);
+        case 5: return exec_mov(pio, s, instr);
+        case 6: return exec_irq(pio, sm, instr);
+        default: return exec_set(pio, s, instr);
+    }
+}
+
+/**
+ * Un ciclo de una máquina: cuenta la demora pendiente o ejecuta la instrucción en curso. El
+ * side-set se aplica al empezar la instrucción, aunque quede detenida.
+ */
+static void sm_tick(pio_sim_t *pio, unsigned sm) {
+    pio_sim_sm_t *s = &pio->sm[sm];
+
+    s->ticks++;
+    if (s->delay) {
+        s->delay--;
+        return;
+    }
+
+    bool forced = s->exec_pending;
+    uint16_t instr = forced ? s->exec_instr : pio->mem[s->pc];
+    unsigned field = (instr >> 8) & 0x1F;
+    unsigned delay_bits = 5 - s->cfg.sideset_bits;
+    unsigned delay = field & low_mask(delay_bits);
+
+    if (s->cfg.sideset_bits) {
+        bool enabled = !s->cfg.sideset_opt || (field & 0x10);
+        unsigned bits = s->cfg.sideset_bits - (s->cfg.sideset_opt ? 1 : 0);
+        uint32_t value = (field >> delay_bits) & low_mask(bits);
+        if (enabled) {
+            write_pins(s->cfg.sideset_pindirs ? &pio->pindirs : &pio->pins_out, s->cfg.sideset_base, bits, value);
+        }
+    }
+
+    s->exec_pending = false;
+    exec_result_t result = execute(pio, sm, instr);
+    if (result == EXEC_STALL) {
+        if (forced) {
+            s->exec_pending = true;
+        }
+        s->stalls++;
+        return;
+    }
+    if (result == EXEC_DONE && !forced) {
+        s->pc = s->pc == s->cfg.wrap ? s->cfg.wrap_target : (s->pc + 1) & 0x1F;
+    }
+    // Las demoras de OUT EXEC y MOV EXEC se ignoran (hoja de datos, 3.4.5.2 y 3.4.8.2)
+    bool to_exec = (instr >> 13 == 3 && ((instr >> 5) & 7) == 7) || (instr >> 13 == 5 && ((instr >> 5) & 7) == 4);
+    s->delay = to_exec ? 0 : delay;
+    s->retired = true;
+    s->last_instr = instr;
+    s->executed++;
+}
+
+/**
+ * Avanza un ciclo del reloj del sistema. Cada máquina habilitada ejecuta un ciclo cuando su
+ * divisor lo permite.
+ */
+void pio_sim_step(pio_sim_t *pio) {
+    pio->cycle++;
+    for (unsigned sm = 0; sm < PIO_SIM_SM_COUNT; ++sm) {
+        pio_sim_sm_t *s = &pio->sm[sm];
+
+        s->retired = false;
+        if (!s->enabled) {
+            continue;
+        }
+        s->div_acc += 256;
+        if (s->div_acc < s->cfg.clkdiv_q8) {
+            continue;
+        }
+        s->div_acc -= s->cfg.clkdiv_q8;
+        sm_tick(pio, sm);
+    }
+}
+
+/**
+ * Ciclos del reloj del sistema que pueden pasar sin que avance ninguna máquina habilitada: el
+ * próximo pio_sim_step() después de ellos ejecuta al menos una. UINT32_MAX si no hay ninguna
+ * habilitada.
+ */
+uint32_t pio_sim_idle_cycles(const pio_sim_t *pio) {
+    uint32_t idle = UINT32_MAX;
+
+    for (unsigned sm = 0; sm < PIO_SIM_SM_COUNT; ++sm) {
+        const pio_sim_sm_t *s = &pio->sm[sm];
+        if (s->enabled) {
+            uint32_t ticks = (s->cfg.clkdiv_q8 - s->div_acc + 255) / 256;
+            if (ticks - 1 < idle) {
+                idle = ticks - 1;
+            }
+        }
+    }
+    return idle;
+}
+
+/**
+ * Avanza cycles ciclos en los que no ejecuta ninguna máquina, sin simularlos uno por uno. No debe
+ * superar pio_sim_idle_cycles().
+ */
+void pio_sim_skip(pio_sim_t *pio, uint32_t cycles) {
+    pio->cycle += cycles;
+    for (unsigned sm = 0; sm < PIO_SIM_SM_COUNT; ++sm) {
+        pio->sm[sm].retired = false;
+        if (pio->sm[sm].enabled) {
+            pio->sm[sm].div_acc += cycles * 256;
+        }
+    }
+}
+
+/**
+ * Avanza hasta el próximo ciclo en que alguna máquina habilitada avanza y lo ejecuta, saltando los
+ * ciclos intermedios, en los que nada cambia. Quien alimenta los FIFO debe hacerlo antes de cada
+ * llamada, porque los DREQ solo cambian cuando avanza una máquina.
+ * @return Ciclos del reloj del sistema avanzados (al menos 1).
+ */
+uint64_t pio_sim_step_next(pio_sim_t *pio) {
+    uint32_t idle = pio_sim_idle_cycles(pio);
+
+    if (idle == UINT32_MAX) {
+        idle = 0;
+    }
+    pio_sim_skip(pio, idle);
+    pio_sim_step(pio);
+    return (uint64_t)idle + 1;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file pio_sim.h
+ *
+ * @brief Emulador de un bloque PIO del RP2040, ciclo a ciclo, para las herramientas de la máquina
+ * anfitriona.
+ *
+ * Reproduce las nueve instrucciones (JMP, WAIT, IN, OUT, PUSH, PULL, MOV, IRQ, SET) con sus
+ * demoras y side-set opcional, los FIFO de 4 palabras (8 al unirlos), autopush y autopull con
+ * umbral, el divisor de reloj fraccionario de 16.8 bits, los 8 indicadores de IRQ, la ejecución
+ * forzada (OUT EXEC, MOV EXEC, pio_sim_exec()) y las señales DREQ de los FIFO para conectar un DMA
+ * simulado. Los pines son los 32 GPIO compartidos por las cuatro máquinas: cada pin lee lo que
+ * escribe el PIO si es salida, o pins_in (lo que maneja el circuito simulado) si es entrada.
+ *
+ * Las máquinas avanzan con pio_sim_step(), un ciclo del reloj del sistema por llamada, o con
+ * pio_sim_step_next(), que salta los ciclos en los que el divisor no deja avanzar a ninguna. Lo que no
+ * afecta a los programas del proyecto no se modela: la sincronización de entradas (dos ciclos de
+ * retardo en el hardware), las prioridades entre máquinas que escriben el mismo pin en el mismo
+ * ciclo (gana la de número mayor, como en el hardware, pero sin el orden OUT/SET/side-set) y las
+ * interrupciones del sistema.
+ */
+
+#ifndef PIO_SIM_H
+#define PIO_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PIO_SIM_SM_COUNT 4 ///< Máquinas de estados por bloque PIO
+#define PIO_SIM_MEM_SIZE 32 ///< Instrucciones en la memoria del bloque
+#define PIO_SIM_FIFO_DEPTH 4 ///< Palabras por FIFO; el doble si se unen
+
+/**
+ * Configuración de una máquina de estados, con los mismos campos que pio_sm_config del SDK.
+ */
+typedef struct {
+    uint32_t clkdiv_q8; ///< Divisor de reloj en 16.8 (256 = 1, cada ciclo)
+    uint8_t wrap_target; ///< Dirección a la que salta después de wrap
+    uint8_t wrap; ///< Última instrucción antes de volver a wrap_target
+    uint8_t out_base; ///< Primer pin de OUT y MOV PINS
+    uint8_t out_count; ///< Pines de OUT
+    uint8_t set_base; ///< Primer pin de SET
+    uint8_t set_count; ///< Pines de SET
+    uint8_t in_base; ///< Primer pin de IN y WAIT PIN
+    uint8_t sideset_base; ///< Primer pin de side-set
+    uint8_t sideset_bits; ///< Bits de side-set, incluido el bit de habilitación si es opcional
+    bool sideset_opt; ///< El side-set es opcional (el bit 12 lo habilita)
+    bool sideset_pindirs; ///< El side-set escribe direcciones en lugar de valores
+    uint8_t jmp_pin; ///< Pin de JMP PIN
+    bool out_shift_right; ///< OUT saca los bits menos significativos primero
+    bool in_shift_right; ///< IN entra por los bits más significativos
+    bool autopull; ///< Recargar el OSR al llegar al umbral
+    bool autopush; ///< Enviar el ISR al llegar al umbral
+    uint8_t pull_threshold; ///< Umbral de autopull en bits (0 = 32)
+    uint8_t push_threshold; ///< Umbral de autopush en bits (0 = 32)
+    bool join_tx; ///< Unir los FIFO como un TX de 8 palabras
+    bool join_rx; ///< Unir los FIFO como un RX de 8 palabras
+    bool status_rx; ///< MOV STATUS compara el FIFO RX en lugar del TX
+    uint8_t status_n; ///< MOV STATUS da todo unos si el nivel es menor que status_n
+} pio_sim_config_t;
+
+/**
+ * FIFO de una dirección.
+ */
+typedef struct {
+    uint32_t data[2 * PIO_SIM_FIFO_DEPTH]; ///< Palabras
+    uint8_t head; ///< Índice de la palabra más antigua
+    uint8_t level; ///< Palabras guardadas
+    uint8_t depth; ///< Capacidad actual (0, 4 u 8)
+} pio_sim_fifo_t;
+
+/**
+ * Estado de una máquina de estados.
+ */
+typedef struct {
+    pio_sim_config_t cfg; ///< Configuración
+    bool enabled; ///< Avanza con el reloj
+    uint8_t pc; ///< Dirección de la instrucción en curso
+    uint32_t x, y; ///< Registros de trabajo
+    uint32_t isr, osr; ///< Registros de desplazamiento
+    uint8_t isr_count; ///< Bits entrados en el ISR
+    uint8_t osr_count; ///< Bits sacados del OSR (32 = vacío)
+    uint32_t delay; ///< Ciclos de demora pendientes
+    uint32_t div_acc; ///< Acumulador del divisor de reloj
+    bool exec_pending; ///< La próxima instrucción es exec_instr, no la de pc
+    uint16_t exec_instr; ///< Instrucción forzada
+    bool irq_waiting; ///< IRQ WAIT ya puso su indicador y espera que se borre
+    pio_sim_fifo_t tx, rx; ///< FIFO hacia y desde la máquina
+
+    bool retired; ///< Terminó una instrucción en el último ciclo
+    uint16_t last_instr; ///< Última instrucción terminada
+
+    uint64_t ticks; ///< Ciclos de la máquina (habilitados por el divisor)
+    uint64_t executed; ///< Instrucciones terminadas
+    uint64_t stalls; ///< Ciclos detenida (FIFO vacío o lleno, WAIT, IRQ WAIT)
+} pio_sim_sm_t;
+
+/**
+ * Bloque PIO con sus cuatro máquinas y los pines.
+ */
+typedef struct {
+    uint16_t mem[PIO_SIM_MEM_SIZE]; ///< Memoria de instrucciones
+    pio_sim_sm_t sm[PIO_SIM_SM_COUNT]; ///< Máquinas de estados
+    uint8_t irq; ///< Indicadores de IRQ
+    uint32_t pins_out; ///< Valores escritos por el PIO
+    uint32_t pindirs; ///< Direcciones (1 = salida)
+    uint32_t pins_in; ///< Valores manejados por el circuito en los pines de entrada
+    uint64_t cycle; ///< Ciclos del reloj del sistema simulados
+} pio_sim_t;
+
+void pio_sim_init(pio_sim_t *pio);
+
+bool pio_sim_load(pio_sim_t *pio, const uint16_t *program, unsigned length, unsigned offset);
+
+void pio_sim_config_default(pio_sim_config_t *cfg);
+
+uint32_t pio_sim_clkdiv_q8(uint32_t clk_sys_hz, uint32_t sm_hz);
+
+void pio_sim_sm_init(pio_sim_t *pio, unsigned sm, unsigned initial_pc, const pio_sim_config_t *cfg);
+
+void pio_sim_set_enabled(pio_sim_t *pio, unsigned sm, bool enabled);
+
+void pio_sim_exec(pio_sim_t *pio, unsigned sm, uint16_t instr);
+
+void pio_sim_restart(pio_sim_t *pio, unsigned sm, bool clkdiv);
+
+void pio_sim_step(pio_sim_t *pio);
+
+uint32_t pio_sim_idle_cycles(const pio_sim_t *pio);
+
+void pio_sim_skip(pio_sim_t *pio, uint32_t cycles);
+
+uint64_t pio_sim_step_next(pio_sim_t *pio);
+
+bool pio_sim_put(pio_sim_t *pio, unsigned sm, uint32_t word);
+
+bool pio_sim_get(pio_sim_t *pio, unsigned sm, uint32_t *word);
+
+/**
+ * DREQ del FIFO TX: hay espacio para otra palabra.
+ */
+static inline bool pio_sim_tx_dreq(const pio_sim_t *pio, unsigned sm) {
+    return pio->sm[sm].tx.level < pio->sm[sm].tx.depth;
+}
+
+/**
+ * DREQ del FIFO RX: hay una palabra para leer.
+ */
+static inline bool pio_sim_rx_dreq(const pio_sim_t *pio, unsigned sm) {
+    return pio->sm[sm].rx.level > 0;
+}
+
+/**
+ * Valor actual de los 32 pines.
+ */
+static inline uint32_t pio_sim_pins(const pio_sim_t *pio) {
+    return (pio->pins_out & pio->pindirs) | (pio->pins_in & ~pio->pindirs);
+}
+
+#endif
@@ -0,0 +1,203 @@
+/**
+ * @file rate_run.c
+ *
+ * @brief Simula en la máquina anfitriona la cola de audio USB de la Pico (siggen/rate_match.h)
+ * entre dos relojes que no coinciden.
+ *
+ * El productor entrega un paquete por cuadro USB de 1 ms, con las muestras que corresponden a una
+ * fuente DERIVA ppm más rápida que la salida (47, 48 o 49 a 48 kHz) y con un retardo aleatorio de
+ * hasta JITTER us, como la tarea USB del núcleo 0. El consumidor rellena un bloque de BLOQUE
+ * muestras cada vez que el DMA terminaría uno. La señal es un tono de FREQ Hz.
+ *
+ * Se informa en cuánto tiempo el promedio de cada segundo de la corrección del paso llegó a la
+ * deriva y quedó a menos de RUN_SETTLE_PPM; de la segunda mitad, la corrección media y sus
+ * extremos, el nivel de la cola y la frecuencia del tono en la salida frente a la esperada; las
+ * veces que la cola se vació y los paquetes descartados después de llenarse, y el costo del
+ * remuestreo por muestra de salida. Termina con error si hubo pérdidas o si la corrección no
+ * convergió en la primera mitad.
+ *
+ * Uso: rate_run [-i ENTRADA] [-o SALIDA] [-d DERIVA] [-t SEGUNDOS] [-j JITTER] [-b BLOQUE] [-f FREQ] [-q CALIDAD] [-c FACTOR] [-v]
+ *  - -i ENTRADA  Frecuencia de muestreo del audio USB (Hz, por defecto 48000).
+ *  - -o SALIDA   Frecuencia de muestreo del DAC (Hz, por defecto 1000000).
+ *  - -d DERIVA   Cuánto más rápido va el reloj de la fuente (ppm, por defecto 300; puede ser negativa).
+ *  - -t SEGUNDOS Duración simulada (por defecto 60).
+ *  - -j JITTER   Retardo máximo de la entrega de cada paquete (us, por defecto 500).
+ *  - -b BLOQUE   Muestras por bloque del DAC (por defecto 1024).
+ *  - -f FREQ     Frecuencia del tono (Hz, por defecto 1000).
+ *  - -q CALIDAD  Interpolación: off (lineal, por defecto), low, mid o high (siggen/polyphase.h).
+ *  - -c FACTOR   Factor de la cadena de interpolación antes del remuestreo (siggen/interp_chain.h;
+ *                por defecto 1, sin cadena).
+ *  - -v          Imprimir "ms,nivel,ppm" cada 100 ms por la salida estándar.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "../siggen/rate_match.h"
+
+#define RUN_PI 3.14159265358979323846
+#define RUN_SETTLE_PPM 50 ///< Banda alrededor de la deriva para considerar que la corrección convergió; el retardo
+                          ///< aleatorio de los paquetes mueve los promedios de un segundo unas decenas de ppm
+
+static rate_match_t rm;
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    uint32_t in_rate = 48000, out_rate = 1000000, block = 1024;
+    double drift_ppm = 300, seconds = 60, jitter_us = 500, tone_hz = 1000;
+    polyphase_quality_t quality = POLYPHASE_NEAREST;
+    uint32_t chain = 1;
+    bool verbose = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:o:d:t:j:b:f:q:c:v")) != -1) {
+        switch (opt) {
+            case 'i': in_rate = (uint32_t)atol(optarg); break;
+            case 'o': out_rate = (uint32_t)atol(optarg); break;
+            case 'd': drift_ppm = atof(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            case 'j': jitter_us = atof(optarg); break;
+            case 'b': block = (uint32_t)atol(optarg); break;
+            case 'f': tone_hz = atof(optarg); break;
+            case 'q':
+                if (!polyphase_quality_parse(optarg, &quality)) {
+                    fprintf(stderr, "Calidad desconocida: %s (off, low, mid o high)\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'c': chain = (uint32_t)atol(optarg); break;
+            case 'v': verbose = true; break;
+            default:
+                fprintf(stderr, "Uso: %s [-i ENTRADA] [-o SALIDA] [-d DERIVA] [-t SEGUNDOS] [-j JITTER] [-b BLOQUE] "
+                                "[-f FREQ] [-q CALIDAD] [-c FACTOR] [-v]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (!in_rate || in_rate >= out_rate || !block || in_rate * (1 + drift_ppm * 1e-6) / 1000 > RATE_MATCH_SLOT_SAMPLES) {
+        fprintf(stderr, "La entrada tiene que ser menor que la salida y entrar en paquetes de %d muestras\n",
+                RATE_MATCH_SLOT_SAMPLES);
+        return 2;
+    }
+
+    uint8_t *codes = malloc(block);
+    rate_match_init(&rm, out_rate);
+    rate_match_set_quality(&rm, quality);
+    if (!rate_match_set_chain(&rm, chain)) {
+        fprintf(stderr, "El factor de la cadena tiene que ser una potencia de 2 entre 1 y %d\n", INTERP_CHAIN_MAX_FACTOR);
+        return 2;
+    }
+    rate_match_start(&rm, in_rate);
+
+    // Productor: cuadros de 1 ms con un retardo de entrega aleatorio
+    double per_frame = in_rate * (1 + drift_ppm * 1e-6) / 1000;
+    double owed = 0, tone_phase = 0;
+    uint64_t frame = 0;
+    double deliver_s = jitter_us * 1e-6 * rand() / RAND_MAX;
+
+    // Consumidor y mediciones: la convergencia por promedios de un segundo y el resto en la segunda
+    // mitad de la simulación
+    uint64_t blocks = 0, window_blocks = 0, half_samples = 0, crossings = 0;
+    double render_s = 0, window_ppm = 0, settled_s = 0, half_ppm = 0, ppm_min = 1e9, ppm_max = -1e9;
+    double last_print_s = 0;
+    uint32_t fill_min = UINT32_MAX, fill_max = 0, underruns_primed = 0, overruns_primed = 0;
+    bool primed = false, above = false;
+
+    for (;;) {
+        double block_s = (double)blocks * block / out_rate;
+        if (block_s >= seconds) {
+            break;
+        }
+        if (deliver_s <= block_s) {
+            // Un paquete: las muestras que la fuente produjo en este cuadro
+            owed += per_frame;
+            size_t n = (size_t)owed;
+            owed -= n;
+            int16_t *slot = rate_match_slot(&rm);
+            for (size_t i = 0; i < n; ++i) {
+                if (slot) {
+                    slot[i] = (int16_t)lrint(26000 * sin(2 * RUN_PI * tone_phase));
+                }
+                tone_phase += tone_hz / in_rate;
+                tone_phase -= floor(tone_phase);
+            }
+            if (slot) {
+                rate_match_push(&rm, n);
+            }
+            frame++;
+            deliver_s = frame * 1e-3 + jitter_us * 1e-6 * rand() / RAND_MAX;
+            continue;
+        }
+
+        double t0 = now_s();
+        rate_match_render(&rm, codes, block);
+        render_s += now_s() - t0;
+        blocks++;
+
+        if (rm.state != RATE_MATCH_RUNNING) {
+            continue;
+        }
+        if (!primed) {
+            primed = true;
+            underruns_primed = rm.underruns;
+            overruns_primed = rm.overruns;
+        }
+        double ppm = rate_match_ppm(&rm);
+        window_ppm += ppm;
+        if (++window_blocks * block >= out_rate) {
+            if (fabs(window_ppm / window_blocks - drift_ppm) > RUN_SETTLE_PPM) {
+                settled_s = block_s;
+            }
+            window_ppm = 0;
+            window_blocks = 0;
+        }
+        if (block_s >= seconds / 2) {
+            // Cruces por el centro, para la frecuencia del tono
+            for (uint32_t i = 0; i < block; ++i) {
+                bool up = codes[i] >= RATE_MATCH_MID_CODE;
+                crossings += up && !above && half_samples;
+                above = up;
+            }
+            half_samples += block;
+            half_ppm += ppm * block;
+            ppm_min = ppm < ppm_min ? ppm : ppm_min;
+            ppm_max = ppm > ppm_max ? ppm : ppm_max;
+            fill_min = rm.fill < fill_min ? rm.fill : fill_min;
+            fill_max = rm.fill > fill_max ? rm.fill : fill_max;
+        }
+        if (verbose && block_s - last_print_s >= 0.1) {
+            printf("%.0f,%u,%ld\n", block_s * 1000, rm.fill, (long)rate_match_ppm(&rm));
+            last_print_s = block_s;
+        }
+    }
+
+    uint32_t underruns = rm.underruns - underruns_primed, overruns = rm.overruns - overruns_primed;
+    double mean_ppm = half_samples ? half_ppm / half_samples : 0;
+    bool converged = half_samples && fabs(mean_ppm - drift_ppm) <= RUN_SETTLE_PPM && settled_s < seconds / 2;
+    double tone_ppm = half_samples ? (crossings * (double)out_rate / half_samples / (tone_hz * (1 + drift_ppm * 1e-6)) - 1) * 1e6 : 0;
+
+    fprintf(stderr, "%u Hz -> %u Hz, cadena x%u, interpolación %s, deriva %+.0f ppm, %.0f s: ", in_rate, out_rate,
+            rm.factor, quality == POLYPHASE_NEAREST ? "lineal" : polyphase_quality_name(quality), drift_ppm, seconds);
+    if (converged) {
+        fprintf(stderr, "convergió en %.1f s", settled_s);
+    } else {
+        fprintf(stderr, "NO convergió");
+    }
+    fprintf(stderr, "; segunda mitad: corrección %+.1f ppm (%+.0f a %+.0f), cola %u a %u muestras (objetivo %u), "
+                    "tono %+.0f ppm; vaciados %u, descartados %u; %.1f ns por muestra\n",
+            mean_ppm, ppm_min, ppm_max, fill_min, fill_max, rm.target, tone_ppm, underruns, overruns,
+            render_s * 1e9 / ((double)blocks * block));
+    free(codes);
+    return converged && !underruns && !overruns ? 0 : 1;
+}
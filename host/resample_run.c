@@ -0,0 +1,211 @@
+/**
+ * @file resample_run.c
+ *
+ * @brief Mide en la máquina anfitriona el costo y el rechazo de imágenes del remuestreo polifásico
+ * de siggen/polyphase.h con cada nivel de calidad.
+ *
+ * Hay dos caminos, como en la Pico:
+ *  - tabla: el reproductor de siggen/wavepack.h recorre una tabla de LARGO códigos del DAC con
+ *    PERIODOS periodos de un seno a un paso fraccionario PASO, como la imagen de la flash.
+ *  - flujo: muestras de 16 bits del mismo seno entran de a una a polyphase_stream_t y se leen a
+ *    posiciones fraccionarias, como el audio USB de siggen/rate_match.h. Sin filtro, este camino
+ *    interpola linealmente, como rate_match.
+ *
+ * El rechazo es cuánto más abajo que la fundamental quedan las dos primeras imágenes, a 1 - f y
+ * 1 + f de la frecuencia de las muestras de entrada (escaladas por el paso), medidas con Goertzel
+ * y ventana de Hann sobre MUESTRAS muestras de salida; el costo, los nanosegundos por muestra de
+ * salida de la mejor de cinco repeticiones. El camino de la tabla sale en códigos de 8 bits, así
+ * que su rechazo queda limitado por la cuantización de la tabla y de la salida; el del flujo
+ * muestra el del filtro. Cada resultado es además una línea
+ * "@RESAMPLE,<calidad>,<camino>,<ns por muestra>,<rechazo dB>" por la salida estándar, con la
+ * calidad como en !interp (off, low, mid o high).
+ *
+ * Termina con error si el rechazo del flujo de algún banco queda más de RUN_MARGIN_DB por debajo
+ * del de su diseño (polyphase_bank_t::image_db).
+ *
+ * Uso: resample_run [-p PASO] [-l LARGO] [-c PERIODOS] [-n MUESTRAS]
+ *  - -p PASO     Muestras de entrada por muestra de salida (por defecto 0.3; menor que 1).
+ *  - -l LARGO    Muestras de la tabla (por defecto 64).
+ *  - -c PERIODOS Periodos del seno en la tabla (por defecto 5).
+ *  - -n MUESTRAS Muestras de salida analizadas (por defecto 16384).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "../siggen/polyphase.h"
+#include "../siggen/wavepack.h"
+
+#define RUN_PI 3.14159265358979323846
+#define RUN_BLOCK 1024 ///< Muestras por bloque, como DAC_BLOCK_SAMPLES
+#define RUN_BLOCKS 256 ///< Bloques por repetición de la medición del costo
+#define RUN_REPEATS 5 ///< Repeticiones de la medición del costo; se informa la más rápida
+#define RUN_MARGIN_DB 3 ///< Diferencia admitida entre el rechazo medido en el flujo y el de diseño
+
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Amplitud de la componente de frecuencia f (ciclos por muestra) de x, con ventana de Hann.
+ */
+static double tone_level(const double *x, size_t n, double f) {
+    double coef = 2 * cos(2 * RUN_PI * f), s1 = 0, s2 = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        double s0 = (0.5 - 0.5 * cos(2 * RUN_PI * i / n)) * x[i] + coef * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return sqrt(s1 * s1 + s2 * s2 - coef * s1 * s2);
+}
+
+/**
+ * Rechazo en dB de las dos primeras imágenes de un tono de f ciclos por muestra de entrada.
+ */
+static double rejection_db(const double *x, size_t n, double f, double step) {
+    double signal = tone_level(x, n, f * step);
+    double image = fmax(tone_level(x, n, (1 - f) * step), tone_level(x, n, (1 + f) * step));
+
+    return 20 * log10(signal / fmax(image, 1e-9));
+}
+
+/**
+ * Flujo: genera n muestras de salida a partir de las muestras de 16 bits de in, leídas a paso step
+ * (Q32). Sin banco interpola linealmente.
+ */
+static void stream_render(const polyphase_bank_t *bank, const int16_t *in, uint32_t step, int32_t *out, size_t n) {
+    polyphase_stream_t s;
+    uint32_t frac = 0;
+    int32_t prev = 0, next = 0;
+
+    if (bank) {
+        polyphase_stream_init(&s, bank, 0);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (bank) {
+            out[i] = polyphase_stream_at(&s, frac);
+        } else {
+            out[i] = prev + (int32_t)(((int64_t)(next - prev) * frac) >> 32);
+        }
+        uint32_t pos = frac + step;
+        if (pos < frac) {
+            prev = next;
+            next = *in++;
+            if (bank) {
+                polyphase_stream_push(&s, (int16_t)next);
+            }
+        }
+        frac = pos;
+    }
+}
+
+int main(int argc, char **argv) {
+    static const char *const args[POLYPHASE_QUALITIES] = { "off", "low", "mid", "high" };
+    double step = 0.3;
+    uint32_t len = 64, cycles = 5;
+    size_t samples = 16384;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:l:c:n:")) != -1) {
+        switch (opt) {
+            case 'p': step = atof(optarg); break;
+            case 'l': len = (uint32_t)atol(optarg); break;
+            case 'c': cycles = (uint32_t)atol(optarg); break;
+            case 'n': samples = (size_t)atol(optarg); break;
+            default:
+                fprintf(stderr, "Uso: %s [-p PASO] [-l LARGO] [-c PERIODOS] [-n MUESTRAS]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (step <= 0 || step >= 1 || !len || !cycles || 2 * cycles >= len || samples < RUN_BLOCK) {
+        fprintf(stderr, "El paso tiene que estar entre 0 y 1 y la tabla tener más de dos muestras por periodo\n");
+        return 2;
+    }
+
+    double f = (double)cycles / len;
+    uint32_t inc = (uint32_t)lrint(step * 65536);
+    uint8_t *table = malloc(len), *codes = malloc(samples), *block = malloc(RUN_BLOCK);
+    int32_t *stream = malloc(samples * sizeof(*stream));
+    int16_t *input = malloc((samples + 1) * sizeof(*input));
+    double *x = malloc(samples * sizeof(*x));
+    bool ok = true;
+
+    step = inc / 65536.0;
+    for (uint32_t i = 0; i < len; ++i) {
+        table[i] = (uint8_t)lrint(128 + 100 * sin(2 * RUN_PI * f * i));
+    }
+    for (size_t i = 0; i <= samples; ++i) {
+        input[i] = (int16_t)lrint(26000 * sin(2 * RUN_PI * f * i));
+    }
+    fprintf(stderr, "Tabla de %u muestras con %u periodos, paso %.5f, %zu muestras analizadas\n", len, cycles, step,
+            samples);
+    fprintf(stderr, "%-11s %5s %12s %12s %12s %12s\n", "calidad", "coef", "tabla ns", "tabla dB", "flujo ns", "flujo dB");
+
+    for (int q = 0; q < POLYPHASE_QUALITIES; ++q) {
+        const polyphase_bank_t *bank = polyphase_bank((polyphase_quality_t)q);
+        wavepack_player_t p = {
+            .table = table,
+            .table_len = len,
+            .inc_int = inc >> 16,
+            .inc_frac = inc & 0xFFFF,
+        };
+        wavepack_player_set_quality(&p, (polyphase_quality_t)q);
+
+        // Tabla: costo y rechazo
+        double table_ns = 1e9;
+        for (int r = 0; r < RUN_REPEATS; ++r) {
+            double t0 = now_s();
+            for (int b = 0; b < RUN_BLOCKS; ++b) {
+                wavepack_player_render(&p, block, RUN_BLOCK);
+            }
+            table_ns = fmin(table_ns, (now_s() - t0) * 1e9 / ((double)RUN_BLOCKS * RUN_BLOCK));
+        }
+        p.pos = 0;
+        p.frac = 0;
+        wavepack_player_render(&p, codes, samples);
+        for (size_t i = 0; i < samples; ++i) {
+            x[i] = codes[i] - 128.0;
+        }
+        double table_db = rejection_db(x, samples, f, step);
+
+        // Flujo: costo y rechazo
+        uint32_t step_q32 = (uint32_t)lrint(step * 4294967296.0);
+        double stream_ns = 1e9;
+        for (int r = 0; r < RUN_REPEATS; ++r) {
+            double t0 = now_s();
+            stream_render(bank, input, step_q32, stream, samples);
+            stream_ns = fmin(stream_ns, (now_s() - t0) * 1e9 / samples);
+        }
+        // Se descarta el arranque, mientras la ventana del filtro se llena
+        size_t skip = RUN_BLOCK;
+        for (size_t i = skip; i < samples; ++i) {
+            x[i - skip] = stream[i];
+        }
+        double stream_db = rejection_db(x, samples - skip, f, step);
+
+        fprintf(stderr, "%-11s %5u %12.2f %12.1f %12.2f %12.1f%s\n", polyphase_quality_name((polyphase_quality_t)q), bank ? bank->taps : 1, table_ns, table_db,
+                stream_ns, stream_db, bank && stream_db < bank->image_db - RUN_MARGIN_DB ? "  POR DEBAJO DEL DISEÑO" : "");
+        printf("@RESAMPLE,%s,table,%.2f,%.1f\n", args[q], table_ns, table_db);
+        printf("@RESAMPLE,%s,stream,%.2f,%.1f\n", args[q], stream_ns, stream_db);
+        if (bank && stream_db < bank->image_db - RUN_MARGIN_DB) {
+            ok = false;
+        }
+    }
+    free(table);
+    free(codes);
+    free(block);
+    free(stream);
+    free(input);
+    free(x);
+    return ok ? 0 : 1;
+}
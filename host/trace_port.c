@@ -0,0 +1,11 @@
+/**
+ * @file trace_port.c
+ *
+ * @brief Reloj virtual de la traza en la máquina anfitriona.
+ */
+
+#include "trace_port.h"
+
+uint32_t trace_sim_clock;
+uint32_t trace_sim_clock_hz = 1000000;
+uint32_t trace_sim_core;
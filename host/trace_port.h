@@ -0,0 +1,42 @@
+/**
+ * @file trace_port.h
+ *
+ * @brief Reloj de siggen/trace.h en las herramientas de la máquina anfitriona.
+ *
+ * El reloj es virtual: lo avanza el simulador (trace_sim_clock) y su frecuencia la decide cada
+ * herramienta al volcar la traza. Todo corre en un solo hilo, que se registra como el núcleo
+ * trace_sim_core.
+ */
+
+#ifndef TRACE_PORT_H
+#define TRACE_PORT_H
+
+#include <stdint.h>
+
+#define TRACE_PORT_CLOCK_MASK 0xFFFFFFFFu ///< Bits del contador de trace_port_clock()
+
+extern uint32_t trace_sim_clock; ///< Reloj virtual, en ciclos
+extern uint32_t trace_sim_clock_hz; ///< Frecuencia del reloj virtual
+extern uint32_t trace_sim_core; ///< Núcleo simulado que registra los eventos
+
+static inline uint32_t trace_port_clock(void) {
+    return trace_sim_clock;
+}
+
+static inline uint32_t trace_port_time_us(void) {
+    return (uint32_t)((uint64_t)trace_sim_clock * 1000000 / trace_sim_clock_hz);
+}
+
+static inline uint32_t trace_port_core(void) {
+    return trace_sim_core;
+}
+
+static inline uint32_t trace_port_lock(void) {
+    return 0;
+}
+
+static inline void trace_port_unlock(uint32_t key) {
+    (void)key;
+}
+
+#endif
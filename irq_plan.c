@@ -0,0 +1,126 @@
+/**
+ * @file irq_plan.c
+ *
+ * @brief Aplicación del plan de prioridades y sonda de latencia de interrupciones.
+ */
+
+#include "irq_plan.h"
+#include "dac_out.h"
+#include "stackmon.h"
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/structs/iobank0.h"
+#include <stdio.h>
+
+lat_hist_t irq_latency_timer = { .name = "timer" };
+lat_hist_t irq_latency_gpio = { .name = "gpio" };
+
+static repeating_timer_t probe_timer; ///< Alarma periódica de la sonda
+static bool probe_running; ///< La sonda está activa
+static uint64_t probe_target_us; ///< Instante en que debía dispararse la alarma en curso
+static uint32_t probe_period_us; ///< Periodo de la sonda
+static uint32_t probe_cycles_per_us; ///< Ciclos del reloj del sistema por microsegundo
+static volatile uint32_t probe_force_cvr; ///< SysTick al forzar la interrupción de GPIO
+
+#define PROBE_FORCE_MASK (GPIO_IRQ_EDGE_RISE << 4 * (IRQ_PROBE_PIN % 8)) ///< Bit de IRQ_PROBE_PIN en su registro INTF
+
+static void print_text(void *ctx, const char *text) {
+    (void)ctx;
+    fputs(text, stdout);
+}
+
+/**
+ * Aplica el plan de prioridades en el núcleo que llama.
+ */
+void irq_plan_apply(void) {
+    static const struct {
+        uint irq;
+        uint8_t priority;
+    } plan[] = {
+        {DMA_IRQ_0, IRQ_PRIO_OUTPUT},
+        {DMA_IRQ_1, IRQ_PRIO_OUTPUT},
+        {PIO0_IRQ_0, IRQ_PRIO_OUTPUT},
+        {PIO0_IRQ_1, IRQ_PRIO_OUTPUT},
+        {TIMER_IRQ_0, IRQ_PRIO_TIMER},
+        {TIMER_IRQ_1, IRQ_PRIO_TIMER},
+        {TIMER_IRQ_2, IRQ_PRIO_TIMER},
+        {TIMER_IRQ_3, IRQ_PRIO_TIMER},
+        {IO_IRQ_BANK0, IRQ_PRIO_INPUT},
+        {USBCTRL_IRQ, IRQ_PRIO_USB},
+    };
+
+    for (size_t i = 0; i < sizeof(plan) / sizeof(plan[0]); ++i) {
+        irq_set_priority(plan[i].irq, plan[i].priority);
+    }
+}
+
+/**
+ * Rutina de la alarma de la sonda: registra su retraso y fuerza la interrupción de GPIO.
+ */
+static bool probe_alarm(repeating_timer_t *rt) {
+    (void)rt;
+    int64_t late = (int64_t)(time_us_64() - probe_target_us);
+
+    lat_hist_add(&irq_latency_timer, late > 0 ? (uint32_t)late * probe_cycles_per_us : 0);
+    probe_target_us += probe_period_us;
+
+    probe_force_cvr = isr_stats_begin();
+    hw_set_bits(&iobank0_hw->proc0_irq_ctrl.intf[IRQ_PROBE_PIN / 8], PROBE_FORCE_MASK);
+    return true;
+}
+
+/**
+ * Arranca la sonda con el periodo indicado. Debe llamarse desde el núcleo 0, que es el que
+ * atiende las interrupciones de GPIO.
+ * @return false si no hay alarmas libres o si la sonda ya estaba activa.
+ */
+bool irq_probe_start(uint32_t period_us) {
+    if (probe_running || period_us == 0) {
+        return false;
+    }
+    probe_cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    probe_period_us = period_us;
+    probe_target_us = time_us_64() + period_us;
+    probe_running = add_repeating_timer_us(-(int64_t)period_us, probe_alarm, NULL, &probe_timer);
+    return probe_running;
+}
+
+void irq_probe_stop(void) {
+    if (probe_running) {
+        cancel_repeating_timer(&probe_timer);
+        hw_clear_bits(&iobank0_hw->proc0_irq_ctrl.intf[IRQ_PROBE_PIN / 8], PROBE_FORCE_MASK);
+        probe_running = false;
+    }
+}
+
+/**
+ * Atiende la interrupción forzada por la sonda. Se llama al principio de gpio_callback().
+ * @return true si gpio era IRQ_PROBE_PIN y el evento ya fue atendido.
+ */
+bool irq_probe_gpio(uint gpio) {
+    if (gpio != IRQ_PROBE_PIN) {
+        return false;
+    }
+    hw_clear_bits(&iobank0_hw->proc0_irq_ctrl.intf[IRQ_PROBE_PIN / 8], PROBE_FORCE_MASK);
+    lat_hist_add(&irq_latency_gpio, (probe_force_cvr - systick_hw->cvr) & 0xFFFFFF);
+    return true;
+}
+
+void irq_plan_reset_stats(void) {
+    lat_hist_reset(&dac_out_irq_latency);
+    lat_hist_reset(&irq_latency_timer);
+    lat_hist_reset(&irq_latency_gpio);
+}
+
+/**
+ * Imprime el plan de prioridades y los histogramas de latencia, en ciclos.
+ */
+void irq_plan_print(void) {
+    printf("Prioridades: salida=0x%02x temporizador=0x%02x entrada=0x%02x usb=0x%02x\n",
+           IRQ_PRIO_OUTPUT, IRQ_PRIO_TIMER, IRQ_PRIO_INPUT, IRQ_PRIO_USB);
+    printf("Latencia (ciclos a %lu MHz), sonda %s:\n", (unsigned long)(clock_get_hz(clk_sys) / 1000000),
+           probe_running ? "activa" : "inactiva");
+    lat_hist_print(&dac_out_irq_latency, print_text, NULL);
+    lat_hist_print(&irq_latency_timer, print_text, NULL);
+    lat_hist_print(&irq_latency_gpio, print_text, NULL);
+}
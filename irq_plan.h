@@ -0,0 +1,65 @@
+/**
+ * @file irq_plan.h
+ *
+ * @brief Prioridades de las interrupciones y medición de su latencia.
+ *
+ * El Cortex-M0+ tiene cuatro niveles de prioridad (0x00, 0x40, 0x80 y 0xC0; menor es más
+ * urgente). Por defecto el SDK deja todas las interrupciones en 0x80, y a igual prioridad ninguna
+ * se adelanta a otra. En el firmware la interrupción de fin de bloque (DMA_IRQ_1) corre sola en el
+ * núcleo 1, y el temporizador, la entrada (gpio_callback()) y el USB en el núcleo 0, así que lo que
+ * el plan ordena es sobre todo el núcleo 0:
+ *  - Temporizadores: el planificador y la pila USB dependen de que lleguen a tiempo; una ráfaga
+ *    del teclado o una transferencia USB larga no los retrasa.
+ *  - Entrada (GPIO): solo encola el evento; unos microsegundos de retraso no se notan.
+ *  - USB: la menos urgente; el host reintenta.
+ *  - Salida (DMA y PIO): la más urgente. Comparte núcleo con las demás en el modo de relleno
+ *    desde la interrupción (dac_out_set_refill(), el módulo de MicroPython), y durante un
+ *    arranque sincronizado la entrada sube a esta prioridad para atender el disparo.
+ *
+ * Las prioridades del NVIC son propias de cada núcleo, así que irq_plan_apply() debe llamarse
+ * en los dos.
+ *
+ * La latencia (desde el evento hasta la entrada a la rutina) se acumula en histogramas en
+ * ciclos del reloj del sistema:
+ *  - dma (dac_out_irq_latency): desviación de la entrada a la rutina, medida con el SysTick,
+ *    respecto del fin de bloque nominal, que el PIO marca a intervalos exactos desde el arranque.
+ *  - timer y gpio: una sonda opcional (irq_probe_start()) programa una alarma periódica y mide su
+ *    retraso; desde la alarma fuerza una interrupción de GPIO en IRQ_PROBE_PIN y mide cuánto
+ *    tarda en atenderse, incluida la salida de la rutina de la alarma.
+ *
+ * La variación entre bloques de dac_out_stats (max_irq_jitter_us) tiene resolución de
+ * microsegundos: no muestra diferencias de unos cientos de ciclos, que sí se ven en el histograma
+ * dma.
+ */
+
+#ifndef IRQ_PLAN_H
+#define IRQ_PLAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "siggen/lat_hist.h"
+
+#define IRQ_PRIO_OUTPUT 0x00 ///< DMA y PIO de la salida
+#define IRQ_PRIO_TIMER 0x40 ///< Alarmas del temporizador
+#define IRQ_PRIO_INPUT 0x80 ///< GPIO del botón y del teclado
+#define IRQ_PRIO_USB 0xC0 ///< Controlador USB
+
+#define IRQ_PROBE_PIN 17 ///< GPIO libre donde la sonda fuerza interrupciones (no se configura como salida)
+
+extern lat_hist_t irq_latency_timer; ///< Alarma de la sonda hasta su rutina
+extern lat_hist_t irq_latency_gpio; ///< Interrupción forzada por la sonda hasta gpio_callback()
+
+void irq_plan_apply(void);
+
+bool irq_probe_start(uint32_t period_us);
+
+void irq_probe_stop(void);
+
+bool irq_probe_gpio(uint gpio);
+
+void irq_plan_reset_stats(void);
+
+void irq_plan_print(void);
+
+#endif
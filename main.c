@@ -9,17 +9,30 @@
  * teclado matricial, ajustando los parámetros de amplitud, frecuencia y desplazamiento DC.
  * 
  * @section circuit Circuito
+ * - DAC de 8 bits conectado a GP0-GP7 (GP0 es el bit menos significativo).
  * - Botón conectado a GP16 para cambio de forma de onda.
  * - Filas del teclado matricial conectadas a GP18, GP19, GP20, GP21
  * - Columnas del teclado matricial conectadas a GP22, GP26, GP27, GP28
+ * - Disparo compartido del arranque sincronizado en GP15 (sync_start.h).
  * 
  * @section libraries Bibliotecas
  * - pico/stdlib.h
+ * - pico/multicore.h
  * - hardware/gpio.h
  * - hardware/irq.h
  * 
  * @section notes Notas
  * - Este programa utiliza interrupciones para todas las entradas de usuario para mejorar la eficiencia.
+ * - Las interrupciones solo registran el evento y despiertan una tarea. El núcleo 0 ejecuta un
+ *   planificador cooperativo (siggen/sched.h) con las tareas de entrada, consola USB, telemetría,
+ *   persistencia y la pila USB, y duerme con WFE cuando no hay nada que hacer.
+ * - Por USB aparece, además de la consola, un disco donde se copia un CSV o un WAV para
+ *   reproducirlo en lugar de la síntesis (msc_disk.h), y una interfaz bulk para cargar tablas a
+ *   la máxima velocidad con host/gds_bulk (usb_bulk.h). Con la opción USB_AUDIO de CMake también un
+ *   parlante: mientras la PC reproduce, su audio sale por el DAC (usb_audio.h).
+ * - El núcleo 1 genera la señal por bloques (siggen/synth.h) y los entrega al DAC por PIO y DMA
+ *   (dac_out.h). Entre bloques duerme con WFE hasta la interrupción de fin de bloque del DMA. Con
+ *   la opción DAC_BACKEND=sio de CMake los escribe la CPU en los pines (dac_sio.h).
  * 
  * @section todo Por hacer
  * - Añadir funcionalidades adicionales y optimizar el manejo de errores.
@@ -32,45 +45,61 @@
  */
 
 #include "pico/stdlib.h"
+#include "pico/multicore.h"
 #include "hardware/gpio.h"
 #include <stdio.h>
-#include <math.h>
 #include <string.h>
-#include <ctype.h>
-#include <stdlib.h>
-
-#define DEBOUNCE_MS 200 ///< Retraso (uS). Con fines de eliminación de rebotes
-#define AMPLITUDE_MIN 100.0 ///< Amplitud mínima (mV)
-#define AMPLITUDE_MAX 2500.0 ///< Amplitud máxima (mV)
-#define FREQUENCY_MIN 1 ///< Frecuencia mínima (Hz)
-#define FREQUENCY_MAX 12000000 ///< Frecuencia máxima (Hz)
-#define DAC_MAX_VALUE 255 ///< Valor máximo de amplitud a convertir por el DAC de 8 bits (2^8 - 1)
-#define VREF 3.3 ///< Voltaje de referencia para el DAC de 8 bits
-#define M_PI 3.141592 ///< Valor de PI
-#define ROWS 4 ///< Cantidad de filas
-#define COLS 4 ///< Cantidad de columnas
-#define WAVEFORM_BUTTON_PIN 16
-#define DAC_PIN 0
+#include "siggen/engine.h"
+#include "siggen/input_log.h"
+#include "siggen/sched.h"
+#include "siggen/synth.h"
+#include "siggen/platform.h"
+#include "siggen/arena.h"
+#include "siggen/trace.h"
+#include "dac_out.h"
+#include "dac_sio.h"
+#include "console.h"
+#include "telemetry.h"
+#include "persist.h"
+#include "stackmon.h"
+#include "irq_plan.h"
+#include "sync_start.h"
+#include "wave_store.h"
+#include "usb_dev.h"
+#include "msc_disk.h"
+#include "usb_audio.h"
+#include "usb_bulk.h"
+
+#ifndef INPUT_LOG_ENABLED
+#define INPUT_LOG_ENABLED 0 ///< Si es 1, cada interrupción de GPIO se registra por consola para reproducirla en el simulador
+#endif
+
+#if DAC_BACKEND_SIO
+static const dac_backend_t *const dac = &dac_backend_sio; ///< Salida al DAC por CPU
+#else
+static const dac_backend_t *const dac = &dac_backend_pio; ///< Salida al DAC por PIO y DMA
+#endif
+#define INPUT_QUEUE_LEN 16 ///< Capacidad de la cola de eventos entre la interrupción de GPIO y la tarea de entrada (potencia de 2)
+#define PERSIST_PERIOD_US 2000000 ///< Los parámetros se guardan cuando no cambian durante este tiempo (uS)
 
 uint rowPins[ROWS] = {18, 19, 20, 21}; ///< Disposición de pines de las filas (GPIOs) en el RP2040
 uint colPins[COLS] = {22, 26, 27, 28}; ///< Disposición de pines de las columnas (GPIOs) en el RP2040
 char keys[ROWS][COLS] = {{'1','2','3','A'},{'4','5','6','B'},{'7','8','9','C'},{'*','0','#','D'}}; ///< Matriz 4x4, que contiene cada uno de los caracteres presentes en el diseño del teclado. El orden de los caracteres debe coincidir con el orden del teclado en sí.
 
-typedef enum {
-    SINE, ///< Onda sinusoidal. Sin(2*pi*f*t). centrada alrededor de su desplazamiento DC
-    SQUARE, ///< Onda cuadrada, también llamada onda pulsada, simétrica (ciclo de trabajo del 50%) centrada alrededor de su desplazamiento DC
-    SAWTOOTH, ///< Onda diente de sierra. El tiempo de subida coincide con el período, mientras que el tiempo de caída va a cero. centrada alrededor de su desplazamiento DC
-    TRIANGULAR ///< Onda triangular. Simétrica (tiempo de subida igual al 50% del período, tiempo de caída igual al 50% del período). Centrada alrededor de su desplazamiento DC
-} Waveform;
+engine_t engine; ///< Estado del generador: forma de onda, parámetros y entrada del teclado en curso
 
-volatile Waveform current_waveform = SINE; ///< Forma de onda actual producida por la señal. En esta línea, establece la forma de onda de señal predeterminada como onda sinusoidal.
-volatile float amplitude = 1000.0; ///< Establece la amplitud actual en el valor por DEFECTO
-volatile float frequency = 10.0; ///< Establece la frecuencia actual en el valor por DEFECTO
-volatile float dc_offset = 500.0; ///< Establece el desplazamiento DC actual en el valor por DEFECTO.
+sched_t sched; ///< Planificador cooperativo del núcleo 0
+task_t input_task; ///< Procesa los eventos del botón y del teclado
+task_t console_task_handle; ///< Lee la consola USB
+task_t telemetry_task_handle; ///< Reporte periódico
+task_t persist_task; ///< Guarda los parámetros en flash
+task_t usb_task_handle; ///< Atiende la pila USB (consola y disco de formas de onda)
 
-char paramType = 0;
-char inputBuffer[20];
-int inputIndex = 0;
+input_event_t input_queue[INPUT_QUEUE_LEN]; ///< Eventos pendientes escritos por gpio_callback()
+volatile uint32_t input_head = 0; ///< Índice de escritura (solo lo modifica la interrupción)
+volatile uint32_t input_tail = 0; ///< Índice de lectura (solo lo modifica la tarea de entrada)
+volatile uint32_t input_dropped = 0; ///< Eventos perdidos por cola llena
+isr_stats_t gpio_isr_stats = { .name = "gpio" }; ///< Tiempos de gpio_callback()
 
 // Función para manejar las interrupciones de los GPIO
 void gpio_callback(uint gpio, uint32_t events);
@@ -78,36 +107,182 @@ void gpio_callback(uint gpio, uint32_t events);
 // Función para inicializar los GPIO
 void setup_gpio();
 
-// Función para manejar la entrada del teclado
-void handle_input(char key);
+// Función para barrer el teclado matricial
+int scan_keypad(void *ctx, char *pressed, int max);
+
+// Función para escribir en la consola USB el texto producido por el motor
+void console_output(void *ctx, const char *text);
 
-// Función para generar la forma de onda
-void generate_waveform();
+// Bucle del núcleo 1
+void core1_main();
+
+// Tareas del núcleo 0
+void input_task_fn(void *ctx);
+void persist_task_fn(void *ctx);
 
 /**
- * Función principal del programa. Trabajando solo con llamadas de subrutina de interrupción.
+ * Reloj de 32 bits en microsegundos para el planificador.
+ */
+static uint32_t sched_clock() {
+    return time_us_32();
+}
+
+/**
+ * Duerme el núcleo con WFE hasta el siguiente evento o hasta el instante indicado. Cualquier
+ * interrupción despierta al núcleo, así que una tarea despertada desde una interrupción se
+ * atiende de inmediato.
+ */
+static void sleep_until(uint32_t deadline_us) {
+    int32_t remaining = (int32_t)(deadline_us - time_us_32());
+
+    if (deadline_us != SCHED_NO_DEADLINE && remaining <= 0) {
+        return;
+    }
+    activity_sleep(&core_activity[0], time_us_32());
+    if (deadline_us == SCHED_NO_DEADLINE) {
+        __wfe();
+    } else {
+        best_effort_wfe_or_timeout(delayed_by_us(get_absolute_time(), remaining));
+    }
+    activity_wake(&core_activity[0], time_us_32());
+}
+
+/**
+ * Función principal del programa. El núcleo 0 atiende la interfaz de usuario con el planificador
+ * cooperativo y el núcleo 1 genera la señal.
  */
 int main() {
+    stackmon_paint_core0();
+    stackmon_init_core();
+    trace_start();
+    // La pila USB la inicia el firmware, antes de que pico_stdio_usb la use para la consola
+    usb_audio_init(dac->sample_rate);
+    usb_dev_init(&usb_task_handle);
     stdio_init_all();
+    activity_wake(&core_activity[0], time_us_32());
+    engine_init(&engine, console_output, NULL);
+    persist_load(&engine);
+    wave_store_init();
+    msc_disk_init(dac->sample_rate);
+    usb_bulk_init(dac->sample_rate);
     setup_gpio();
+    irq_plan_apply();
     printf("Signal Generator Started.\n");
 
+    stackmon_register_isr(&gpio_isr_stats);
+    stackmon_register_isr(&dac_out_isr_stats);
+    stackmon_paint_core1();
+    multicore_launch_core1(core1_main);
+
+    sched_init(&sched, sched_clock);
+    sched_add(&sched, &input_task, "entrada", input_task_fn, NULL);
+    sched_add(&sched, &console_task_handle, "consola", console_task, NULL);
+    sched_add(&sched, &telemetry_task_handle, "telemetria", telemetry_task, NULL);
+    sched_add(&sched, &persist_task, "persist", persist_task_fn, NULL);
+    sched_add(&sched, &usb_task_handle, "usb", usb_dev_task, NULL);
+    console_init(&engine, &sched, &console_task_handle);
+    telemetry_init(&engine, &telemetry_task_handle);
+
+    uint32_t now = time_us_32();
+    sched_wake_at(&usb_task_handle, now);
+    sched_wake_at(&console_task_handle, now);
+    sched_wake_at(&telemetry_task_handle, now + TELEMETRY_PERIOD_US);
+    sched_wake_at(&persist_task, now + PERSIST_PERIOD_US);
+
     while (true) {
-        generate_waveform();
+        sync_start_poll();
+        sleep_until(sched_run(&sched));
     }
 
     return 0;
 }
 
 /**
- * Inicializa cada pin de la Raspberry Pi Pico necesario para producir la señal. En este caso, inicializa 8 pines de acuerdo con los 8 bits necesarios en el DAC. Mientras
- * los pines estén en secuencia, estos podrían inicializarse con un bucle for. Además, configura el botón de pulsación con su propio resistor de pull-up.
+ * Copia los parámetros del motor al oscilador si cambiaron desde la última copia. Si el núcleo 0
+ * está escribiendo en ese momento, se reintenta en el siguiente bloque.
  */
-void setup_gpio() {
-    // Configuración para el DAC y el botón de forma de onda
-    gpio_init(DAC_PIN);
-    gpio_set_dir(DAC_PIN, GPIO_OUT);
+static void SIGGEN_HOT(apply_params)(synth_t *synth, uint32_t *seen_seq) {
+    engine_params_t p;
+    uint32_t seq;
+
+    if (engine.param_seq != *seen_seq && engine_snapshot(&engine, &p, &seq)) {
+        synth_set(synth, p.waveform, p.amplitude_uv, p.dc_offset_uv, p.frequency_millihz);
+        *seen_seq = seq;
+    }
+}
+
+/**
+ * Bucle del núcleo 1: rellena cada bloque que el DMA termina de enviar y duerme con WFE hasta la
+ * siguiente interrupción de fin de bloque. Con la salida por SIO siempre hay un bloque disponible
+ * y commit() vuelve después de escribirlo, así que el núcleo no duerme. Los parámetros se releen
+ * una vez por bloque, solo si cambiaron. Un pedido de arranque sincronizado (sync_start.h)
+ * detiene la salida y la vuelve a arrancar, armada, con los bloques rellenos. Se registra como
+ * víctima del bloqueo multinúcleo para que el núcleo 0 pueda detenerlo mientras escribe en la
+ * flash.
+ */
+void SIGGEN_HOT(core1_main)() {
+    synth_t synth;
+    uint32_t seen_seq = engine.param_seq + 1;
+    bool started = false;
+    bool arm_pending = false; ///< Arrancar con start_armed() cuando los bloques estén listos
+
+    stackmon_init_core();
+    multicore_lockout_victim_init();
+    synth_init(&synth, dac->sample_rate);
+    apply_params(&synth, &seen_seq);
+    dac->init(DAC_PIN, dac->sample_rate);
+    irq_plan_apply();
+    // Último paso del arranque que toma memoria de una arena; después no se admiten más peticiones
+    arena_seal();
+    activity_wake(&core_activity[1], time_us_32());
+
+    while (true) {
+        if (sync_start_take_request()) {
+            if (dac->start_armed) {
+                // Los dos bloques se vuelven a rellenar desde la fase cero antes de armar
+                dac->stop();
+                synth.phase = 0;
+                started = false;
+                arm_pending = true;
+            } else {
+                sync_start_reject();
+            }
+        }
+        uint8_t *block = dac->acquire();
+
+        if (!block) {
+            if (!started) {
+                if (arm_pending) {
+                    sync_start_armed();
+                    dac->start_armed(SYNC_TRIGGER_PIN);
+                    arm_pending = false;
+                } else {
+                    dac->start();
+                }
+                started = true;
+                continue;
+            }
+            activity_sleep(&core_activity[1], time_us_32());
+            __wfe();
+            activity_wake(&core_activity[1], time_us_32());
+            continue;
+        }
+        apply_params(&synth, &seen_seq);
+        TRACE_BEGIN(TRACE_ID_RENDER);
+        if (!usb_audio_render(block, DAC_BLOCK_SAMPLES) && !wave_store_render(block, DAC_BLOCK_SAMPLES)) {
+            synth_render(&synth, block, DAC_BLOCK_SAMPLES);
+        }
+        TRACE_END(TRACE_ID_RENDER);
+        dac->commit();
+    }
+}
 
+/**
+ * Inicializa el botón de pulsación con su propio resistor de pull-up y el teclado matricial. Los 8 pines del DAC los configura
+ * la salida (dac->init()) en el núcleo 1.
+ */
+void setup_gpio() {
+    // Configuración para el botón de forma de onda. Los pines del DAC los configura dac->init()
     gpio_init(WAVEFORM_BUTTON_PIN);
     gpio_set_dir(WAVEFORM_BUTTON_PIN, GPIO_IN);
     gpio_pull_up(WAVEFORM_BUTTON_PIN);
@@ -126,93 +301,110 @@ void setup_gpio() {
         gpio_pull_up(colPins[i]);
         gpio_set_irq_enabled_with_callback(colPins[i], GPIO_IRQ_EDGE_FALL, true, &gpio_callback);
     }
+
+    sync_start_init();
 }
 
 /**
- * Esta función genera una forma de onda basada en la ecuación correspondiente a la forma de onda deseada.
+ * Escribe en la consola USB el texto producido por el motor.
  */
-void generate_waveform() {
-    static uint64_t last_time = 0;
-    uint64_t current_time = time_us_64();
-    float value = 0;
-
-    // Calcular el paso de tiempo
-    float time_step = (current_time - last_time) / 1000000.0f;
-    last_time = current_time;
-
-    switch (current_waveform) {
-        case SINE:
-            value = amplitude * (sinf(2 * M_PI * frequency * time_step) / 2 + 0.5) + dc_offset;
-            break;
-        case SQUARE:
-            value = amplitude * (sinf(2 * M_PI * frequency * time_step) > 0 ? 1 : -1) / 2 + 0.5 + dc_offset;
-            break;
-        case SAWTOOTH:
-            value = amplitude * (2 * fmod(frequency * time_step, 1) - 1) / 2 + 0.5 + dc_offset;
-            break;
-        case TRIANGULAR:
-            value = amplitude * (1.0 - fabs(fmod(frequency * time_step * 4, 4) - 2)) + dc_offset;
-            break;
+void console_output(void *ctx, const char *text) {
+    (void)ctx;
+    fputs(text, stdout);
+}
+
+/**
+ * Barre el teclado matricial activando una fila a la vez y leyendo las columnas.
+ *
+ * @param ctx      Evento en registro (input_event_t) o NULL si el registro está deshabilitado.
+ * @param pressed  Arreglo donde se escriben las teclas presionadas.
+ * @param max      Capacidad de pressed.
+ * @return Cantidad de teclas presionadas.
+ */
+int scan_keypad(void *ctx, char *pressed, int max) {
+    int count = 0;
+
+    for (int row = 0; row < ROWS; ++row) {
+        gpio_put(rowPins[row], 0);  // Activar la fila
+        for (int col = 0; col < COLS; ++col) {
+            if (!gpio_get(colPins[col]) && count < max) {
+                pressed[count++] = keys[row][col];
+            }
+        }
+        gpio_put(rowPins[row], 1);  // Desactivar la fila
     }
 
-    // Convertir a valor DAC
-    uint dac_value = (uint)((value / VREF) * DAC_MAX_VALUE);
-    gpio_put(DAC_PIN, dac_value);  // Suponiendo que DAC_PIN está conectado a un DAC de escalera R2R simple o similar
+    if (ctx) {
+        input_event_t *ev = (input_event_t *)ctx;
+        ev->nkeys = (uint8_t)count;
+        memcpy(ev->keys, pressed, count);
+    }
+    return count;
 }
 
 /**
  * Función para manejar las interrupciones de los GPIO. Debe manejar tanto el botón como el teclado.
+ * Solo registra el evento con su instante y despierta la tarea de entrada; el antirrebote, el
+ * barrido del teclado y la impresión se hacen fuera de la interrupción.
  */
 void gpio_callback(uint gpio, uint32_t events) {
-    static uint64_t last_interrupt_time = 0;
-    uint64_t current_time = to_ms_since_boot(get_absolute_time());
-
-    if (current_time - last_interrupt_time > DEBOUNCE_MS) {
-        last_interrupt_time = current_time;
-
-        if (gpio == WAVEFORM_BUTTON_PIN) {
-            current_waveform = (Waveform)((current_waveform + 1) % 4);
-            printf("Forma de onda cambiada a %d\n", current_waveform);
-        } else {
-            for (int row = 0; row < ROWS; ++row) {
-                gpio_put(rowPins[row], 0);  // Activar la fila
-                for (int col = 0; col < COLS; ++col) {
-                    if (!gpio_get(colPins[col])) {
-                        char key = keys[row][col];
-                        printf("Tecla presionada: %c\n", key);
-                        handle_input(key);
-                    }
-                }
-                gpio_put(rowPins[row], 1);  // Desactivar la fila
-            }
-        }
+    if (irq_probe_gpio(gpio) || sync_start_gpio(gpio)) {
+        return;
+    }
+    uint32_t start = isr_stats_begin();
+    uint32_t head = input_head;
+
+    TRACE_BEGIN(TRACE_ID_GPIO_IRQ);
+    if (head - input_tail >= INPUT_QUEUE_LEN) {
+        input_dropped++;
+    } else {
+        input_event_t *ev = &input_queue[head % INPUT_QUEUE_LEN];
+        ev->t_ms = to_ms_since_boot(get_absolute_time());
+        ev->gpio = (uint8_t)gpio;
+        ev->nkeys = 0;
+        input_head = head + 1;
+        sched_wake(&input_task, time_us_32());
     }
+    TRACE_COUNTER(TRACE_ID_INPUT_QUEUE, input_head - input_tail);
+    TRACE_END(TRACE_ID_GPIO_IRQ);
+    isr_stats_end(&gpio_isr_stats, start);
 }
 
 /**
- * Obtener la entrada y convertirla de cadena a valor flotante, para amplitud, frecuencia y desplazamiento.
+ * Tarea de entrada: entrega al motor, en orden, todos los eventos que dejó la interrupción. El
+ * botón y el teclado comparten esta tarea porque comparten el estado del antirrebote. El
+ * antirrebote usa el instante registrado en la interrupción, no el de ejecución de la tarea.
  */
-void handle_input(char key) {
-    if (key == 'D') {
-        if (paramType == 'A') {
-            amplitude = strtof(inputBuffer, NULL);
-            printf("Amplitud establecida en: %.2f mV\n", amplitude);
-        } else if (paramType == 'B') {
-            frequency = strtof(inputBuffer,NULL);
-            printf("Frecuencia establecida en: %.2f Hz\n", frequency);
-        } else if (paramType == 'C') {
-            dc_offset = strtof(inputBuffer,NULL);
-            printf("Desplazamiento DC establecido en: %.2f mV\n", dc_offset);
-        }
-        inputIndex = 0;
-        memset(inputBuffer, 0, sizeof(inputBuffer));
-    } else {
-        if (key == 'A' || key == 'B' || key == 'C') {
-            paramType = key;
-        } else if (isdigit(key)) {
-            if (inputIndex < sizeof(inputBuffer) - 1) {
-                inputBuffer[inputIndex++] = key;
-            }
-        }
+void input_task_fn(void *ctx) {
+    (void)ctx;
+
+    while (input_tail != input_head) {
+        input_event_t *ev = &input_queue[input_tail % INPUT_QUEUE_LEN];
+#if INPUT_LOG_ENABLED
+        char line[INPUT_LOG_LINE_MAX];
+
+        engine_gpio_event(&engine, ev->t_ms, ev->gpio, scan_keypad, ev);
+        input_log_format(line, sizeof(line), ev);
+        fputs(line, stdout);
+#else
+        engine_gpio_event(&engine, ev->t_ms, ev->gpio, scan_keypad, NULL);
+#endif
+        input_tail++;
+    }
+}
+
+/**
+ * Tarea de persistencia: guarda los parámetros cuando difieren de los guardados y permanecieron
+ * iguales durante un periodo completo, para no escribir la flash mientras el usuario todavía está
+ * tecleando.
+ */
+void persist_task_fn(void *ctx) {
+    (void)ctx;
+    static uint32_t last_seq;
+
+    if (engine.param_seq == last_seq && engine.inputIndex == 0 && persist_changed(&engine)) {
+        persist_save(&engine);
     }
+    last_seq = engine.param_seq;
+    sched_wake_at(&persist_task, time_us_32() + PERSIST_PERIOD_US);
 }
@@ -0,0 +1,87 @@
+## @package bench_pwm_dma
+#  Mide la frecuencia lograda por la salida PWM con DMA de GDS_Micropython.py frente a la pedida.
+#
+#  Para cada frecuencia del barrido se programa la salida con start_pwm_output() y se cuentan los
+#  ciclos de PWM con el slice 0 en modo contador de flancos de subida de su entrada B (GP17), que
+#  debe unirse con un cable a la salida (GP15). Como cada ciclo de PWM entrega un punto del búfer,
+#  la frecuencia medida es ciclos por segundo / puntos por periodo. Se usa la onda cuadrada con
+#  desplazamiento para que ningún punto tenga ciclo de trabajo 0 % o 100 %, lo que ocultaría flancos.
+#  El contador es de 16 bits y se lee cada POLL_MS: con frecuencias altas su divisor agrupa los
+#  flancos para que entre dos lecturas nunca cuente más de COUNT_MARGIN.
+#
+#  @section usage Uso
+#  Copiar GDS_Micropython.py a la Pico y ejecutar:
+#  mpremote run micropython/bench_pwm_dma.py
+
+from machine import Pin, mem32
+import utime
+import GDS_Micropython as gds
+
+## Entrada B del slice 0, unida a la salida PWM
+COUNT_PIN = 17
+COUNT_BASE = 0x40050000
+IO_BANK0_CTRL = 0x40014004
+FUNCSEL_PWM = 4
+## Frecuencias del barrido (Hz)
+FREQUENCIES = [1, 10, 100, 1000, 5000, 10000, 50000, 100000, 500000, 1000000]
+## Duración de cada medición (ms)
+MEASURE_MS = 1000
+## Intervalo entre lecturas del contador (ms)
+POLL_MS = 10
+## Cuenta máxima prevista entre dos lecturas; deja lugar para lecturas atrasadas hasta 4 veces
+COUNT_MARGIN = 0x10000 // 4
+
+## Divisor entero del contador para una tasa de flancos prevista
+#  @param edges_per_s Flancos por segundo esperados en GP17.
+#  @return Flancos por cuenta, entre 1 y 255.
+def counter_div(edges_per_s):
+    per_poll = edges_per_s * POLL_MS / 1000
+    return min(255, max(1, int(per_poll // COUNT_MARGIN) + 1))
+
+## Configura el slice 0 como contador de flancos de subida en GP17
+#  @param div Flancos por cuenta (divisor entero del slice).
+def setup_counter(div):
+    Pin(COUNT_PIN, Pin.IN)
+    mem32[IO_BANK0_CTRL + 8 * COUNT_PIN] = FUNCSEL_PWM
+    mem32[COUNT_BASE + 0x00] = 0            # CSR: deshabilitado
+    mem32[COUNT_BASE + 0x04] = div << 4     # DIV entero, sin fracción
+    mem32[COUNT_BASE + 0x10] = 0xFFFF       # TOP
+    mem32[COUNT_BASE + 0x08] = 0            # CTR
+    mem32[COUNT_BASE + 0x00] = (2 << 4) | 1 # CSR: DIVMODE = flanco de subida de B, EN
+
+## Cuenta flancos durante MEASURE_MS leyendo el contador de 16 bits antes de que desborde
+#  @param div Divisor con el que se configuró el contador.
+#  @return Flancos por segundo.
+def count_edges(div):
+    total = 0
+    last = mem32[COUNT_BASE + 0x08]
+    start = utime.ticks_us()
+    deadline = utime.ticks_add(utime.ticks_ms(), MEASURE_MS)
+    while utime.ticks_diff(deadline, utime.ticks_ms()) > 0:
+        utime.sleep_ms(POLL_MS)
+        now = mem32[COUNT_BASE + 0x08]
+        total += (now - last) & 0xFFFF
+        last = now
+    return total * div * 1000000 / utime.ticks_diff(utime.ticks_us(), start)
+
+def main():
+    gds.amplitude = 1000
+    gds.dc_offset = 500
+    gds.current_waveform_index = gds.wave_forms.index('square')
+    print("{:>9s} {:>13s} {:>13s} {:>7s} {:>9s} {:>7s}".format(
+        "pedida", "calculada", "medida", "puntos", "error(%)", "TOP"))
+    for freq in FREQUENCIES:
+        gds.frequency = freq
+        achieved = gds.start_pwm_output()
+        div = counter_div(achieved * gds.pwm_points)
+        setup_counter(div)
+        utime.sleep_ms(50)
+        measured = count_edges(div) / gds.pwm_points
+        if measured == 0:
+            print("{:9d} {:13.3f} {:>13s}   sin flancos: unir GP15 con GP17".format(freq, achieved, "-"))
+            continue
+        print("{:9d} {:13.3f} {:13.3f} {:7d} {:9.3f} {:7d}".format(
+            freq, achieved, measured, gds.pwm_points, (measured - freq) * 100 / freq, mem32[gds.PWM_TOP]))
+    gds.stop_pwm_output()
+
+main()
@@ -0,0 +1,110 @@
+## @package bench_siggen
+#  Compara la máxima frecuencia de salida limpia entre la generación en Python puro
+#  (generate_wave() de GDS_Micropython.py) y el módulo nativo siggen.
+#
+#  Se considera limpia una señal con al menos MIN_SAMPLES puntos por periodo y, en el camino
+#  nativo, sin bloques repetidos por el DMA (underruns).
+#  - Python puro: se mide el costo de un paso del bucle de generate_wave() (cálculo de la forma
+#    de onda y duty_u16(), sin la espera) y se deduce la frecuencia a la que el intérprete todavía
+#    entrega MIN_SAMPLES pasos por periodo, y también los 360 pasos que usa el script.
+#  - Nativo: se barre la frecuencia con siggen.set() y se verifica con siggen.stats() que la
+#    interrupción del DMA llegue a rellenar todos los bloques; la frecuencia limpia queda acotada
+#    por SAMPLE_RATE / MIN_SAMPLES.
+#
+#  @section usage Uso
+#  Copiar a la Pico con el firmware de MicroPython que incluye el módulo siggen y ejecutar:
+#  mpremote run micropython/bench_siggen.py
+#  Sin el módulo solo se mide el camino en Python.
+
+from machine import Pin, PWM
+import utime
+import math
+
+try:
+    import siggen
+except ImportError:
+    siggen = None
+
+## Puntos por periodo para considerar limpia la señal
+MIN_SAMPLES = 32
+## Pasos medidos por forma de onda en el camino de Python
+PY_STEPS = 720
+## Primer GPIO del DAC de 8 bits para el camino nativo
+DAC_PIN_BASE = 0
+## Tiempo de salida en cada punto del barrido nativo (ms)
+SETTLE_MS = 300
+
+amplitude = 1000
+dc_offset = 500
+
+## Mide el tiempo medio de un paso de generate_wave() para una forma de onda, en µs
+#  @param pwm Salida PWM que recibe los valores.
+#  @param wave_form Nombre de la forma de onda como en GDS_Micropython.py.
+def python_step_us(pwm, wave_form):
+    start = utime.ticks_us()
+    step = 1
+    for _ in range(PY_STEPS):
+        if wave_form == 'sine':
+            duty = amplitude * (math.sin(math.radians(step)) / 2 + 0.5) + dc_offset
+        elif wave_form == 'triangle':
+            duty = (2 * amplitude / math.pi) * math.asin(math.sin(math.radians(step))) + dc_offset
+        elif wave_form == 'sawtooth':
+            duty = ((-2 * amplitude / math.pi) * math.atan(1/math.tan(math.radians(step / 2)))) + dc_offset
+        else:
+            duty = (amplitude if step < 180 else 0) + dc_offset
+        pwm.duty_u16(int((duty / 3300) * 65535))
+        step = step % 359 + 1
+    return utime.ticks_diff(utime.ticks_us(), start) / PY_STEPS
+
+## Mide el camino en Python puro y devuelve la frecuencia limpia de la forma de onda más lenta
+def bench_python():
+    pwm = PWM(Pin(15))
+    pwm.freq(100000)
+    worst = 0
+    print("Python puro:")
+    for wave_form in ('sine', 'triangle', 'sawtooth', 'square'):
+        step_us = python_step_us(pwm, wave_form)
+        worst = max(worst, step_us)
+        print("  {:9s} paso={:7.1f} us  max(360 pasos)={:8.3f} Hz  max({} pasos)={:8.1f} Hz".format(
+            wave_form, step_us, 1e6 / (360 * step_us), MIN_SAMPLES, 1e6 / (MIN_SAMPLES * step_us)))
+    pwm.deinit()
+    return 1e6 / (MIN_SAMPLES * worst)
+
+## Barre la frecuencia del módulo nativo y devuelve la máxima limpia de la forma de onda más lenta
+def bench_native():
+    limit = siggen.SAMPLE_RATE // MIN_SAMPLES
+    worst = limit
+    print("Modulo nativo (muestreo {} Hz, bloques de {} muestras):".format(
+        siggen.SAMPLE_RATE, siggen.BLOCK_SAMPLES))
+    siggen.set(waveform='sine', amplitude=amplitude, offset=dc_offset, frequency=1000)
+    siggen.start(DAC_PIN_BASE)
+    for wave_form in ('sine', 'triangle', 'sawtooth', 'square'):
+        clean = 0
+        frequency = 1000
+        siggen.stats(True)
+        while frequency <= limit:
+            siggen.set(waveform=wave_form, frequency=frequency)
+            before = siggen.stats()['underruns']
+            utime.sleep_ms(SETTLE_MS)
+            if siggen.stats()['underruns'] != before:
+                break
+            clean = frequency
+            frequency *= 2
+        stats = siggen.stats()
+        print("  {:9s} limpia hasta {:8d} Hz  sintesis={} us/bloque  jitter={} us".format(
+            wave_form, clean, stats['max_render_us'], stats['max_irq_jitter_us']))
+        worst = min(worst, clean)
+    siggen.stop()
+    return worst
+
+def main():
+    py_max = bench_python()
+    print("Python puro: frecuencia limpia max = {:.1f} Hz".format(py_max))
+    if siggen is None:
+        print("Modulo siggen no disponible en este firmware")
+        return
+    native_max = bench_native()
+    print("Nativo: frecuencia limpia max = {} Hz".format(native_max))
+    print("Mejora: {:.0f}x".format(native_max / py_max))
+
+main()
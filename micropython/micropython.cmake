@@ -0,0 +1,3 @@
+# Módulos de usuario de MicroPython de este proyecto (USER_C_MODULES apunta a este archivo).
+
+include(${CMAKE_CURRENT_LIST_DIR}/siggen/micropython.cmake)
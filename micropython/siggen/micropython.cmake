@@ -0,0 +1,26 @@
+# Módulo de usuario de MicroPython "siggen" para el puerto rp2. Compila el motor de síntesis y la
+# salida por PIO y DMA del firmware en C sin copiarlos.
+#
+# make -C ports/rp2 BOARD=RPI_PICO USER_C_MODULES=<repo>/micropython/micropython.cmake
+
+add_library(usermod_siggen INTERFACE)
+
+set(SIGGEN_ROOT ${CMAKE_CURRENT_LIST_DIR}/../..)
+
+target_sources(usermod_siggen INTERFACE
+    ${CMAKE_CURRENT_LIST_DIR}/modsiggen.c
+    ${SIGGEN_ROOT}/dac_out.c
+    ${SIGGEN_ROOT}/siggen/synth.c
+    ${SIGGEN_ROOT}/siggen/arena.c
+)
+
+target_include_directories(usermod_siggen INTERFACE
+    ${CMAKE_CURRENT_LIST_DIR}
+    ${SIGGEN_ROOT}
+)
+
+target_compile_definitions(usermod_siggen INTERFACE SIGGEN_RAM_HOT_PATH=1)
+
+pico_generate_pio_header(usermod_siggen ${SIGGEN_ROOT}/dac_out.pio)
+
+target_link_libraries(usermod INTERFACE usermod_siggen)
@@ -0,0 +1,213 @@
+/**
+ * @file modsiggen.c
+ *
+ * @brief Módulo de C para MicroPython que expone el motor de síntesis y la salida por PIO y DMA.
+ *
+ * La versión en Python (GDS_Micropython.py) calcula cada punto de la señal en el intérprete, lo
+ * que la limita a unos pocos hercios. Con este módulo el script solo maneja el teclado, el botón
+ * y los mensajes; las muestras las produce synth_render() (el mismo código del firmware en C) y
+ * las envía el DMA al DAC de 8 bits a DAC_SAMPLE_RATE. Como MicroPython ocupa el núcleo 0 y el
+ * núcleo 1 puede estar en uso por _thread, los bloques se rellenan desde la interrupción de fin de
+ * bloque del DMA (ver dac_out_set_refill()).
+ *
+ * Uso desde Python:
+ * @code
+ * import siggen
+ * siggen.set(waveform='sine', amplitude=1000, offset=500, frequency=1000)
+ * siggen.start(0)      # DAC en GP0..GP7
+ * print(siggen.stats())
+ * siggen.stop()
+ * @endcode
+ *
+ * Amplitud y desplazamiento se expresan en mV y la frecuencia en Hz, igual que en el script; se
+ * aceptan enteros o números con decimales.
+ */
+
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "hardware/sync.h"
+#include "siggen/platform.h"
+#include "siggen/synth.h"
+#include "dac_out.h"
+
+static synth_t synth; ///< Oscilador que rellena los bloques del DAC
+static engine_params_t params = { SINE, 1000000, 500000, 10000 }; ///< Últimos parámetros establecidos
+static bool initialized; ///< dac_out_init() ya se llamó
+static bool running; ///< La salida está activa
+
+/**
+ * Nombres aceptados para la forma de onda, en el orden de la enumeración Waveform. 'triangle' es
+ * el nombre que usa GDS_Micropython.py.
+ */
+static const qstr waveform_names[] = {
+    MP_QSTR_sine, MP_QSTR_square, MP_QSTR_sawtooth, MP_QSTR_triangle,
+};
+
+static void SIGGEN_HOT(siggen_refill)(uint8_t *block) {
+    synth_render(&synth, block, DAC_BLOCK_SAMPLES);
+}
+
+/**
+ * Convierte un número de Python a milésimas de la unidad sin pasar por float si es entero.
+ */
+static int64_t get_milli(mp_obj_t obj) {
+    if (mp_obj_is_int(obj)) {
+        return (int64_t)mp_obj_get_int(obj) * 1000;
+    }
+    return (int64_t)(mp_obj_get_float(obj) * 1000);
+}
+
+static Waveform get_waveform(mp_obj_t obj) {
+    if (mp_obj_is_str(obj)) {
+        qstr name = mp_obj_str_get_qstr(obj);
+        for (size_t i = 0; i < MP_ARRAY_SIZE(waveform_names); ++i) {
+            if (waveform_names[i] == name) {
+                return (Waveform)i;
+            }
+        }
+    } else {
+        mp_int_t index = mp_obj_get_int(obj);
+        if (index >= 0 && index < (mp_int_t)MP_ARRAY_SIZE(waveform_names)) {
+            return (Waveform)index;
+        }
+    }
+    mp_raise_ValueError(MP_ERROR_TEXT("forma de onda no válida"));
+}
+
+/**
+ * Aplica los parámetros al oscilador. Se deshabilitan las interrupciones para que la rutina del
+ * DMA no renderice un bloque con el oscilador a medio actualizar.
+ */
+static void apply_params(void) {
+    uint32_t irq = save_and_disable_interrupts();
+    synth_set(&synth, params.waveform, params.amplitude_uv, params.dc_offset_uv, params.frequency_millihz);
+    restore_interrupts(irq);
+}
+
+/**
+ * siggen.set(*, waveform, amplitude, offset, frequency): cambia los parámetros indicados. Los
+ * que se omiten conservan su valor. Los rangos son los mismos que valida el firmware en C.
+ */
+static mp_obj_t siggen_set(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_waveform, ARG_amplitude, ARG_offset, ARG_frequency };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_waveform, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_amplitude, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_offset, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_frequency, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    engine_params_t next = params;
+
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_waveform].u_obj != MP_OBJ_NULL) {
+        next.waveform = get_waveform(args[ARG_waveform].u_obj);
+    }
+    if (args[ARG_amplitude].u_obj != MP_OBJ_NULL) {
+        int64_t uv = get_milli(args[ARG_amplitude].u_obj);
+        if (uv < AMPLITUDE_MIN * 1000LL || uv > AMPLITUDE_MAX * 1000LL) {
+            mp_raise_ValueError(MP_ERROR_TEXT("amplitud fuera de rango"));
+        }
+        next.amplitude_uv = (int32_t)uv;
+    }
+    if (args[ARG_offset].u_obj != MP_OBJ_NULL) {
+        int64_t uv = get_milli(args[ARG_offset].u_obj);
+        if (uv < -VREF_UV || uv > VREF_UV) {
+            mp_raise_ValueError(MP_ERROR_TEXT("desplazamiento fuera de rango"));
+        }
+        next.dc_offset_uv = (int32_t)uv;
+    }
+    if (args[ARG_frequency].u_obj != MP_OBJ_NULL) {
+        int64_t mhz = get_milli(args[ARG_frequency].u_obj);
+        if (mhz < FREQUENCY_MIN * 1000LL || mhz > FREQUENCY_MAX * 1000LL) {
+            mp_raise_ValueError(MP_ERROR_TEXT("frecuencia fuera de rango"));
+        }
+        next.frequency_millihz = (uint64_t)mhz;
+    }
+
+    params = next;
+    apply_params();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(siggen_set_obj, 0, siggen_set);
+
+/**
+ * siggen.start(pin_base=0): arranca la salida en los pines pin_base..pin_base+7. El PIO, los
+ * canales de DMA y el pin base se fijan en la primera llamada.
+ */
+static mp_obj_t siggen_start(size_t n_args, const mp_obj_t *args) {
+    if (running) {
+        return mp_const_none;
+    }
+    if (!initialized) {
+        mp_int_t pin_base = n_args > 0 ? mp_obj_get_int(args[0]) : 0;
+        if (pin_base < 0 || pin_base + 8 > NUM_BANK0_GPIOS) {
+            mp_raise_ValueError(MP_ERROR_TEXT("pin base no válido"));
+        }
+        synth_init(&synth, DAC_SAMPLE_RATE);
+        apply_params();
+        dac_out_init((uint)pin_base, DAC_SAMPLE_RATE);
+        dac_out_set_refill(siggen_refill);
+        initialized = true;
+    }
+    dac_out_start();
+    running = true;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(siggen_start_obj, 0, 1, siggen_start);
+
+/**
+ * siggen.stop(): detiene la salida; los pines conservan la última muestra.
+ */
+static mp_obj_t siggen_stop(void) {
+    if (running) {
+        dac_out_stop();
+        running = false;
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(siggen_stop_obj, siggen_stop);
+
+static void dict_store_uint(mp_obj_t dict, qstr key, uint32_t value) {
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(key), mp_obj_new_int_from_uint(value));
+}
+
+/**
+ * siggen.stats(reset=False): contadores de la salida como diccionario (bloques enviados, bloques
+ * repetidos por no rellenarse a tiempo, peor tiempo de síntesis de un bloque y peor desviación
+ * del intervalo entre interrupciones, en µs). Con reset=True se reinician los máximos después de
+ * leerlos.
+ */
+static mp_obj_t siggen_stats(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t dict = mp_obj_new_dict(5);
+
+    dict_store_uint(dict, MP_QSTR_sample_rate, DAC_SAMPLE_RATE);
+    dict_store_uint(dict, MP_QSTR_blocks, dac_out_stats.blocks);
+    dict_store_uint(dict, MP_QSTR_underruns, dac_out_stats.underruns);
+    dict_store_uint(dict, MP_QSTR_max_render_us, dac_out_stats.max_render_us);
+    dict_store_uint(dict, MP_QSTR_max_irq_jitter_us, dac_out_stats.max_irq_jitter_us);
+    if (n_args > 0 && mp_obj_is_true(args[0])) {
+        dac_out_reset_stats();
+    }
+    return dict;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(siggen_stats_obj, 0, 1, siggen_stats);
+
+static const mp_rom_map_elem_t siggen_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_siggen) },
+    { MP_ROM_QSTR(MP_QSTR_set), MP_ROM_PTR(&siggen_set_obj) },
+    { MP_ROM_QSTR(MP_QSTR_start), MP_ROM_PTR(&siggen_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&siggen_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats), MP_ROM_PTR(&siggen_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_SAMPLE_RATE), MP_ROM_INT(DAC_SAMPLE_RATE) },
+    { MP_ROM_QSTR(MP_QSTR_BLOCK_SAMPLES), MP_ROM_INT(DAC_BLOCK_SAMPLES) },
+};
+static MP_DEFINE_CONST_DICT(siggen_module_globals, siggen_module_globals_table);
+
+const mp_obj_module_t siggen_user_cmodule = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t *)&siggen_module_globals,
+};
+
+MP_REGISTER_MODULE(MP_QSTR_siggen, siggen_user_cmodule);
@@ -0,0 +1,514 @@
+/**
+ * @file msc_disk.c
+ *
+ * @brief Volumen FAT12 generado al vuelo e importación de lo que el host escribe en él.
+ *
+ * Distribución del volumen (sectores de 512 bytes, clusters de 8 KB):
+ *  - 0: sector de arranque.
+ *  - 1 a 6 y 7 a 12: las dos copias de la FAT.
+ *  - 13 a 28: directorio raíz (256 entradas).
+ *  - 29 en adelante: datos. El cluster 2 es LEAME.TXT, el 3 es ESTADO.TXT y el resto está libre.
+ */
+
+#include "msc_disk.h"
+#include "wave_store.h"
+#include "siggen/arena.h"
+#include "siggen/wave_import.h"
+#include "pico/stdlib.h"
+#include "pico/unique_id.h"
+#include "tusb.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SECTOR 512 ///< Bytes por sector
+#define CLUSTER_SECTORS 16 ///< Sectores por cluster; con 8 KB los 16 MB quedan en menos de 4085 clusters (FAT12)
+#define FAT_SECTORS 6 ///< Sectores de cada FAT: (2046 + 2) entradas de 12 bits
+#define ROOT_ENTRIES 256 ///< Entradas del directorio raíz
+#define ROOT_SECTORS (ROOT_ENTRIES * 32 / SECTOR)
+#define LBA_FAT1 1
+#define LBA_FAT2 (LBA_FAT1 + FAT_SECTORS)
+#define LBA_ROOT (LBA_FAT2 + FAT_SECTORS)
+#define LBA_DATA (LBA_ROOT + ROOT_SECTORS)
+#define CLUSTER_README 2 ///< LEAME.TXT
+#define CLUSTER_STATUS 3 ///< ESTADO.TXT
+#define CLUSTER_FIRST_FREE 4 ///< Primer cluster que puede usar el host
+#define STATUS_LEN 512 ///< Largo fijo de ESTADO.TXT, relleno con espacios
+#define KNOWN_FILES 16 ///< Entradas recordadas del último sector de directorio escrito
+#define FAT_DATE ((2024 - 1980) << 9 | 4 << 5 | 1) ///< Fecha de los archivos generados: 1 de abril de 2024
+
+/**
+ * Estado de la importación.
+ */
+typedef enum {
+    IMPORT_IDLE, ///< Todavía no se copió nada
+    IMPORT_RUNNING, ///< Llegando los sectores de un archivo
+    IMPORT_DONE, ///< La tabla quedó en la flash y se reproduce
+    IMPORT_FAILED, ///< El archivo no se pudo convertir
+} import_state_t;
+
+/**
+ * Archivo que figura en el directorio escrito por el host.
+ */
+typedef struct {
+    uint32_t cluster; ///< Primer cluster
+    uint32_t size; ///< Tamaño (bytes)
+    char name[13]; ///< Nombre 8.3 con el punto
+} known_file_t;
+
+/**
+ * Importación en curso o la última terminada.
+ */
+typedef struct {
+    import_state_t state; ///< Estado
+    wave_import_t parser; ///< Conversión
+    uint32_t first_lba; ///< Primer sector del archivo
+    uint32_t next_lba; ///< Sector que se espera a continuación
+    uint32_t received; ///< Bytes recibidos en orden
+    uint32_t size; ///< Tamaño según el directorio, o 0 si todavía no se conoce
+    char name[13]; ///< Nombre según el directorio, o vacío
+    bool truncated; ///< La tabla no entró en la región de la flash
+    const char *error; ///< Motivo de IMPORT_FAILED
+    uint32_t first_us; ///< Llegada del primer sector
+    uint32_t last_us; ///< Llegada del último sector
+    uint32_t play_us; ///< Desde el último sector hasta que el núcleo 1 empezó la tabla
+    bool playing; ///< play_us es válido
+    bool report_pending; ///< Falta imprimir el resultado
+} import_t;
+
+ARENA_DEFINE(arena_msc, "msc", sizeof(import_t), 8);
+
+static import_t *import; ///< Tomada de arena_msc en msc_disk_init()
+
+static known_file_t known[KNOWN_FILES]; ///< Archivos del último sector de directorio escrito
+static uint32_t sample_rate; ///< Frecuencia de muestreo de la salida (Hz)
+static bool csv_codes; ///< Los CSV traen códigos del DAC en lugar de valores de -1 a 1
+
+static const char readme[] =
+    "GENERADOR DE SEÑALES GDS - DISCO DE FORMAS DE ONDA\r\n"
+    "\r\n"
+    "Copie aquí un archivo .CSV o .WAV: se convierte mientras se copia y queda\r\n"
+    "sonando sin fin en lugar de la síntesis. \"!wave off\" en la consola vuelve\r\n"
+    "a la síntesis.\r\n"
+    "\r\n"
+    "CSV: una muestra por línea, en el último campo, con valores de -1 a 1 (o\r\n"
+    "códigos de 0 a 255 después de \"!drive codes\"). Con ';' como separador, la\r\n"
+    "coma es el separador decimal.\r\n"
+    "WAV: PCM de 8 a 32 bits o flotante; se toma el primer canal y suena a su\r\n"
+    "frecuencia de muestreo.\r\n"
+    "\r\n"
+    "Entran unas 500000 muestras. El archivo no se guarda, así que el disco\r\n"
+    "vuelve a aparecer vacío; el resultado de la copia queda en ESTADO.TXT.\r\n";
+
+static inline uint32_t le16(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8;
+}
+
+static inline uint32_t le32(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void put16(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put32(uint8_t *p, uint32_t v) {
+    put16(p, v);
+    put16(p + 2, v >> 16);
+}
+
+static inline uint32_t cluster_lba(uint32_t cluster) {
+    return LBA_DATA + (cluster - 2) * CLUSTER_SECTORS;
+}
+
+/**
+ * Prepara el disco y toma el estado de la importación de arena_msc. Debe llamarse durante el
+ * arranque, antes de arena_seal().
+ * @param sample_rate_ Frecuencia de muestreo de la salida (Hz), para reproducir los WAV a su
+ * velocidad.
+ */
+void msc_disk_init(uint32_t sample_rate_) {
+    sample_rate = sample_rate_;
+    import = arena_alloc(&arena_msc, sizeof(*import), 8);
+    if (!import) {
+        panic("arena msc agotada");
+    }
+    memset(import, 0, sizeof(*import));
+}
+
+/**
+ * Elige cómo se leen los valores de los CSV que se copien desde ahora.
+ */
+void msc_disk_set_codes(bool codes) {
+    csv_codes = codes;
+}
+
+/**
+ * Describe la última importación en una línea, sin el fin de línea.
+ */
+static void format_report(char *buf, size_t size) {
+    const wave_import_t *p = &import->parser;
+    const char *name = import->name[0] ? import->name : "archivo";
+    uint32_t bytes = import->size ? import->size : import->received;
+    uint32_t us = import->last_us - import->first_us;
+    int len = 0;
+
+    switch (import->state) {
+        case IMPORT_IDLE: snprintf(buf, size, "Sin importaciones."); return;
+        case IMPORT_RUNNING:
+            snprintf(buf, size, "Importando %s (%s): %lu bytes, %lu muestras.", name, wave_import_format_name(p->format),
+                     (unsigned long)import->received, (unsigned long)p->samples);
+            return;
+        case IMPORT_FAILED:
+            snprintf(buf, size, "%s (%s): no se importó: %s.", name, wave_import_format_name(p->format), import->error);
+            return;
+        default: break;
+    }
+    len = snprintf(buf, size, "%s (%s): %lu bytes en %lu ms (%lu kB/s), %lu muestras", name,
+                   wave_import_format_name(p->format), (unsigned long)bytes, (unsigned long)(us / 1000),
+                   (unsigned long)(us ? (uint64_t)bytes * 1000 / us : 0), (unsigned long)p->samples);
+    if (p->sample_rate && len > 0 && (size_t)len < size) {
+        len += snprintf(buf + len, size - len, " a %lu Hz", (unsigned long)p->sample_rate);
+    }
+    if (p->skipped && len > 0 && (size_t)len < size) {
+        len += snprintf(buf + len, size - len, ", %lu líneas salteadas", (unsigned long)p->skipped);
+    }
+    if (import->truncated && len > 0 && (size_t)len < size) {
+        len += snprintf(buf + len, size - len, ", recortado a %lu", (unsigned long)WAVE_STORE_IMPORT_MAX);
+    }
+    if (import->playing && len > 0 && (size_t)len < size) {
+        snprintf(buf + len, size - len, "; sonando %lu ms después del último sector.",
+                 (unsigned long)(import->play_us / 1000));
+    } else if (len > 0 && (size_t)len < size) {
+        snprintf(buf + len, size - len, ".");
+    }
+}
+
+/**
+ * Imprime el resultado de la última importación: una línea para leer y otra para programas,
+ * @IMPORT,estado,formato,bytes,muestras,copia_us,sonando_us.
+ */
+void msc_disk_print(void) {
+    static const char *const states[] = { "idle", "running", "done", "failed" };
+    char text[200];
+
+    format_report(text, sizeof(text));
+    printf("%s\n", text);
+    printf("@IMPORT,%s,%s,%lu,%lu,%lu,%lu\n", states[import->state], wave_import_format_name(import->parser.format),
+           (unsigned long)(import->size ? import->size : import->received), (unsigned long)import->parser.samples,
+           (unsigned long)(import->last_us - import->first_us), (unsigned long)(import->playing ? import->play_us : 0));
+    printf("Valores de los CSV: %s.\n", csv_codes ? "códigos de 0 a 255" : "de -1 a 1");
+}
+
+static void sink(void *ctx, const uint8_t *codes, size_t count) {
+    (void)ctx;
+    if (!wave_store_import_put(codes, count)) {
+        import->truncated = true;
+    }
+}
+
+/**
+ * Termina el archivo en curso: deja la tabla en la flash y la pone a sonar. El resultado se
+ * imprime desde msc_disk_poll(), fuera de las retrollamadas de TinyUSB.
+ */
+static void finish(void) {
+    wave_import_status_t status = wave_import_finish(&import->parser);
+    uint32_t rate = import->parser.sample_rate;
+
+    import->report_pending = true;
+    if (status != WAVE_IMPORT_END || !import->parser.samples) {
+        wave_store_import_abort();
+        import->state = IMPORT_FAILED;
+        import->error = status != WAVE_IMPORT_END ? wave_import_status_name(status) : "no tiene muestras";
+        return;
+    }
+    // Un WAV suena a su frecuencia: avanza rate / sample_rate muestras de la tabla por muestra de salida
+    uint64_t inc = rate ? ((uint64_t)rate << 16) / sample_rate : 1u << 16;
+    if (!wave_store_import_end(sample_rate, inc > UINT32_MAX ? UINT32_MAX : inc ? (uint32_t)inc : 1)) {
+        import->state = IMPORT_FAILED;
+        import->error = "la imagen no quedó válida";
+        return;
+    }
+    wave_store_select(0);
+    import->state = IMPORT_DONE;
+}
+
+static const known_file_t *find_known(uint32_t cluster) {
+    for (unsigned i = 0; i < KNOWN_FILES; ++i) {
+        if (known[i].cluster == cluster) {
+            return &known[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Entrega al importador n sectores consecutivos desde el que se esperaba. Con el tamaño conocido se
+ * descarta el relleno del último sector.
+ */
+static void feed(const uint8_t *data, uint32_t n) {
+    uint32_t len = n * SECTOR;
+
+    if (import->size) {
+        uint32_t left = import->size > import->received ? import->size - import->received : 0;
+        len = len < left ? len : left;
+    }
+    wave_import_feed(&import->parser, data, len);
+    import->received += len;
+    import->next_lba += n;
+    import->last_us = time_us_32();
+    if (import->parser.status != WAVE_IMPORT_RUNNING || (import->size && import->received >= import->size)) {
+        finish();
+    }
+}
+
+/**
+ * Escritura al área de datos de n sectores consecutivos desde lba.
+ */
+static void data_write(uint32_t lba, const uint8_t *data, uint32_t n) {
+    if (import->state == IMPORT_RUNNING) {
+        if (lba == import->next_lba) {
+            feed(data, n);
+            return;
+        }
+        // Reescritura de sectores que ya llegaron, como el último de un archivo que crece
+        if (lba >= import->first_lba && lba < import->next_lba) {
+            return;
+        }
+        // El host pasó a otro archivo: el anterior llegó completo
+        finish();
+    }
+
+    // Solo empieza un archivo nuevo al principio de un cluster libre con un formato conocido
+    uint32_t cluster = (lba - LBA_DATA) / CLUSTER_SECTORS + 2;
+    if ((lba - LBA_DATA) % CLUSTER_SECTORS || cluster < CLUSTER_FIRST_FREE) {
+        return;
+    }
+    wave_import_format_t format = wave_import_detect(data, SECTOR);
+    if (format == WAVE_IMPORT_NONE) {
+        return;
+    }
+
+    const known_file_t *k = find_known(cluster);
+    memset(import, 0, sizeof(*import));
+    import->state = IMPORT_RUNNING;
+    import->first_lba = lba;
+    import->next_lba = lba;
+    import->first_us = time_us_32();
+    if (k) {
+        import->size = k->size;
+        memcpy(import->name, k->name, sizeof(import->name));
+    }
+    wave_import_init(&import->parser, format, csv_codes, sink, NULL);
+    wave_store_import_begin();
+    feed(data, n);
+}
+
+/**
+ * Escritura a un sector del directorio raíz: se recuerdan los archivos que figuran y, si uno es el
+ * que se está importando, su tamaño marca dónde termina.
+ */
+static void dir_write(const uint8_t *sector) {
+    uint32_t import_cluster = (import->first_lba - LBA_DATA) / CLUSTER_SECTORS + 2;
+    unsigned count = 0;
+
+    memset(known, 0, sizeof(known));
+    for (unsigned i = 0; i < SECTOR / 32 && count < KNOWN_FILES; ++i) {
+        const uint8_t *e = sector + 32 * i;
+        // Fin del directorio, entrada borrada, nombre largo, carpeta o etiqueta
+        if (!e[0]) {
+            break;
+        }
+        if (e[0] == 0xE5 || e[11] == 0x0F || (e[11] & 0x18)) {
+            continue;
+        }
+        known_file_t *k = &known[count];
+        k->cluster = le16(e + 26);
+        k->size = le32(e + 28);
+        if (k->cluster < CLUSTER_FIRST_FREE || !k->size) {
+            continue;
+        }
+        size_t len = 0;
+        for (unsigned j = 0; j < 11; ++j) {
+            if (j == 8 && e[8] != ' ') {
+                k->name[len++] = '.';
+            }
+            if (e[j] != ' ') {
+                k->name[len++] = (char)e[j];
+            }
+        }
+        k->name[len] = '\0';
+        count++;
+
+        if (import->state != IMPORT_IDLE && k->cluster == import_cluster) {
+            memcpy(import->name, k->name, sizeof(import->name));
+            import->size = k->size;
+            if (import->state == IMPORT_RUNNING && import->received >= import->size) {
+                finish();
+            }
+        }
+    }
+}
+
+/**
+ * Plazos de la importación: termina el archivo en curso si el host dejó de escribir e imprime el
+ * resultado cuando la tabla empezó a sonar. Se llama desde la tarea USB, después de tud_task().
+ */
+void msc_disk_poll(void) {
+    uint32_t now = time_us_32();
+
+    if (import->state == IMPORT_RUNNING &&
+        now - import->last_us > (import->size ? MSC_DISK_IDLE_SIZED_US : MSC_DISK_IDLE_US)) {
+        finish();
+    }
+    if (!import->report_pending) {
+        return;
+    }
+    if (import->state == IMPORT_DONE) {
+        uint32_t since;
+        if (!wave_store_playing(&since) || (int32_t)(since - import->last_us) < 0) {
+            // El núcleo 1 la toma en el próximo bloque
+            if (now - import->last_us < 1000000) {
+                return;
+            }
+        } else {
+            import->play_us = since - import->last_us;
+            import->playing = true;
+        }
+    }
+    import->report_pending = false;
+    msc_disk_print();
+}
+
+static void boot_sector(uint8_t *b) {
+    static const uint8_t bpb[] = {
+        0xEB, 0x3C, 0x90, 'M', 'S', 'D', 'O', 'S', '5', '.', '0', // Salto y fabricante
+        SECTOR & 0xFF, SECTOR >> 8, CLUSTER_SECTORS, 1, 0, 2, // Sector, cluster, reservados y cantidad de FAT
+        ROOT_ENTRIES & 0xFF, ROOT_ENTRIES >> 8, MSC_DISK_SECTORS & 0xFF, MSC_DISK_SECTORS >> 8, 0xF8,
+        FAT_SECTORS, 0, 1, 0, 1, 0, // Sectores por FAT, por pista y cabezas
+        0, 0, 0, 0, 0, 0, 0, 0, // Sectores ocultos y total de 32 bits
+        0x80, 0, 0x29, // Unidad, reservado y firma del BPB extendido
+    };
+    pico_unique_board_id_t id;
+
+    memcpy(b, bpb, sizeof(bpb));
+    pico_get_unique_board_id(&id);
+    memcpy(b + 39, id.id, 4);
+    memcpy(b + 43, "GDS        ", 11);
+    memcpy(b + 54, "FAT12   ", 8);
+    b[510] = 0x55;
+    b[511] = 0xAA;
+}
+
+static void dir_entry(uint8_t *e, const char *name, uint8_t attr, uint32_t cluster, uint32_t size) {
+    memcpy(e, name, 11);
+    e[11] = attr;
+    put16(e + 16, FAT_DATE);
+    put16(e + 18, FAT_DATE);
+    put16(e + 24, FAT_DATE);
+    put16(e + 26, cluster);
+    put32(e + 28, size);
+}
+
+static void status_text(uint8_t *b) {
+    format_report((char *)b, STATUS_LEN - 2);
+    size_t len = strlen((char *)b);
+    memset(b + len, ' ', STATUS_LEN - 2 - len);
+    b[STATUS_LEN - 2] = '\r';
+    b[STATUS_LEN - 1] = '\n';
+}
+
+static void read_sector(uint32_t lba, uint8_t *b) {
+    memset(b, 0, SECTOR);
+    if (lba == 0) {
+        boot_sector(b);
+    } else if (lba == LBA_FAT1 || lba == LBA_FAT2) {
+        // Entradas 0 y 1 reservadas, 2 y 3 de un cluster cada una (fin de cadena)
+        static const uint8_t fat[] = { 0xF8, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+        memcpy(b, fat, sizeof(fat));
+    } else if (lba == LBA_ROOT) {
+        dir_entry(b, "GDS        ", 0x08, 0, 0);
+        dir_entry(b + 32, "LEAME   TXT", 0x01, CLUSTER_README, sizeof(readme) - 1);
+        dir_entry(b + 64, "ESTADO  TXT", 0x01, CLUSTER_STATUS, STATUS_LEN);
+    } else if (lba == cluster_lba(CLUSTER_README)) {
+        memcpy(b, readme, sizeof(readme) - 1);
+    } else if (lba == cluster_lba(CLUSTER_STATUS)) {
+        status_text(b);
+    }
+}
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]) {
+    (void)lun;
+    memcpy(vendor_id, "GDS     ", 8);
+    memcpy(product_id, "Formas de onda  ", 16);
+    memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+    (void)lun;
+    return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count, uint16_t *block_size) {
+    (void)lun;
+    *block_count = MSC_DISK_SECTORS;
+    *block_size = SECTOR;
+}
+
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject) {
+    (void)lun;
+    (void)power_condition;
+    (void)start;
+    (void)load_eject;
+    return true;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun) {
+    (void)lun;
+    return true;
+}
+
+/**
+ * Lectura: TinyUSB pide de a CFG_TUD_MSC_EP_BUFSIZE bytes como máximo, siempre sectores enteros.
+ */
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
+    uint8_t *out = (uint8_t *)buffer;
+
+    (void)lun;
+    lba += offset / SECTOR;
+    for (uint32_t done = 0; done + SECTOR <= bufsize; done += SECTOR) {
+        read_sector(lba++, out + done);
+    }
+    return (int32_t)bufsize;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
+    uint32_t count = bufsize / SECTOR;
+
+    (void)lun;
+    lba += offset / SECTOR;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (lba + i >= LBA_DATA) {
+            data_write(lba + i, buffer + i * SECTOR, count - i);
+            break;
+        }
+        if (lba + i >= LBA_ROOT) {
+            dir_write(buffer + i * SECTOR);
+        }
+    }
+    return (int32_t)bufsize;
+}
+
+/**
+ * Comandos SCSI que no atiende TinyUSB. Se acepta el bloqueo de la expulsión, que los sistemas
+ * piden al montar; el resto se rechaza.
+ */
+int32_t tud_msc_scsi_cb(uint8_t lun, const uint8_t scsi_cmd[16], void *buffer, uint16_t bufsize) {
+    (void)buffer;
+    (void)bufsize;
+    if (scsi_cmd[0] == SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL) {
+        return 0;
+    }
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+    return -1;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file msc_disk.h
+ *
+ * @brief Disco USB para importar formas de onda: se copia un CSV o un WAV y queda sonando.
+ *
+ * El disco es un volumen FAT12 de 16 MB que no existe: el sector de arranque, las FAT y el
+ * directorio se generan al leerlos, con dos archivos de texto (LEAME.TXT con instrucciones y
+ * ESTADO.TXT con el resultado de la última importación). Las escrituras del host a las FAT y al
+ * directorio no se guardan; las escrituras al área de datos se convierten al llegar:
+ *  - La primera escritura de un archivo nuevo (al principio de un cluster libre) se reconoce con
+ *    wave_import_detect(); si no es CSV ni WAV (carpetas, archivos ocultos de macOS) se ignora.
+ *  - Los sectores siguientes, consecutivos, se entregan a siggen/wave_import.h y los códigos van
+ *    directo a la flash con wave_store_import_put(), sin guardar el archivo.
+ *  - El archivo termina cuando termina el WAV, cuando el directorio que escribe el host dice su
+ *    tamaño y ya llegó completo, cuando el host escribe en otro lado, o después de
+ *    MSC_DISK_IDLE_US sin escrituras. Entonces la tabla se reproduce sin fin en lugar de la
+ *    síntesis (!wave off vuelve a la síntesis), a la velocidad original del WAV o a una muestra de la
+ *    tabla por muestra de salida para un CSV.
+ *
+ * Se informa por la consola (y en ESTADO.TXT) el caudal de la copia en kB/s, contado desde el
+ * primer sector hasta el último, y el tiempo desde el último sector hasta que el núcleo 1 empieza
+ * a reproducir la tabla. Los sistemas operativos escriben los archivos nuevos en orden en un disco
+ * sin fragmentar; un archivo que llega desordenado se importa hasta donde llegó en orden.
+ */
+
+#ifndef MSC_DISK_H
+#define MSC_DISK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MSC_DISK_SECTORS 32768 ///< Sectores de 512 bytes del volumen (16 MB)
+#define MSC_DISK_IDLE_US 300000 ///< Sin escrituras durante este tiempo, un archivo sin tamaño conocido se da por terminado
+#define MSC_DISK_IDLE_SIZED_US 2000000 ///< Lo mismo para un archivo cuyo tamaño ya se conoce pero no llegó completo
+
+void msc_disk_init(uint32_t sample_rate);
+
+void msc_disk_poll(void);
+
+void msc_disk_set_codes(bool codes);
+
+void msc_disk_print(void);
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file persist.c
+ *
+ * @brief Guarda y recupera los parámetros del generador en flash.
+ *
+ * El registro ocupa la primera página del último sector. Antes de borrar y programar se detiene
+ * el núcleo 1 con multicore_lockout (su código se ejecuta desde la flash por XIP) y se deshabilitan
+ * las interrupciones del núcleo 0, así que la salida se congela unos 50 ms por escritura. Por eso
+ * la tarea de persistencia solo escribe cuando los parámetros cambiaron y dejaron de cambiar.
+ */
+
+#include "persist.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "siggen/crc32.h"
+#include <stddef.h>
+#include <string.h>
+
+#define PERSIST_MAGIC 0x53444750 ///< "PGDS" en little-endian
+#define PERSIST_VERSION 2 ///< Versión del formato del registro
+#define PERSIST_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE) ///< Desplazamiento del sector dentro de la flash
+
+/**
+ * Registro guardado en flash. El CRC cubre todos los campos anteriores.
+ */
+typedef struct {
+    uint32_t magic; ///< PERSIST_MAGIC
+    uint16_t version; ///< PERSIST_VERSION
+    uint16_t waveform; ///< Forma de onda
+    int32_t amplitude_uv; ///< Amplitud (uV)
+    int32_t dc_offset_uv; ///< Desplazamiento DC (uV)
+    uint64_t frequency_millihz; ///< Frecuencia (mHz)
+    uint32_t crc; ///< CRC-32 de los campos anteriores
+} persist_record_t;
+
+static persist_record_t saved; ///< Copia de lo último que se leyó o escribió en flash
+
+static void record_from_engine(persist_record_t *r, const engine_t *e) {
+    memset(r, 0, sizeof(*r));
+    r->magic = PERSIST_MAGIC;
+    r->version = PERSIST_VERSION;
+    r->waveform = (uint16_t)e->waveform;
+    r->amplitude_uv = e->amplitude_uv;
+    r->dc_offset_uv = e->dc_offset_uv;
+    r->frequency_millihz = e->frequency_millihz;
+    r->crc = crc32_compute(r, offsetof(persist_record_t, crc));
+}
+
+/**
+ * Carga los parámetros guardados en el motor.
+ * @return false si no hay un registro válido; en ese caso el motor conserva sus valores por defecto.
+ */
+bool persist_load(engine_t *e) {
+    const persist_record_t *r = (const persist_record_t *)(XIP_BASE + PERSIST_OFFSET);
+
+    if (r->magic != PERSIST_MAGIC || r->version != PERSIST_VERSION || r->waveform > TRIANGULAR ||
+        r->crc != crc32_compute(r, offsetof(persist_record_t, crc))) {
+        record_from_engine(&saved, e);
+        return false;
+    }
+    engine_params_t p = {
+        .waveform = (Waveform)r->waveform,
+        .amplitude_uv = r->amplitude_uv,
+        .dc_offset_uv = r->dc_offset_uv,
+        .frequency_millihz = r->frequency_millihz,
+    };
+    saved = *r;
+    engine_set_params(e, &p);
+    return true;
+}
+
+/**
+ * Indica si los parámetros del motor difieren de los guardados.
+ */
+bool persist_changed(const engine_t *e) {
+    persist_record_t current;
+
+    record_from_engine(&current, e);
+    return memcmp(&current, &saved, sizeof(current)) != 0;
+}
+
+/**
+ * Escribe los parámetros del motor en flash. Debe llamarse desde el núcleo 0 y fuera de
+ * interrupciones.
+ */
+bool persist_save(const engine_t *e) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    persist_record_t r;
+
+    record_from_engine(&r, e);
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &r, sizeof(r));
+
+    multicore_lockout_start_blocking();
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(PERSIST_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(PERSIST_OFFSET, page, FLASH_PAGE_SIZE);
+    restore_interrupts(irq);
+    multicore_lockout_end_blocking();
+
+    saved = r;
+    return true;
+}
@@ -0,0 +1,20 @@
+/**
+ * @file persist.h
+ *
+ * @brief Almacenamiento de los parámetros del generador en el último sector de la flash, para
+ * que la forma de onda, amplitud, frecuencia y desplazamiento sobrevivan a un reinicio.
+ */
+
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stdbool.h>
+#include "siggen/engine.h"
+
+bool persist_load(engine_t *e);
+
+bool persist_changed(const engine_t *e);
+
+bool persist_save(const engine_t *e);
+
+#endif
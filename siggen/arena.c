@@ -0,0 +1,57 @@
+/**
+ * @file arena.c
+ *
+ * @brief Implementación de las arenas estáticas.
+ */
+
+#include "arena.h"
+
+static arena_t *arena_list; ///< Arenas que recibieron al menos una petición
+static bool sealed; ///< Ya no se aceptan peticiones
+
+/**
+ * Toma @p size bytes alineados a @p align (potencia de 2) de la arena. La arena entra en la lista
+ * de reportes con su primera petición.
+ * @return NULL si no hay espacio o si ya se llamó a arena_seal().
+ */
+void *arena_alloc(arena_t *a, size_t size, size_t align) {
+    if (!a->listed) {
+        a->listed = true;
+        a->next = arena_list;
+        arena_list = a;
+    }
+
+    uintptr_t start = ((uintptr_t)a->base + a->used + (align - 1)) & ~(uintptr_t)(align - 1);
+    size_t end = (size_t)(start - (uintptr_t)a->base) + size;
+    if (sealed || end > a->size) {
+        a->failures++;
+        return NULL;
+    }
+
+    a->used = end;
+    if (end > a->high_water) {
+        a->high_water = end;
+    }
+    return (void *)start;
+}
+
+/**
+ * Libera todo lo entregado por la arena. El máximo alcanzado se conserva.
+ */
+void arena_reset(arena_t *a) {
+    a->used = 0;
+}
+
+/**
+ * Termina el arranque: desde aquí toda petición a cualquier arena falla.
+ */
+void arena_seal(void) {
+    sealed = true;
+}
+
+/**
+ * Primera arena de la lista de reportes; las siguientes se recorren con el campo next.
+ */
+const arena_t *arena_first(void) {
+    return arena_list;
+}
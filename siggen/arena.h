@@ -0,0 +1,54 @@
+/**
+ * @file arena.h
+ *
+ * @brief Arenas estáticas con nombre para los búferes grandes del generador.
+ *
+ * Cada arena es un arreglo estático reservado en tiempo de compilación; los módulos toman de ella
+ * sus búferes durante el arranque con arena_alloc() y el programa nunca usa malloc(). Como cada
+ * arena vive en su propia sección (.bss.arena_<nombre>_storage), tools/mem_budget.py puede
+ * verificar su tamaño contra un presupuesto al compilar. En ejecución se lleva el uso actual, el
+ * máximo alcanzado y las peticiones rechazadas, que se reportan con el comando !mem y, uso y máximo,
+ * en la telemetría periódica.
+ *
+ * Después de arena_seal() toda petición falla: así cualquier asignación fuera del arranque se
+ * detecta como un fallo contado en lugar de pasar inadvertida.
+ */
+
+#ifndef SIGGEN_ARENA_H
+#define SIGGEN_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Arena de memoria. Los campos son de solo lectura para el resto del programa.
+ */
+typedef struct arena {
+    const char *name; ///< Nombre para los reportes
+    uint8_t *base; ///< Inicio del almacenamiento
+    size_t size; ///< Tamaño del almacenamiento
+    size_t used; ///< Bytes entregados desde el último arena_reset()
+    size_t high_water; ///< Máximo de used desde el arranque
+    uint32_t failures; ///< Peticiones rechazadas por falta de espacio o por arena_seal()
+    bool listed; ///< Ya está en la lista de arenas
+    struct arena *next; ///< Siguiente arena de la lista
+} arena_t;
+
+/**
+ * Define una arena de @p size bytes alineada a @p align (potencia de 2). @p var es también el
+ * prefijo del nombre de la sección del almacenamiento, por lo que debe empezar por "arena_".
+ */
+#define ARENA_DEFINE(var, label, size, align) \
+    static uint8_t var##_storage[size] __attribute__((aligned(align))); \
+    arena_t var = { label, var##_storage, size, 0, 0, 0, false, NULL }
+
+void *arena_alloc(arena_t *a, size_t size, size_t align);
+
+void arena_reset(arena_t *a);
+
+void arena_seal(void);
+
+const arena_t *arena_first(void);
+
+#endif
@@ -0,0 +1,268 @@
+/**
+ * @file bulk_proto.c
+ *
+ * @brief Receptor de tramas binarias con la carga directa al destino.
+ */
+
+#include "bulk_proto.h"
+#include "crc32.h"
+#include <string.h>
+
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+/**
+ * Prepara el receptor, sin destinos: PING, SINK y END funcionan sin ellos.
+ * @param stream El transporte es un flujo de bytes (la consola) y no un endpoint con paquetes.
+ */
+void bulk_proto_init(bulk_proto_t *p, bool stream) {
+    memset(p, 0, sizeof(*p));
+    p->stream = stream;
+}
+
+void bulk_proto_set_target(bulk_proto_t *p, bulk_op_t op, const bulk_target_t *target, void *ctx) {
+    p->targets[op] = target;
+    p->ctx[op] = ctx;
+}
+
+static const bulk_target_t *target_of(const bulk_proto_t *p) {
+    return p->head.op < BULK_OP_COUNT ? p->targets[p->head.op] : NULL;
+}
+
+/**
+ * Marca la trama en curso con un error; el resto de la carga se recibe y se descarta.
+ */
+static void fail(bulk_proto_t *p, bulk_status_t status) {
+    if (p->status == BULK_OK) {
+        p->status = (uint8_t)status;
+    }
+    p->discard = true;
+}
+
+/**
+ * Lugar donde el transporte debe recibir los próximos bytes.
+ * @param len Bytes que caben. Por un endpoint es el largo de la transferencia a programar: un
+ *            múltiplo de BULK_PACKET_SIZE, salvo cuando cubre el resto de la carga.
+ */
+uint8_t *bulk_proto_rx_buf(bulk_proto_t *p, size_t *len) {
+    p->bounced = false;
+    if (!p->in_payload) {
+        // Un paquete entero: un encabezado más largo se detecta en lugar de desbordar el búfer
+        *len = p->stream ? BULK_HEADER_LEN - p->hdr_fill : BULK_PACKET_SIZE;
+        return p->armed = p->scratch + p->hdr_fill;
+    }
+
+    uint32_t remaining = p->head.len - p->received;
+    const bulk_target_t *t = target_of(p);
+    if (!p->discard && t && t->window) {
+        size_t room;
+        uint8_t *window = t->window(p->ctx[p->head.op], &room);
+        if (!room) {
+            fail(p, BULK_ERR_FULL);
+        } else {
+            size_t n = room < remaining ? room : remaining;
+            if (!p->stream && n < remaining) {
+                n -= n % BULK_PACKET_SIZE;
+            }
+            if (n) {
+                *len = n;
+                return p->armed = window;
+            }
+            // La ventana es más chica que un paquete: se recibe aparte y se copia
+            p->bounced = true;
+        }
+    }
+    *len = remaining < BULK_SCRATCH_SIZE ? remaining : BULK_SCRATCH_SIZE;
+    return p->armed = p->scratch;
+}
+
+/**
+ * Copia al destino lo que se recibió en el búfer interno, repartido en las ventanas que ofrezca.
+ */
+static void bounce(bulk_proto_t *p, const bulk_target_t *t, size_t n) {
+    const uint8_t *src = p->scratch;
+    void *ctx = p->ctx[p->head.op];
+
+    p->bounced_bytes += n;
+    while (n) {
+        size_t room;
+        uint8_t *window = t->window(ctx, &room);
+        if (!room) {
+            fail(p, BULK_ERR_FULL);
+            return;
+        }
+        size_t chunk = room < n ? room : n;
+        memcpy(window, src, chunk);
+        t->commit(ctx, chunk);
+        src += chunk;
+        n -= chunk;
+    }
+}
+
+/**
+ * Cierra la trama en curso y arma la respuesta.
+ */
+static bool finish(bulk_proto_t *p, uint32_t now_us) {
+    const bulk_target_t *t = target_of(p);
+    // El destino aceptó la trama si no hubo error o si se llenó después
+    bool begun = p->status == BULK_OK || p->status == BULK_ERR_FULL;
+
+    if ((p->head.flags & BULK_FLAG_CRC) && p->status == BULK_OK && p->crc != p->head.crc) {
+        p->status = BULK_ERR_CRC;
+    }
+    if (begun && t && t->end && !t->end(p->ctx[p->head.op], &p->head, p->status == BULK_OK) &&
+        p->status == BULK_OK) {
+        p->status = BULK_ERR_REFUSED;
+    }
+    p->in_payload = false;
+    p->last = (bulk_reply_t){
+        .op = p->head.op,
+        .status = p->status,
+        .seq = p->head.seq,
+        .count = p->received,
+        .crc = p->crc,
+        .elapsed_us = now_us - p->start_us,
+    };
+    put32(p->reply, BULK_REPLY_MAGIC);
+    p->reply[4] = p->last.op;
+    p->reply[5] = p->last.status;
+    put16(p->reply + 6, p->last.seq);
+    put32(p->reply + 8, p->last.count);
+    put32(p->reply + 12, p->last.crc);
+    put32(p->reply + 16, p->last.elapsed_us);
+    p->frames++;
+    p->errors += p->status != BULK_OK;
+    return true;
+}
+
+/**
+ * Llegaron n bytes al lugar que entregó bulk_proto_rx_buf(). Por un endpoint, n es lo que recibió
+ * la transferencia completa.
+ * @return true si terminó una trama: la respuesta está en p->reply (y en p->last).
+ */
+bool bulk_proto_rx_done(bulk_proto_t *p, size_t n, uint32_t now_us) {
+    if (!p->in_payload) {
+        p->hdr_fill += (uint32_t)n;
+        if (p->stream && p->hdr_fill < BULK_HEADER_LEN) {
+            return false;
+        }
+        bool valid = p->hdr_fill == BULK_HEADER_LEN && get32(p->scratch) == BULK_MAGIC;
+        const uint8_t *h = p->scratch;
+
+        p->hdr_fill = 0;
+        p->received = 0;
+        p->crc = 0;
+        p->start_us = now_us;
+        p->discard = false;
+        p->status = BULK_OK;
+        if (!valid) {
+            memset(&p->head, 0, sizeof(p->head));
+            p->head.op = 0xFF;
+            p->status = BULK_ERR_HEADER;
+            return finish(p, now_us);
+        }
+        p->head.op = h[4];
+        p->head.flags = h[5];
+        p->head.seq = get16(h + 6);
+        p->head.len = get32(h + 8);
+        p->head.arg = get32(h + 12);
+        p->head.crc = get32(h + 16);
+
+        const bulk_target_t *t = target_of(p);
+        if (p->head.op >= BULK_OP_COUNT || (!t && p->head.op != BULK_OP_PING && p->head.op != BULK_OP_SINK &&
+                                            p->head.op != BULK_OP_END)) {
+            fail(p, BULK_ERR_OP);
+        } else if (t && t->begin && !t->begin(p->ctx[p->head.op], &p->head)) {
+            fail(p, BULK_ERR_REFUSED);
+        }
+        if (!p->head.len) {
+            return finish(p, now_us);
+        }
+        p->in_payload = true;
+        return false;
+    }
+
+    uint32_t remaining = p->head.len - p->received;
+    const bulk_target_t *t = target_of(p);
+
+    n = n < remaining ? n : remaining;
+    if (p->head.flags & BULK_FLAG_CRC) {
+        p->crc = crc32_update(p->crc, p->armed, n);
+    }
+    if (!p->discard && t) {
+        if (p->bounced) {
+            bounce(p, t, n);
+        } else if (p->armed != p->scratch) {
+            t->commit(p->ctx[p->head.op], n);
+        }
+    }
+    p->received += (uint32_t)n;
+    p->bytes += n;
+    return p->received == p->head.len ? finish(p, now_us) : false;
+}
+
+/**
+ * Abandona la trama en curso (el transporte se reinició o dejó de recibir): el destino la descarta.
+ */
+void bulk_proto_abort(bulk_proto_t *p) {
+    const bulk_target_t *t = target_of(p);
+
+    if (p->in_payload && (p->status == BULK_OK || p->status == BULK_ERR_FULL) && t && t->end) {
+        t->end(p->ctx[p->head.op], &p->head, false);
+    }
+    p->in_payload = false;
+    p->hdr_fill = 0;
+}
+
+/**
+ * Escribe un encabezado de BULK_HEADER_LEN bytes (lado del host).
+ */
+void bulk_header_pack(uint8_t *out, const bulk_header_t *head) {
+    put32(out, BULK_MAGIC);
+    out[4] = head->op;
+    out[5] = head->flags;
+    put16(out + 6, head->seq);
+    put32(out + 8, head->len);
+    put32(out + 12, head->arg);
+    put32(out + 16, head->crc);
+}
+
+/**
+ * Lee una respuesta de BULK_REPLY_LEN bytes (lado del host).
+ * @return false si la magia no coincide.
+ */
+bool bulk_reply_parse(const uint8_t *in, bulk_reply_t *reply) {
+    if (get32(in) != BULK_REPLY_MAGIC) {
+        return false;
+    }
+    reply->op = in[4];
+    reply->status = in[5];
+    reply->seq = get16(in + 6);
+    reply->count = get32(in + 8);
+    reply->crc = get32(in + 12);
+    reply->elapsed_us = get32(in + 16);
+    return true;
+}
+
+const char *bulk_status_name(uint8_t status) {
+    static const char *const names[] = {
+        "ok", "encabezado inválido", "operación desconocida", "rechazada", "destino lleno", "CRC incorrecto",
+    };
+
+    return status < sizeof(names) / sizeof(names[0]) ? names[status] : "?";
+}
@@ -0,0 +1,143 @@
+/**
+ * @file bulk_proto.h
+ *
+ * @brief Protocolo de tramas binarias para cargar datos en el generador a la máxima velocidad del
+ * USB, sin copias intermedias en el dispositivo.
+ *
+ * Cada trama es un encabezado de BULK_HEADER_LEN bytes seguido de una carga de len bytes; el
+ * dispositivo contesta cada trama con una respuesta de BULK_REPLY_LEN bytes. Todos los campos van
+ * en little-endian:
+ *  - Encabezado: magia "GDSB", operación, banderas, secuencia (16 bits), largo de la carga, argumento
+ *    de la operación y CRC-32 de la carga (siggen/crc32.h, solo con BULK_FLAG_CRC).
+ *  - Respuesta: magia "GDSR", operación, estado (bulk_status_t), secuencia, bytes de carga
+ *    recibidos, CRC-32 calculado y microsegundos entre el encabezado y el último byte.
+ *
+ * Por un endpoint bulk (bulk_proto_init() con stream = false) el encabezado se envía en una
+ * transferencia propia, que termina con un paquete corto, y la carga en las siguientes. El
+ * dispositivo pide con bulk_proto_rx_buf() dónde programar la próxima transferencia: el encabezado
+ * va a un búfer interno y la carga directamente a la ventana que ofrece el destino de la operación
+ * (bulk_target_t), recortada a un múltiplo de BULK_PACKET_SIZE para que ningún paquete la desborde.
+ * Solo cuando la ventana es más chica que un paquete la carga pasa por el búfer interno y se copia.
+ * Por un flujo de bytes (la consola CDC, stream = true) los trozos pueden ser de cualquier tamaño.
+ *
+ * La Pico lo atiende en usb_bulk.h; host/gds_bulk es el cliente, con libusb, por la consola CDC para
+ * comparar, o contra el protocolo en el mismo proceso (-L) para probarlo en la máquina anfitriona.
+ */
+
+#ifndef SIGGEN_BULK_PROTO_H
+#define SIGGEN_BULK_PROTO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BULK_MAGIC 0x42534447u ///< "GDSB" en little-endian
+#define BULK_REPLY_MAGIC 0x52534447u ///< "GDSR" en little-endian
+#define BULK_HEADER_LEN 20 ///< Bytes del encabezado
+#define BULK_REPLY_LEN 20 ///< Bytes de la respuesta
+#define BULK_PACKET_SIZE 64 ///< Paquete bulk de USB de velocidad completa
+#define BULK_SCRATCH_SIZE 512 ///< Búfer interno: encabezados, cargas que se descartan y ventanas chicas
+
+#define BULK_FLAG_CRC 0x01 ///< El campo crc del encabezado es válido y se verifica
+
+/**
+ * Operaciones.
+ */
+typedef enum {
+    BULK_OP_PING, ///< Sin carga; mide la latencia
+    BULK_OP_SINK, ///< La carga se descarta; mide el caudal
+    BULK_OP_TABLE, ///< La carga son códigos del DAC para una tabla; arg es su frecuencia de muestreo (0: una muestra por muestra de salida)
+    BULK_OP_END, ///< Sin carga; termina la sesión (la consola vuelve al modo texto)
+    BULK_OP_COUNT,
+} bulk_op_t;
+
+/**
+ * Estado de la respuesta.
+ */
+typedef enum {
+    BULK_OK,
+    BULK_ERR_HEADER, ///< Encabezado de largo o magia incorrectos
+    BULK_ERR_OP, ///< Operación desconocida o sin destino
+    BULK_ERR_REFUSED, ///< El destino rechazó la trama
+    BULK_ERR_FULL, ///< El destino se llenó; el resto de la carga se descartó
+    BULK_ERR_CRC, ///< El CRC de la carga no coincide
+} bulk_status_t;
+
+/**
+ * Encabezado de una trama.
+ */
+typedef struct {
+    uint8_t op; ///< bulk_op_t
+    uint8_t flags; ///< BULK_FLAG_*
+    uint16_t seq; ///< Número de secuencia, se devuelve en la respuesta
+    uint32_t len; ///< Bytes de carga
+    uint32_t arg; ///< Argumento de la operación
+    uint32_t crc; ///< CRC-32 de la carga
+} bulk_header_t;
+
+/**
+ * Respuesta a una trama.
+ */
+typedef struct {
+    uint8_t op; ///< Operación de la trama
+    uint8_t status; ///< bulk_status_t
+    uint16_t seq; ///< Secuencia de la trama
+    uint32_t count; ///< Bytes de carga recibidos
+    uint32_t crc; ///< CRC-32 de la carga recibida
+    uint32_t elapsed_us; ///< Desde el encabezado hasta el último byte
+} bulk_reply_t;
+
+/**
+ * Destino de la carga de una operación. Las funciones se llaman desde bulk_proto_rx_done() y
+ * bulk_proto_rx_buf(), en el contexto del transporte.
+ */
+typedef struct {
+    bool (*begin)(void *ctx, const bulk_header_t *head); ///< Prepara el destino; false rechaza la trama
+    uint8_t *(*window)(void *ctx, size_t *len); ///< Dónde van los próximos bytes y cuántos entran (0 = lleno)
+    void (*commit)(void *ctx, size_t len); ///< Llegaron len bytes a la ventana
+    bool (*end)(void *ctx, const bulk_header_t *head, bool ok); ///< Fin de la carga; con ok = false se descarta
+} bulk_target_t;
+
+/**
+ * Estado del receptor de un transporte.
+ */
+typedef struct {
+    const bulk_target_t *targets[BULK_OP_COUNT]; ///< Destino de cada operación
+    void *ctx[BULK_OP_COUNT]; ///< Contexto de cada destino
+    bool stream; ///< El transporte es un flujo de bytes
+    bool in_payload; ///< Recibiendo la carga de head
+    bool discard; ///< El resto de la carga se descarta
+    bool bounced; ///< El último lugar entregado fue el búfer interno en lugar de la ventana
+    uint8_t status; ///< Estado de la trama en curso
+    bulk_header_t head; ///< Trama en curso
+    uint32_t hdr_fill; ///< Bytes del encabezado recibidos
+    uint32_t received; ///< Bytes de carga recibidos
+    uint32_t crc; ///< CRC-32 de la carga recibida
+    uint32_t start_us; ///< Instante del encabezado
+    uint8_t *armed; ///< Último lugar entregado por bulk_proto_rx_buf()
+    bulk_reply_t last; ///< Última respuesta
+    uint8_t reply[BULK_REPLY_LEN]; ///< Última respuesta, lista para enviar
+    uint32_t frames; ///< Tramas terminadas
+    uint32_t errors; ///< Tramas con error
+    uint64_t bytes; ///< Bytes de carga recibidos
+    uint64_t bounced_bytes; ///< Bytes de carga que pasaron por el búfer interno hacia un destino
+    uint8_t scratch[BULK_SCRATCH_SIZE]; ///< Búfer interno
+} bulk_proto_t;
+
+void bulk_proto_init(bulk_proto_t *p, bool stream);
+
+void bulk_proto_set_target(bulk_proto_t *p, bulk_op_t op, const bulk_target_t *target, void *ctx);
+
+uint8_t *bulk_proto_rx_buf(bulk_proto_t *p, size_t *len);
+
+bool bulk_proto_rx_done(bulk_proto_t *p, size_t n, uint32_t now_us);
+
+void bulk_proto_abort(bulk_proto_t *p);
+
+void bulk_header_pack(uint8_t *out, const bulk_header_t *head);
+
+bool bulk_reply_parse(const uint8_t *in, bulk_reply_t *reply);
+
+const char *bulk_status_name(uint8_t status);
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file crc32.h
+ *
+ * @brief CRC-32 (polinomio 0xEDB88320, el mismo de zlib) para validar datos guardados en flash.
+ */
+
+#ifndef SIGGEN_CRC32_H
+#define SIGGEN_CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+/**
+ * Calcula el CRC-32 de un bloque completo.
+ */
+static inline uint32_t crc32_compute(const void *data, size_t len) {
+    return crc32_update(0, data, len);
+}
+
+#endif
@@ -0,0 +1,169 @@
+/**
+ * @file engine.c
+ *
+ * @brief Implementación del núcleo portable del generador de señales.
+ */
+
+#include "engine.h"
+#include "fixdec.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+/**
+ * Inicializa el motor con los valores por DEFECTO (seno, 1000 mV, 10 Hz, 500 mV).
+ */
+void engine_init(engine_t *e, engine_output_fn output, void *output_ctx) {
+    memset(e, 0, sizeof(*e));
+    e->waveform = SINE;
+    e->amplitude_uv = 1000 * FIXDEC_SCALE;
+    e->frequency_millihz = 10 * FIXDEC_SCALE;
+    e->dc_offset_uv = 500 * FIXDEC_SCALE;
+    e->output = output;
+    e->output_ctx = output_ctx;
+}
+
+/**
+ * Marca el inicio de una escritura de parámetros: el contador queda impar.
+ */
+static inline void begin_update(engine_t *e) {
+    e->param_seq++;
+    __sync_synchronize();
+}
+
+/**
+ * Marca el fin de una escritura de parámetros: el contador vuelve a ser par.
+ */
+static inline void end_update(engine_t *e) {
+    __sync_synchronize();
+    e->param_seq++;
+}
+
+/**
+ * Reemplaza todos los parámetros de la señal (por ejemplo, al recuperarlos de la flash).
+ */
+void engine_set_params(engine_t *e, const engine_params_t *p) {
+    begin_update(e);
+    e->waveform = p->waveform;
+    e->amplitude_uv = p->amplitude_uv;
+    e->dc_offset_uv = p->dc_offset_uv;
+    e->frequency_millihz = p->frequency_millihz;
+    end_update(e);
+}
+
+/**
+ * Copia los parámetros de forma consistente desde otro núcleo. La frecuencia ocupa 64 bits y no
+ * se lee atómicamente en el Cortex-M0+, así que se verifica que el contador de secuencia no
+ * cambió durante la copia.
+ *
+ * @param seq  Recibe el valor del contador correspondiente a la copia.
+ * @return false si había una escritura en curso; se debe reintentar más tarde.
+ */
+bool engine_snapshot(const engine_t *e, engine_params_t *p, uint32_t *seq) {
+    uint32_t before = e->param_seq;
+
+    if (before & 1) {
+        return false;
+    }
+    __sync_synchronize();
+    p->waveform = e->waveform;
+    p->amplitude_uv = e->amplitude_uv;
+    p->dc_offset_uv = e->dc_offset_uv;
+    p->frequency_millihz = e->frequency_millihz;
+    __sync_synchronize();
+    *seq = before;
+    return e->param_seq == before;
+}
+
+/**
+ * Formatea un mensaje y lo entrega a la función de salida del motor.
+ */
+void engine_printf(engine_t *e, const char *fmt, ...) {
+    char line[96];
+    va_list args;
+
+    if (!e->output) {
+        return;
+    }
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    e->output(e->output_ctx, line);
+}
+
+/**
+ * Procesa un flanco en un GPIO de entrada. Aplica el antirrebote compartido entre el botón y el
+ * teclado: cualquier evento a menos de DEBOUNCE_MS del último aceptado se descarta.
+ *
+ * @param now_ms   Instante del evento en milisegundos desde el arranque.
+ * @param gpio     GPIO que produjo la interrupción.
+ * @param scan     Barrido del teclado; solo se llama si el evento es del teclado y fue aceptado.
+ * @return true si el evento superó el antirrebote.
+ */
+bool engine_gpio_event(engine_t *e, uint32_t now_ms, unsigned gpio, engine_scan_fn scan, void *scan_ctx) {
+    if (now_ms - e->last_interrupt_time <= DEBOUNCE_MS) {
+        return false;
+    }
+    e->last_interrupt_time = now_ms;
+
+    if (gpio == WAVEFORM_BUTTON_PIN) {
+        begin_update(e);
+        e->waveform = (Waveform)((e->waveform + 1) % 4);
+        end_update(e);
+        engine_printf(e, "Forma de onda cambiada a %d\n", e->waveform);
+    } else if (scan) {
+        char keys[ROWS * COLS];
+        int count = scan(scan_ctx, keys, ROWS * COLS);
+        for (int i = 0; i < count; ++i) {
+            engine_printf(e, "Tecla presionada: %c\n", keys[i]);
+            engine_handle_input(e, keys[i]);
+        }
+    }
+    return true;
+}
+
+/**
+ * Obtener la entrada y convertirla de cadena a valor entero en milésimas, para amplitud, frecuencia y desplazamiento.
+ * La tecla '*' (o '.' desde la consola) es el punto decimal.
+ */
+void engine_handle_input(engine_t *e, char key) {
+    if (key == 'D') {
+        int64_t value;
+        char text[FIXDEC_MAX_LEN];
+
+        if (e->paramType && fixdec_parse(e->inputBuffer, NULL, &value)) {
+            if (e->paramType != 'B' && value > INT32_MAX) {
+                value = INT32_MAX;
+            }
+            begin_update(e);
+            if (e->paramType == 'A') {
+                e->amplitude_uv = (int32_t)value;
+            } else if (e->paramType == 'B') {
+                e->frequency_millihz = (uint64_t)value;
+            } else if (e->paramType == 'C') {
+                e->dc_offset_uv = (int32_t)value;
+            }
+            end_update(e);
+
+            fixdec_format(text, sizeof(text), value, 2);
+            if (e->paramType == 'A') {
+                engine_printf(e, "Amplitud establecida en: %s mV\n", text);
+            } else if (e->paramType == 'B') {
+                engine_printf(e, "Frecuencia establecida en: %s Hz\n", text);
+            } else if (e->paramType == 'C') {
+                engine_printf(e, "Desplazamiento DC establecido en: %s mV\n", text);
+            }
+        }
+        e->inputIndex = 0;
+        memset(e->inputBuffer, 0, sizeof(e->inputBuffer));
+    } else {
+        if (key == 'A' || key == 'B' || key == 'C') {
+            e->paramType = key;
+        } else if (isdigit((unsigned char)key) || key == '*' || key == '.') {
+            if (e->inputIndex < (int)sizeof(e->inputBuffer) - 1) {
+                e->inputBuffer[e->inputIndex++] = key == '*' ? '.' : key;
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * @file engine.h
+ *
+ * @brief Núcleo portable del generador de señales: parámetros, máquina de estados de la entrada
+ * por teclado y antirrebote compartido entre el botón y el teclado matricial.
+ *
+ * Este módulo no depende del SDK de la Raspberry Pi Pico, de modo que el mismo código se compila
+ * en el firmware (main.c) y en el simulador de la máquina anfitriona (host/gds_replay.c). Todo el
+ * acceso al hardware (lectura del teclado, impresión por consola) se inyecta mediante funciones.
+ */
+
+#ifndef SIGGEN_ENGINE_H
+#define SIGGEN_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DEBOUNCE_MS 200 ///< Retraso (mS). Con fines de eliminación de rebotes
+#define AMPLITUDE_MIN 100 ///< Amplitud mínima (mV)
+#define AMPLITUDE_MAX 2500 ///< Amplitud máxima (mV)
+#define FREQUENCY_MIN 1 ///< Frecuencia mínima (Hz)
+#define FREQUENCY_MAX 12000000 ///< Frecuencia máxima (Hz)
+#define ROWS 4 ///< Cantidad de filas
+#define COLS 4 ///< Cantidad de columnas
+#define WAVEFORM_BUTTON_PIN 16 ///< GPIO del botón de cambio de forma de onda
+
+typedef enum {
+    SINE, ///< Onda sinusoidal. Sin(2*pi*f*t). centrada alrededor de su desplazamiento DC
+    SQUARE, ///< Onda cuadrada, también llamada onda pulsada, simétrica (ciclo de trabajo del 50%) centrada alrededor de su desplazamiento DC
+    SAWTOOTH, ///< Onda diente de sierra. El tiempo de subida coincide con el período, mientras que el tiempo de caída va a cero. centrada alrededor de su desplazamiento DC
+    TRIANGULAR ///< Onda triangular. Simétrica (tiempo de subida igual al 50% del período, tiempo de caída igual al 50% del período). Centrada alrededor de su desplazamiento DC
+} Waveform;
+
+/**
+ * Función que recibe cada línea de texto producida por el motor. En el firmware escribe en la
+ * consola USB; en el simulador la captura para compararla entre ejecuciones.
+ */
+typedef void (*engine_output_fn)(void *ctx, const char *text);
+
+/**
+ * Función que barre el teclado matricial y escribe en @p keys las teclas presionadas.
+ * @return Cantidad de teclas escritas (como máximo @p max).
+ */
+typedef int (*engine_scan_fn)(void *ctx, char *keys, int max);
+
+/**
+ * Parámetros de la señal en unidades enteras: milésimas de mV (uV) y milésimas de Hz (mHz).
+ */
+typedef struct {
+    Waveform waveform; ///< Forma de onda
+    int32_t amplitude_uv; ///< Amplitud (uV)
+    int32_t dc_offset_uv; ///< Desplazamiento DC (uV)
+    uint64_t frequency_millihz; ///< Frecuencia (mHz)
+} engine_params_t;
+
+/**
+ * Estado completo del generador. Los parámetros son volátiles porque los escribe el núcleo de la
+ * interfaz y los lee el núcleo de síntesis; este último debe usar engine_snapshot().
+ */
+typedef struct {
+    volatile Waveform waveform; ///< Forma de onda actual producida por la señal
+    volatile int32_t amplitude_uv; ///< Amplitud actual (uV)
+    volatile uint64_t frequency_millihz; ///< Frecuencia actual (mHz)
+    volatile int32_t dc_offset_uv; ///< Desplazamiento DC actual (uV)
+    volatile uint32_t param_seq; ///< Contador de secuencia: impar mientras se escriben los parámetros, se incrementa en 2 con cada cambio
+
+    char paramType; ///< Parámetro seleccionado con 'A', 'B' o 'C'
+    char inputBuffer[20]; ///< Dígitos acumulados hasta presionar 'D'
+    int inputIndex; ///< Posición de escritura en inputBuffer
+
+    uint32_t last_interrupt_time; ///< Instante (mS) del último evento aceptado por el antirrebote
+
+    engine_output_fn output; ///< Destino del texto producido
+    void *output_ctx; ///< Contexto para output
+} engine_t;
+
+void engine_init(engine_t *e, engine_output_fn output, void *output_ctx);
+
+bool engine_gpio_event(engine_t *e, uint32_t now_ms, unsigned gpio, engine_scan_fn scan, void *scan_ctx);
+
+void engine_handle_input(engine_t *e, char key);
+
+void engine_set_params(engine_t *e, const engine_params_t *p);
+
+bool engine_snapshot(const engine_t *e, engine_params_t *p, uint32_t *seq);
+
+void engine_printf(engine_t *e, const char *fmt, ...);
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file GDS.ino
+ *
+ * @brief Generador de señales GDSv14 reducido a la interfaz sobre la biblioteca siggen.
+ *
+ * El boceto solo barre el teclado y el botón y entrega los eventos al motor (engine), que valida
+ * los valores e imprime los mensajes. Las muestras las calcula synth_render() por bloques en punto
+ * fijo, con el mismo código que el firmware de la Pico, y par_out las escribe en el DAC al ritmo de
+ * SAMPLE_RATE. Cada segundo se imprime la frecuencia de muestreo lograda y las muestras atrasadas.
+ *
+ * @section circuit Circuito
+ * - Botón en GP16, activo en bajo (INPUT_PULLUP).
+ * - Filas del teclado en (GP18, GP19, GP20, GP21) y columnas en (GP22, GP26, GP27, GP28).
+ * - DAC de 8 bits en GP0 (LSB) a GP7 (MSB).
+ *
+ * @section usage Uso
+ * Instalar la carpeta siggen/ del repositorio como biblioteca (copiarla o enlazarla en
+ * ~/Arduino/libraries/siggen) y abrir este ejemplo desde Archivo > Ejemplos > siggen.
+ */
+
+#include <siggen.h>
+
+#define SAMPLE_RATE 20000 ///< Frecuencia de muestreo pedida (Hz)
+#define BLOCK_SAMPLES 256 ///< Muestras por bloque entre dos revisiones de la interfaz
+#define KEYPAD_SCAN_MS 10 ///< Periodo de barrido del teclado y del botón (mS)
+#define REPORT_MS 1000 ///< Periodo del reporte de la frecuencia de muestreo (mS)
+#define DAC_PIN_BASE 0 ///< Primer GPIO del DAC; los 8 bits ocupan pines consecutivos
+
+const char keys[ROWS][COLS] = {
+    {'1', '2', '3', 'A'},
+    {'4', '5', '6', 'B'},
+    {'7', '8', '9', 'C'},
+    {'*', '0', '#', 'D'}
+}; ///< Distribución de las teclas del teclado matricial
+const byte rowPins[ROWS] = {18, 19, 20, 21}; ///< Pines de las filas
+const byte colPins[COLS] = {22, 26, 27, 28}; ///< Pines de las columnas
+
+static engine_t engine; ///< Parámetros y máquina de estados de la entrada
+static synth_t synth; ///< Oscilador
+static par_out_t out; ///< Salida paralela al DAC
+static uint8_t block[BLOCK_SAMPLES]; ///< Bloque de muestras en curso
+static uint32_t seen_seq = UINT32_MAX; ///< Secuencia de parámetros aplicada al oscilador
+static uint32_t last_scan_ms; ///< Último barrido del teclado
+static uint32_t last_report_ms; ///< Último reporte
+static bool key_down; ///< Había una tecla presionada en el barrido anterior
+static bool button_down; ///< El botón estaba presionado en el barrido anterior
+
+static void serial_output(void *ctx, const char *text) {
+    (void)ctx;
+    Serial.print(text);
+}
+
+static uint32_t clock_us(void) {
+    return micros();
+}
+
+/**
+ * Escribe una muestra en el DAC. En el RP2040 los ocho bits cambian a la vez con una sola
+ * escritura del registro de salida; en otras placas se escriben bit a bit.
+ */
+static void write_dac(void *ctx, uint8_t value) {
+    (void)ctx;
+#if defined(ARDUINO_ARCH_RP2040)
+    gpio_put_masked(0xFFu << DAC_PIN_BASE, (uint32_t)value << DAC_PIN_BASE);
+#else
+    for (int i = 0; i < 8; i++) {
+        digitalWrite(DAC_PIN_BASE + i, (value >> i) & 1);
+    }
+#endif
+}
+
+/**
+ * Barre el teclado sin esperas: las columnas quedan con pull-up y cada fila se pone en bajo por
+ * turno. El antirrebote lo hace engine_gpio_event().
+ */
+static int scan_keypad(void *ctx, char *pressed, int max) {
+    int count = 0;
+
+    (void)ctx;
+    for (byte row = 0; row < ROWS; row++) {
+        pinMode(rowPins[row], OUTPUT);
+        digitalWrite(rowPins[row], LOW);
+        for (byte col = 0; col < COLS; col++) {
+            if (digitalRead(colPins[col]) == LOW && count < max) {
+                pressed[count++] = keys[row][col];
+            }
+        }
+        pinMode(rowPins[row], INPUT);
+    }
+    return count;
+}
+
+/**
+ * Detecta flancos de presión del botón y del teclado y los entrega al motor.
+ */
+static void poll_inputs(uint32_t now_ms) {
+    char pressed[ROWS * COLS];
+    bool button = digitalRead(WAVEFORM_BUTTON_PIN) == LOW;
+    bool key = scan_keypad(NULL, pressed, ROWS * COLS) > 0;
+
+    if (button && !button_down) {
+        engine_gpio_event(&engine, now_ms, WAVEFORM_BUTTON_PIN, NULL, NULL);
+    }
+    if (key && !key_down) {
+        engine_gpio_event(&engine, now_ms, rowPins[0], scan_keypad, NULL);
+    }
+    button_down = button;
+    key_down = key;
+}
+
+void setup() {
+    Serial.begin(115200);
+    for (int i = 0; i < 8; i++) {
+        pinMode(DAC_PIN_BASE + i, OUTPUT);
+    }
+    pinMode(WAVEFORM_BUTTON_PIN, INPUT_PULLUP);
+    for (byte col = 0; col < COLS; col++) {
+        pinMode(colPins[col], INPUT_PULLUP);
+    }
+
+    engine_init(&engine, serial_output, NULL);
+    synth_init(&synth, SAMPLE_RATE);
+    par_out_init(&out, write_dac, NULL, clock_us, SAMPLE_RATE);
+}
+
+void loop() {
+    uint32_t now_ms = millis();
+    engine_params_t p;
+    uint32_t seq;
+
+    if (now_ms - last_scan_ms >= KEYPAD_SCAN_MS) {
+        last_scan_ms = now_ms;
+        poll_inputs(now_ms);
+    }
+    if (engine.param_seq != seen_seq && engine_snapshot(&engine, &p, &seq)) {
+        synth_set(&synth, p.waveform, p.amplitude_uv, p.dc_offset_uv, p.frequency_millihz);
+        seen_seq = seq;
+    }
+
+    synth_render(&synth, block, BLOCK_SAMPLES);
+    par_out_write_block(&out, block, BLOCK_SAMPLES);
+
+    if (now_ms - last_report_ms >= REPORT_MS) {
+        uint32_t late = out.late;
+        last_report_ms = now_ms;
+        engine_printf(&engine, "Muestreo: %lu Hz (pedido %lu Hz), atrasadas: %lu\n",
+                      (unsigned long)par_out_rate(&out), (unsigned long)SAMPLE_RATE, (unsigned long)late);
+    }
+}
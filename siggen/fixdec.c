@@ -0,0 +1,109 @@
+/**
+ * @file fixdec.c
+ *
+ * @brief Implementación de la conversión decimal en punto fijo.
+ */
+
+#include "fixdec.h"
+
+#define FIXDEC_LIMIT (INT64_MAX / 10 - 9) ///< Valor máximo antes de agregar otro dígito sin desbordar
+
+/**
+ * Interpreta un número decimal con signo opcional y parte fraccionaria opcional ("1500",
+ * "-12.5", "0.001"). Se conservan tres decimales; el cuarto redondea (la mitad se aleja del cero)
+ * y los siguientes se ignoran.
+ *
+ * @param s      Texto a interpretar.
+ * @param end    Si no es NULL, recibe la posición del primer carácter no consumido.
+ * @param milli  Valor en milésimas.
+ * @return false si no hay dígitos o el valor no cabe en 64 bits.
+ */
+bool fixdec_parse(const char *s, const char **end, int64_t *milli) {
+    const char *p = s;
+    bool negative = false, any = false;
+    int64_t value = 0;
+    int decimals = 0;
+
+    if (*p == '+' || *p == '-') {
+        negative = *p++ == '-';
+    }
+    for (; *p >= '0' && *p <= '9'; ++p, any = true) {
+        if (value > FIXDEC_LIMIT / FIXDEC_SCALE) {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    value *= FIXDEC_SCALE;
+
+    if (*p == '.') {
+        int64_t unit = FIXDEC_SCALE / 10;
+        for (++p; *p >= '0' && *p <= '9'; ++p, any = true) {
+            if (decimals < 3) {
+                value += (*p - '0') * unit;
+                unit /= 10;
+            } else if (decimals == 3 && *p >= '5') {
+                value += 1;
+            }
+            decimals++;
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    if (end) {
+        *end = p;
+    }
+    *milli = negative ? -value : value;
+    return true;
+}
+
+/**
+ * Escribe un valor en milésimas con la cantidad de decimales pedida (0 a 3), redondeando la mitad
+ * lejos del cero. Escribe siempre el terminador si size > 0.
+ *
+ * @return Cantidad de caracteres del número (sin el terminador), aunque no hayan cabido.
+ */
+int fixdec_format(char *buf, size_t size, int64_t milli, unsigned decimals) {
+    static const int32_t round_step[] = {1000, 100, 10, 1};
+    char tmp[FIXDEC_MAX_LEN];
+    int n = 0, len = 0;
+    uint64_t mag;
+
+    if (decimals > 3) {
+        decimals = 3;
+    }
+    mag = milli < 0 ? (uint64_t)0 - (uint64_t)milli : (uint64_t)milli;
+
+    // Redondear a la cantidad de decimales pedida
+    uint64_t step = (uint64_t)round_step[decimals];
+    mag = (mag + step / 2) / step;
+    bool negative = milli < 0 && mag != 0;
+
+    // Dígitos en orden inverso: primero los decimales, luego la parte entera
+    for (unsigned i = 0; i < decimals; ++i) {
+        tmp[n++] = (char)('0' + mag % 10);
+        mag /= 10;
+    }
+    if (decimals) {
+        tmp[n++] = '.';
+    }
+    do {
+        tmp[n++] = (char)('0' + mag % 10);
+        mag /= 10;
+    } while (mag);
+    if (negative) {
+        tmp[n++] = '-';
+    }
+
+    while (n > 0) {
+        char c = tmp[--n];
+        if ((size_t)len + 1 < size) {
+            buf[len] = c;
+        }
+        len++;
+    }
+    if (size > 0) {
+        buf[(size_t)len < size ? (size_t)len : size - 1] = '\0';
+    }
+    return len;
+}
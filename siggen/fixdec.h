@@ -0,0 +1,26 @@
+/**
+ * @file fixdec.h
+ *
+ * @brief Conversión entre texto decimal y enteros en milésimas, sin punto flotante.
+ *
+ * En el Cortex-M0+ no hay FPU: strtof() y printf("%f") arrastran la biblioteca de flotantes por
+ * software, que ocupa flash y es lenta. Los parámetros del generador se guardan como enteros en
+ * milésimas de su unidad (uV para los mV, mHz para los Hz) y estas rutinas los convierten a y desde
+ * texto.
+ */
+
+#ifndef SIGGEN_FIXDEC_H
+#define SIGGEN_FIXDEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FIXDEC_SCALE 1000 ///< Milésimas por unidad
+#define FIXDEC_MAX_LEN 24 ///< Longitud máxima de un número formateado, incluyendo el terminador
+
+bool fixdec_parse(const char *s, const char **end, int64_t *milli);
+
+int fixdec_format(char *buf, size_t size, int64_t milli, unsigned decimals);
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file input_log.c
+ *
+ * @brief Conversión entre eventos de entrada y líneas de registro.
+ */
+
+#include "input_log.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * Escribe el evento como una línea de registro terminada en salto de línea.
+ * @return Cantidad de caracteres escritos (sin el terminador).
+ */
+int input_log_format(char *buf, size_t size, const input_event_t *ev) {
+    return snprintf(buf, size, INPUT_LOG_PREFIX "%lu,%u,%.*s\n",
+                    (unsigned long)ev->t_ms, (unsigned)ev->gpio, (int)ev->nkeys, ev->keys);
+}
+
+/**
+ * Interpreta una línea de registro. Se aceptan espacios o caracteres de control antes del prefijo
+ * y un retorno de carro al final, tal como quedan al guardar una sesión serie desde Windows.
+ * @return false si la línea no es un registro válido.
+ */
+bool input_log_parse(const char *line, input_event_t *ev) {
+    const char *p = strstr(line, INPUT_LOG_PREFIX);
+    char *end;
+
+    if (!p) {
+        return false;
+    }
+    p += strlen(INPUT_LOG_PREFIX);
+
+    ev->t_ms = (uint32_t)strtoul(p, &end, 10);
+    if (end == p || *end != ',') {
+        return false;
+    }
+    p = end + 1;
+
+    unsigned long gpio = strtoul(p, &end, 10);
+    if (end == p || *end != ',' || gpio > 29) {
+        return false;
+    }
+    ev->gpio = (uint8_t)gpio;
+    p = end + 1;
+
+    ev->nkeys = 0;
+    while (*p && *p != '\r' && *p != '\n' && ev->nkeys < sizeof(ev->keys)) {
+        ev->keys[ev->nkeys++] = *p++;
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file input_log.h
+ *
+ * @brief Registro de eventos de entrada para su reproducción determinista en la máquina anfitriona.
+ *
+ * Cada interrupción de GPIO se registra como una línea de texto con el formato
+ * `@EV,<t_ms>,<gpio>,<teclas>`, donde `<teclas>` son los caracteres encontrados por el barrido del
+ * teclado (vacío si el evento fue descartado por el antirrebote o si es el botón). Las líneas se
+ * intercalan con el resto de la salida de la consola, así que basta con guardar la sesión serie
+ * completa: el simulador ignora todo lo que no empiece por el prefijo.
+ */
+
+#ifndef SIGGEN_INPUT_LOG_H
+#define SIGGEN_INPUT_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"
+
+#define INPUT_LOG_PREFIX "@EV," ///< Prefijo que identifica una línea de registro
+#define INPUT_LOG_LINE_MAX 48 ///< Longitud máxima de una línea de registro, incluyendo el terminador
+
+/**
+ * Evento de entrada tal como lo vio la rutina de interrupción.
+ */
+typedef struct {
+    uint32_t t_ms; ///< Instante del evento (mS desde el arranque)
+    uint8_t gpio; ///< GPIO que produjo la interrupción
+    uint8_t nkeys; ///< Cantidad de teclas encontradas por el barrido
+    char keys[ROWS * COLS]; ///< Teclas encontradas por el barrido
+} input_event_t;
+
+int input_log_format(char *buf, size_t size, const input_event_t *ev);
+
+bool input_log_parse(const char *line, input_event_t *ev);
+
+#endif
@@ -0,0 +1,165 @@
+/**
+ * @file interp_chain.c
+ *
+ * @brief Etapas de medio banda, compensación y CIC de la cadena de interpolación.
+ */
+
+#include "interp_chain.h"
+#include "platform.h"
+#include <string.h>
+
+/*
+ * Coeficientes generados por tools/fir_design.py, con contenido hasta 0,375 de la frecuencia de
+ * entrada de la cadena.
+ */
+
+/** Primera etapa: 8 pares, beta 6; ondulación 0,008 dB e imágenes a -61 dB. */
+static const int16_t halfband1[8] = {
+    10323, -3157, 1588, -861, 454, -218, 88, -25
+};
+
+/** Segunda etapa: 4 pares, beta 6; ondulación 0,005 dB e imágenes a -65 dB. */
+static const int16_t halfband2[4] = {
+    9989, -2335, 638, -100
+};
+
+/** Coeficiente a de la compensación (-a, 1 + 2a, -a) en Q15, por log2 del factor del CIC. */
+static const int16_t cic_comp[INTERP_CHAIN_CIC_MAX_SHIFT + 1] = {
+    0, 4325, 5433, 5712, 5782
+};
+
+static inline int16_t saturate(int32_t x) {
+    return (int16_t)(x < -32768 ? -32768 : x > 32767 ? 32767 : x);
+}
+
+static void halfband_init(interp_halfband_t *h, const int16_t *coefs, uint32_t pairs) {
+    h->coefs = coefs;
+    h->pairs = pairs;
+    h->head = 0;
+    memset(h->hist, 0, sizeof(h->hist));
+}
+
+/**
+ * Prepara la cadena para un factor, con la historia en silencio.
+ * @param factor Potencia de 2 entre 1 (sin cadena) e INTERP_CHAIN_MAX_FACTOR.
+ * @return false si el factor no es válido; la cadena queda con factor 1.
+ */
+bool interp_chain_init(interp_chain_t *c, uint32_t factor) {
+    bool ok = factor && factor <= INTERP_CHAIN_MAX_FACTOR && !(factor & (factor - 1));
+    uint32_t shift = 0;
+
+    memset(c, 0, sizeof(*c));
+    if (!ok) {
+        factor = 1;
+    }
+    c->factor = factor;
+    while ((1u << shift) < factor) {
+        shift++;
+    }
+    c->halfbands = shift < 2 ? shift : 2;
+    c->cic_shift = shift - c->halfbands;
+    c->comp_a = cic_comp[c->cic_shift];
+    halfband_init(&c->hb[0], halfband1, sizeof(halfband1) / sizeof(halfband1[0]));
+    halfband_init(&c->hb[1], halfband2, sizeof(halfband2) / sizeof(halfband2[0]));
+    return ok;
+}
+
+/**
+ * Etapa de medio banda: una muestra de entrada, dos de salida. La primera es la entrada de hace
+ * pairs muestras y la segunda, la interpolada entre esa y la siguiente.
+ */
+static inline void SIGGEN_HOT(halfband_run)(interp_halfband_t *h, int16_t x, int16_t *out) {
+    uint32_t pairs = h->pairs, len = 2 * pairs, head = h->head;
+
+    h->hist[head] = x;
+    h->hist[head + len] = x;
+    head = head + 1 < len ? head + 1 : 0;
+    h->head = head;
+
+    const int16_t *w = h->hist + head;
+    const int16_t *coefs = h->coefs;
+    int32_t acc = 0;
+    for (uint32_t k = 0; k < pairs; ++k) {
+        acc += coefs[k] * (w[pairs - 1 - k] + w[pairs + k]);
+    }
+    out[0] = w[pairs - 1];
+    out[1] = saturate((acc + (1 << 13)) >> 14);
+}
+
+/**
+ * Compensación de la caída del CIC: (-a, 1 + 2a, -a), con una muestra de retardo.
+ */
+static inline int16_t SIGGEN_HOT(compensate)(interp_chain_t *c, int16_t x) {
+    int32_t x1 = c->comp_hist[0], x2 = c->comp_hist[1];
+
+    c->comp_hist[1] = (int16_t)x1;
+    c->comp_hist[0] = x;
+    return saturate(x1 + ((c->comp_a * (2 * x1 - x - x2) + (1 << 14)) >> 15));
+}
+
+/**
+ * CIC: los peines a la frecuencia de entrada y, después de intercalar 2^cic_shift - 1 ceros, los
+ * integradores a la de salida. La ganancia es el factor a la INTERP_CHAIN_CIC_ORDER - 1, que se
+ * descuenta con un desplazamiento.
+ */
+static inline void SIGGEN_HOT(cic_run)(interp_chain_t *c, int16_t x, int16_t *out) {
+    uint32_t v = (uint32_t)(int32_t)x;
+    uint32_t shift = (INTERP_CHAIN_CIC_ORDER - 1) * c->cic_shift, r = 1u << c->cic_shift;
+
+    for (int s = 0; s < INTERP_CHAIN_CIC_ORDER; ++s) {
+        uint32_t d = v - c->comb[s];
+        c->comb[s] = v;
+        v = d;
+    }
+
+    uint32_t i0 = c->integ[0], i1 = c->integ[1], i2 = c->integ[2], i3 = c->integ[3];
+    for (uint32_t k = 0; k < r; ++k) {
+        i0 += v;
+        i1 += i0;
+        i2 += i1;
+        i3 += i2;
+        v = 0;
+        out[k] = saturate(((int32_t)i3 + (1 << (shift - 1))) >> shift);
+    }
+    c->integ[0] = i0;
+    c->integ[1] = i1;
+    c->integ[2] = i2;
+    c->integ[3] = i3;
+}
+
+/**
+ * Sube n muestras de entrada a n * factor muestras de salida.
+ * @param out Lugar para n * factor muestras.
+ * @return Muestras escritas.
+ */
+size_t SIGGEN_HOT(interp_chain_process)(interp_chain_t *c, const int16_t *in, size_t n, int16_t *out) {
+    uint32_t halfbands = c->halfbands, cic_r = c->cic_shift ? 1u << c->cic_shift : 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        int16_t a[4];
+        uint32_t m = 1;
+
+        a[0] = in[i];
+        if (halfbands >= 1) {
+            halfband_run(&c->hb[0], a[0], a);
+            m = 2;
+        }
+        if (halfbands >= 2) {
+            int16_t b[2] = { a[0], a[1] };
+            halfband_run(&c->hb[1], b[0], a);
+            halfband_run(&c->hb[1], b[1], a + 2);
+            m = 4;
+        }
+        if (cic_r) {
+            for (uint32_t j = 0; j < m; ++j) {
+                cic_run(c, compensate(c, a[j]), out);
+                out += cic_r;
+            }
+        } else {
+            for (uint32_t j = 0; j < m; ++j) {
+                *out++ = a[j];
+            }
+        }
+    }
+    return n * c->factor;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file interp_chain.h
+ *
+ * @brief Cadena de interpolación entera en punto fijo para subir un flujo de baja frecuencia de
+ * muestreo a la del DAC.
+ *
+ * Mandar el audio a la frecuencia del DAC gastaría el ancho de banda del USB en muestras que no
+ * agregan información; la PC manda a 48 kHz y la Pico sube la frecuencia por un factor entero
+ * potencia de 2 antes del remuestreo fraccionario de rate_match.h, que así interpola una señal ya
+ * sobremuestreada. La cadena tiene, según el factor:
+ *  - Dos etapas de medio banda (x2 cada una): la primera, larga, separa la banda de paso de su
+ *    imagen; la segunda, a la frecuencia doble, puede ser más corta. En una de cada dos salidas la
+ *    entrada pasa tal cual, y la otra cuesta un producto por cada par de muestras simétricas.
+ *  - Un CIC de orden INTERP_CHAIN_CIC_ORDER (x2 a x16) para el resto del factor: solo sumas y
+ *    restas, a la frecuencia más alta. Sus ceros caen sobre las imágenes que dejan las etapas
+ *    anteriores; la caída que produce en la banda de paso la corrige un FIR de tres coeficientes
+ *    a su entrada.
+ *
+ * Factor 2: una etapa de medio banda; 4: las dos; 8 a 64: las dos y el CIC. Con contenido hasta
+ * 0,375 de la frecuencia de entrada (18 kHz a 48 kHz) las imágenes quedan unos 60 dB abajo.
+ * Todos los coeficientes están en siggen/interp_chain.c y los genera tools/fir_design.py. El CIC
+ * trabaja en aritmética modular de 32 bits, así que sus integradores pueden dar la vuelta: alcanza
+ * con que la salida entre en 32 bits, y con orden 4 y factor 16 (ganancia 2^12) le sobran. El
+ * orden 4 y no 3 es por el factor 8, donde el CIC x2 solo tiene a su favor la caída de sus ceros.
+ *
+ * La cadena procesa bloques: cada muestra de entrada produce factor muestras de salida.
+ * host/chain_run mide el costo por muestra, la frecuencia de entrada máxima que soporta un núcleo
+ * y el rechazo de las imágenes de cada factor; el firmware bench.c, el costo en la Pico.
+ */
+
+#ifndef SIGGEN_INTERP_CHAIN_H
+#define SIGGEN_INTERP_CHAIN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define INTERP_CHAIN_MAX_FACTOR 64 ///< Factor máximo: dos etapas de medio banda por el CIC más largo
+#define INTERP_CHAIN_MAX_PAIRS 8 ///< Pares de coeficientes de la etapa de medio banda más larga
+#define INTERP_CHAIN_CIC_ORDER 4 ///< Integradores y peines del CIC (cic_run() está desenrollado para 4)
+#define INTERP_CHAIN_CIC_MAX_SHIFT 4 ///< log2 del factor máximo del CIC
+
+/**
+ * Etapa de medio banda. La historia está duplicada para que la ventana sea siempre contigua.
+ */
+typedef struct {
+    const int16_t *coefs; ///< pairs coeficientes en Q14
+    uint32_t pairs; ///< Pares de muestras simétricas por salida interpolada
+    uint32_t head; ///< Posición de la muestra más antigua de la ventana
+    int16_t hist[4 * INTERP_CHAIN_MAX_PAIRS]; ///< Últimas 2 * pairs muestras, dos veces
+} interp_halfband_t;
+
+/**
+ * Cadena completa.
+ */
+typedef struct {
+    uint32_t factor; ///< Factor total
+    uint32_t halfbands; ///< Etapas de medio banda en uso (0 a 2)
+    uint32_t cic_shift; ///< log2 del factor del CIC; 0 = sin CIC
+    int32_t comp_a; ///< Coeficiente de la compensación del CIC, en Q15
+    int16_t comp_hist[2]; ///< Dos entradas anteriores de la compensación
+    uint32_t comb[INTERP_CHAIN_CIC_ORDER]; ///< Entrada anterior de cada peine
+    uint32_t integ[INTERP_CHAIN_CIC_ORDER]; ///< Integradores
+    interp_halfband_t hb[2]; ///< Etapas de medio banda
+} interp_chain_t;
+
+bool interp_chain_init(interp_chain_t *c, uint32_t factor);
+
+size_t interp_chain_process(interp_chain_t *c, const int16_t *in, size_t n, int16_t *out);
+
+#endif
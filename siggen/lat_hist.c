@@ -0,0 +1,62 @@
+/**
+ * @file lat_hist.c
+ *
+ * @brief Implementación de los histogramas de latencia.
+ */
+
+#include "lat_hist.h"
+#include <stdio.h>
+
+void lat_hist_reset(lat_hist_t *h) {
+    for (int i = 0; i < LAT_HIST_BINS; ++i) {
+        h->bins[i] = 0;
+    }
+    h->count = 0;
+    h->max = 0;
+}
+
+/**
+ * Cota superior del percentil indicado: el extremo superior del intervalo donde cae, o el máximo
+ * registrado si es menor.
+ */
+uint32_t lat_hist_percentile(const lat_hist_t *h, unsigned percent) {
+    uint64_t target = ((uint64_t)h->count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < LAT_HIST_BINS - 1; ++i) {
+        seen += h->bins[i];
+        if (seen >= target) {
+            uint32_t upper = i ? ((uint32_t)1 << i) - 1 : 0;
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+/**
+ * Imprime el total, el máximo, los percentiles 50 y 99 y los intervalos que no están vacíos.
+ */
+void lat_hist_print(const lat_hist_t *h, void (*out)(void *ctx, const char *text), void *ctx) {
+    char line[96];
+
+    snprintf(line, sizeof(line), "%-8s n=%lu p50<=%lu p99<=%lu max=%lu\n", h->name,
+             (unsigned long)h->count, (unsigned long)lat_hist_percentile(h, 50),
+             (unsigned long)lat_hist_percentile(h, 99), (unsigned long)h->max);
+    out(ctx, line);
+    for (int i = 0; i < LAT_HIST_BINS; ++i) {
+        char range[24];
+
+        if (!h->bins[i]) {
+            continue;
+        }
+        if (i < 2) {
+            snprintf(range, sizeof(range), "%d", i);
+        } else if (i == LAT_HIST_BINS - 1) {
+            snprintf(range, sizeof(range), ">=%lu", 1ul << (i - 1));
+        } else {
+            snprintf(range, sizeof(range), "%lu-%lu", 1ul << (i - 1), (1ul << i) - 1);
+        }
+        snprintf(line, sizeof(line), "  %-14s %10lu\n", range, (unsigned long)h->bins[i]);
+        out(ctx, line);
+    }
+}
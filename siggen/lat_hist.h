@@ -0,0 +1,51 @@
+/**
+ * @file lat_hist.h
+ *
+ * @brief Histogramas de latencia con intervalos en potencias de 2.
+ *
+ * El intervalo i (i > 0) cuenta los valores en [2^(i-1), 2^i); el intervalo 0 cuenta los ceros y
+ * el último acumula todo lo que no entra en los anteriores. Agregar un valor es barato (una
+ * instrucción de conteo de ceros y un incremento), así que puede hacerse desde una rutina de
+ * interrupción. La unidad la decide quien llena el histograma; en la Pico son ciclos del reloj
+ * del sistema.
+ */
+
+#ifndef SIGGEN_LAT_HIST_H
+#define SIGGEN_LAT_HIST_H
+
+#include <limits.h>
+#include <stdint.h>
+
+#define LAT_HIST_BINS 20 ///< Cantidad de intervalos; el último acumula los valores desde 2^18
+
+/**
+ * Histograma de una fuente de latencia.
+ */
+typedef struct {
+    const char *name; ///< Nombre para los reportes
+    volatile uint32_t bins[LAT_HIST_BINS]; ///< Cantidad de valores por intervalo
+    volatile uint32_t count; ///< Cantidad total de valores
+    volatile uint32_t max; ///< Mayor valor registrado
+} lat_hist_t;
+
+/**
+ * Registra un valor. No es reentrante: cada histograma debe llenarse desde una sola rutina.
+ */
+static inline void lat_hist_add(lat_hist_t *h, uint32_t value) {
+    // unsigned long tiene al menos 32 bits en cualquier arquitectura; unsigned int puede tener 16
+    int bin = value ? (int)(sizeof(unsigned long) * CHAR_BIT) - __builtin_clzl(value) : 0;
+
+    h->bins[bin < LAT_HIST_BINS ? bin : LAT_HIST_BINS - 1]++;
+    h->count++;
+    if (value > h->max) {
+        h->max = value;
+    }
+}
+
+void lat_hist_reset(lat_hist_t *h);
+
+uint32_t lat_hist_percentile(const lat_hist_t *h, unsigned percent);
+
+void lat_hist_print(const lat_hist_t *h, void (*out)(void *ctx, const char *text), void *ctx);
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * @file par_out.c
+ *
+ * @brief Implementación de la salida paralela por CPU.
+ */
+
+#include "par_out.h"
+#include <string.h>
+
+/**
+ * Prepara la salida. Con sample_rate igual a 0 las muestras se escriben tan rápido como permita
+ * la función de escritura, lo que sirve para medir su costo.
+ */
+void par_out_init(par_out_t *p, par_out_write_fn write, void *ctx, uint32_t (*now_us)(void), uint32_t sample_rate) {
+    memset(p, 0, sizeof(*p));
+    p->write = write;
+    p->ctx = ctx;
+    p->now_us = now_us;
+    p->period_q8 = sample_rate ? (uint32_t)((256ull * 1000000 + sample_rate / 2) / sample_rate) : 0;
+    p->since_us = now_us();
+    p->next_us = p->since_us;
+}
+
+/**
+ * Escribe un bloque de muestras respetando la frecuencia de muestreo. Si al empezar el bloque la
+ * salida ya está atrasada en más de un bloque, el ritmo se reinicia desde el instante actual.
+ */
+void par_out_write_block(par_out_t *p, const uint8_t *block, size_t n) {
+    if (!p->period_q8) {
+        for (size_t i = 0; i < n; ++i) {
+            p->write(p->ctx, block[i]);
+        }
+        p->samples += n;
+        return;
+    }
+
+    uint32_t now = p->now_us();
+    if ((int32_t)(now - p->next_us) > (int32_t)(((uint64_t)p->period_q8 * n) >> 8)) {
+        p->next_us = now;
+        p->frac_q8 = 0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        now = p->now_us();
+        if ((int32_t)(now - p->next_us) > 0) {
+            p->late++;
+        }
+        while ((int32_t)(now - p->next_us) < 0) {
+            now = p->now_us();
+        }
+        p->write(p->ctx, block[i]);
+        p->frac_q8 += p->period_q8;
+        p->next_us += p->frac_q8 >> 8;
+        p->frac_q8 &= 0xff;
+    }
+    p->samples += n;
+}
+
+/**
+ * Frecuencia de muestreo lograda desde la llamada anterior (o desde par_out_init()), en
+ * muestras por segundo. Reinicia los contadores, incluido late, que debe leerse antes.
+ */
+uint32_t par_out_rate(par_out_t *p) {
+    uint32_t now = p->now_us();
+    uint32_t window = now - p->since_us;
+    uint32_t rate = window ? (uint32_t)((uint64_t)p->samples * 1000000 / window) : 0;
+
+    p->samples = 0;
+    p->late = 0;
+    p->since_us = now;
+    return rate;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file par_out.h
+ *
+ * @brief Salida de bloques de muestras a un DAC paralelo de 8 bits escrito por la CPU.
+ *
+ * Es la ruta de salida para las plataformas sin PIO ni DMA (el boceto de Arduino, por ejemplo).
+ * La escritura de una muestra en los pines se inyecta como función, de modo que el mismo código
+ * se usa con cualquier forma de acceso al puerto y también en la máquina anfitriona. Cada muestra
+ * se escribe en su instante programado según la frecuencia de muestreo; si la CPU no llega a
+ * tiempo la muestra se escribe igual y se cuenta como atrasada, sin intentar recuperar el ritmo
+ * más allá de un bloque.
+ */
+
+#ifndef SIGGEN_PAR_OUT_H
+#define SIGGEN_PAR_OUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Escribe una muestra en los pines del DAC, todos los bits a la vez si la plataforma lo permite.
+ */
+typedef void (*par_out_write_fn)(void *ctx, uint8_t value);
+
+/**
+ * Estado de la salida paralela. Los contadores son de solo lectura para el resto del programa.
+ */
+typedef struct {
+    par_out_write_fn write; ///< Escritura de una muestra
+    void *ctx; ///< Contexto para write
+    uint32_t (*now_us)(void); ///< Reloj en microsegundos
+    uint32_t period_q8; ///< Periodo de muestreo en 1/256 de microsegundo; 0 escribe sin esperar
+    uint32_t next_us; ///< Instante de la próxima muestra
+    uint32_t frac_q8; ///< Fracción de microsegundo acumulada para la próxima muestra
+    uint32_t samples; ///< Muestras escritas
+    uint32_t late; ///< Muestras escritas después de su instante
+    uint32_t since_us; ///< Inicio de la ventana de medición
+} par_out_t;
+
+void par_out_init(par_out_t *p, par_out_write_fn write, void *ctx, uint32_t (*now_us)(void), uint32_t sample_rate);
+
+void par_out_write_block(par_out_t *p, const uint8_t *block, size_t n);
+
+uint32_t par_out_rate(par_out_t *p);
+
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file platform.h
+ *
+ * @brief Ubicación en memoria del camino crítico de síntesis.
+ *
+ * En la Pico el código se ejecuta por defecto desde la flash a través de la caché XIP; un fallo de
+ * caché (por ejemplo después de actividad de la pila USB) detiene la producción de muestras. Las
+ * funciones marcadas con SIGGEN_HOT se copian a la SRAM al arrancar, y los datos marcados con
+ * SIGGEN_HOT_DATA van al banco SCRATCH_X, que solo usa el núcleo 1 (allí está también su pila)
+ * y que el DMA no toca: los búferes del DAC quedan en la SRAM principal intercalada.
+ *
+ * Con la opción RAM_HOT_PATH=OFF de CMake, o fuera de la Pico, las macros no tienen efecto, lo
+ * que permite comparar ambas ubicaciones con el mismo código.
+ */
+
+#ifndef SIGGEN_PLATFORM_H
+#define SIGGEN_PLATFORM_H
+
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE && defined(SIGGEN_RAM_HOT_PATH) && SIGGEN_RAM_HOT_PATH
+#include "pico.h"
+#define SIGGEN_HOT(fn) __not_in_flash_func(fn) ///< Función del camino crítico, ejecutada desde SRAM
+#define SIGGEN_HOT_DATA(group) __scratch_x(group) ///< Dato del camino crítico, en el banco SCRATCH_X
+#else
+#define SIGGEN_HOT(fn) fn
+#define SIGGEN_HOT_DATA(group)
+#endif
+
+#endif
@@ -0,0 +1,474 @@
+/**
+ * @file polyphase.c
+ *
+ * @brief Bancos de coeficientes y productos escalares del remuestreo polifásico.
+ */
+
+#include "polyphase.h"
+#include "platform.h"
+#include <string.h>
+
+/*
+ * Bancos generados por tools/fir_design.py. El rechazo de cada uno es el de la peor imagen de un
+ * contenido que llega hasta un cuarto de la frecuencia de las muestras de entrada.
+ */
+
+/** 4 coeficientes por fase, beta 3: imágenes a -36 dB. */
+static const int16_t coefs_low[(POLYPHASE_PHASES + 1) * 4] = {
+    0, 16384, 0, 0, -92, 16395, 94, -13, -182, 16402, 191, -27,
+    -269, 16404, 291, -42, -354, 16402, 393, -57, -436, 16396, 497, -73,
+    -517, 16386, 604, -89, -595, 16371, 714, -106, -670, 16352, 826, -124,
+    -743, 16328, 941, -142, -814, 16300, 1058, -160, -883, 16270, 1177, -180,
+    -949, 16234, 1299, -200, -1013, 16194, 1423, -220, -1074, 16149, 1550, -241,
+    -1133, 16100, 1679, -262, -1190, 16048, 1810, -284, -1244, 15992, 1943, -307,
+    -1296, 15931, 2079, -330, -1346, 15867, 2217, -354, -1393, 15798, 2357, -378,
+    -1438, 15726, 2499, -403, -1481, 15650, 2643, -428, -1522, 15570, 2789, -453,
+    -1560, 15486, 2937, -479, -1597, 15400, 3087, -506, -1631, 15309, 3239, -533,
+    -1663, 15214, 3393, -560, -1692, 15115, 3548, -587, -1720, 15013, 3706, -615,
+    -1746, 14909, 3865, -644, -1769, 14801, 4025, -673, -1791, 14690, 4187, -702,
+    -1810, 14574, 4351, -731, -1828, 14456, 4516, -760, -1844, 14335, 4683, -790,
+    -1858, 14211, 4851, -820, -1870, 14085, 5020, -851, -1880, 13955, 5190, -881,
+    -1888, 13822, 5362, -912, -1895, 13687, 5534, -942, -1900, 13549, 5708, -973,
+    -1903, 13408, 5883, -1004, -1905, 13266, 6058, -1035, -1905, 13120, 6234, -1065,
+    -1903, 12971, 6412, -1096, -1900, 12822, 6589, -1127, -1896, 12670, 6768, -1158,
+    -1890, 12515, 6947, -1188, -1882, 12359, 7126, -1219, -1874, 12201, 7306, -1249,
+    -1864, 12041, 7486, -1279, -1853, 11879, 7667, -1309, -1840, 11714, 7848, -1338,
+    -1826, 11550, 8028, -1368, -1812, 11383, 8209, -1396, -1796, 11215, 8390, -1425,
+    -1779, 11045, 8571, -1453, -1761, 10875, 8751, -1481, -1742, 10703, 8931, -1508,
+    -1722, 10529, 9111, -1534, -1701, 10354, 9291, -1560, -1680, 10179, 9470, -1585,
+    -1657, 10003, 9648, -1610, -1634, 9826, 9826, -1634, -1610, 9648, 10003, -1657,
+    -1585, 9470, 10179, -1680, -1560, 9291, 10354, -1701, -1534, 9111, 10529, -1722,
+    -1508, 8931, 10703, -1742, -1481, 8751, 10875, -1761, -1453, 8571, 11045, -1779,
+    -1425, 8390, 11215, -1796, -1396, 8209, 11383, -1812, -1368, 8028, 11550, -1826,
+    -1338, 7848, 11714, -1840, -1309, 7667, 11879, -1853, -1279, 7486, 12041, -1864,
+    -1249, 7306, 12201, -1874, -1219, 7126, 12359, -1882, -1188, 6947, 12515, -1890,
+    -1158, 6768, 12670, -1896, -1127, 6589, 12822, -1900, -1096, 6412, 12971, -1903,
+    -1065, 6234, 13120, -1905, -1035, 6058, 13266, -1905, -1004, 5883, 13408, -1903,
+    -973, 5708, 13549, -1900, -942, 5534, 13687, -1895, -912, 5362, 13822, -1888,
+    -881, 5190, 13955, -1880, -851, 5020, 14085, -1870, -820, 4851, 14211, -1858,
+    -790, 4683, 14335, -1844, -760, 4516, 14456, -1828, -731, 4351, 14574, -1810,
+    -702, 4187, 14690, -1791, -673, 4025, 14801, -1769, -644, 3865, 14909, -1746,
+    -615, 3706, 15013, -1720, -587, 3548, 15115, -1692, -560, 3393, 15214, -1663,
+    -533, 3239, 15309, -1631, -506, 3087, 15400, -1597, -479, 2937, 15486, -1560,
+    -453, 2789, 15570, -1522, -428, 2643, 15650, -1481, -403, 2499, 15726, -1438,
+    -378, 2357, 15798, -1393, -354, 2217, 15867, -1346, -330, 2079, 15931, -1296,
+    -307, 1943, 15992, -1244, -284, 1810, 16048, -1190, -262, 1679, 16100, -1133,
+    -241, 1550, 16149, -1074, -220, 1423, 16194, -1013, -200, 1299, 16234, -949,
+    -180, 1177, 16270, -883, -160, 1058, 16300, -814, -142, 941, 16328, -743,
+    -124, 826, 16352, -670, -106, 714, 16371, -595, -89, 604, 16386, -517,
+    -73, 497, 16396, -436, -57, 393, 16402, -354, -42, 291, 16404, -269,
+    -27, 191, 16402, -182, -13, 94, 16395, -92, 0, 0, 16384, 0
+};
+
+/** 8 coeficientes por fase, beta 5: imágenes a -54 dB. */
+static const int16_t coefs_mid[(POLYPHASE_PHASES + 1) * 8] = {
+    0, 0, 0, 16384, 0, 0, 0, 0, -10, 35, -110, 16384,
+    112, -36, 10, -1, -19, 70, -218, 16378, 227, -72, 20, -2,
+    -28, 103, -323, 16371, 343, -109, 31, -4, -37, 136, -426, 16359,
+    462, -146, 41, -5, -46, 169, -527, 16344, 583, -184, 52, -7,
+    -55, 201, -626, 16326, 706, -223, 63, -8, -63, 232, -722, 16303,
+    832, -262, 74, -10, -71, 262, -816, 16277, 959, -302, 86, -11,
+    -79, 292, -908, 16248, 1088, -342, 98, -13, -86, 321, -997, 16215,
+    1220, -383, 109, -15, -94, 349, -1084, 16180, 1353, -424, 121, -17,
+    -101, 376, -1169, 16139, 1489, -465, 134, -19, -108, 403, -1251, 16096,
+    1626, -507, 146, -21, -114, 429, -1331, 16049, 1765, -550, 159, -23,
+    -120, 454, -1408, 15997, 1906, -592, 172, -25, -126, 479, -1483, 15943,
+    2049, -635, 184, -27, -132, 502, -1556, 15886, 2194, -679, 198, -29,
+    -138, 525, -1626, 15825, 2340, -722, 211, -31, -143, 547, -1694, 15762,
+    2488, -766, 224, -34, -148, 569, -1760, 15693, 2638, -810, 238, -36,
+    -153, 589, -1823, 15625, 2789, -855, 251, -39, -157, 609, -1883, 15548,
+    2942, -899, 265, -41, -162, 628, -1942, 15473, 3096, -944, 279, -44,
+    -166, 646, -1998, 15392, 3252, -989, 293, -46, -170, 664, -2052, 15308,
+    3410, -1034, 307, -49, -173, 681, -2103, 15220, 3569, -1079, 321, -52,
+    -177, 696, -2152, 15132, 3729, -1124, 335, -55, -180, 712, -2199, 15038,
+    3890, -1169, 349, -57, -183, 726, -2243, 14942, 4053, -1214, 363, -60,
+    -185, 740, -2285, 14843, 4216, -1259, 377, -63, -188, 752, -2325, 14742,
+    4381, -1304, 392, -66, -190, 764, -2363, 14638, 4547, -1349, 406, -69,
+    -192, 776, -2398, 14530, 4714, -1394, 420, -72, -194, 786, -2431, 14419,
+    4882, -1438, 435, -75, -195, 796, -2462, 14306, 5051, -1483, 449, -78,
+    -197, 805, -2491, 14191, 5221, -1527, 463, -81, -198, 814, -2518, 14072,
+    5392, -1570, 477, -85, -199, 821, -2542, 13951, 5563, -1614, 492, -88,
+    -200, 828, -2565, 13828, 5735, -1657, 506, -91, -200, 834, -2585, 13701,
+    5908, -1700, 520, -94, -201, 840, -2603, 13574, 6081, -1742, 533, -98,
+    -201, 845, -2619, 13442, 6255, -1784, 547, -101, -201, 849, -2633, 13308,
+    6429, -1825, 561, -104, -201, 852, -2646, 13173, 6604, -1866, 575, -107,
+    -201, 855, -2656, 13037, 6779, -1907, 588, -111, -200, 857, -2664, 12896,
+    6954, -1946, 601, -114, -200, 859, -2670, 12754, 7129, -1985, 614, -117,
+    -199, 860, -2675, 12611, 7305, -2024, 627, -121, -198, 860, -2677, 12463,
+    7481, -2061, 640, -124, -197, 859, -2678, 12317, 7656, -2098, 652, -127,
+    -196, 859, -2677, 12166, 7832, -2135, 665, -130, -194, 857, -2674, 12015,
+    8007, -2170, 677, -134, -193, 855, -2670, 11862, 8183, -2204, 688, -137,
+    -191, 852, -2664, 11707, 8358, -2238, 700, -140, -190, 849, -2656, 11552,
+    8532, -2271, 711, -143, -188, 845, -2646, 11392, 8707, -2302, 722, -146,
+    -186, 841, -2635, 11232, 8881, -2333, 733, -149, -184, 836, -2623, 11073,
+    9054, -2362, 743, -153, -182, 831, -2608, 10910, 9227, -2391, 753, -156,
+    -179, 825, -2593, 10746, 9399, -2418, 762, -158, -177, 819, -2576, 10581,
+    9571, -2445, 772, -161, -175, 812, -2557, 10416, 9742, -2470, 780, -164,
+    -172, 805, -2537, 10247, 9912, -2493, 789, -167, -170, 797, -2516, 10081,
+    10081, -2516, 797, -170, -167, 789, -2493, 9912, 10247, -2537, 805, -172,
+    -164, 780, -2470, 9742, 10416, -2557, 812, -175, -161, 772, -2445, 9571,
+    10581, -2576, 819, -177, -158, 762, -2418, 9399, 10746, -2593, 825, -179,
+    -156, 753, -2391, 9227, 10910, -2608, 831, -182, -153, 743, -2362, 9054,
+    11073, -2623, 836, -184, -149, 733, -2333, 8881, 11232, -2635, 841, -186,
+    -146, 722, -2302, 8707, 11392, -2646, 845, -188, -143, 711, -2271, 8532,
+    11552, -2656, 849, -190, -140, 700, -2238, 8358, 11707, -2664, 852, -191,
+    -137, 688, -2204, 8183, 11862, -2670, 855, -193, -134, 677, -2170, 8007,
+    12015, -2674, 857, -194, -130, 665, -2135, 7832, 12166, -2677, 859, -196,
+    -127, 652, -2098, 7656, 12317, -2678, 859, -197, -124, 640, -2061, 7481,
+    12463, -2677, 860, -198, -121, 627, -2024, 7305, 12611, -2675, 860, -199,
+    -117, 614, -1985, 7129, 12754, -2670, 859, -200, -114, 601, -1946, 6954,
+    12896, -2664, 857, -200, -111, 588, -1907, 6779, 13037, -2656, 855, -201,
+    -107, 575, -1866, 6604, 13173, -2646, 852, -201, -104, 561, -1825, 6429,
+    13308, -2633, 849, -201, -101, 547, -1784, 6255, 13442, -2619, 845, -201,
+    -98, 533, -1742, 6081, 13574, -2603, 840, -201, -94, 520, -1700, 5908,
+    13701, -2585, 834, -200, -91, 506, -1657, 5735, 13828, -2565, 828, -200,
+    -88, 492, -1614, 5563, 13951, -2542, 821, -199, -85, 477, -1570, 5392,
+    14072, -2518, 814, -198, -81, 463, -1527, 5221, 14191, -2491, 805, -197,
+    -78, 449, -1483, 5051, 14306, -2462, 796, -195, -75, 435, -1438, 4882,
+    14419, -2431, 786, -194, -72, 420, -1394, 4714, 14530, -2398, 776, -192,
+    -69, 406, -1349, 4547, 14638, -2363, 764, -190, -66, 392, -1304, 4381,
+    14742, -2325, 752, -188, -63, 377, -1259, 4216, 14843, -2285, 740, -185,
+    -60, 363, -1214, 4053, 14942, -2243, 726, -183, -57, 349, -1169, 3890,
+    15038, -2199, 712, -180, -55, 335, -1124, 3729, 15132, -2152, 696, -177,
+    -52, 321, -1079, 3569, 15220, -2103, 681, -173, -49, 307, -1034, 3410,
+    15308, -2052, 664, -170, -46, 293, -989, 3252, 15392, -1998, 646, -166,
+    -44, 279, -944, 3096, 15473, -1942, 628, -162, -41, 265, -899, 2942,
+    15548, -1883, 609, -157, -39, 251, -855, 2789, 15625, -1823, 589, -153,
+    -36, 238, -810, 2638, 15693, -1760, 569, -148, -34, 224, -766, 2488,
+    15762, -1694, 547, -143, -31, 211, -722, 2340, 15825, -1626, 525, -138,
+    -29, 198, -679, 2194, 15886, -1556, 502, -132, -27, 184, -635, 2049,
+    15943, -1483, 479, -126, -25, 172, -592, 1906, 15997, -1408, 454, -120,
+    -23, 159, -550, 1765, 16049, -1331, 429, -114, -21, 146, -507, 1626,
+    16096, -1251, 403, -108, -19, 134, -465, 1489, 16139, -1169, 376, -101,
+    -17, 121, -424, 1353, 16180, -1084, 349, -94, -15, 109, -383, 1220,
+    16215, -997, 321, -86, -13, 98, -342, 1088, 16248, -908, 292, -79,
+    -11, 86, -302, 959, 16277, -816, 262, -71, -10, 74, -262, 832,
+    16303, -722, 232, -63, -8, 63, -223, 706, 16326, -626, 201, -55,
+    -7, 52, -184, 583, 16344, -527, 169, -46, -5, 41, -146, 462,
+    16359, -426, 136, -37, -4, 31, -109, 343, 16371, -323, 103, -28,
+    -2, 20, -72, 227, 16378, -218, 70, -19, -1, 10, -36, 112,
+    16384, -110, 35, -10, 0, 0, 0, 0, 16384, 0, 0, 0
+};
+
+/** 16 coeficientes por fase, beta 8: imágenes a -82 dB. */
+static const int16_t coefs_high[(POLYPHASE_PHASES + 1) * 16] = {
+    0, 0, 0, 0, 0, 0, 0, 16384, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 2, -5, 12, -25, 50, -120, 16383,
+    122, -51, 25, -12, 5, -2, 0, 0, -1, 3, -10, 23,
+    -49, 100, -237, 16378, 246, -102, 50, -24, 10, -4, 1, 0,
+    -1, 5, -15, 35, -73, 149, -353, 16370, 371, -154, 75, -36,
+    15, -5, 1, 0, -2, 7, -20, 46, -97, 197, -466, 16357,
+    499, -206, 101, -48, 21, -7, 2, 0, -2, 8, -24, 57,
+    -120, 245, -577, 16342, 629, -259, 127, -61, 26, -9, 2, 0,
+    -2, 10, -29, 68, -143, 292, -685, 16321, 761, -312, 153, -73,
+    31, -11, 3, 0, -3, 12, -33, 79, -166, 338, -792, 16300,
+    895, -366, 179, -86, 37, -13, 3, 0, -3, 13, -38, 89,
+    -188, 383, -896, 16275, 1031, -420, 206, -99, 42, -15, 4, 0,
+    -3, 14, -42, 100, -210, 428, -998, 16246, 1168, -475, 232, -111,
+    48, -17, 4, 0, -4, 16, -46, 110, -232, 472, -1098, 16213,
+    1308, -530, 259, -124, 54, -19, 5, 0, -4, 17, -50, 120,
+    -253, 515, -1195, 16179, 1449, -585, 286, -137, 59, -21, 5, -1,
+    -4, 19, -55, 130, -274, 557, -1290, 16139, 1592, -640, 313, -150,
+    65, -23, 6, -1, -5, 20, -58, 139, -294, 599, -1383, 16096,
+    1737, -696, 340, -163, 71, -25, 7, -1, -5, 21, -62, 149,
+    -314, 639, -1473, 16053, 1883, -752, 367, -176, 76, -28, 7, -1,
+    -5, 22, -66, 158, -334, 679, -1561, 16005, 2031, -808, 394, -190,
+    82, -30, 8, -1, -5, 24, -70, 167, -353, 718, -1647, 15951,
+    2181, -864, 422, -203, 88, -32, 8, -1, -6, 25, -73, 175,
+    -372, 756, -1730, 15897, 2332, -921, 449, -216, 94, -34, 9, -1,
+    -6, 26, -77, 184, -390, 793, -1811, 15837, 2485, -977, 476, -229,
+    100, -36, 10, -1, -6, 27, -80, 192, -408, 829, -1890, 15777,
+    2639, -1034, 504, -243, 106, -38, 10, -1, -6, 28, -83, 200,
+    -425, 865, -1966, 15710, 2795, -1090, 531, -256, 112, -41, 11, -1,
+    -7, 29, -87, 208, -442, 899, -2039, 15644, 2952, -1147, 558, -269,
+    118, -43, 11, -1, -7, 30, -90, 216, -459, 932, -2111, 15573,
+    3110, -1203, 586, -283, 124, -45, 12, -1, -7, 31, -93, 223,
+    -475, 965, -2179, 15499, 3270, -1260, 613, -296, 129, -47, 13, -2,
+    -7, 32, -95, 230, -490, 996, -2246, 15422, 3431, -1316, 640, -309,
+    135, -50, 13, -2, -7, 33, -98, 237, -505, 1027, -2310, 15340,
+    3593, -1372, 667, -322, 141, -52, 14, -2, -7, 33, -101, 244,
+    -520, 1056, -2372, 15258, 3756, -1428, 694, -335, 147, -54, 15, -2,
+    -7, 34, -103, 250, -534, 1085, -2431, 15171, 3921, -1484, 720, -348,
+    153, -56, 15, -2, -8, 35, -106, 256, -547, 1112, -2488, 15084,
+    4086, -1540, 747, -361, 159, -59, 16, -2, -8, 36, -108, 262,
+    -560, 1139, -2542, 14989, 4253, -1595, 773, -374, 165, -61, 17, -2,
+    -8, 36, -110, 268, -573, 1164, -2594, 14896, 4420, -1650, 799, -387,
+    171, -63, 17, -2, -8, 37, -112, 273, -585, 1189, -2644, 14798,
+    4588, -1704, 825, -400, 176, -65, 18, -2, -8, 37, -114, 279,
+    -596, 1212, -2691, 14696, 4758, -1758, 851, -412, 182, -68, 19, -3,
+    -8, 38, -116, 284, -608, 1235, -2736, 14594, 4928, -1812, 876, -425,
+    188, -70, 19, -3, -8, 38, -118, 288, -618, 1256, -2779, 14489,
+    5098, -1865, 901, -437, 194, -72, 20, -3, -8, 39, -119, 293,
+    -628, 1277, -2819, 14378, 5270, -1918, 926, -450, 199, -74, 21, -3,
+    -8, 39, -121, 297, -638, 1296, -2857, 14269, 5442, -1970, 951, -462,
+    205, -77, 21, -3, -8, 40, -122, 301, -647, 1314, -2893, 14155,
+    5614, -2021, 975, -474, 210, -79, 22, -3, -8, 40, -124, 305,
+    -655, 1332, -2926, 14035, 5788, -2072, 999, -485, 216, -81, 23, -3,
+    -8, 40, -125, 308, -663, 1348, -2957, 13919, 5961, -2122, 1022, -497,
+    221, -83, 23, -3, -8, 41, -126, 311, -670, 1363, -2985, 13796,
+    6135, -2172, 1046, -508, 226, -85, 24, -4, -8, 41, -127, 314,
+    -677, 1377, -3012, 13673, 6310, -2221, 1068, -520, 232, -87, 25, -4,
+    -8, 41, -128, 317, -684, 1391, -3036, 13547, 6484, -2268, 1091, -531,
+    237, -90, 25, -4, -8, 41, -129, 320, -690, 1403, -3058, 13419,
+    6659, -2316, 1112, -541, 242, -92, 26, -4, -8, 41, -130, 322,
+    -695, 1414, -3078, 13288, 6834, -2362, 1134, -552, 247, -94, 27, -4,
+    -8, 41, -130, 324, -700, 1424, -3095, 13154, 7009, -2407, 1155, -562,
+    252, -96, 27, -4, -8, 41, -131, 326, -705, 1433, -3111, 13021,
+    7185, -2451, 1175, -573, 256, -98, 28, -4, -8, 41, -131, 327,
+    -708, 1442, -3124, 12881, 7360, -2495, 1195, -582, 261, -100, 29, -4,
+    -8, 41, -132, 328, -712, 1449, -3135, 12744, 7535, -2537, 1214, -592,
+    266, -101, 29, -5, -8, 41, -132, 330, -715, 1455, -3144, 12601,
+    7710, -2578, 1233, -601, 270, -103, 30, -5, -8, 41, -132, 330,
+    -717, 1460, -3151, 12459, 7885, -2619, 1251, -610, 274, -105, 31, -5,
+    -8, 41, -132, 331, -719, 1464, -3156, 12314, 8059, -2658, 1269, -619,
+    279, -107, 31, -5, -8, 41, -132, 331, -721, 1468, -3159, 12168,
+    8234, -2696, 1285, -628, 283, -109, 32, -5, -8, 41, -132, 332,
+    -722, 1470, -3160, 12017, 8408, -2732, 1302, -636, 287, -110, 32, -5,
+    -8, 41, -132, 332, -722, 1471, -3159, 11869, 8581, -2768, 1317, -644,
+    290, -112, 33, -5, -8, 41, -132, 331, -722, 1472, -3156, 11716,
+    8754, -2802, 1333, -651, 294, -114, 34, -6, -8, 41, -131, 331,
+    -722, 1471, -3151, 11561, 8927, -2835, 1347, -658, 298, -115, 34, -6,
+    -7, 40, -131, 330, -721, 1470, -3144, 11407, 9098, -2866, 1360, -665,
+    301, -117, 35, -6, -7, 40, -130, 329, -720, 1467, -3135, 11250,
+    9270, -2896, 1373, -672, 304, -118, 35, -6, -7, 40, -130, 328,
+    -718, 1464, -3124, 11090, 9440, -2925, 1386, -678, 307, -119, 36, -6,
+    -7, 39, -129, 327, -716, 1460, -3112, 10932, 9610, -2952, 1397, -684,
+    310, -121, 36, -6, -7, 39, -128, 326, -713, 1455, -3098, 10768,
+    9778, -2977, 1408, -689, 313, -122, 37, -6, -7, 39, -127, 324,
+    -710, 1449, -3082, 10607, 9946, -3002, 1418, -694, 315, -123, 37, -6,
+    -7, 38, -126, 322, -707, 1443, -3064, 10444, 10113, -3024, 1427, -699,
+    318, -124, 37, -7, -7, 38, -125, 320, -703, 1435, -3045, 10279,
+    10279, -3045, 1435, -703, 320, -125, 38, -7, -7, 37, -124, 318,
+    -699, 1427, -3024, 10113, 10444, -3064, 1443, -707, 322, -126, 38, -7,
+    -6, 37, -123, 315, -694, 1418, -3002, 9946, 10607, -3082, 1449, -710,
+    324, -127, 39, -7, -6, 37, -122, 313, -689, 1408, -2977, 9778,
+    10768, -3098, 1455, -713, 326, -128, 39, -7, -6, 36, -121, 310,
+    -684, 1397, -2952, 9610, 10932, -3112, 1460, -716, 327, -129, 39, -7,
+    -6, 36, -119, 307, -678, 1386, -2925, 9440, 11090, -3124, 1464, -718,
+    328, -130, 40, -7, -6, 35, -118, 304, -672, 1373, -2896, 9270,
+    11250, -3135, 1467, -720, 329, -130, 40, -7, -6, 35, -117, 301,
+    -665, 1360, -2866, 9098, 11407, -3144, 1470, -721, 330, -131, 40, -7,
+    -6, 34, -115, 298, -658, 1347, -2835, 8927, 11561, -3151, 1471, -722,
+    331, -131, 41, -8, -6, 34, -114, 294, -651, 1333, -2802, 8754,
+    11716, -3156, 1472, -722, 331, -132, 41, -8, -5, 33, -112, 290,
+    -644, 1317, -2768, 8581, 11869, -3159, 1471, -722, 332, -132, 41, -8,
+    -5, 32, -110, 287, -636, 1302, -2732, 8408, 12017, -3160, 1470, -722,
+    332, -132, 41, -8, -5, 32, -109, 283, -628, 1285, -2696, 8234,
+    12168, -3159, 1468, -721, 331, -132, 41, -8, -5, 31, -107, 279,
+    -619, 1269, -2658, 8059, 12314, -3156, 1464, -719, 331, -132, 41, -8,
+    -5, 31, -105, 274, -610, 1251, -2619, 7885, 12459, -3151, 1460, -717,
+    330, -132, 41, -8, -5, 30, -103, 270, -601, 1233, -2578, 7710,
+    12601, -3144, 1455, -715, 330, -132, 41, -8, -5, 29, -101, 266,
+    -592, 1214, -2537, 7535, 12744, -3135, 1449, -712, 328, -132, 41, -8,
+    -4, 29, -100, 261, -582, 1195, -2495, 7360, 12881, -3124, 1442, -708,
+    327, -131, 41, -8, -4, 28, -98, 256, -573, 1175, -2451, 7185,
+    13021, -3111, 1433, -705, 326, -131, 41, -8, -4, 27, -96, 252,
+    -562, 1155, -2407, 7009, 13154, -3095, 1424, -700, 324, -130, 41, -8,
+    -4, 27, -94, 247, -552, 1134, -2362, 6834, 13288, -3078, 1414, -695,
+    322, -130, 41, -8, -4, 26, -92, 242, -541, 1112, -2316, 6659,
+    13419, -3058, 1403, -690, 320, -129, 41, -8, -4, 25, -90, 237,
+    -531, 1091, -2268, 6484, 13547, -3036, 1391, -684, 317, -128, 41, -8,
+    -4, 25, -87, 232, -520, 1068, -2221, 6310, 13673, -3012, 1377, -677,
+    314, -127, 41, -8, -4, 24, -85, 226, -508, 1046, -2172, 6135,
+    13796, -2985, 1363, -670, 311, -126, 41, -8, -3, 23, -83, 221,
+    -497, 1022, -2122, 5961, 13919, -2957, 1348, -663, 308, -125, 40, -8,
+    -3, 23, -81, 216, -485, 999, -2072, 5788, 14035, -2926, 1332, -655,
+    305, -124, 40, -8, -3, 22, -79, 210, -474, 975, -2021, 5614,
+    14155, -2893, 1314, -647, 301, -122, 40, -8, -3, 21, -77, 205,
+    -462, 951, -1970, 5442, 14269, -2857, 1296, -638, 297, -121, 39, -8,
+    -3, 21, -74, 199, -450, 926, -1918, 5270, 14378, -2819, 1277, -628,
+    293, -119, 39, -8, -3, 20, -72, 194, -437, 901, -1865, 5098,
+    14489, -2779, 1256, -618, 288, -118, 38, -8, -3, 19, -70, 188,
+    -425, 876, -1812, 4928, 14594, -2736, 1235, -608, 284, -116, 38, -8,
+    -3, 19, -68, 182, -412, 851, -1758, 4758, 14696, -2691, 1212, -596,
+    279, -114, 37, -8, -2, 18, -65, 176, -400, 825, -1704, 4588,
+    14798, -2644, 1189, -585, 273, -112, 37, -8, -2, 17, -63, 171,
+    -387, 799, -1650, 4420, 14896, -2594, 1164, -573, 268, -110, 36, -8,
+    -2, 17, -61, 165, -374, 773, -1595, 4253, 14989, -2542, 1139, -560,
+    262, -108, 36, -8, -2, 16, -59, 159, -361, 747, -1540, 4086,
+    15084, -2488, 1112, -547, 256, -106, 35, -8, -2, 15, -56, 153,
+    -348, 720, -1484, 3921, 15171, -2431, 1085, -534, 250, -103, 34, -7,
+    -2, 15, -54, 147, -335, 694, -1428, 3756, 15258, -2372, 1056, -520,
+    244, -101, 33, -7, -2, 14, -52, 141, -322, 667, -1372, 3593,
+    15340, -2310, 1027, -505, 237, -98, 33, -7, -2, 13, -50, 135,
+    -309, 640, -1316, 3431, 15422, -2246, 996, -490, 230, -95, 32, -7,
+    -2, 13, -47, 129, -296, 613, -1260, 3270, 15499, -2179, 965, -475,
+    223, -93, 31, -7, -1, 12, -45, 124, -283, 586, -1203, 3110,
+    15573, -2111, 932, -459, 216, -90, 30, -7, -1, 11, -43, 118,
+    -269, 558, -1147, 2952, 15644, -2039, 899, -442, 208, -87, 29, -7,
+    -1, 11, -41, 112, -256, 531, -1090, 2795, 15710, -1966, 865, -425,
+    200, -83, 28, -6, -1, 10, -38, 106, -243, 504, -1034, 2639,
+    15777, -1890, 829, -408, 192, -80, 27, -6, -1, 10, -36, 100,
+    -229, 476, -977, 2485, 15837, -1811, 793, -390, 184, -77, 26, -6,
+    -1, 9, -34, 94, -216, 449, -921, 2332, 15897, -1730, 756, -372,
+    175, -73, 25, -6, -1, 8, -32, 88, -203, 422, -864, 2181,
+    15951, -1647, 718, -353, 167, -70, 24, -5, -1, 8, -30, 82,
+    -190, 394, -808, 2031, 16005, -1561, 679, -334, 158, -66, 22, -5,
+    -1, 7, -28, 76, -176, 367, -752, 1883, 16053, -1473, 639, -314,
+    149, -62, 21, -5, -1, 7, -25, 71, -163, 340, -696, 1737,
+    16096, -1383, 599, -294, 139, -58, 20, -5, -1, 6, -23, 65,
+    -150, 313, -640, 1592, 16139, -1290, 557, -274, 130, -55, 19, -4,
+    -1, 5, -21, 59, -137, 286, -585, 1449, 16179, -1195, 515, -253,
+    120, -50, 17, -4, 0, 5, -19, 54, -124, 259, -530, 1308,
+    16213, -1098, 472, -232, 110, -46, 16, -4, 0, 4, -17, 48,
+    -111, 232, -475, 1168, 16246, -998, 428, -210, 100, -42, 14, -3,
+    0, 4, -15, 42, -99, 206, -420, 1031, 16275, -896, 383, -188,
+    89, -38, 13, -3, 0, 3, -13, 37, -86, 179, -366, 895,
+    16300, -792, 338, -166, 79, -33, 12, -3, 0, 3, -11, 31,
+    -73, 153, -312, 761, 16321, -685, 292, -143, 68, -29, 10, -2,
+    0, 2, -9, 26, -61, 127, -259, 629, 16342, -577, 245, -120,
+    57, -24, 8, -2, 0, 2, -7, 21, -48, 101, -206, 499,
+    16357, -466, 197, -97, 46, -20, 7, -2, 0, 1, -5, 15,
+    -36, 75, -154, 371, 16370, -353, 149, -73, 35, -15, 5, -1,
+    0, 1, -4, 10, -24, 50, -102, 246, 16378, -237, 100, -49,
+    23, -10, 3, -1, 0, 0, -2, 5, -12, 25, -51, 122,
+    16383, -120, 50, -25, 12, -5, 2, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 16384, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const polyphase_bank_t banks[POLYPHASE_QUALITIES] = {
+    [POLYPHASE_LOW] = { coefs_low, 4, false, 36 },
+    [POLYPHASE_MID] = { coefs_mid, 8, false, 54 },
+    [POLYPHASE_HIGH] = { coefs_high, 16, true, 82 },
+};
+
+static const char *const quality_args[POLYPHASE_QUALITIES] = { "off", "low", "mid", "high" };
+
+/**
+ * Banco de un nivel de calidad, o NULL para POLYPHASE_NEAREST (o un nivel que no existe).
+ */
+const polyphase_bank_t *polyphase_bank(polyphase_quality_t quality) {
+    return quality > POLYPHASE_NEAREST && quality < POLYPHASE_QUALITIES ? &banks[quality] : NULL;
+}
+
+const char *polyphase_quality_name(polyphase_quality_t quality) {
+    static const char *const names[] = { "sin filtro", "baja", "media", "alta" };
+
+    return (unsigned)quality < sizeof(names) / sizeof(names[0]) ? names[quality] : "?";
+}
+
+/**
+ * Nivel de calidad por su nombre en los comandos: "off", "low", "mid" o "high".
+ * @return false si el nombre no es ninguno.
+ */
+bool polyphase_quality_parse(const char *name, polyphase_quality_t *quality) {
+    for (int i = 0; i < POLYPHASE_QUALITIES; ++i) {
+        if (strcmp(name, quality_args[i]) == 0) {
+            *quality = (polyphase_quality_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Fila de coeficientes para una posición frac (Q32) después de la muestra de referencia. Sin
+ * interpolación es la fase más cercana (la fila POLYPHASE_PHASES es la muestra siguiente); con
+ * interpolación, la anterior, y mu recibe la distancia a ella en Q8.
+ */
+static inline const int16_t *select_row(const polyphase_bank_t *bank, uint32_t frac, uint32_t *mu) {
+    if (bank->lerp) {
+        *mu = (frac >> (24 - POLYPHASE_PHASE_BITS)) & 0xFF;
+        return bank->coefs + (frac >> (32 - POLYPHASE_PHASE_BITS)) * bank->taps;
+    }
+    *mu = 0;
+    return bank->coefs + (((frac >> (31 - POLYPHASE_PHASE_BITS)) + 1) >> 1) * bank->taps;
+}
+
+static inline int32_t dot_u8(const int16_t *c, const uint8_t *x, uint32_t taps) {
+    int32_t acc = 0;
+
+    for (uint32_t k = 0; k < taps; ++k) {
+        acc += c[k] * x[k];
+    }
+    return acc;
+}
+
+static inline int32_t dot_s16(const int16_t *c, const int16_t *x, uint32_t taps) {
+    int32_t acc = 0;
+
+    for (uint32_t k = 0; k < taps; ++k) {
+        acc += c[k] * x[k];
+    }
+    return acc;
+}
+
+/**
+ * Escribe n muestras de una tabla periódica recorrida desde pos + frac con un paso de
+ * inc_int + inc_frac / 65536, como wavepack_player_render(), filtradas con un banco. Cerca de los
+ * bordes la ventana da la vuelta por el otro extremo de la tabla.
+ * @param bank  Banco de coeficientes (no NULL).
+ * @param table Tabla de códigos del DAC.
+ * @param len   Muestras de la tabla.
+ * @param pos   Posición en la tabla; se actualiza.
+ * @param frac  Fracción de la posición en Q16; se actualiza.
+ */
+void SIGGEN_HOT(polyphase_table_render)(const polyphase_bank_t *bank, const uint8_t *table, uint32_t len, uint32_t *pos,
+                                        uint32_t *frac, uint32_t inc_int, uint32_t inc_frac, uint8_t *out, size_t n) {
+    uint32_t taps = bank->taps, before = taps / 2 - 1, after = taps / 2;
+    uint32_t p = *pos, f = *frac;
+    uint8_t window[POLYPHASE_MAX_TAPS];
+
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t *x = window;
+        if (p >= before && p + after < len) {
+            x = table + (p - before);
+        } else {
+            uint32_t k = p + len - before % len;
+            k = k < len ? k : k - len;
+            for (uint32_t j = 0; j < taps; ++j) {
+                window[j] = table[k];
+                k = k + 1 < len ? k + 1 : 0;
+            }
+        }
+
+        // Producto en Q14 de los códigos; se pasa a Q8 antes de interpolar para no desbordar
+        uint32_t mu;
+        const int16_t *c = select_row(bank, f << 16, &mu);
+        int32_t y = dot_u8(c, x, taps) >> 6;
+        if (mu) {
+            y += (((dot_u8(c + taps, x, taps) >> 6) - y) * (int32_t)mu) >> 8;
+        }
+        y = (y + 128) >> 8;
+        out[i] = (uint8_t)(y < 0 ? 0 : y > 255 ? 255 : y);
+
+        f += inc_frac;
+        p += inc_int + (f >> 16);
+        f &= 0xFFFF;
+        if (p >= len) {
+            p -= len;
+        }
+    }
+    *pos = p;
+    *frac = f;
+}
+
+/**
+ * Prepara un flujo con la ventana llena de un valor, por ejemplo la última muestra del filtro
+ * anterior, para que cambiar de banco no produzca un salto.
+ */
+void polyphase_stream_init(polyphase_stream_t *s, const polyphase_bank_t *bank, int16_t fill) {
+    s->bank = bank;
+    s->head = 0;
+    for (uint32_t i = 0; i < 2u * bank->taps; ++i) {
+        s->hist[i] = fill;
+    }
+}
+
+/**
+ * Muestra del flujo en la posición frac (Q32) entre las dos muestras centrales de la ventana, es
+ * decir, con un retardo de taps / 2 muestras respecto de la última que entró.
+ * @return Muestra de 16 bits sin recortar: el filtro puede pasarse un poco de la escala.
+ */
+int32_t SIGGEN_HOT(polyphase_stream_at)(const polyphase_stream_t *s, uint32_t frac) {
+    const polyphase_bank_t *bank = s->bank;
+    const int16_t *x = s->hist + s->head;
+    uint32_t mu;
+    const int16_t *c = select_row(bank, frac, &mu);
+    int32_t y = dot_s16(c, x, bank->taps) >> 6;
+
+    if (mu) {
+        y += (((dot_s16(c + bank->taps, x, bank->taps) >> 6) - y) * (int32_t)mu) >> 8;
+    }
+    return (y + 128) >> 8;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file polyphase.h
+ *
+ * @brief Remuestreo polifásico en punto fijo para reproducir tablas y flujos a pasos fraccionarios.
+ *
+ * Leer la muestra más cercana a la posición fraccionaria (lo que hace el DDS sin interpolación)
+ * equivale a retener cada muestra de entrada: el espectro de la tabla se repite alrededor de cada
+ * múltiplo de su frecuencia de muestreo efectiva y el instante de cada muestra tiembla hasta media
+ * muestra. Un filtro FIR pasabajos evaluado en la posición exacta quita esas imágenes. Su respuesta
+ * al impulso está tabulada en POLYPHASE_PHASES fases: la fila p tiene los coeficientes para una
+ * posición p / POLYPHASE_PHASES de muestra después de la muestra de referencia, así que cada
+ * muestra de salida es un producto escalar de taps muestras de entrada por una fila.
+ *
+ * Hay un banco de coeficientes por nivel de calidad (polyphase_quality_t); los genera
+ * tools/fir_design.py, que también informa su respuesta. Los coeficientes están en Q14 y cada
+ * fila suma 1, así que una entrada constante sale igual y la fase 0 es la identidad: con pasos
+ * enteros el resultado es el mismo que sin filtro. El banco más alto además interpola entre dos
+ * fases vecinas, lo que hace despreciable el temblor que deja cuantizar la posición.
+ *
+ * Los filtros cortan en la mitad de la frecuencia de las muestras de entrada: sirven para subir
+ * la frecuencia (paso menor que 1). Con pasos mayores las tablas deben estar limitadas en banda
+ * para el paso más rápido, como sin filtro.
+ *
+ * Hay dos formas de uso, ambas por bloques: polyphase_table_render() recorre una tabla periódica
+ * (wavepack.h) y polyphase_stream_t filtra un flujo de muestras de 16 bits que llegan de a una,
+ * como el audio de rate_match.h. host/resample_run mide el costo por muestra y el rechazo de las
+ * imágenes de cada banco; el firmware bench.c, lo mismo en la Pico.
+ */
+
+#ifndef SIGGEN_POLYPHASE_H
+#define SIGGEN_POLYPHASE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define POLYPHASE_PHASE_BITS 7 ///< Bits de la posición que eligen la fase
+#define POLYPHASE_PHASES (1 << POLYPHASE_PHASE_BITS) ///< Fases por muestra de entrada
+#define POLYPHASE_MAX_TAPS 16 ///< Coeficientes por fase del banco más largo
+#define POLYPHASE_ONE 16384 ///< 1.0 en el formato de los coeficientes (Q14)
+
+/**
+ * Nivel de calidad, de menor a mayor costo.
+ */
+typedef enum {
+    POLYPHASE_NEAREST, ///< Sin filtro: la muestra más cercana, como el DDS
+    POLYPHASE_LOW, ///< 4 coeficientes por fase
+    POLYPHASE_MID, ///< 8 coeficientes por fase
+    POLYPHASE_HIGH, ///< 16 coeficientes por fase e interpolación entre fases
+    POLYPHASE_QUALITIES, ///< Cantidad de niveles
+} polyphase_quality_t;
+
+/**
+ * Banco de coeficientes.
+ */
+typedef struct {
+    const int16_t *coefs; ///< POLYPHASE_PHASES + 1 filas de taps coeficientes en Q14
+    uint8_t taps; ///< Coeficientes por fase (par)
+    bool lerp; ///< Interpolar entre las dos fases vecinas
+    uint8_t image_db; ///< Rechazo de diseño de las imágenes, con contenido hasta un cuarto de la frecuencia de entrada
+} polyphase_bank_t;
+
+/**
+ * Flujo de muestras de 16 bits. La historia está duplicada para que la ventana de taps muestras
+ * sea siempre contigua.
+ */
+typedef struct {
+    const polyphase_bank_t *bank; ///< Banco en uso
+    uint32_t head; ///< Posición de la muestra más antigua de la ventana
+    int16_t hist[2 * POLYPHASE_MAX_TAPS]; ///< Últimas taps muestras, dos veces
+} polyphase_stream_t;
+
+const polyphase_bank_t *polyphase_bank(polyphase_quality_t quality);
+
+const char *polyphase_quality_name(polyphase_quality_t quality);
+
+bool polyphase_quality_parse(const char *name, polyphase_quality_t *quality);
+
+void polyphase_table_render(const polyphase_bank_t *bank, const uint8_t *table, uint32_t len, uint32_t *pos,
+                            uint32_t *frac, uint32_t inc_int, uint32_t inc_frac, uint8_t *out, size_t n);
+
+void polyphase_stream_init(polyphase_stream_t *s, const polyphase_bank_t *bank, int16_t fill);
+
+/**
+ * Agrega una muestra al flujo; la más antigua sale de la ventana.
+ */
+static inline void polyphase_stream_push(polyphase_stream_t *s, int16_t x) {
+    uint32_t taps = s->bank->taps;
+    uint32_t head = s->head;
+
+    s->hist[head] = x;
+    s->hist[head + taps] = x;
+    s->head = head + 1 < taps ? head + 1 : 0;
+}
+
+int32_t polyphase_stream_at(const polyphase_stream_t *s, uint32_t frac);
+
+#endif
@@ -0,0 +1,312 @@
+/**
+ * @file rate_match.c
+ *
+ * @brief Cola de paquetes de audio, cadena de interpolación y remuestreo lineal o polifásico con
+ * corrección de deriva.
+ */
+
+#include "rate_match.h"
+#include "platform.h"
+#include <string.h>
+
+#define MAX_CORR_Q24 ((int32_t)((int64_t)RATE_MATCH_MAX_PPM * ((int32_t)1 << 24) / 1000000))
+
+/**
+ * Prepara la cola, sin flujo.
+ * @param out_rate Frecuencia de muestreo de la salida (Hz).
+ */
+void rate_match_init(rate_match_t *rm, uint32_t out_rate) {
+    memset(rm, 0, sizeof(*rm));
+    rm->out_rate = out_rate;
+    rm->chain_factor = 1;
+    rm->factor = 1;
+    rm->chain_seen = 1;
+    interp_chain_init(&rm->chain, 1);
+    rm->integ_max = (int64_t)MAX_CORR_Q24 * ((int64_t)out_rate << 8) / RATE_MATCH_KI;
+}
+
+/**
+ * Productor: empieza un flujo a in_rate. Lo que quedaba en la cola se descarta, pero la corrección
+ * aprendida se conserva si la frecuencia no cambia, porque la deriva entre los relojes es la misma.
+ */
+void rate_match_start(rate_match_t *rm, uint32_t in_rate) {
+    rm->in_rate = in_rate;
+    rm->generation++;
+    rm->active = true;
+}
+
+/**
+ * Productor: termina el flujo; el consumidor vuelve a RATE_MATCH_IDLE en el próximo bloque.
+ */
+void rate_match_stop(rate_match_t *rm) {
+    rm->active = false;
+}
+
+/**
+ * Elige la interpolación entre las muestras del flujo; el consumidor la toma en el próximo bloque.
+ * Se llama desde el mismo lado que rate_match_start().
+ */
+void rate_match_set_quality(rate_match_t *rm, polyphase_quality_t quality) {
+    rm->quality = quality < POLYPHASE_QUALITIES ? quality : POLYPHASE_NEAREST;
+}
+
+/**
+ * Elige el factor de la cadena de interpolación; el consumidor lo toma en el próximo bloque, y lo
+ * reduce si in_rate * factor no queda por debajo de out_rate. Se llama desde el mismo lado que
+ * rate_match_start().
+ * @param factor Potencia de 2 entre 1 (sin cadena) e INTERP_CHAIN_MAX_FACTOR.
+ * @return false si el factor no es válido; el pedido no cambia.
+ */
+bool rate_match_set_chain(rate_match_t *rm, uint32_t factor) {
+    if (!factor || factor > INTERP_CHAIN_MAX_FACTOR || (factor & (factor - 1))) {
+        return false;
+    }
+    rm->chain_factor = factor;
+    return true;
+}
+
+/**
+ * Productor: paquete donde escribir las próximas muestras, o NULL si la cola está llena (el
+ * paquete se cuenta como descartado). Queda reservado hasta rate_match_push().
+ */
+int16_t *rate_match_slot(rate_match_t *rm) {
+    uint32_t head = rm->head;
+
+    if (head - rm->tail >= RATE_MATCH_SLOTS) {
+        rm->overruns++;
+        return NULL;
+    }
+    return rm->slots[head % RATE_MATCH_SLOTS];
+}
+
+/**
+ * Productor: publica el paquete de rate_match_slot() con count muestras.
+ */
+void rate_match_push(rate_match_t *rm, size_t count) {
+    uint32_t head = rm->head;
+
+    rm->lens[head % RATE_MATCH_SLOTS] = (uint16_t)(count < RATE_MATCH_SLOT_SAMPLES ? count : RATE_MATCH_SLOT_SAMPLES);
+    // Las muestras tienen que ser visibles para el otro núcleo antes que el índice
+    __sync_synchronize();
+    rm->head = head + 1;
+}
+
+/**
+ * Muestras publicadas que el consumidor todavía no leyó.
+ */
+static uint32_t queued(const rate_match_t *rm) {
+    uint32_t head = rm->head;
+    uint32_t count = 0;
+
+    for (uint32_t t = rm->tail; t != head; ++t) {
+        count += rm->lens[t % RATE_MATCH_SLOTS];
+    }
+    return count - rm->read_pos;
+}
+
+/**
+ * Siguiente muestra de la cola, o false si está vacía.
+ */
+static inline bool SIGGEN_HOT(pop)(rate_match_t *rm, int32_t *sample) {
+    for (;;) {
+        uint32_t tail = rm->tail;
+        if (tail == rm->head) {
+            return false;
+        }
+        uint32_t slot = tail % RATE_MATCH_SLOTS;
+        if (rm->read_pos < rm->lens[slot]) {
+            *sample = rm->slots[slot][rm->read_pos++];
+            return true;
+        }
+        rm->read_pos = 0;
+        rm->tail = tail + 1;
+    }
+}
+
+/**
+ * Siguiente muestra a la salida de la cadena de interpolación, o false si la cola está vacía. La
+ * cadena procesa de a bloques: toma hasta INTERP_CHAIN_MAX_FACTOR / factor muestras de la cola.
+ */
+static inline bool SIGGEN_HOT(next_input)(rate_match_t *rm, int32_t *sample) {
+    if (rm->factor == 1) {
+        return pop(rm, sample);
+    }
+    if (rm->staged_pos == rm->staged_len) {
+        int16_t in[INTERP_CHAIN_MAX_FACTOR / 2];
+        uint32_t count = 0, max = INTERP_CHAIN_MAX_FACTOR / rm->factor;
+        int32_t x;
+
+        while (count < max && pop(rm, &x)) {
+            in[count++] = (int16_t)x;
+        }
+        if (!count) {
+            return false;
+        }
+        rm->staged_len = (uint32_t)interp_chain_process(&rm->chain, in, count, rm->staged);
+        rm->staged_pos = 0;
+    }
+    *sample = rm->staged[rm->staged_pos++];
+    return true;
+}
+
+/**
+ * Vacía la cadena de interpolación y descarta lo que quedaba sin leer de su salida.
+ */
+static void reset_chain(rate_match_t *rm) {
+    interp_chain_init(&rm->chain, rm->factor);
+    rm->staged_len = 0;
+    rm->staged_pos = 0;
+}
+
+/**
+ * Toma el factor pedido para la cadena, reducido hasta que in_rate * factor quede por debajo de
+ * out_rate, y recalcula el paso nominal conservando la corrección de la deriva.
+ */
+static void set_chain(rate_match_t *rm) {
+    uint32_t factor = rm->chain_factor;
+
+    rm->chain_seen = factor;
+    while (factor > 1 && (uint64_t)rm->rate * factor >= rm->out_rate) {
+        factor /= 2;
+    }
+    rm->factor = factor;
+    reset_chain(rm);
+    rm->step_nominal = (uint32_t)((((uint64_t)rm->rate * factor) << 32) / rm->out_rate);
+    rm->step = rm->step_nominal + (uint32_t)(((int64_t)rm->step_nominal * rm->corr_q24) >> 24);
+}
+
+static void set_rate(rate_match_t *rm, uint32_t in_rate) {
+    rm->rate = in_rate;
+    rm->target = (uint32_t)((uint64_t)in_rate * RATE_MATCH_TARGET_US / 1000000);
+    rm->integ = 0;
+    rm->corr_q24 = 0;
+    set_chain(rm);
+}
+
+/**
+ * Control proporcional-integral del paso a partir del nivel de la cola, una vez por bloque de n
+ * muestras de salida. El nivel medido salta un paquete entero cada vez que llega uno (un diente de
+ * sierra a la diferencia entre la frecuencia de los paquetes y la de los bloques, 23 Hz en la
+ * Pico), así que se filtra antes de usarlo.
+ */
+static void SIGGEN_HOT(update_step)(rate_match_t *rm, uint32_t fill, size_t n) {
+    // Dos filtros de primer orden en cascada con coeficiente n / (out_rate * RATE_MATCH_FILTER_US) en
+    // Q16, para que la constante de tiempo no dependa del tamaño del bloque
+    int64_t alpha = ((int64_t)n << 16) * 1000000 / ((int64_t)rm->out_rate * RATE_MATCH_FILTER_US);
+    alpha = alpha < 65536 ? alpha : 65536;
+    rm->fill_lp_q8 += (int32_t)((((int64_t)fill << 8) - rm->fill_lp_q8) * alpha >> 16);
+    rm->fill_q8 += (int32_t)(((int64_t)rm->fill_lp_q8 - rm->fill_q8) * alpha >> 16);
+    int32_t err = rm->fill_q8 - (int32_t)(rm->target << 8);
+
+    // Una cola que crece pide consumir más rápido: la corrección tiene el signo del error
+    rm->integ += (int64_t)err * (int64_t)n;
+    if (rm->integ > rm->integ_max) {
+        rm->integ = rm->integ_max;
+    } else if (rm->integ < -rm->integ_max) {
+        rm->integ = -rm->integ_max;
+    }
+    int64_t corr = (((int64_t)RATE_MATCH_KP * err) >> 8) + rm->integ * RATE_MATCH_KI / ((int64_t)rm->out_rate << 8);
+    if (corr > MAX_CORR_Q24) {
+        corr = MAX_CORR_Q24;
+    } else if (corr < -MAX_CORR_Q24) {
+        corr = -MAX_CORR_Q24;
+    }
+    rm->corr_q24 = (int32_t)corr;
+    rm->step = rm->step_nominal + (uint32_t)(((int64_t)rm->step_nominal * corr) >> 24);
+}
+
+/**
+ * Consumidor: llena un bloque de n códigos del DAC con el audio de la cola. Mientras la cola se
+ * llena hasta el nivel buscado (al empezar o después de vaciarse) el bloque es silencio.
+ * @return false si no hay flujo de audio; el bloque no se toca y debe llenarlo otra fuente.
+ */
+bool SIGGEN_HOT(rate_match_render)(rate_match_t *rm, uint8_t *codes, size_t n) {
+    if (!rm->active || rm->in_rate >= rm->out_rate) {
+        rm->state = RATE_MATCH_IDLE;
+        return false;
+    }
+    if (rm->state == RATE_MATCH_IDLE || rm->generation != rm->seen_generation || rm->in_rate != rm->rate) {
+        rm->seen_generation = rm->generation;
+        if (rm->in_rate != rm->rate) {
+            set_rate(rm, rm->in_rate);
+        }
+        rm->read_pos = 0;
+        rm->tail = rm->head;
+        rm->state = RATE_MATCH_PRIMING;
+    }
+    if (rm->chain_factor != rm->chain_seen) {
+        set_chain(rm);
+    }
+
+    // Lo que queda en la salida de la cadena también está en la cola, en muestras de entrada
+    uint32_t fill = queued(rm) + (rm->staged_len - rm->staged_pos) / rm->factor;
+    rm->fill = fill;
+    if (rm->state == RATE_MATCH_PRIMING) {
+        reset_chain(rm);
+        if (fill < rm->target || !next_input(rm, &rm->next)) {
+            memset(codes, RATE_MATCH_MID_CODE, n);
+            return true;
+        }
+        rm->prev = rm->next;
+        rm->frac = 0;
+        rm->fir_quality = POLYPHASE_QUALITIES; // Vuelve a llenar la ventana del filtro con la muestra nueva
+        rm->fill_lp_q8 = (int32_t)(fill << 8);
+        rm->fill_q8 = rm->fill_lp_q8;
+        rm->state = RATE_MATCH_RUNNING;
+    }
+    update_step(rm, fill, n);
+    if (rm->quality != rm->fir_quality) {
+        rm->fir_quality = rm->quality;
+        if (rm->fir_quality != POLYPHASE_NEAREST) {
+            polyphase_stream_init(&rm->fir, polyphase_bank(rm->fir_quality), (int16_t)rm->next);
+        }
+    }
+
+    bool fir = rm->fir_quality != POLYPHASE_NEAREST;
+    int32_t prev = rm->prev;
+    int32_t next = rm->next;
+    uint32_t frac = rm->frac;
+    uint32_t step = rm->step;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (fir) {
+            int32_t y = polyphase_stream_at(&rm->fir, frac);
+            y = y < -32768 ? -32768 : y > 32767 ? 32767 : y;
+            codes[i] = (uint8_t)((y + 32768) >> 8);
+        } else {
+            // (prev + 32768) << 15 entra en 31 bits y la diferencia por la fracción Q15, también
+            codes[i] = (uint8_t)((((prev + 32768) << 15) + (next - prev) * (int32_t)(frac >> 17)) >> 23);
+        }
+        uint32_t pos = frac + step;
+        if (pos < frac) {
+            prev = next;
+            if (!next_input(rm, &next)) {
+                rm->underruns++;
+                rm->state = RATE_MATCH_PRIMING;
+                memset(codes + i + 1, RATE_MATCH_MID_CODE, n - i - 1);
+                break;
+            }
+            if (fir) {
+                polyphase_stream_push(&rm->fir, (int16_t)next);
+            }
+        }
+        frac = pos;
+    }
+    rm->prev = prev;
+    rm->next = next;
+    rm->frac = frac;
+    return true;
+}
+
+/**
+ * Corrección actual del paso en ppm: positiva si la fuente es más rápida que la salida.
+ */
+int32_t rate_match_ppm(const rate_match_t *rm) {
+    return (int32_t)((int64_t)rm->corr_q24 * 1000000 / ((int32_t)1 << 24));
+}
+
+const char *rate_match_state_name(rate_match_state_t state) {
+    static const char *const names[] = { "inactivo", "llenando", "reproduciendo" };
+
+    return (unsigned)state < sizeof(names) / sizeof(names[0]) ? names[state] : "?";
+}
@@ -0,0 +1,126 @@
+/**
+ * @file rate_match.h
+ *
+ * @brief Cola de paquetes de audio entre dos relojes y remuestreo fraccionario que se adapta a la
+ * diferencia entre ellos.
+ *
+ * Un productor (la pila USB en la Pico) entrega paquetes de muestras de 16 bits a in_rate según su
+ * propio reloj; el consumidor (el núcleo 1) los convierte a códigos del DAC a out_rate con
+ * interpolación lineal. Los dos relojes nunca coinciden del todo: unos cientos de ppm de diferencia
+ * vacían o llenan cualquier cola en segundos. Una vez por bloque, rate_match_render() mide cuántas
+ * muestras quedan en la cola, las filtra y corrige el paso del remuestreo con un control
+ * proporcional-integral para mantenerlas en RATE_MATCH_TARGET_US; la corrección converge a la
+ * deriva entre los relojes y queda acotada a RATE_MATCH_MAX_PPM.
+ *
+ * La cola tiene RATE_MATCH_SLOTS paquetes de hasta RATE_MATCH_SLOT_SAMPLES muestras. El productor
+ * pide el próximo paquete libre con rate_match_slot(), escribe en él (la Pico programa ahí la
+ * transferencia del endpoint, sin copia intermedia) y lo publica con rate_match_push(). Productor
+ * y consumidor pueden estar en núcleos distintos: cada índice lo modifica uno solo.
+ *
+ * Solo sube la frecuencia de muestreo (in_rate < out_rate), que es el caso de la Pico: como mucho
+ * una muestra de entrada por muestra de salida. Con rate_match_set_quality() la interpolación
+ * lineal se reemplaza por un filtro polifásico (polyphase.h), que quita las imágenes del audio
+ * alrededor de los múltiplos de in_rate a cambio de taps / 2 muestras de retardo. Con
+ * rate_match_set_chain() las muestras pasan antes por la cadena de interpolación de
+ * interp_chain.h, que sube el flujo por un factor entero: el remuestreo fraccionario trabaja
+ * entonces sobre una señal ya sobremuestreada, con las imágenes lejos, y la PC puede seguir
+ * mandando a 48 kHz. El factor efectivo es el mayor que no lleva in_rate * factor hasta out_rate.
+ * host/rate_run simula los dos relojes con deriva y reporta la convergencia, el nivel de la cola
+ * y el costo por muestra.
+ */
+
+#ifndef SIGGEN_RATE_MATCH_H
+#define SIGGEN_RATE_MATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "interp_chain.h"
+#include "polyphase.h"
+
+#define RATE_MATCH_SLOTS 16 ///< Paquetes en la cola (potencia de 2)
+#define RATE_MATCH_SLOT_SAMPLES 50 ///< Muestras máximas por paquete: 48 por milisegundo a 48 kHz más margen
+#define RATE_MATCH_TARGET_US 6000 ///< Nivel de la cola que se busca mantener (us de audio)
+#define RATE_MATCH_MAX_PPM 2000 ///< Corrección máxima del paso
+#define RATE_MATCH_FILTER_US 130000 ///< Constante de tiempo de cada etapa del filtro del nivel de la cola (us)
+#define RATE_MATCH_KP 349 ///< Ganancia proporcional: corrección Q24 por muestra de error (unos 21 ppm)
+#define RATE_MATCH_KI 87 ///< Ganancia integral: corrección Q24 por muestra de error y por segundo
+#define RATE_MATCH_MID_CODE 128 ///< Código del silencio mientras se llena la cola
+
+/**
+ * Estado del consumidor.
+ */
+typedef enum {
+    RATE_MATCH_IDLE, ///< Sin flujo de audio; la salida es de otra fuente
+    RATE_MATCH_PRIMING, ///< Esperando que la cola llegue al nivel buscado; sale silencio
+    RATE_MATCH_RUNNING, ///< Remuestreando
+} rate_match_state_t;
+
+/**
+ * Cola y remuestreo. Los campos del productor solo los escribe el productor y los del consumidor
+ * solo el consumidor.
+ */
+typedef struct {
+    int16_t slots[RATE_MATCH_SLOTS][RATE_MATCH_SLOT_SAMPLES]; ///< Paquetes
+    volatile uint16_t lens[RATE_MATCH_SLOTS]; ///< Muestras de cada paquete publicado
+
+    // Productor
+    volatile uint32_t head; ///< Paquetes publicados
+    volatile bool active; ///< Hay un flujo de audio
+    volatile uint32_t generation; ///< Se incrementa con cada rate_match_start()
+    volatile uint32_t in_rate; ///< Frecuencia de muestreo del flujo (Hz)
+    volatile uint32_t overruns; ///< Paquetes descartados por cola llena
+    volatile polyphase_quality_t quality; ///< Filtro pedido; POLYPHASE_NEAREST = interpolación lineal
+    volatile uint32_t chain_factor; ///< Factor pedido a la cadena de interpolación; 1 = sin cadena
+
+    // Consumidor
+    volatile uint32_t tail; ///< Paquetes consumidos
+    volatile rate_match_state_t state; ///< Estado
+    volatile uint32_t fill; ///< Muestras en la cola en el último bloque
+    volatile int32_t corr_q24; ///< Corrección del paso en Q24 (2^24 = 100 %)
+    volatile uint32_t underruns; ///< Veces que la cola se vació remuestreando
+    uint32_t out_rate; ///< Frecuencia de muestreo de la salida (Hz)
+    uint32_t seen_generation; ///< Última generación atendida
+    uint32_t rate; ///< in_rate con que se calcularon step_nominal y target
+    uint32_t read_pos; ///< Próxima muestra del paquete tail
+    uint32_t factor; ///< Factor efectivo de la cadena
+    uint32_t chain_seen; ///< chain_factor con que se calculó factor
+    interp_chain_t chain; ///< Cadena de interpolación, si factor es mayor que 1
+    int16_t staged[INTERP_CHAIN_MAX_FACTOR]; ///< Salida de la cadena todavía sin leer
+    uint32_t staged_len; ///< Muestras en staged
+    uint32_t staged_pos; ///< Próxima muestra de staged
+    uint32_t step_nominal; ///< in_rate * factor / out_rate en Q32
+    uint32_t step; ///< Paso corregido en Q32
+    uint32_t frac; ///< Posición entre prev y next en Q32
+    int32_t prev; ///< Muestra (después de la cadena) anterior a la posición
+    int32_t next; ///< Muestra (después de la cadena) posterior a la posición
+    polyphase_quality_t fir_quality; ///< Filtro en uso
+    polyphase_stream_t fir; ///< Ventana del filtro, si fir_quality no es POLYPHASE_NEAREST
+    uint32_t target; ///< Nivel buscado (muestras)
+    int32_t fill_lp_q8; ///< Nivel después del primer filtro, en Q8
+    int32_t fill_q8; ///< Nivel filtrado en Q8
+    int64_t integ; ///< Integral del error: Q8 muestras por muestra de salida
+    int64_t integ_max; ///< Cota de integ que corresponde a RATE_MATCH_MAX_PPM
+} rate_match_t;
+
+void rate_match_init(rate_match_t *rm, uint32_t out_rate);
+
+void rate_match_start(rate_match_t *rm, uint32_t in_rate);
+
+void rate_match_stop(rate_match_t *rm);
+
+void rate_match_set_quality(rate_match_t *rm, polyphase_quality_t quality);
+
+bool rate_match_set_chain(rate_match_t *rm, uint32_t factor);
+
+int16_t *rate_match_slot(rate_match_t *rm);
+
+void rate_match_push(rate_match_t *rm, size_t count);
+
+bool rate_match_render(rate_match_t *rm, uint8_t *codes, size_t n);
+
+int32_t rate_match_ppm(const rate_match_t *rm);
+
+const char *rate_match_state_name(rate_match_state_t state);
+
+#endif
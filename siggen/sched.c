@@ -0,0 +1,160 @@
+/**
+ * @file sched.c
+ *
+ * @brief Implementación del planificador cooperativo.
+ */
+
+#include "sched.h"
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Compara instantes de 32 bits teniendo en cuenta el desborde del contador (cada ~71 minutos).
+ */
+static inline bool time_reached(uint32_t now, uint32_t at) {
+    return (int32_t)(now - at) >= 0;
+}
+
+void sched_init(sched_t *s, uint32_t (*now_us)(void)) {
+    memset(s, 0, sizeof(*s));
+    s->now_us = now_us;
+    s->since_us = now_us();
+}
+
+/**
+ * Registra una tarea. La tarea no se ejecuta hasta que se despierte por primera vez.
+ * @return false si ya no hay espacio.
+ */
+bool sched_add(sched_t *s, task_t *t, const char *name, task_fn fn, void *ctx) {
+    if (s->count >= SCHED_MAX_TASKS) {
+        return false;
+    }
+    memset(t, 0, sizeof(*t));
+    t->name = name;
+    t->fn = fn;
+    t->ctx = ctx;
+    TRACE_NAME(TRACE_ID_TASK + s->count, name);
+    s->tasks[s->count++] = t;
+    return true;
+}
+
+/**
+ * Marca la tarea como lista. Puede llamarse desde una rutina de interrupción; si la tarea ya
+ * estaba lista se conserva el instante original para no ocultar latencia.
+ */
+void sched_wake(task_t *t, uint32_t now_us) {
+    if (!t->pending) {
+        t->ready_us = now_us;
+        t->pending = true;
+    }
+}
+
+/**
+ * Programa la tarea para el instante indicado. Reemplaza cualquier instante programado antes.
+ * Solo debe llamarse desde tareas, no desde interrupciones.
+ */
+void sched_wake_at(task_t *t, uint32_t at_us) {
+    t->wake_at_us = at_us;
+    t->timed = true;
+}
+
+/**
+ * Ejecuta una vez cada tarea lista, en orden de prioridad.
+ * @return Instante del próximo despertar programado, o SCHED_NO_DEADLINE si no hay ninguno.
+ *         Si alguna tarea quedó lista durante la pasada se devuelve el instante actual.
+ */
+uint32_t sched_run(sched_t *s) {
+    uint32_t now = s->now_us();
+    uint32_t next = SCHED_NO_DEADLINE;
+    bool have_next = false;
+
+    for (int i = 0; i < s->count; ++i) {
+        task_t *t = s->tasks[i];
+        uint32_t ready;
+
+        if (t->pending) {
+            ready = t->ready_us;
+            t->pending = false;
+        } else if (t->timed && time_reached(now, t->wake_at_us)) {
+            ready = t->wake_at_us;
+            t->timed = false;
+        } else {
+            continue;
+        }
+
+        uint32_t start = s->now_us();
+        TRACE_BEGIN(TRACE_ID_TASK + i);
+        t->fn(t->ctx);
+        TRACE_END(TRACE_ID_TASK + i);
+        now = s->now_us();
+
+        uint32_t run = now - start;
+        uint32_t latency = (int32_t)(start - ready) > 0 ? start - ready : 0;
+        t->runs++;
+        t->total_run_us += run;
+        t->total_latency_us += latency;
+        if (run > t->max_run_us) {
+            t->max_run_us = run;
+        }
+        if (latency > t->max_latency_us) {
+            t->max_latency_us = latency;
+        }
+        s->busy_us += run;
+    }
+
+    for (int i = 0; i < s->count; ++i) {
+        task_t *t = s->tasks[i];
+        if (t->pending) {
+            return now;
+        }
+        if (t->timed && (!have_next || (int32_t)(t->wake_at_us - next) < 0)) {
+            next = t->wake_at_us;
+            have_next = true;
+        }
+    }
+    return next;
+}
+
+/**
+ * Reinicia la ventana de estadísticas de todas las tareas.
+ */
+void sched_reset_stats(sched_t *s) {
+    for (int i = 0; i < s->count; ++i) {
+        task_t *t = s->tasks[i];
+        t->runs = 0;
+        t->total_run_us = 0;
+        t->max_run_us = 0;
+        t->total_latency_us = 0;
+        t->max_latency_us = 0;
+    }
+    s->busy_us = 0;
+    s->since_us = s->now_us();
+}
+
+/**
+ * Imprime una tabla con las estadísticas de cada tarea y la carga total del núcleo desde el
+ * último sched_reset_stats().
+ */
+void sched_print_stats(const sched_t *s, void (*out)(void *ctx, const char *text), void *ctx) {
+    char line[96];
+    uint32_t window = s->now_us() - s->since_us;
+
+    snprintf(line, sizeof(line), "%-10s %8s %10s %8s %10s %8s\n",
+             "tarea", "ejec", "prom(us)", "max(us)", "lat(us)", "lmax(us)");
+    out(ctx, line);
+    for (int i = 0; i < s->count; ++i) {
+        const task_t *t = s->tasks[i];
+        unsigned long avg_run = t->runs ? (unsigned long)(t->total_run_us / t->runs) : 0;
+        unsigned long avg_lat = t->runs ? (unsigned long)(t->total_latency_us / t->runs) : 0;
+        snprintf(line, sizeof(line), "%-10s %8lu %10lu %8lu %10lu %8lu\n",
+                 t->name, (unsigned long)t->runs, avg_run, (unsigned long)t->max_run_us,
+                 avg_lat, (unsigned long)t->max_latency_us);
+        out(ctx, line);
+    }
+    snprintf(line, sizeof(line), "carga: %lu.%02lu%% en %lu ms\n",
+             window ? (unsigned long)(s->busy_us * 100 / window) : 0,
+             window ? (unsigned long)(s->busy_us * 10000 / window % 100) : 0,
+             (unsigned long)(window / 1000));
+    out(ctx, line);
+}
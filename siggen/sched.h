@@ -0,0 +1,73 @@
+/**
+ * @file sched.h
+ *
+ * @brief Planificador cooperativo de tareas de ejecución completa (run-to-completion).
+ *
+ * Cada tarea es una función corta que se ejecuta hasta terminar y nunca bloquea. Una tarea queda
+ * lista cuando una interrupción (u otra tarea) la despierta con sched_wake() o cuando vence el
+ * instante programado con sched_wake_at(). El planificador no conoce el hardware: el llamador le
+ * entrega el reloj y decide cómo dormir (WFE en la Pico, nada en el simulador) hasta el instante
+ * que devuelve sched_run().
+ *
+ * Por cada tarea se registran el número de ejecuciones, el tiempo de ejecución (total y máximo)
+ * y la latencia de despertar (desde que quedó lista hasta que empezó a ejecutarse).
+ */
+
+#ifndef SIGGEN_SCHED_H
+#define SIGGEN_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS 8 ///< Cantidad máxima de tareas registradas
+#define SCHED_NO_DEADLINE UINT32_MAX ///< Valor de sched_run() cuando ninguna tarea tiene instante programado
+
+typedef void (*task_fn)(void *ctx);
+
+/**
+ * Tarea registrada en el planificador. Los campos de estadísticas son de solo lectura para el
+ * resto del programa.
+ */
+typedef struct {
+    const char *name; ///< Nombre corto para los reportes
+    task_fn fn; ///< Función de la tarea
+    void *ctx; ///< Contexto para fn
+
+    volatile bool pending; ///< Despertada por un evento
+    volatile uint32_t ready_us; ///< Instante en que quedó lista por evento
+    bool timed; ///< Tiene un instante de despertar programado
+    uint32_t wake_at_us; ///< Instante de despertar programado
+
+    uint32_t runs; ///< Cantidad de ejecuciones
+    uint64_t total_run_us; ///< Tiempo total de ejecución
+    uint32_t max_run_us; ///< Tiempo máximo de una ejecución
+    uint64_t total_latency_us; ///< Suma de latencias de despertar
+    uint32_t max_latency_us; ///< Latencia máxima de despertar
+} task_t;
+
+/**
+ * Planificador. Las tareas se revisan en el orden en que se registraron, que es su prioridad.
+ */
+typedef struct {
+    task_t *tasks[SCHED_MAX_TASKS]; ///< Tareas registradas
+    int count; ///< Cantidad de tareas registradas
+    uint32_t (*now_us)(void); ///< Reloj en microsegundos
+    uint64_t busy_us; ///< Tiempo total ejecutando tareas
+    uint32_t since_us; ///< Inicio de la ventana de estadísticas
+} sched_t;
+
+void sched_init(sched_t *s, uint32_t (*now_us)(void));
+
+bool sched_add(sched_t *s, task_t *t, const char *name, task_fn fn, void *ctx);
+
+void sched_wake(task_t *t, uint32_t now_us);
+
+void sched_wake_at(task_t *t, uint32_t at_us);
+
+uint32_t sched_run(sched_t *s);
+
+void sched_reset_stats(sched_t *s);
+
+void sched_print_stats(const sched_t *s, void (*out)(void *ctx, const char *text), void *ctx);
+
+#endif
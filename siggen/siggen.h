@@ -0,0 +1,36 @@
+/**
+ * @file siggen.h
+ *
+ * @brief Encabezado único de la biblioteca siggen para Arduino.
+ *
+ * La carpeta siggen/ es a la vez el núcleo portable del firmware de la Pico (CMakeLists.txt), de
+ * las herramientas de la máquina anfitriona (host/Makefile) y una biblioteca de Arduino con el
+ * formato plano: library.properties en la raíz y los ejemplos en examples/. El IDE compila todos
+ * los .c de la carpeta, así que no hay copias de las fuentes. Los bocetos, que son C++, incluyen
+ * este encabezado para obtener el enlace de C.
+ */
+
+#ifndef SIGGEN_H
+#define SIGGEN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bulk_proto.h"
+#include "engine.h"
+#include "fixdec.h"
+#include "interp_chain.h"
+#include "lat_hist.h"
+#include "par_out.h"
+#include "polyphase.h"
+#include "rate_match.h"
+#include "synth.h"
+#include "wavepack.h"
+#include "wave_import.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * @file synth.c
+ *
+ * @brief Núcleos de síntesis por bloques. Cada forma de onda tiene su propio bucle para que la
+ * selección se haga una vez por bloque y no una vez por muestra.
+ */
+
+#include "synth.h"
+#include "platform.h"
+#include <string.h>
+
+/**
+ * Un periodo del seno en Q15 (256 muestras). No es const para que pueda ubicarse en SRAM.
+ */
+static int16_t SIGGEN_HOT_DATA("synth") sine_q15[256] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739,
+    9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+    25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+    32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285,
+    32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268,
+    28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+    23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151,
+    15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179,
+    6393, 5602, 4808, 4011, 3212, 2410, 1608, 804, 0, -804, -1608, -2410,
+    -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159,
+    -20787, -21403, -22005, -22594, -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956, -30273, -30571, -30852, -31113,
+    -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580,
+    -31356, -31113, -30852, -30571, -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731, -23170, -22594, -22005, -21403,
+    -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+    -3212, -2410, -1608, -804
+};
+
+void synth_init(synth_t *s, uint32_t sample_rate) {
+    memset(s, 0, sizeof(*s));
+    s->sample_rate = sample_rate;
+    s->waveform = SINE;
+}
+
+/**
+ * Recalcula el incremento de fase y la escala del DAC. La frecuencia se limita a la mitad de la
+ * frecuencia de muestreo y la amplitud y el desplazamiento al doble del rango del DAC, lo que
+ * garantiza que los productos de synth_render() caben en 32 bits.
+ *
+ * @param amplitude_uv  Amplitud pico a pico (uV).
+ * @param dc_offset_uv  Desplazamiento DC (uV).
+ * @param frequency_millihz Frecuencia (mHz).
+ */
+void synth_set(synth_t *s, Waveform waveform, int32_t amplitude_uv, int32_t dc_offset_uv, uint64_t frequency_millihz) {
+    uint64_t nyquist_millihz = (uint64_t)s->sample_rate * 500;
+
+    if (frequency_millihz > nyquist_millihz) {
+        frequency_millihz = nyquist_millihz;
+    }
+    if (amplitude_uv < 0) {
+        amplitude_uv = 0;
+    } else if (amplitude_uv > 2 * VREF_UV) {
+        amplitude_uv = 2 * VREF_UV;
+    }
+    if (dc_offset_uv < -2 * VREF_UV) {
+        dc_offset_uv = -2 * VREF_UV;
+    } else if (dc_offset_uv > 2 * VREF_UV) {
+        dc_offset_uv = 2 * VREF_UV;
+    }
+
+    // Parte entera y fraccionaria por separado para no desbordar 64 bits
+    uint64_t hz = frequency_millihz / 1000, millihz = frequency_millihz % 1000;
+    uint64_t inc = (hz << 32) / s->sample_rate + (millihz << 32) / ((uint64_t)s->sample_rate * 1000);
+
+    s->waveform = waveform;
+    s->phase_inc = inc > UINT32_MAX ? UINT32_MAX : (uint32_t)inc;
+    s->offset_q8 = (int32_t)((int64_t)dc_offset_uv * DAC_MAX_VALUE * 256 / VREF_UV);
+    s->gain_q8 = (int32_t)((int64_t)amplitude_uv / 2 * DAC_MAX_VALUE * 256 / VREF_UV);
+}
+
+/**
+ * Convierte un valor de forma de onda en Q15 a código del DAC, con saturación.
+ */
+static inline uint8_t to_dac(const synth_t *s, int32_t w) {
+    int32_t code = (s->offset_q8 + ((w * s->gain_q8) >> 15) + 128) >> 8;
+    return code < 0 ? 0 : code > DAC_MAX_VALUE ? DAC_MAX_VALUE : (uint8_t)code;
+}
+
+/**
+ * Genera n muestras consecutivas en out y deja la fase lista para el siguiente bloque.
+ */
+void SIGGEN_HOT(synth_render)(synth_t *s, uint8_t *out, size_t n) {
+    uint32_t phase = s->phase, inc = s->phase_inc;
+
+    switch (s->waveform) {
+        case SINE:
+            for (size_t i = 0; i < n; ++i, phase += inc) {
+                out[i] = to_dac(s, sine_q15[phase >> 24]);
+            }
+            break;
+        case SQUARE:
+            for (size_t i = 0; i < n; ++i, phase += inc) {
+                out[i] = to_dac(s, phase < 0x80000000u ? 32767 : -32767);
+            }
+            break;
+        case SAWTOOTH:
+            for (size_t i = 0; i < n; ++i, phase += inc) {
+                out[i] = to_dac(s, (int32_t)(phase >> 16) - 32768);
+            }
+            break;
+        case TRIANGULAR:
+            for (size_t i = 0; i < n; ++i, phase += inc) {
+                int32_t t = (int32_t)(phase >> 15);
+                out[i] = to_dac(s, t < 65536 ? t - 32768 : 98303 - t);
+            }
+            break;
+    }
+    s->phase = phase;
+}
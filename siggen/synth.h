@@ -0,0 +1,40 @@
+/**
+ * @file synth.h
+ *
+ * @brief Síntesis digital directa (DDS) por bloques en punto fijo.
+ *
+ * Un acumulador de fase de 32 bits avanza phase_inc por muestra; la forma de onda se calcula a
+ * partir de la fase (tabla de 256 entradas para el seno, aritmética entera para las demás) y se
+ * escala a códigos del DAC de 8 bits. Todas las formas de onda quedan centradas en el
+ * desplazamiento DC, con la amplitud como valor pico a pico.
+ */
+
+#ifndef SIGGEN_SYNTH_H
+#define SIGGEN_SYNTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"
+
+#define DAC_MAX_VALUE 255 ///< Valor máximo de amplitud a convertir por el DAC de 8 bits (2^8 - 1)
+#define VREF_UV 3300000 ///< Voltaje de referencia para el DAC de 8 bits (uV)
+
+/**
+ * Estado de un oscilador. Los campos derivados se recalculan en synth_set().
+ */
+typedef struct {
+    uint32_t sample_rate; ///< Frecuencia de muestreo (Hz)
+    Waveform waveform; ///< Forma de onda
+    uint32_t phase; ///< Acumulador de fase; 2^32 equivale a un periodo
+    uint32_t phase_inc; ///< Incremento de fase por muestra
+    int32_t offset_q8; ///< Código del DAC para el desplazamiento DC, en Q8
+    int32_t gain_q8; ///< Código del DAC para media amplitud, en Q8
+} synth_t;
+
+void synth_init(synth_t *s, uint32_t sample_rate);
+
+void synth_set(synth_t *s, Waveform waveform, int32_t amplitude_uv, int32_t dc_offset_uv, uint64_t frequency_millihz);
+
+void synth_render(synth_t *s, uint8_t *out, size_t n);
+
+#endif
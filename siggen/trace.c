@@ -0,0 +1,116 @@
+/**
+ * @file trace.c
+ *
+ * @brief Control y volcado de los anillos de traza. Sin SIGGEN_TRACE las funciones no hacen nada.
+ */
+
+#include "trace.h"
+#include "arena.h"
+#include <stdio.h>
+
+#if SIGGEN_TRACE
+
+ARENA_DEFINE(arena_trace, "trace", TRACE_CORES * sizeof(trace_ring_t), 4);
+
+trace_ring_t *trace_rings; ///< Un anillo por núcleo, tomados de arena_trace en el primer trace_start()
+volatile bool trace_on;
+
+static const char *trace_names[TRACE_MAX_IDS] = {
+    [TRACE_ID_RENDER] = "render",
+    [TRACE_ID_DMA_IRQ] = "dma_irq",
+    [TRACE_ID_REFILL] = "refill",
+    [TRACE_ID_FREE_BLOCKS] = "bloques_libres",
+    [TRACE_ID_GPIO_IRQ] = "gpio_irq",
+    [TRACE_ID_INPUT_QUEUE] = "cola_entrada",
+    [TRACE_ID_ENGINE_INPUT] = "motor_entrada",
+};
+
+/**
+ * Vacía los anillos y empieza a registrar. El tiempo detenido no se acumula en el reloj extendido.
+ * La primera llamada toma los anillos de arena_trace, así que debe hacerse durante el arranque;
+ * después de arena_seal() la traza queda sin anillos y no registra nada.
+ */
+void trace_start(void) {
+    trace_on = false;
+    if (!trace_rings) {
+        trace_rings = arena_alloc(&arena_trace, TRACE_CORES * sizeof(trace_ring_t), 4);
+        if (!trace_rings) {
+            return;
+        }
+    }
+    for (int c = 0; c < TRACE_CORES; ++c) {
+        trace_rings[c].head = 0;
+        trace_rings[c].resync = true;
+    }
+    trace_on = true;
+}
+
+void trace_stop(void) {
+    trace_on = false;
+}
+
+/**
+ * Da nombre a un identificador, para los identificadores que se asignan en ejecución (tareas).
+ */
+void trace_set_name(unsigned id, const char *name) {
+    if (id < TRACE_MAX_IDS) {
+        trace_names[id] = name;
+    }
+}
+
+/**
+ * Escribe la traza, del evento más antiguo al más nuevo de cada núcleo. Debe llamarse con la
+ * traza detenida (trace_stop()).
+ * @param clock_hz Frecuencia del reloj de las marcas de tiempo.
+ */
+void trace_dump(uint32_t clock_hz, void (*out)(void *ctx, const char *text), void *ctx) {
+    static const char phases[] = {'B', 'E', 'C', 'i'};
+    char line[64];
+
+    snprintf(line, sizeof(line), "@TRH,%lu\n", (unsigned long)clock_hz);
+    out(ctx, line);
+    for (unsigned id = 0; id < TRACE_MAX_IDS; ++id) {
+        if (trace_names[id]) {
+            snprintf(line, sizeof(line), "@TRN,%u,%s\n", id, trace_names[id]);
+            out(ctx, line);
+        }
+    }
+    for (int c = 0; trace_rings && c < TRACE_CORES; ++c) {
+        const trace_ring_t *r = &trace_rings[c];
+        uint32_t first = r->head > TRACE_RING_LEN ? r->head - TRACE_RING_LEN : 0;
+
+        if (!r->head) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "@TRA,%d,%lu,%lu\n", c, (unsigned long)r->anchor_cycles,
+                 (unsigned long)r->anchor_us);
+        out(ctx, line);
+        for (uint32_t i = first; i < r->head; ++i) {
+            const trace_event_t *e = &r->events[i & (TRACE_RING_LEN - 1)];
+            snprintf(line, sizeof(line), "@TR,%d,%c,%lu,%lu,%lu\n", c, phases[e->meta >> 30],
+                     (unsigned long)((e->meta >> 24) & 0x3F), (unsigned long)e->ts,
+                     (unsigned long)(e->meta & 0xFFFFFF));
+            out(ctx, line);
+        }
+    }
+}
+
+#else
+
+void trace_start(void) {
+}
+
+void trace_stop(void) {
+}
+
+void trace_set_name(unsigned id, const char *name) {
+    (void)id;
+    (void)name;
+}
+
+void trace_dump(uint32_t clock_hz, void (*out)(void *ctx, const char *text), void *ctx) {
+    (void)clock_hz;
+    out(ctx, "Traza no disponible: compilar con SIGGEN_TRACE=1.\n");
+}
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file trace.h
+ *
+ * @brief Puntos de traza (inicio, fin, contador e instante) en un búfer circular por núcleo.
+ *
+ * Con SIGGEN_TRACE=1 cada punto de traza guarda un evento de 8 bytes (marca de tiempo y
+ * descriptor) en el anillo del núcleo que lo ejecuta, con las interrupciones deshabilitadas
+ * durante unas pocas instrucciones. Sin SIGGEN_TRACE las macros no generan código.
+ *
+ * El reloj, el número de núcleo y la sección crítica los entrega cada plataforma en
+ * trace_port.h (la Pico en la raíz del proyecto, la máquina anfitriona en host/):
+ *  - trace_port_clock(): contador ascendente de TRACE_PORT_CLOCK_MASK bits. Cada anillo lo
+ *    extiende a 32 bits acumulando diferencias, así que entre dos eventos del mismo núcleo no
+ *    puede pasar más de una vuelta del contador (en la Pico, 2^24 ciclos: 134 ms a 125 MHz).
+ *  - trace_port_time_us(): reloj común a los núcleos. Con él se toma un ancla (ciclos, uS) en el
+ *    primer evento de cada vuelta del anillo, que sirve para alinear los núcleos al convertir la
+ *    traza.
+ *  - trace_port_core(), trace_port_lock(), trace_port_unlock().
+ *
+ * trace_dump() escribe la traza como líneas de texto (`@TRH`, `@TRN`, `@TRA`, `@TR`) que
+ * tools/trace_to_chrome.py convierte al formato JSON de Chrome y Perfetto.
+ */
+
+#ifndef SIGGEN_TRACE_H
+#define SIGGEN_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef SIGGEN_TRACE
+#define SIGGEN_TRACE 0 ///< Si es 1, los puntos de traza registran eventos
+#endif
+
+#define TRACE_CORES 2 ///< Anillos, uno por núcleo
+#define TRACE_RING_LEN 512 ///< Eventos por anillo (potencia de 2)
+#define TRACE_MAX_IDS 64 ///< Identificadores de traza posibles
+
+/**
+ * Identificadores fijos. Los de las tareas del planificador son TRACE_ID_TASK + índice.
+ */
+enum {
+    TRACE_ID_RENDER, ///< Síntesis de un bloque en el núcleo 1
+    TRACE_ID_DMA_IRQ, ///< Interrupción de fin de bloque del DMA
+    TRACE_ID_REFILL, ///< Relleno de un bloque desde la interrupción
+    TRACE_ID_FREE_BLOCKS, ///< Contador: bloques libres de la salida
+    TRACE_ID_GPIO_IRQ, ///< Interrupción de GPIO
+    TRACE_ID_INPUT_QUEUE, ///< Contador: eventos en la cola de entrada
+    TRACE_ID_ENGINE_INPUT, ///< Evento de entrada procesado por el motor
+    TRACE_ID_TASK = 16, ///< Primera tarea del planificador
+};
+
+/**
+ * Fases de un evento, con los nombres del formato de Chrome.
+ */
+enum {
+    TRACE_PH_BEGIN, ///< 'B'
+    TRACE_PH_END, ///< 'E'
+    TRACE_PH_COUNTER, ///< 'C'; el valor va en los 24 bits bajos
+    TRACE_PH_INSTANT, ///< 'i'
+};
+
+/**
+ * Descriptor de un evento: fase (2 bits), identificador (6 bits) y valor (24 bits).
+ */
+#define TRACE_META(ph, id, value) (((uint32_t)(ph) << 30) | ((uint32_t)(id) << 24) | ((uint32_t)(value) & 0xFFFFFF))
+
+typedef struct {
+    uint32_t ts; ///< Marca de tiempo extendida a 32 bits, en ciclos del reloj de la plataforma
+    uint32_t meta; ///< TRACE_META()
+} trace_event_t;
+
+/**
+ * Anillo de un núcleo.
+ */
+typedef struct {
+    trace_event_t events[TRACE_RING_LEN]; ///< Eventos; el más antiguo se sobrescribe
+    uint32_t head; ///< Eventos escritos desde trace_start()
+    uint32_t last; ///< Última lectura de trace_port_clock()
+    uint32_t cycles; ///< Reloj extendido a 32 bits
+    bool resync; ///< El próximo evento no acumula la diferencia (el reloj estuvo detenido)
+    uint32_t anchor_cycles; ///< Reloj extendido en el ancla
+    uint32_t anchor_us; ///< trace_port_time_us() en el ancla
+} trace_ring_t;
+
+void trace_start(void);
+
+void trace_stop(void);
+
+void trace_set_name(unsigned id, const char *name);
+
+void trace_dump(uint32_t clock_hz, void (*out)(void *ctx, const char *text), void *ctx);
+
+#if SIGGEN_TRACE
+
+#include "trace_port.h"
+
+extern trace_ring_t *trace_rings;
+extern volatile bool trace_on;
+
+/**
+ * Guarda un evento en el anillo del núcleo que llama. Puede llamarse desde interrupciones.
+ */
+static inline void trace_record(uint32_t meta) {
+    if (!trace_on) {
+        return;
+    }
+    uint32_t key = trace_port_lock();
+    trace_ring_t *r = &trace_rings[trace_port_core()];
+    uint32_t now = trace_port_clock();
+
+    if (r->resync) {
+        r->resync = false;
+    } else {
+        r->cycles += (now - r->last) & TRACE_PORT_CLOCK_MASK;
+    }
+    r->last = now;
+    if (!(r->head & (TRACE_RING_LEN - 1))) {
+        r->anchor_cycles = r->cycles;
+        r->anchor_us = trace_port_time_us();
+    }
+    trace_event_t *e = &r->events[r->head++ & (TRACE_RING_LEN - 1)];
+    e->ts = r->cycles;
+    e->meta = meta;
+    trace_port_unlock(key);
+}
+
+#define TRACE_BEGIN(id) trace_record(TRACE_META(TRACE_PH_BEGIN, (id), 0))
+#define TRACE_END(id) trace_record(TRACE_META(TRACE_PH_END, (id), 0))
+#define TRACE_COUNTER(id, value) trace_record(TRACE_META(TRACE_PH_COUNTER, (id), (value)))
+#define TRACE_INSTANT(id) trace_record(TRACE_META(TRACE_PH_INSTANT, (id), 0))
+#define TRACE_NAME(id, name) trace_set_name((id), (name))
+
+#else
+
+#define TRACE_BEGIN(id) ((void)0)
+#define TRACE_END(id) ((void)0)
+#define TRACE_COUNTER(id, value) ((void)0)
+#define TRACE_INSTANT(id) ((void)0)
+#define TRACE_NAME(id, name) ((void)0)
+
+#endif
+
+#endif
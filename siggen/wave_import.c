@@ -0,0 +1,494 @@
+/**
+ * @file wave_import.c
+ *
+ * @brief Conversión en flujo de CSV y WAV a códigos del DAC.
+ *
+ * Los números del CSV se leen dígito a dígito como mantisa entera y potencia de 10, y se pasan a
+ * Q24 (24 bits de fracción) con aritmética entera; los flotantes de un WAV se pasan a Q24 desde sus
+ * bits. Así no entra la biblioteca de punto flotante por software en la Pico.
+ */
+
+#include "wave_import.h"
+#include <string.h>
+
+#define Q24_ONE ((int64_t)1 << 24) ///< 1.0 en Q24
+#define Q24_LIMIT ((int64_t)1 << 40) ///< Magnitud a partir de la cual un valor se satura
+#define MANTISSA_DIGITS 9 ///< Dígitos significativos que se conservan (caben en 32 bits)
+#define EXPONENT_LIMIT 1000 ///< Exponente a partir del cual se satura
+
+/**
+ * Etapas del número del campo en curso.
+ */
+enum {
+    NUM_START, ///< Espacios antes del número; el campo está vacío
+    NUM_SIGN, ///< Después del signo
+    NUM_INT, ///< Parte entera
+    NUM_POINT, ///< Punto decimal sin dígitos antes
+    NUM_FRAC, ///< Parte decimal
+    NUM_EXP, ///< Después de la 'e'
+    NUM_EXP_SIGN, ///< Después del signo del exponente
+    NUM_EXP_DIGITS, ///< Dígitos del exponente
+    NUM_DONE, ///< Espacios después de un número válido
+    NUM_BAD, ///< El campo no es un número
+};
+
+/**
+ * Etapas del RIFF.
+ */
+enum {
+    RIFF_HEADER, ///< "RIFF", tamaño y "WAVE"
+    RIFF_CHUNK, ///< Encabezado de un bloque: identificador y tamaño
+    RIFF_FMT, ///< Contenido del bloque "fmt "
+    RIFF_SKIP, ///< Bloque que no interesa
+    RIFF_DATA, ///< Muestras
+};
+
+static inline uint32_t le16(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8;
+}
+
+static inline uint32_t le32(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * Reconoce el formato por el principio del archivo (idealmente WAVE_IMPORT_DETECT_LEN bytes). Un
+ * CSV es texto sin caracteres de control, con al menos un dígito, hasta el primer byte nulo.
+ */
+wave_import_format_t wave_import_detect(const uint8_t *head, size_t len) {
+    bool digit = false, semicolon = false;
+
+    if (len >= 12 && !memcmp(head, "RIFF", 4) && !memcmp(head + 8, "WAVE", 4)) {
+        return WAVE_IMPORT_WAV;
+    }
+    for (size_t i = 0; i < len && head[i]; ++i) {
+        uint8_t c = head[i];
+        if (c < 0x20 && c != '\t' && c != '\r' && c != '\n') {
+            return WAVE_IMPORT_NONE;
+        }
+        digit |= c >= '0' && c <= '9';
+        semicolon |= c == ';';
+    }
+    if (!digit) {
+        return WAVE_IMPORT_NONE;
+    }
+    return semicolon ? WAVE_IMPORT_CSV_SEMICOLON : WAVE_IMPORT_CSV;
+}
+
+/**
+ * Prepara una conversión.
+ * @param format Formato, de wave_import_detect().
+ * @param codes  Los valores del CSV son códigos de 0 a 255 en lugar de valores de -1 a 1.
+ * @param sink   Recibe los códigos, de a WAVE_IMPORT_OUT_LEN como máximo.
+ */
+void wave_import_init(wave_import_t *p, wave_import_format_t format, bool codes, wave_import_sink_fn sink, void *ctx) {
+    memset(p, 0, sizeof(*p));
+    p->format = format;
+    p->codes = codes;
+    p->sink = sink;
+    p->ctx = ctx;
+    p->column = WAVE_IMPORT_LAST;
+    p->status = format == WAVE_IMPORT_NONE ? WAVE_IMPORT_ERR_FORMAT : WAVE_IMPORT_RUNNING;
+}
+
+/**
+ * Elige el campo del CSV o el canal del WAV que se convierte. Se llama después de
+ * wave_import_init() y antes del primer trozo.
+ * @param column Desde 0, o WAVE_IMPORT_LAST para el último campo y el primer canal.
+ */
+void wave_import_set_column(wave_import_t *p, int column) {
+    p->column = (int16_t)(column < 0 || column > INT16_MAX ? WAVE_IMPORT_LAST : column);
+}
+
+static void flush(wave_import_t *p) {
+    if (p->out_len) {
+        p->sink(p->ctx, p->out, p->out_len);
+        p->samples += p->out_len;
+        p->out_len = 0;
+    }
+}
+
+static inline void put(wave_import_t *p, uint8_t code) {
+    p->out[p->out_len++] = code;
+    if (p->out_len == WAVE_IMPORT_OUT_LEN) {
+        flush(p);
+    }
+}
+
+/**
+ * Código del DAC para un valor en Q24: de -1 a 1 a todo el rango, o un código con codes. Se
+ * redondea al más cercano.
+ */
+static inline uint8_t q24_to_code(int64_t value, bool codes) {
+    if (codes) {
+        value = (value + Q24_ONE / 2) >> 24;
+        return value <= 0 ? 0 : value >= 255 ? 255 : (uint8_t)value;
+    }
+    if (value <= -Q24_ONE) {
+        return 0;
+    }
+    if (value >= Q24_ONE) {
+        return 255;
+    }
+    return (uint8_t)(((value + Q24_ONE) * 255 + Q24_ONE) >> 25);
+}
+
+/**
+ * Valor en Q24 del número del campo en curso.
+ */
+static int64_t field_value(const wave_import_t *p) {
+    int64_t value = (int64_t)p->mantissa << 24;
+    int32_t e10 = p->scale + (p->exp_negative ? -p->exponent : p->exponent);
+
+    for (; e10 > 0 && value; --e10) {
+        value *= 10;
+        if (value >= Q24_LIMIT) {
+            value = Q24_LIMIT;
+            break;
+        }
+    }
+    if (e10 < 0) {
+        int64_t div = 1;
+        for (; e10 < 0 && div <= INT64_MAX / 100; ++e10) {
+            div *= 10;
+        }
+        value = e10 < 0 ? 0 : (value + div / 2) / div;
+    }
+    return p->negative ? -value : value;
+}
+
+static void end_field(wave_import_t *p) {
+    uint8_t num = p->num;
+
+    if (p->column == WAVE_IMPORT_LAST) {
+        if (num == NUM_INT || num == NUM_FRAC || num == NUM_EXP_DIGITS || num == NUM_DONE) {
+            p->line_valid = true;
+            p->line_value = field_value(p);
+        } else if (num != NUM_START) {
+            p->line_valid = false;
+        }
+    } else if (p->field == p->column) {
+        p->line_valid = num == NUM_INT || num == NUM_FRAC || num == NUM_EXP_DIGITS || num == NUM_DONE;
+        p->line_value = p->line_valid ? field_value(p) : 0;
+    }
+    // Un campo vacío no cambia el último valor de la línea
+    p->line_text |= num != NUM_START;
+    p->field += p->field < UINT16_MAX;
+    p->num = NUM_START;
+    p->negative = false;
+    p->exp_negative = false;
+    p->digits = 0;
+    p->mantissa = 0;
+    p->scale = 0;
+    p->exponent = 0;
+}
+
+static void end_line(wave_import_t *p) {
+    end_field(p);
+    if (p->line_valid) {
+        put(p, q24_to_code(p->line_value, p->codes));
+    } else if (p->line_text) {
+        p->skipped++;
+    }
+    p->line_valid = false;
+    p->line_text = false;
+    p->field = 0;
+}
+
+static inline void mantissa_digit(wave_import_t *p, unsigned d, bool fraction) {
+    if (p->digits < MANTISSA_DIGITS) {
+        p->mantissa = p->mantissa * 10 + d;
+        p->scale -= fraction;
+        // Los ceros a la izquierda no ocupan dígitos significativos
+        p->digits += p->mantissa != 0;
+    } else if (!fraction) {
+        p->scale++;
+    }
+}
+
+/**
+ * Avanza el número del campo en curso con un carácter que no separa campos ni líneas.
+ */
+static void number_char(wave_import_t *p, uint8_t c) {
+    bool point = c == '.' || (c == ',' && p->format == WAVE_IMPORT_CSV_SEMICOLON);
+    bool digit = c >= '0' && c <= '9';
+    bool space = c == ' ' || c == '\r' || c == '"';
+
+    switch (p->num) {
+        case NUM_START:
+            if (space) {
+                break;
+            }
+            if (c == '-' || c == '+') {
+                p->negative = c == '-';
+                p->num = NUM_SIGN;
+            } else if (digit) {
+                mantissa_digit(p, c - '0', false);
+                p->num = NUM_INT;
+            } else {
+                p->num = point ? NUM_POINT : NUM_BAD;
+            }
+            break;
+        case NUM_SIGN:
+            if (digit) {
+                mantissa_digit(p, c - '0', false);
+                p->num = NUM_INT;
+            } else {
+                p->num = point ? NUM_POINT : NUM_BAD;
+            }
+            break;
+        case NUM_INT:
+        case NUM_POINT:
+        case NUM_FRAC:
+            if (digit) {
+                mantissa_digit(p, c - '0', p->num != NUM_INT);
+                p->num = p->num == NUM_INT ? NUM_INT : NUM_FRAC;
+            } else if (point && p->num == NUM_INT) {
+                p->num = NUM_FRAC;
+            } else if ((c == 'e' || c == 'E') && p->num != NUM_POINT) {
+                p->num = NUM_EXP;
+            } else {
+                p->num = space && p->num != NUM_POINT ? NUM_DONE : NUM_BAD;
+            }
+            break;
+        case NUM_EXP:
+            if (c == '-' || c == '+') {
+                p->exp_negative = c == '-';
+                p->num = NUM_EXP_SIGN;
+                break;
+            }
+            // fall through
+        case NUM_EXP_SIGN:
+        case NUM_EXP_DIGITS:
+            if (digit) {
+                p->exponent = p->exponent < EXPONENT_LIMIT ? p->exponent * 10 + (c - '0') : EXPONENT_LIMIT;
+                p->num = NUM_EXP_DIGITS;
+            } else {
+                p->num = space && p->num == NUM_EXP_DIGITS ? NUM_DONE : NUM_BAD;
+            }
+            break;
+        case NUM_DONE:
+            p->num = space ? NUM_DONE : NUM_BAD;
+            break;
+        default: break;
+    }
+}
+
+static void csv_feed(wave_import_t *p, const uint8_t *data, size_t len) {
+    uint8_t separator = p->format == WAVE_IMPORT_CSV_SEMICOLON ? ';' : ',';
+
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t c = data[i];
+        if (c == '\n') {
+            end_line(p);
+        } else if (c == separator || c == '\t') {
+            end_field(p);
+        } else if (!c) {
+            end_line(p);
+            p->status = WAVE_IMPORT_END;
+            return;
+        } else {
+            number_char(p, c);
+        }
+    }
+}
+
+/**
+ * Valor en Q24 de un flotante IEEE 754 de 32 bits dado por sus bits.
+ */
+static int64_t float_to_q24(uint32_t bits) {
+    int32_t exp = (int32_t)((bits >> 23) & 0xFF);
+    int64_t mant = (bits & 0x7FFFFF) | 0x800000;
+
+    // valor = mant * 2^(exp - 150), y en Q24 se multiplica por 2^24
+    int32_t shift = exp - 126;
+    int64_t value = exp == 0 ? 0 : shift >= 17 ? Q24_LIMIT : shift >= 0 ? mant << shift : shift > -25 ? (mant + ((int64_t)1 << (-shift - 1))) >> -shift : 0;
+    return bits & 0x80000000u ? -value : value;
+}
+
+static inline uint8_t wav_code(const wave_import_t *p, const uint8_t *frame) {
+    frame += p->column == WAVE_IMPORT_LAST ? 0 : p->column * (p->bits / 8);
+    switch (p->bits) {
+        case 8: return frame[0];
+        case 16: return (uint8_t)(frame[1] ^ 0x80);
+        case 24: return (uint8_t)(frame[2] ^ 0x80);
+        default: return p->wav_format == 3 ? q24_to_code(float_to_q24(le32(frame)), false) : (uint8_t)(frame[3] ^ 0x80);
+    }
+}
+
+/**
+ * Lee el bloque "fmt ", ya guardado en hdr, y decide si el WAV se puede convertir. block queda en
+ * 0 si no.
+ */
+static bool wav_format_ok(wave_import_t *p) {
+    const uint8_t *h = p->hdr;
+
+    if (p->hdr_len < 16) {
+        return false;
+    }
+    p->wav_format = (uint16_t)le16(h);
+    p->channels = (uint16_t)le16(h + 2);
+    p->sample_rate = le32(h + 4);
+    p->block = (uint16_t)le16(h + 12);
+    p->bits = (uint16_t)le16(h + 14);
+    // WAVE_FORMAT_EXTENSIBLE: el formato real son los dos primeros bytes del subformato
+    if (p->wav_format == 0xFFFE && p->hdr_len >= 26) {
+        p->wav_format = (uint16_t)le16(h + 24);
+    }
+    bool pcm = p->wav_format == 1 && (p->bits == 8 || p->bits == 16 || p->bits == 24 || p->bits == 32);
+    bool flt = p->wav_format == 3 && p->bits == 32;
+    if (!(pcm || flt) || !p->channels || p->block != p->channels * (p->bits / 8) || p->block > WAVE_IMPORT_FRAME_MAX ||
+        p->column >= (int)p->channels) {
+        p->block = 0;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Junta bytes en hdr hasta tener want.
+ * @return Bytes consumidos.
+ */
+static size_t collect(wave_import_t *p, const uint8_t *data, size_t len, uint32_t want) {
+    size_t take = want - p->hdr_len < len ? want - p->hdr_len : len;
+
+    memcpy(p->hdr + p->hdr_len, data, take);
+    p->hdr_len += (uint32_t)take;
+    return take;
+}
+
+/**
+ * Convierte los cuadros de la carga "data" que haya en data.
+ * @return Bytes consumidos.
+ */
+static size_t wav_data(wave_import_t *p, const uint8_t *data, size_t len) {
+    size_t avail = p->left != UINT32_MAX && p->left < len ? p->left : len;
+    size_t done = 0;
+    uint32_t block = p->block;
+
+    // Cuadro partido entre el trozo anterior y este
+    while (p->frame_len && done < avail) {
+        p->frame[p->frame_len++] = data[done++];
+        if (p->frame_len == block) {
+            put(p, wav_code(p, p->frame));
+            p->frame_len = 0;
+        }
+    }
+    for (; avail - done >= block; done += block) {
+        put(p, wav_code(p, data + done));
+    }
+    while (done < avail) {
+        p->frame[p->frame_len++] = data[done++];
+    }
+    if (p->left != UINT32_MAX) {
+        p->left -= (uint32_t)avail;
+        if (!p->left) {
+            p->status = WAVE_IMPORT_END;
+        }
+    }
+    return avail;
+}
+
+static void wav_feed(wave_import_t *p, const uint8_t *data, size_t len) {
+    while (len && p->status == WAVE_IMPORT_RUNNING) {
+        size_t used = 0;
+
+        switch (p->riff) {
+            case RIFF_HEADER:
+                used = collect(p, data, len, 12);
+                if (p->hdr_len == 12) {
+                    if (memcmp(p->hdr, "RIFF", 4) || memcmp(p->hdr + 8, "WAVE", 4)) {
+                        p->status = WAVE_IMPORT_ERR_FORMAT;
+                    }
+                    p->hdr_len = 0;
+                    p->riff = RIFF_CHUNK;
+                }
+                break;
+            case RIFF_CHUNK:
+                used = collect(p, data, len, 8);
+                if (p->hdr_len == 8) {
+                    uint32_t size = le32(p->hdr + 4);
+                    p->hdr_len = 0;
+                    if (!memcmp(p->hdr, "data", 4)) {
+                        // Sin un "fmt " válido antes no se sabe leer las muestras
+                        if (!p->block) {
+                            p->status = WAVE_IMPORT_ERR_FORMAT;
+                        }
+                        // Los WAV grabados en vivo suelen dejar el tamaño en 0 o en 0xFFFFFFFF
+                        p->left = size ? size : UINT32_MAX;
+                        p->riff = RIFF_DATA;
+                    } else {
+                        // Los bloques tienen largo par
+                        p->left = size + (size & 1);
+                        p->riff = memcmp(p->hdr, "fmt ", 4) ? RIFF_SKIP : RIFF_FMT;
+                    }
+                }
+                break;
+            case RIFF_FMT:
+            case RIFF_SKIP:
+                used = p->left < len ? p->left : len;
+                if (p->riff == RIFF_FMT && p->hdr_len < sizeof(p->hdr)) {
+                    collect(p, data, used, sizeof(p->hdr));
+                }
+                p->left -= (uint32_t)used;
+                if (!p->left) {
+                    if (p->riff == RIFF_FMT && !wav_format_ok(p)) {
+                        p->status = WAVE_IMPORT_ERR_FORMAT;
+                    }
+                    p->hdr_len = 0;
+                    p->riff = RIFF_CHUNK;
+                }
+                break;
+            default: used = wav_data(p, data, len); break;
+        }
+        data += used;
+        len -= used;
+    }
+}
+
+/**
+ * Convierte el próximo trozo del archivo.
+ * @return Estado; después de WAVE_IMPORT_END o de un error el resto del archivo se ignora.
+ */
+wave_import_status_t wave_import_feed(wave_import_t *p, const uint8_t *data, size_t len) {
+    if (p->status == WAVE_IMPORT_RUNNING) {
+        if (p->format == WAVE_IMPORT_WAV) {
+            wav_feed(p, data, len);
+        } else {
+            csv_feed(p, data, len);
+        }
+        flush(p);
+    }
+    return p->status;
+}
+
+/**
+ * Termina la conversión al final del archivo: cierra la última línea de un CSV sin salto de línea
+ * final.
+ * @return WAVE_IMPORT_END si el archivo se convirtió, o el error.
+ */
+wave_import_status_t wave_import_finish(wave_import_t *p) {
+    if (p->status == WAVE_IMPORT_RUNNING) {
+        if (p->format == WAVE_IMPORT_WAV) {
+            // Sin tamaño en "data", los datos llegan hasta el final; sin "data", no hay muestras
+            p->status = p->riff == RIFF_DATA ? WAVE_IMPORT_END : WAVE_IMPORT_ERR_FORMAT;
+        } else {
+            end_line(p);
+            p->status = WAVE_IMPORT_END;
+        }
+        flush(p);
+    }
+    return p->status;
+}
+
+const char *wave_import_format_name(wave_import_format_t format) {
+    static const char *const names[] = { "desconocido", "csv", "csv;", "wav" };
+
+    return (unsigned)format < sizeof(names) / sizeof(names[0]) ? names[format] : "?";
+}
+
+const char *wave_import_status_name(wave_import_status_t status) {
+    static const char *const names[] = { "en curso", "terminado", "formato no admitido" };
+
+    return (unsigned)status < sizeof(names) / sizeof(names[0]) ? names[status] : "?";
+}
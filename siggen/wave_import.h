@@ -0,0 +1,118 @@
+/**
+ * @file wave_import.h
+ *
+ * @brief Conversión en flujo de archivos CSV y WAV a códigos del DAC, sin memoria dinámica ni
+ * punto flotante.
+ *
+ * El archivo se entrega en trozos de cualquier tamaño con wave_import_feed() y los códigos salen,
+ * en grupos, por una función del usuario; el estado entre trozos ocupa unos 230 bytes, así que
+ * un archivo de varios megabytes se convierte sin guardarlo. La Pico lo usa para importar lo que
+ * se copia a su disco USB (msc_disk.h); host/import_run lo ejecuta sobre archivos en la máquina
+ * anfitriona.
+ *
+ * Formatos:
+ *  - CSV: un registro por línea; se toma el último campo, así que sirve tanto una columna de
+ *    valores como pares "tiempo,valor", o el que se elija con wave_import_set_column(). Las líneas
+ *    cuyo campo elegido no es un número (títulos, comentarios) se saltean. Los valores van de -1 a 1, o son códigos de 0 a 255 si se pide.
+ *    Si el principio del archivo tiene ';', los campos se separan con ';' y los decimales con ',',
+ *    como exportan las planillas en español. Un byte nulo termina el archivo: es el relleno del
+ *    último sector.
+ *  - WAV: PCM de 8, 16, 24 o 32 bits, o flotante de 32 bits, con hasta WAVE_IMPORT_FRAME_MAX bytes
+ *    por cuadro; se toma el primer canal, o el elegido con wave_import_set_column(), y se
+ *    conservan los 8 bits más significativos.
+ */
+
+#ifndef SIGGEN_WAVE_IMPORT_H
+#define SIGGEN_WAVE_IMPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WAVE_IMPORT_DETECT_LEN 512 ///< Bytes del principio que conviene pasarle a wave_import_detect()
+#define WAVE_IMPORT_FRAME_MAX 32 ///< Bytes máximos por cuadro de un WAV (todos los canales)
+#define WAVE_IMPORT_OUT_LEN 64 ///< Códigos por llamada a la función de salida
+#define WAVE_IMPORT_LAST (-1) ///< Columna por defecto: el último campo del CSV y el primer canal del WAV
+
+/**
+ * Formato reconocido por wave_import_detect().
+ */
+typedef enum {
+    WAVE_IMPORT_NONE, ///< Ni CSV ni WAV (binario, o texto sin números)
+    WAVE_IMPORT_CSV, ///< CSV separado por ',' (o tabulaciones) con punto decimal
+    WAVE_IMPORT_CSV_SEMICOLON, ///< CSV separado por ';' con coma decimal
+    WAVE_IMPORT_WAV, ///< RIFF/WAVE
+} wave_import_format_t;
+
+/**
+ * Estado de la conversión.
+ */
+typedef enum {
+    WAVE_IMPORT_RUNNING, ///< Espera más datos
+    WAVE_IMPORT_END, ///< Terminó: fin de los datos del WAV o byte nulo del CSV
+    WAVE_IMPORT_ERR_FORMAT, ///< El WAV no es de un formato admitido
+} wave_import_status_t;
+
+/**
+ * Recibe los códigos convertidos.
+ */
+typedef void (*wave_import_sink_fn)(void *ctx, const uint8_t *codes, size_t count);
+
+/**
+ * Conversión en curso.
+ */
+typedef struct {
+    wave_import_format_t format; ///< Formato
+    wave_import_status_t status; ///< Estado
+    bool codes; ///< Los valores del CSV son códigos del DAC
+    int16_t column; ///< Campo del CSV o canal del WAV (desde 0), o WAVE_IMPORT_LAST
+    wave_import_sink_fn sink; ///< Salida
+    void *ctx; ///< Contexto de sink
+    uint32_t samples; ///< Códigos entregados
+    uint32_t skipped; ///< Líneas del CSV salteadas
+
+    // CSV: número del campo en curso, mantisa * 10^(exponente - decimales)
+    uint16_t field; ///< Campo en curso de la línea
+    uint8_t num; ///< Etapa del número (NUM_* en wave_import.c)
+    bool negative; ///< Mantisa negativa
+    bool exp_negative; ///< Exponente negativo
+    uint8_t digits; ///< Dígitos significativos de la mantisa
+    uint32_t mantissa; ///< Dígitos significativos
+    int32_t scale; ///< Potencia de 10 por la que se multiplica la mantisa
+    int32_t exponent; ///< Exponente escrito después de la 'e'
+    bool line_text; ///< La línea en curso tiene algún campo
+    bool line_valid; ///< El último campo cerrado de la línea es un número
+    int64_t line_value; ///< Su valor en Q24
+
+    // WAV
+    uint8_t riff; ///< Etapa del RIFF (RIFF_* en wave_import.c)
+    uint8_t hdr[28]; ///< Encabezado o principio del bloque "fmt " en construcción
+    uint32_t hdr_len; ///< Bytes en hdr
+    uint32_t left; ///< Bytes que faltan del bloque en curso (UINT32_MAX = hasta el final)
+    uint16_t wav_format; ///< 1 = PCM, 3 = flotante
+    uint16_t channels; ///< Canales
+    uint16_t bits; ///< Bits por muestra
+    uint16_t block; ///< Bytes por cuadro
+    uint32_t sample_rate; ///< Frecuencia de muestreo del WAV (Hz), 0 en un CSV
+    uint8_t frame[WAVE_IMPORT_FRAME_MAX]; ///< Cuadro partido entre dos trozos
+    uint32_t frame_len; ///< Bytes en frame
+
+    uint8_t out[WAVE_IMPORT_OUT_LEN]; ///< Códigos que faltan entregar
+    uint32_t out_len; ///< Códigos en out
+} wave_import_t;
+
+wave_import_format_t wave_import_detect(const uint8_t *head, size_t len);
+
+void wave_import_init(wave_import_t *p, wave_import_format_t format, bool codes, wave_import_sink_fn sink, void *ctx);
+
+void wave_import_set_column(wave_import_t *p, int column);
+
+wave_import_status_t wave_import_feed(wave_import_t *p, const uint8_t *data, size_t len);
+
+wave_import_status_t wave_import_finish(wave_import_t *p);
+
+const char *wave_import_format_name(wave_import_format_t format);
+
+const char *wave_import_status_name(wave_import_status_t status);
+
+#endif
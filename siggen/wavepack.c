@@ -0,0 +1,160 @@
+/**
+ * @file wavepack.c
+ *
+ * @brief Validación de imágenes wavepack y reproducción de sus secuencias.
+ */
+
+#include "wavepack.h"
+#include "crc32.h"
+#include "platform.h"
+#include <assert.h>
+#include <stddef.h>
+
+static_assert(sizeof(wavepack_header_t) == 32, "wavepack_header_t cambió de tamaño");
+static_assert(sizeof(wavepack_chunk_t) == 16, "wavepack_chunk_t cambió de tamaño");
+static_assert(sizeof(wavepack_step_t) == 12, "wavepack_step_t cambió de tamaño");
+
+/**
+ * Valida una imagen y deja pack listo para leerla en su lugar.
+ * @param pack         Imagen abierta.
+ * @param image        Primer byte; debe estar alineado a WAVEPACK_ALIGN.
+ * @param available    Bytes legibles desde image (por ejemplo, el tamaño de la región de flash).
+ * @param check_chunks Verificar también el CRC de cada carga. Recorre toda la imagen, así que en
+ *                     la Pico conviene hacerlo una vez al arrancar y no en cada cambio.
+ */
+wavepack_result_t wavepack_open(wavepack_t *pack, const void *image, size_t available, bool check_chunks) {
+    const wavepack_header_t *h = (const wavepack_header_t *)image;
+
+    pack->base = (const uint8_t *)image;
+    pack->header = h;
+    pack->dir = (const wavepack_chunk_t *)(h + 1);
+    pack->bad_entry = 0;
+
+    if (available < sizeof(*h) || h->magic != WAVEPACK_MAGIC) {
+        return WAVEPACK_ERR_MAGIC;
+    }
+    if (h->version != WAVEPACK_VERSION || h->header_size != sizeof(*h)) {
+        return WAVEPACK_ERR_VERSION;
+    }
+    uint32_t entries = (uint32_t)h->table_count + h->sequence_count;
+    if (entries > WAVEPACK_MAX_ENTRIES || h->image_size > available ||
+        h->image_size < sizeof(*h) + entries * sizeof(wavepack_chunk_t)) {
+        return WAVEPACK_ERR_SIZE;
+    }
+    uint32_t crc = crc32_update(0, h, offsetof(wavepack_header_t, crc));
+    if (crc32_update(crc, pack->dir, entries * sizeof(wavepack_chunk_t)) != h->crc) {
+        return WAVEPACK_ERR_HEADER_CRC;
+    }
+
+    for (uint32_t i = 0; i < entries; ++i) {
+        const wavepack_chunk_t *c = &pack->dir[i];
+        bool table = i < h->table_count;
+        uint32_t size = table ? c->count : c->count * (uint32_t)sizeof(wavepack_step_t);
+
+        pack->bad_entry = i;
+        if (c->type != (table ? WAVEPACK_TABLE : WAVEPACK_SEQUENCE) || c->offset % WAVEPACK_ALIGN || !c->count ||
+            (!table && c->count > h->image_size / sizeof(wavepack_step_t))) {
+            return WAVEPACK_ERR_ENTRY;
+        }
+        if (c->offset > h->image_size || size > h->image_size - c->offset) {
+            return WAVEPACK_ERR_SIZE;
+        }
+        if (!table) {
+            const wavepack_step_t *steps = (const wavepack_step_t *)(pack->base + c->offset);
+            for (uint32_t k = 0; k < c->count; ++k) {
+                if (steps[k].table >= h->table_count || !steps[k].phase_inc) {
+                    return WAVEPACK_ERR_ENTRY;
+                }
+            }
+        }
+        if (check_chunks && crc32_compute(pack->base + c->offset, size) != c->crc) {
+            return WAVEPACK_ERR_CHUNK_CRC;
+        }
+    }
+    pack->bad_entry = 0;
+    return WAVEPACK_OK;
+}
+
+const char *wavepack_result_name(wavepack_result_t result) {
+    static const char *const names[] = {
+        "válida", "sin imagen", "versión desconocida", "tamaño inválido", "encabezado dañado", "entrada inválida",
+        "carga dañada",
+    };
+    return (unsigned)result < sizeof(names) / sizeof(names[0]) ? names[result] : "?";
+}
+
+static void load_step(wavepack_player_t *p) {
+    const wavepack_step_t *s = &p->steps[p->step];
+
+    p->table = wavepack_table(p->pack, s->table, &p->table_len);
+    p->left = s->samples;
+    p->pos = 0;
+    p->frac = 0;
+    p->inc_int = s->phase_inc >> 16;
+    p->inc_frac = s->phase_inc & 0xFFFF;
+    // Un avance de más de una tabla entera equivale a su resto
+    if (p->inc_int >= p->table_len) {
+        p->inc_int %= p->table_len;
+    }
+}
+
+/**
+ * Prepara la reproducción de una secuencia desde su primer paso. La imagen debe haber pasado
+ * wavepack_open() y sequence debe ser menor que sequence_count.
+ */
+void wavepack_player_init(wavepack_player_t *p, const wavepack_t *pack, uint32_t sequence) {
+    p->pack = pack;
+    p->steps = wavepack_sequence(pack, sequence, &p->step_count);
+    p->step = 0;
+    p->bank = NULL;
+    load_step(p);
+}
+
+/**
+ * Elige cómo se leen las tablas en los pasos fraccionarios; se puede cambiar entre dos llamadas a
+ * wavepack_player_render(). Los pasos enteros siempre leen la tabla tal cual, que es lo mismo que
+ * daría el filtro.
+ */
+void wavepack_player_set_quality(wavepack_player_t *p, polyphase_quality_t quality) {
+    p->bank = polyphase_bank(quality);
+}
+
+/**
+ * Escribe las próximas n muestras de la secuencia. Sin banco, o con un paso entero, cada muestra
+ * es una lectura de la tabla y una suma en punto fijo, así que las tablas deben tener la
+ * resolución que se quiere a la salida; con banco, los pasos fraccionarios pasan por
+ * polyphase_table_render().
+ */
+void SIGGEN_HOT(wavepack_player_render)(wavepack_player_t *p, uint8_t *out, size_t n) {
+    while (n) {
+        size_t chunk = p->left && p->left < n ? p->left : n;
+        const uint8_t *table = p->table;
+        uint32_t len = p->table_len, pos = p->pos, frac = p->frac;
+        uint32_t inc_int = p->inc_int, inc_frac = p->inc_frac;
+
+        if (p->bank && inc_frac) {
+            polyphase_table_render(p->bank, table, len, &pos, &frac, inc_int, inc_frac, out, chunk);
+        } else {
+            for (size_t i = 0; i < chunk; ++i) {
+                out[i] = table[pos];
+                frac += inc_frac;
+                pos += inc_int + (frac >> 16);
+                frac &= 0xFFFF;
+                if (pos >= len) {
+                    pos -= len;
+                }
+            }
+        }
+        p->pos = pos;
+        p->frac = frac;
+        out += chunk;
+        n -= chunk;
+        if (p->left) {
+            p->left -= (uint32_t)chunk;
+            if (!p->left) {
+                p->step = p->step + 1 < p->step_count ? p->step + 1 : 0;
+                load_step(p);
+            }
+        }
+    }
+}
@@ -0,0 +1,145 @@
+/**
+ * @file wavepack.h
+ *
+ * @brief Contenedor binario de tablas de forma de onda y secuencias, listo para reproducir sin
+ * convertir nada.
+ *
+ * La imagen empieza con un encabezado (wavepack_header_t) seguido del directorio: un
+ * wavepack_chunk_t por tabla y luego uno por secuencia, así que la tabla i es la entrada i y la
+ * secuencia j la entrada table_count + j. Cada entrada apunta a su carga, alineada a
+ * WAVEPACK_ALIGN bytes:
+ *  - Tabla: count códigos del DAC de 8 bits, tal como salen por los pines.
+ *  - Secuencia: count pasos wavepack_step_t.
+ *
+ * Todos los campos son little-endian, como la memoria del RP2040, así que la imagen se usa en su
+ * lugar desde la flash (por XIP) o desde la SRAM: wavepack_open() la valida una vez (encabezado,
+ * directorio y CRC-32 de cada carga) y después las tablas y los pasos se leen como arreglos.
+ *
+ * Las imágenes las arma host/gds_pack a partir de CSV, WAV o una descripción JSON. El reproductor
+ * lee la muestra más cercana a la posición, o la filtra con un banco de polyphase.h cuando el paso
+ * no es entero (wavepack_player_set_quality()).
+ */
+
+#ifndef SIGGEN_WAVEPACK_H
+#define SIGGEN_WAVEPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "polyphase.h"
+
+#define WAVEPACK_MAGIC 0x57534447 ///< "GDSW" en little-endian
+#define WAVEPACK_VERSION 1 ///< Versión del formato
+#define WAVEPACK_ALIGN 4 ///< Alineación de las cargas, para leer los pasos como palabras
+#define WAVEPACK_TABLE 0x4C424154 ///< Tipo de entrada de una tabla: "TABL"
+#define WAVEPACK_SEQUENCE 0x4E514553 ///< Tipo de entrada de una secuencia: "SEQN"
+#define WAVEPACK_MAX_ENTRIES 1024 ///< Tablas más secuencias por imagen
+
+/**
+ * Encabezado de la imagen. El CRC cubre los campos anteriores y todo el directorio.
+ */
+typedef struct {
+    uint32_t magic; ///< WAVEPACK_MAGIC
+    uint16_t version; ///< WAVEPACK_VERSION
+    uint16_t header_size; ///< sizeof(wavepack_header_t), para extender el formato
+    uint32_t image_size; ///< Bytes de la imagen completa
+    uint32_t sample_rate; ///< Frecuencia de muestreo para la que se armó (Hz)
+    uint16_t table_count; ///< Tablas
+    uint16_t sequence_count; ///< Secuencias
+    uint32_t flags; ///< Reservado, en 0
+    uint32_t reserved; ///< Reservado, en 0
+    uint32_t crc; ///< CRC-32 de los campos anteriores y del directorio
+} wavepack_header_t;
+
+/**
+ * Entrada del directorio.
+ */
+typedef struct {
+    uint32_t type; ///< WAVEPACK_TABLE o WAVEPACK_SEQUENCE
+    uint32_t offset; ///< Posición de la carga desde el principio de la imagen
+    uint32_t count; ///< Muestras de la tabla o pasos de la secuencia
+    uint32_t crc; ///< CRC-32 de la carga
+} wavepack_chunk_t;
+
+/**
+ * Paso de una secuencia: una tabla recorrida a un ritmo fijo durante una cantidad de muestras.
+ * Cada paso empieza desde la primera muestra de su tabla; al terminar el último, la secuencia
+ * vuelve al primero.
+ */
+typedef struct {
+    uint16_t table; ///< Índice de la tabla
+    uint16_t flags; ///< Reservado, en 0
+    uint32_t phase_inc; ///< Muestras de la tabla que avanza cada muestra de salida, en Q16.16
+    uint32_t samples; ///< Duración en muestras de salida; 0 = hasta que se elija otra secuencia
+} wavepack_step_t;
+
+/**
+ * Resultado de wavepack_open().
+ */
+typedef enum {
+    WAVEPACK_OK, ///< Imagen válida
+    WAVEPACK_ERR_MAGIC, ///< No es una imagen (o está borrada)
+    WAVEPACK_ERR_VERSION, ///< Versión o tamaño de encabezado desconocidos
+    WAVEPACK_ERR_SIZE, ///< La imagen o alguna carga no entra en la memoria disponible
+    WAVEPACK_ERR_HEADER_CRC, ///< El encabezado o el directorio están dañados
+    WAVEPACK_ERR_ENTRY, ///< Una entrada tiene un tipo, alineación o contenido inválidos
+    WAVEPACK_ERR_CHUNK_CRC, ///< Una carga está dañada
+} wavepack_result_t;
+
+/**
+ * Imagen abierta.
+ */
+typedef struct {
+    const uint8_t *base; ///< Primer byte de la imagen
+    const wavepack_header_t *header; ///< Encabezado
+    const wavepack_chunk_t *dir; ///< Directorio
+    uint32_t bad_entry; ///< Entrada que falló, si wavepack_open() devolvió un error de entrada
+} wavepack_t;
+
+/**
+ * Reproductor de una secuencia.
+ */
+typedef struct {
+    const wavepack_t *pack; ///< Imagen
+    const wavepack_step_t *steps; ///< Pasos de la secuencia
+    uint32_t step_count; ///< Cantidad de pasos
+    uint32_t step; ///< Paso en curso
+    uint32_t left; ///< Muestras que le quedan al paso (0 con un paso sin fin)
+    const uint8_t *table; ///< Tabla del paso
+    uint32_t table_len; ///< Muestras de la tabla
+    uint32_t pos; ///< Posición en la tabla
+    uint32_t frac; ///< Fracción de la posición, en Q16
+    uint32_t inc_int; ///< Parte entera de phase_inc
+    uint32_t inc_frac; ///< Parte fraccionaria de phase_inc
+    const polyphase_bank_t *bank; ///< Filtro de los pasos fraccionarios; NULL = muestra más cercana
+} wavepack_player_t;
+
+wavepack_result_t wavepack_open(wavepack_t *pack, const void *image, size_t available, bool check_chunks);
+
+const char *wavepack_result_name(wavepack_result_t result);
+
+/**
+ * Muestras de la tabla index; len recibe su cantidad. No valida index.
+ */
+static inline const uint8_t *wavepack_table(const wavepack_t *pack, uint32_t index, uint32_t *len) {
+    const wavepack_chunk_t *c = &pack->dir[index];
+    *len = c->count;
+    return pack->base + c->offset;
+}
+
+/**
+ * Pasos de la secuencia index; count recibe su cantidad. No valida index.
+ */
+static inline const wavepack_step_t *wavepack_sequence(const wavepack_t *pack, uint32_t index, uint32_t *count) {
+    const wavepack_chunk_t *c = &pack->dir[pack->header->table_count + index];
+    *count = c->count;
+    return (const wavepack_step_t *)(pack->base + c->offset);
+}
+
+void wavepack_player_init(wavepack_player_t *p, const wavepack_t *pack, uint32_t sequence);
+
+void wavepack_player_set_quality(wavepack_player_t *p, polyphase_quality_t quality);
+
+void wavepack_player_render(wavepack_player_t *p, uint8_t *out, size_t n);
+
+#endif
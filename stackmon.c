@@ -0,0 +1,118 @@
+/**
+ * @file stackmon.c
+ *
+ * @brief Implementación del pintado de pilas y del reporte de interrupciones.
+ */
+
+#include "stackmon.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include <stdio.h>
+
+#define STACKMON_PATTERN 0xC5C5C5C5u ///< Palabra con la que se pintan las pilas
+#define STACKMON_MARGIN 256 ///< Bytes por debajo del puntero de pila actual que no se pintan en el núcleo 0
+
+// Límites de las pilas definidos por el guion del enlazador del SDK
+extern uint32_t __StackBottom[], __StackTop[];
+extern uint32_t __StackOneBottom[], __StackOneTop[];
+
+static isr_stats_t *isr_table[STACKMON_MAX_ISRS]; ///< Rutinas de interrupción registradas
+static int isr_count; ///< Cantidad de rutinas registradas
+
+static void paint(uint32_t *from, uint32_t *to) {
+    for (uint32_t *p = from; p < to; ++p) {
+        *p = STACKMON_PATTERN;
+    }
+}
+
+/**
+ * Bytes usados de una pila: desde el tope hasta la primera palabra, contando desde abajo, que
+ * perdió el patrón.
+ */
+static uint32_t high_water(const uint32_t *bottom, const uint32_t *top) {
+    const uint32_t *p = bottom;
+
+    while (p < top && *p == STACKMON_PATTERN) {
+        ++p;
+    }
+    return (uint32_t)((top - p) * sizeof(uint32_t));
+}
+
+/**
+ * Deja el SysTick del núcleo que llama contando libremente con el reloj del procesador, para
+ * isr_stats_begin() e isr_stats_end(). Cada núcleo tiene su propio SysTick.
+ */
+void stackmon_init_core(void) {
+    systick_hw->csr = 0;
+    systick_hw->rvr = 0xFFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+}
+
+/**
+ * Pinta la pila del núcleo 0 desde su base hasta un margen por debajo del marco actual. Debe
+ * llamarse al principio de main().
+ */
+void stackmon_paint_core0(void) {
+    uint32_t marker;
+    uint32_t *limit = &marker - STACKMON_MARGIN / sizeof(uint32_t);
+
+    paint(__StackBottom, limit);
+}
+
+/**
+ * Pinta la pila completa del núcleo 1. Debe llamarse antes de multicore_launch_core1().
+ */
+void stackmon_paint_core1(void) {
+    paint(__StackOneBottom, __StackOneTop);
+}
+
+/**
+ * Agrega una rutina de interrupción al reporte.
+ */
+void stackmon_register_isr(isr_stats_t *s) {
+    if (isr_count < STACKMON_MAX_ISRS) {
+        isr_table[isr_count++] = s;
+    }
+}
+
+/**
+ * Nivel máximo de la pila de un núcleo, en bytes. Se puede llamar desde cualquier núcleo.
+ */
+uint32_t stackmon_stack_used(unsigned core) {
+    return core ? high_water(__StackOneBottom, __StackOneTop) : high_water(__StackBottom, __StackTop);
+}
+
+/**
+ * Peor duración, en ciclos, entre todas las rutinas de interrupción registradas.
+ */
+uint32_t stackmon_isr_max_cycles(void) {
+    uint32_t worst = 0;
+
+    for (int i = 0; i < isr_count; ++i) {
+        uint32_t cycles = isr_table[i]->max_cycles;
+        worst = cycles > worst ? cycles : worst;
+    }
+    return worst;
+}
+
+/**
+ * Imprime el nivel máximo de cada pila y, por cada rutina registrada, las ejecuciones y las
+ * duraciones promedio y máxima.
+ */
+void stackmon_print(void) {
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+
+    printf("pila nucleo0: maximo %lu B de %lu B\n", (unsigned long)stackmon_stack_used(0),
+           (unsigned long)((__StackTop - __StackBottom) * sizeof(uint32_t)));
+    printf("pila nucleo1: maximo %lu B de %lu B\n", (unsigned long)stackmon_stack_used(1),
+           (unsigned long)((__StackOneTop - __StackOneBottom) * sizeof(uint32_t)));
+    for (int i = 0; i < isr_count; ++i) {
+        const isr_stats_t *s = isr_table[i];
+        uint32_t count = s->count;
+        uint32_t avg = count ? (uint32_t)(s->total_cycles / count) : 0;
+        printf("irq %-8s ejec %8lu, prom %6lu ciclos (%lu us), max %6lu ciclos (%lu us)\n", s->name,
+               (unsigned long)count, (unsigned long)avg, (unsigned long)(avg / mhz),
+               (unsigned long)s->max_cycles, (unsigned long)(s->max_cycles / mhz));
+    }
+}
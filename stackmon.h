@@ -0,0 +1,70 @@
+/**
+ * @file stackmon.h
+ *
+ * @brief Marcas de nivel máximo de las pilas y peores tiempos de las rutinas de interrupción.
+ *
+ * Al arrancar, la parte libre de la pila de cada núcleo se llena con un patrón; el nivel máximo
+ * es la distancia desde el tope hasta la palabra más baja que ya no conserva el patrón. En el
+ * RP2040 las excepciones e interrupciones usan la misma pila principal (MSP) del núcleo que las
+ * atiende, así que la marca de cada núcleo incluye la profundidad de sus interrupciones: no hay
+ * una pila de excepciones aparte que medir.
+ *
+ * Las rutinas de interrupción instrumentadas miden su duración en ciclos con el SysTick del
+ * núcleo, que stackmon_init_core() deja contando libremente. Con esos datos se puede reducir el
+ * tamaño de las pilas (PICO_STACK_SIZE, PICO_CORE1_STACK_SIZE) y recuperar SRAM para búferes.
+ */
+
+#ifndef STACKMON_H
+#define STACKMON_H
+
+#include <stdint.h>
+#include "hardware/structs/systick.h"
+
+#define STACKMON_MAX_ISRS 4 ///< Cantidad máxima de rutinas de interrupción registradas
+
+/**
+ * Tiempos de una rutina de interrupción, en ciclos del reloj del sistema.
+ */
+typedef struct {
+    const char *name; ///< Nombre para los reportes
+    volatile uint32_t count; ///< Ejecuciones
+    volatile uint32_t max_cycles; ///< Peor duración
+    volatile uint64_t total_cycles; ///< Suma de duraciones
+} isr_stats_t;
+
+/**
+ * Marca el inicio de una rutina de interrupción.
+ * @return Valor del SysTick, que se entrega a isr_stats_end().
+ */
+static inline uint32_t isr_stats_begin(void) {
+    return systick_hw->cvr;
+}
+
+/**
+ * Registra la duración de una rutina de interrupción. El SysTick cuenta hacia abajo en 24 bits.
+ */
+static inline void isr_stats_end(isr_stats_t *s, uint32_t start) {
+    uint32_t cycles = (start - systick_hw->cvr) & 0xFFFFFF;
+
+    s->count++;
+    s->total_cycles += cycles;
+    if (cycles > s->max_cycles) {
+        s->max_cycles = cycles;
+    }
+}
+
+void stackmon_init_core(void);
+
+void stackmon_paint_core0(void);
+
+void stackmon_paint_core1(void);
+
+void stackmon_register_isr(isr_stats_t *s);
+
+uint32_t stackmon_stack_used(unsigned core);
+
+uint32_t stackmon_isr_max_cycles(void);
+
+void stackmon_print(void);
+
+#endif
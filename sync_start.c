@@ -0,0 +1,171 @@
+/**
+ * @file sync_start.c
+ *
+ * @brief Implementación del arranque sincronizado: pedido desde la consola (núcleo 0), armado
+ * desde el núcleo de síntesis y medición del arranque desde la interrupción del flanco.
+ */
+
+#include "sync_start.h"
+#include "dac_out.h"
+#include "irq_plan.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include <stdio.h>
+
+sync_start_t sync_start;
+
+static bool priority_raised; ///< IO_IRQ_BANK0 del núcleo 0 está en IRQ_PRIO_OUTPUT
+
+static const char *const state_names[] = {
+    "idle", "requested", "arming", "armed", "started", "late", "missed", "unsupported",
+};
+
+/**
+ * Configura el pin del disparo como entrada con resistencia de bajada y habilita su interrupción
+ * de flanco de subida. Debe llamarse desde el núcleo 0 después de registrar gpio_callback().
+ */
+void sync_start_init(void) {
+    gpio_init(SYNC_TRIGGER_PIN);
+    gpio_set_dir(SYNC_TRIGGER_PIN, GPIO_IN);
+    gpio_pull_down(SYNC_TRIGGER_PIN);
+    gpio_set_irq_enabled(SYNC_TRIGGER_PIN, GPIO_IRQ_EDGE_RISE, true);
+    sync_start.state = SYNC_IDLE;
+}
+
+/**
+ * Sube o baja la prioridad de la interrupción de GPIO. La prioridad es de cada núcleo, así que
+ * solo se llama desde el núcleo 0, con las interrupciones deshabilitadas o desde la interrupción.
+ */
+static void set_priority_raised(bool raised) {
+    if (raised != priority_raised) {
+        irq_set_priority(IO_IRQ_BANK0, raised ? IRQ_PRIO_OUTPUT : IRQ_PRIO_INPUT);
+        priority_raised = raised;
+    }
+}
+
+/**
+ * Pide un arranque armado al núcleo de síntesis y lo despierta. Se llama desde el núcleo 0. Un
+ * arranque armado que todavía esperaba el flanco queda reemplazado.
+ */
+void sync_start_request(void) {
+    uint32_t irq = save_and_disable_interrupts();
+    sync_start.request_us = time_us_32();
+    sync_start.arm_us = 0;
+    sync_start.start_us = 0;
+    sync_start.edge_to_start_cycles = 0;
+    sync_start.state = SYNC_REQUESTED;
+    set_priority_raised(false);
+    restore_interrupts(irq);
+    __sev();
+}
+
+/**
+ * Pone la interrupción de GPIO en IRQ_PRIO_OUTPUT mientras hay un arranque armado y en
+ * IRQ_PRIO_INPUT el resto del tiempo. Se llama desde el núcleo 0 en cada vuelta del bucle
+ * principal; sync_start_armed() lo despierta con SEV.
+ */
+void sync_start_poll(void) {
+    if ((sync_start.state == SYNC_ARMED) == priority_raised) {
+        return;
+    }
+    uint32_t irq = save_and_disable_interrupts();
+    set_priority_raised(sync_start.state == SYNC_ARMED);
+    restore_interrupts(irq);
+}
+
+/**
+ * Toma un pedido de arranque armado. Se llama desde el núcleo de síntesis en cada vuelta.
+ * @return true si había un pedido; el llamador detiene la salida, rellena los bloques y llama a
+ * sync_start_armed() justo antes de dac_out_start_armed().
+ */
+bool sync_start_take_request(void) {
+    if (sync_start.state != SYNC_REQUESTED) {
+        return false;
+    }
+    sync_start.state = SYNC_ARMING;
+    return true;
+}
+
+/**
+ * Registra que los bloques están listos y despierta al núcleo 0 para que sync_start_poll() suba la
+ * prioridad de la interrupción del flanco. Un flanco que llegue antes de que la máquina de estados
+ * quede esperando se da por perdido.
+ */
+void sync_start_armed(void) {
+    sync_start.arm_us = time_us_32() - sync_start.request_us;
+    sync_start.state = SYNC_ARMED;
+    __sev();
+}
+
+/**
+ * Registra que la salida en uso no admite el arranque armado. La prioridad no se había subido.
+ */
+void sync_start_reject(void) {
+    sync_start.state = SYNC_UNSUPPORTED;
+}
+
+/**
+ * Atiende el flanco del disparo. Se llama al principio de gpio_callback(); espera el aviso de
+ * arranque de la máquina de estados, que llega unas pocas muestras después del flanco.
+ * @return true si gpio era SYNC_TRIGGER_PIN y el evento ya fue atendido.
+ */
+bool sync_start_gpio(uint gpio) {
+    if (gpio != SYNC_TRIGGER_PIN) {
+        return false;
+    }
+    uint32_t edge_cvr = systick_hw->cvr;
+    uint32_t now = time_us_32();
+
+    // Cualquier flanco termina la espera armada: la prioridad vuelve a la de las entradas
+    set_priority_raised(false);
+    if (sync_start.state != SYNC_ARMED) {
+        return true;
+    }
+    sync_start.start_us = now - sync_start.request_us;
+    if (dac_out_armed_started()) {
+        sync_start.state = SYNC_LATE;
+        return true;
+    }
+    while (!dac_out_armed_started()) {
+        if (time_us_32() - now > SYNC_START_TIMEOUT_US) {
+            sync_start.state = SYNC_MISSED;
+            return true;
+        }
+    }
+    sync_start.edge_to_start_cycles = (edge_cvr - systick_hw->cvr) & 0xFFFFFF;
+    sync_start.state = SYNC_STARTED;
+    return true;
+}
+
+static int64_t release_trigger(alarm_id_t id, void *ctx) {
+    (void)id;
+    (void)ctx;
+    gpio_set_dir(SYNC_TRIGGER_PIN, GPIO_IN);
+    return 0;
+}
+
+/**
+ * Produce el flanco del disparo: maneja la línea en 1 durante SYNC_PULSE_US y la vuelve a soltar.
+ * Solo una placa de la línea debe hacerlo. Su propia salida, si está armada, también arranca.
+ */
+void sync_start_fire(void) {
+    gpio_put(SYNC_TRIGGER_PIN, 1);
+    gpio_set_dir(SYNC_TRIGGER_PIN, GPIO_OUT);
+    if (add_alarm_in_us(SYNC_PULSE_US, release_trigger, NULL, true) < 0) {
+        busy_wait_us_32(SYNC_PULSE_US);
+        gpio_set_dir(SYNC_TRIGGER_PIN, GPIO_IN);
+    }
+}
+
+/**
+ * Imprime el estado del último arranque en una línea para host/gds_ctl:
+ * "@SYNC,estado,armado_us,arranque_us,ciclos_flanco_salida,reloj_hz,muestras_por_segundo".
+ */
+void sync_start_print_record(void) {
+    printf("@SYNC,%s,%lu,%lu,%lu,%lu,%lu\n", state_names[sync_start.state], (unsigned long)sync_start.arm_us,
+           (unsigned long)sync_start.start_us, (unsigned long)sync_start.edge_to_start_cycles,
+           (unsigned long)clock_get_hz(clk_sys), (unsigned long)DAC_SAMPLE_RATE);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file sync_start.h
+ *
+ * @brief Arranque sincronizado de varias placas con un disparo compartido.
+ *
+ * Todas las placas comparten una línea conectada a SYNC_TRIGGER_PIN (con resistencia de bajada
+ * interna, así que en reposo está en 0). !arm detiene la salida, rellena los dos bloques desde la
+ * fase cero del oscilador y deja la máquina de estados del PIO esperando el flanco de subida
+ * (dac_out_start_armed()): la salida arranca en el hardware, sin depender de la latencia de la
+ * CPU ni del USB, así que la diferencia entre placas queda dentro de una muestra. El flanco lo
+ * produce un equipo externo o una de las placas con !fire.
+ *
+ * La interrupción del flanco mide, con SysTick, cuántos ciclos pasan desde su entrada hasta que
+ * la máquina de estados avisa que arrancó. La entrada a la interrupción no se cuenta, pero es la
+ * misma en todas las placas con el mismo firmware, así que la diferencia entre placas es el
+ * desfase entre sus arranques. Mientras hay un arranque armado la interrupción de GPIO del núcleo
+ * 0 sube a la prioridad de la salida para que nada la retrase; sync_start_poll() la sube al quedar
+ * armado y la interrupción del flanco o un nuevo !arm la vuelven a bajar.
+ */
+
+#ifndef SYNC_START_H
+#define SYNC_START_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+#define SYNC_TRIGGER_PIN 15 ///< GPIO del disparo compartido entre placas
+#define SYNC_PULSE_US 100 ///< Duración del pulso de !fire
+#define SYNC_START_TIMEOUT_US 50 ///< Espera máxima del arranque después del flanco (varias muestras)
+
+/**
+ * Estado del arranque sincronizado.
+ */
+typedef enum {
+    SYNC_IDLE, ///< Sin arranque pedido
+    SYNC_REQUESTED, ///< !arm pedido; el núcleo 1 todavía no lo tomó
+    SYNC_ARMING, ///< Rellenando los bloques
+    SYNC_ARMED, ///< Esperando el flanco
+    SYNC_STARTED, ///< Arrancó; edge_to_start_cycles es válido
+    SYNC_LATE, ///< Arrancó antes de que entrara la interrupción; la medición no es válida
+    SYNC_MISSED, ///< Hubo flanco pero la salida no arrancó a tiempo
+    SYNC_UNSUPPORTED, ///< La salida en uso no admite el arranque armado
+} sync_state_t;
+
+/**
+ * Estado y mediciones del último arranque. Los instantes son relativos a !arm.
+ */
+typedef struct {
+    volatile sync_state_t state; ///< Estado
+    volatile uint32_t request_us; ///< Instante de !arm (time_us_32())
+    volatile uint32_t arm_us; ///< Desde !arm hasta quedar armada (relleno de los bloques)
+    volatile uint32_t start_us; ///< Desde !arm hasta el flanco que arrancó la salida
+    volatile uint32_t edge_to_start_cycles; ///< Ciclos desde la entrada a la interrupción del flanco hasta el arranque
+} sync_start_t;
+
+extern sync_start_t sync_start;
+
+void sync_start_init(void);
+
+void sync_start_request(void);
+
+void sync_start_poll(void);
+
+bool sync_start_take_request(void);
+
+void sync_start_armed(void);
+
+void sync_start_reject(void);
+
+bool sync_start_gpio(uint gpio);
+
+void sync_start_fire(void);
+
+void sync_start_print_record(void);
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * @file telemetry.c
+ *
+ * @brief Tarea de telemetría: cuando está habilitada imprime una vez por segundo los parámetros
+ * actuales del generador, el nivel máximo de las pilas con la peor interrupción, el uso de cada
+ * arena y, mientras suena el parlante USB, el estado de su cola.
+ */
+
+#include "telemetry.h"
+#include "dac_out.h"
+#include "siggen/fixdec.h"
+#include "siggen/arena.h"
+#include "stackmon.h"
+#include "usb_audio.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+
+static engine_t *telemetry_engine; ///< Motor cuyo estado se reporta
+static task_t *telemetry_self; ///< Tarea de telemetría, para reprogramarla
+static bool telemetry_enabled; ///< Reporte periódico habilitado
+static uint32_t power_since_us; ///< Inicio de la ventana de telemetry_print_power()
+static uint64_t power_busy_us[2]; ///< busy_us de cada núcleo en la lectura anterior
+static uint32_t power_wakeups[2]; ///< wakeups de cada núcleo en la lectura anterior
+
+core_activity_t core_activity[2];
+
+static const char *const waveform_names[] = {"Seno", "Cuadrada", "Diente de sierra", "Triangular"};
+
+void telemetry_init(engine_t *e, task_t *self) {
+    telemetry_engine = e;
+    telemetry_self = self;
+    telemetry_enabled = false;
+    power_since_us = time_us_32();
+}
+
+void telemetry_set_enabled(bool enabled) {
+    telemetry_enabled = enabled;
+}
+
+/**
+ * Imprime los parámetros actuales en una sola línea.
+ */
+void telemetry_print_status(void) {
+    engine_t *e = telemetry_engine;
+    char amplitude[FIXDEC_MAX_LEN], dc_offset[FIXDEC_MAX_LEN], frequency[FIXDEC_MAX_LEN];
+
+    fixdec_format(amplitude, sizeof(amplitude), e->amplitude_uv, 2);
+    fixdec_format(dc_offset, sizeof(dc_offset), e->dc_offset_uv, 2);
+    fixdec_format(frequency, sizeof(frequency), (int64_t)e->frequency_millihz, 2);
+    printf("Amplitud: %s mV, Desplazamiento DC: %s mV, Frecuencia: %s Hz, Forma de onda: %s\n",
+           amplitude, dc_offset, frequency, waveform_names[e->waveform]);
+}
+
+/**
+ * Lee los contadores de actividad publicados por otro núcleo sin que se mezclen dos
+ * actualizaciones.
+ */
+static void activity_read(const core_activity_t *a, uint64_t *busy_us, uint32_t *wakeups) {
+    for (;;) {
+        uint32_t seq = a->seq;
+        __sync_synchronize();
+        *busy_us = a->busy_us;
+        *wakeups = a->wakeups;
+        __sync_synchronize();
+        if (!(seq & 1) && a->seq == seq) {
+            return;
+        }
+    }
+}
+
+/**
+ * Imprime el ciclo de trabajo y los despertares por segundo de cada núcleo desde el último
+ * reporte, junto con los bloques enviados al DAC y los que se repitieron por falta de datos. Los
+ * contadores de cada núcleo solo los escribe su dueño: aquí se informa la diferencia con la
+ * lectura anterior.
+ */
+void telemetry_print_power(void) {
+    uint32_t now = time_us_32();
+    uint32_t window = now - power_since_us;
+
+    for (int core = 0; core < 2; ++core) {
+        const core_activity_t *a = &core_activity[core];
+        uint64_t total_busy;
+        uint32_t total_wakeups;
+
+        activity_read(a, &total_busy, &total_wakeups);
+        // El núcleo que imprime está despierto: se cuenta hasta ahora
+        if (core == 0) {
+            total_busy += now - a->awake_since_us;
+        }
+        uint64_t busy = total_busy - power_busy_us[core];
+        uint32_t wakeups = total_wakeups - power_wakeups[core];
+        power_busy_us[core] = total_busy;
+        power_wakeups[core] = total_wakeups;
+        printf("nucleo%d: ciclo de trabajo %lu.%02lu%%, despertares/s %lu\n", core,
+               window ? (unsigned long)(busy * 100 / window) : 0,
+               window ? (unsigned long)(busy * 10000 / window % 100) : 0,
+               window ? (unsigned long)((uint64_t)wakeups * 1000000 / window) : 0);
+    }
+    printf("dac: bloques %lu, repetidos %lu, peor relleno %lu us, peor variacion irq %lu us\n",
+           (unsigned long)dac_out_stats.blocks, (unsigned long)dac_out_stats.underruns,
+           (unsigned long)dac_out_stats.max_render_us, (unsigned long)dac_out_stats.max_irq_jitter_us);
+    dac_out_reset_stats();
+    power_since_us = now;
+}
+
+/**
+ * Imprime, para cada arena en uso, los bytes entregados, el máximo alcanzado desde el arranque,
+ * el tamaño y las peticiones rechazadas, seguido del nivel máximo de las pilas y los tiempos de
+ * las interrupciones (stackmon.h).
+ */
+void telemetry_print_memory(void) {
+    for (const arena_t *a = arena_first(); a; a = a->next) {
+        printf("arena %-8s usado %6lu B, maximo %6lu B de %6lu B (%lu%%), rechazos %lu\n", a->name,
+               (unsigned long)a->used, (unsigned long)a->high_water, (unsigned long)a->size,
+               a->size ? (unsigned long)(a->high_water * 100 / a->size) : 0, (unsigned long)a->failures);
+    }
+    stackmon_print();
+}
+
+/**
+ * Imprime el nivel máximo de la pila de cada núcleo y la peor duración entre las interrupciones
+ * registradas en stackmon.h, en una línea.
+ */
+static void print_headroom(void) {
+    printf("pilas: nucleo0 %lu B, nucleo1 %lu B; peor interrupcion %lu ciclos\n",
+           (unsigned long)stackmon_stack_used(0), (unsigned long)stackmon_stack_used(1),
+           (unsigned long)stackmon_isr_max_cycles());
+}
+
+/**
+ * Imprime el uso actual y el máximo de cada arena en una línea.
+ */
+static void print_arenas(void) {
+    printf("arenas:");
+    for (const arena_t *a = arena_first(); a; a = a->next) {
+        printf(" %s %lu/%lu B", a->name, (unsigned long)a->used, (unsigned long)a->high_water);
+    }
+    printf("\n");
+}
+
+/**
+ * Imprime el estado en una línea para herramientas de la máquina anfitriona (host/gds_ctl):
+ * "@TEL,<amplitud uV>,<desplazamiento uV>,<frecuencia mHz>,<forma de onda>,<bloques>,<repetidos>,
+ * <pila núcleo 0 B>,<pila núcleo 1 B>,<peor interrupción ciclos>", en enteros, seguido de
+ * ",<nombre>,<usado B>,<máximo B>" por cada arena en uso.
+ */
+void telemetry_print_record(void) {
+    engine_t *e = telemetry_engine;
+
+    printf("@TEL,%ld,%ld,%llu,%d,%lu,%lu,%lu,%lu,%lu", (long)e->amplitude_uv, (long)e->dc_offset_uv,
+           (unsigned long long)e->frequency_millihz, (int)e->waveform, (unsigned long)dac_out_stats.blocks,
+           (unsigned long)dac_out_stats.underruns, (unsigned long)stackmon_stack_used(0),
+           (unsigned long)stackmon_stack_used(1), (unsigned long)stackmon_isr_max_cycles());
+    for (const arena_t *a = arena_first(); a; a = a->next) {
+        printf(",%s,%lu,%lu", a->name, (unsigned long)a->used, (unsigned long)a->high_water);
+    }
+    printf("\n");
+}
+
+void telemetry_task(void *ctx) {
+    (void)ctx;
+
+    if (telemetry_enabled) {
+        telemetry_print_status();
+        print_headroom();
+        print_arenas();
+        // El costo del remuestreo se promedia por periodo del reporte
+        if (usb_audio_active()) {
+            usb_audio_print();
+            usb_audio_reset_stats();
+        }
+    }
+    sched_wake_at(telemetry_self, time_us_32() + TELEMETRY_PERIOD_US);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file telemetry.h
+ *
+ * @brief Reporte periódico del estado del generador por la consola USB.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include "siggen/engine.h"
+#include "siggen/sched.h"
+
+#define TELEMETRY_PERIOD_US 1000000 ///< Periodo del reporte de telemetría (uS)
+
+/**
+ * Actividad de un núcleo: cuántas veces salió de WFE y cuánto tiempo estuvo despierto. Solo la
+ * escribe el núcleo dueño; los contadores nunca se reinician. En el M0+ ni la suma de 64 bits ni
+ * la lectura son atómicas, así que el dueño los publica entre dos incrementos de seq (impar
+ * mientras escribe) y el otro núcleo los lee con activity_read(), repitiendo si seq cambió.
+ */
+typedef struct {
+    volatile uint32_t seq; ///< Impar mientras el dueño actualiza wakeups o busy_us
+    volatile uint32_t wakeups; ///< Salidas de WFE
+    volatile uint64_t busy_us; ///< Tiempo despierto
+    uint32_t awake_since_us; ///< Instante de la última salida de WFE
+} core_activity_t;
+
+extern core_activity_t core_activity[2];
+
+/**
+ * Registra que el núcleo va a dormir. Solo desde el núcleo dueño.
+ */
+static inline void activity_sleep(core_activity_t *a, uint32_t now_us) {
+    a->seq++;
+    __sync_synchronize();
+    a->busy_us += now_us - a->awake_since_us;
+    __sync_synchronize();
+    a->seq++;
+}
+
+/**
+ * Registra que el núcleo despertó. Solo desde el núcleo dueño.
+ */
+static inline void activity_wake(core_activity_t *a, uint32_t now_us) {
+    a->awake_since_us = now_us;
+    a->seq++;
+    __sync_synchronize();
+    a->wakeups++;
+    __sync_synchronize();
+    a->seq++;
+}
+
+void telemetry_init(engine_t *e, task_t *self);
+
+void telemetry_set_enabled(bool enabled);
+
+void telemetry_print_status(void);
+
+void telemetry_print_power(void);
+
+void telemetry_print_memory(void);
+
+void telemetry_print_record(void);
+
+void telemetry_task(void *ctx);
+
+#endif
@@ -0,0 +1,101 @@
+## @package bench_diff
+#  Compara los reportes del firmware de medición (bench.c) de dos compilaciones.
+#
+#  Cada reporte es la sesión serie capturada mientras corre el firmware bench; solo se leen las
+#  líneas "@BENCH,<prueba>,<métrica>,<valor>", el resto se ignora. Para cada métrica presente en
+#  ambos reportes imprime el valor anterior, el nuevo y la variación, y la marca como regresión
+#  si empeora más que el umbral. Si una métrica mejora o empeora depende de su nombre: las
+#  frecuencias, los bloques por segundo y el rechazo son mejores cuanto más altos; los ciclos, la
+#  carga y los bloques repetidos, cuanto más bajos. Las métricas de "build" se muestran pero no se evalúan.
+#  Termina con código 1 si hay alguna regresión, para usarlo en un script de integración.
+#
+#  @section usage Uso
+#  - timeout 15 cat /dev/ttyACM0 > nuevo.txt   (después de cargar bench.uf2)
+#  - python3 tools/bench_diff.py [-t PORCENTAJE] anterior.txt nuevo.txt
+#
+#  @section author Autores
+#  - Santiago Giraldo Tabares & Ana María Velasco Montenegro.
+
+import argparse
+import sys
+
+PREFIX = "@BENCH,"
+
+## Métricas en las que un valor más alto es mejor
+HIGHER_IS_BETTER = ("blocks_per_s", "max_sample_rate", "rejection_db", "max_input_rate")
+
+
+## Lee un reporte
+#  @param path Ruta de la sesión capturada.
+#  @return Diccionario {(prueba, métrica): valor} en el orden del reporte.
+def read_report(path):
+    results = {}
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            start = line.find(PREFIX)
+            if start < 0:
+                continue
+            fields = line[start + len(PREFIX):].strip().split(",")
+            if len(fields) != 3:
+                continue
+            try:
+                results[(fields[0], fields[1])] = float(fields[2])
+            except ValueError:
+                continue
+    return results
+
+
+## Variación relativa en porcentaje, positiva cuando la métrica empeora
+#  @param metric Nombre de la métrica.
+#  @param old Valor anterior.
+#  @param new Valor nuevo.
+def worsening(metric, old, new):
+    if old == 0:
+        return 0.0 if new == 0 else (100.0 if metric not in HIGHER_IS_BETTER else -100.0)
+    change = (new - old) * 100.0 / abs(old)
+    return -change if metric in HIGHER_IS_BETTER else change
+
+
+## Punto de entrada: imprime la comparación y devuelve 1 si hay regresiones
+def main():
+    parser = argparse.ArgumentParser(description="Compara dos reportes del firmware bench")
+    parser.add_argument("-t", "--threshold", type=float, default=5.0,
+                        help="empeoramiento máximo admitido, en porcentaje (por defecto 5)")
+    parser.add_argument("old", help="reporte de referencia")
+    parser.add_argument("new", help="reporte nuevo")
+    args = parser.parse_args()
+
+    old = read_report(args.old)
+    new = read_report(args.new)
+    if not old or not new:
+        print("bench_diff: algún reporte no tiene líneas %s" % PREFIX, file=sys.stderr)
+        return 2
+
+    regressions = 0
+    print("%-18s %-18s %14s %14s %8s" % ("prueba", "metrica", "anterior", "nuevo", "cambio"))
+    for key in list(old) + [k for k in new if k not in old]:
+        test, metric = key
+        if test == "end":
+            continue
+        if key not in old or key not in new:
+            print("%-18s %-18s %14s %14s" % (test, metric,
+                                            "%.3f" % old[key] if key in old else "-",
+                                            "%.3f" % new[key] if key in new else "-"))
+            continue
+        mark = ""
+        worse = worsening(metric, old[key], new[key])
+        if test != "build" and worse > args.threshold:
+            mark = "  REGRESION"
+            regressions += 1
+        change = (new[key] - old[key]) * 100.0 / abs(old[key]) if old[key] else 0.0
+        print("%-18s %-18s %14.3f %14.3f %+7.1f%%%s" % (test, metric, old[key], new[key], change, mark))
+
+    if regressions:
+        print("bench_diff: %d regresiones por encima del %.1f%%" % (regressions, args.threshold),
+              file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,192 @@
+## @package fir_design
+#  Diseña los coeficientes del remuestreo polifásico (siggen/polyphase.c) y de la cadena de
+#  interpolación (siggen/interp_chain.c) y los imprime como arreglos de C listos para pegar.
+#
+#  Cada banco es un filtro prototipo sinc con ventana de Kaiser, de corte en la mitad de la
+#  frecuencia de las muestras de entrada, partido en POLYPHASE_PHASES fases de taps coeficientes.
+#  La fila p tiene los coeficientes para una posición p / POLYPHASE_PHASES de muestra después de la
+#  muestra de referencia; se agrega la fila POLYPHASE_PHASES (una muestra entera, la fila 0 corrida
+#  un lugar) para que el código pueda interpolar entre fases sin tratar el borde aparte. Los
+#  coeficientes van en Q14, porque el central de las fases cercanas a 0 pasa de 1, y cada fila se
+#  ajusta para sumar exactamente 16384, así que una entrada constante sale sin cambios y la fila 0
+#  es la identidad. También imprime, para cada banco, la respuesta del prototipo: la caída en la
+#  banda de paso y la peor imagen que deja pasar.
+#
+#  Las etapas de medio banda de la cadena duplican la frecuencia: una salida de cada dos es la
+#  entrada y la otra, la suma de pares de muestras simétricas por un coeficiente en Q14 (sinc con
+#  ventana de Kaiser), como los bancos, para que la suma no desborde 32 bits. Los coeficientes de
+#  cada etapa suman 0,5, así que la interpolación de una entrada constante sale igual. La
+#  compensación del CIC es un FIR de tres coeficientes (-a, 1 + 2a, -a) que levanta la caída del CIC
+#  en el borde de la banda de paso; a depende del factor del CIC, así que se imprime uno por cada
+#  log2 del factor.
+#
+#  @section usage Uso
+#  - python3 tools/fir_design.py > bancos.txt
+#
+#  @section author Autores
+#  - Santiago Giraldo Tabares & Ana María Velasco Montenegro.
+
+import math
+import sys
+
+PHASES = 128  ## POLYPHASE_PHASES
+ONE = 16384  ## 1.0 en Q14
+
+## Bancos: nombre del arreglo, coeficientes por fase y beta de la ventana de Kaiser
+BANKS = (
+    ("coefs_low", 4, 3.0),
+    ("coefs_mid", 8, 5.0),
+    ("coefs_high", 16, 8.0),
+)
+
+## Contenido de la tabla, en fracción de su frecuencia de muestreo, para el que se informa la respuesta
+PASSBAND = 0.25
+
+## Etapas de medio banda: nombre del arreglo, pares de coeficientes y beta de la ventana de Kaiser
+HALFBANDS = (
+    ("halfband1", 8, 6.0),
+    ("halfband2", 4, 6.0),
+)
+
+## Banda de paso de la cadena, en fracción de la frecuencia de su entrada (18 kHz a 48 kHz)
+CHAIN_PASSBAND = 0.375
+
+CIC_ORDER = 4  ## INTERP_CHAIN_CIC_ORDER
+CIC_MAX_SHIFT = 4  ## INTERP_CHAIN_CIC_MAX_SHIFT
+
+
+## Función de Bessel modificada de orden 0, por su serie
+def bessel_i0(x):
+    total = term = 1.0
+    k = 1
+    while term > 1e-15 * total:
+        term *= (x / (2 * k)) ** 2
+        total += term
+        k += 1
+    return total
+
+
+## Prototipo continuo: sinc de corte en la mitad de la frecuencia de entrada con ventana de Kaiser
+#  @param t    Tiempo en muestras de entrada desde el centro.
+#  @param taps Largo de la ventana en muestras.
+#  @param beta Parámetro de la ventana.
+def prototype(t, taps, beta):
+    r = 1 - (2 * t / taps) ** 2
+    if r <= 0:
+        return 0.0
+    s = 1.0 if t == 0 else math.sin(math.pi * t) / (math.pi * t)
+    return s * bessel_i0(beta * math.sqrt(r)) / bessel_i0(beta)
+
+
+## Filas del banco en Q14. El coeficiente k de la fila p multiplica la muestra k - (taps / 2 - 1)
+#  posiciones después de la de referencia.
+def design(taps, beta):
+    rows = []
+    for p in range(PHASES + 1):
+        row = [prototype(k - (taps // 2 - 1) - p / PHASES, taps, beta) for k in range(taps)]
+        gain = sum(row)
+        q = [int(round(c * ONE / gain)) for c in row]
+        # El error de redondeo va al coeficiente más grande, que es el que menos cambia en proporción
+        big = max(range(taps), key=lambda k: abs(q[k]))
+        q[big] += ONE - sum(q)
+        rows.append(q)
+    return rows
+
+
+## Respuesta en amplitud del prototipo armado con las filas cuantizadas
+#  @param rows Filas del banco.
+#  @param f    Frecuencia en fracción de la frecuencia de las muestras de entrada.
+def response(rows, f):
+    re = im = 0.0
+    taps = len(rows[0])
+    for p in range(PHASES):
+        for k in range(taps):
+            t = k - (taps // 2 - 1) - p / PHASES
+            re += rows[p][k] * math.cos(2 * math.pi * f * t)
+            im += rows[p][k] * math.sin(2 * math.pi * f * t)
+    return math.hypot(re, im) / (ONE * PHASES)
+
+
+## Coeficientes de una etapa de medio banda en Q14: el k multiplica las dos muestras a k + 1/2
+#  muestras de entrada de la posición interpolada.
+def design_halfband(pairs, beta):
+    c = []
+    for k in range(pairs):
+        t = k + 0.5
+        window = bessel_i0(beta * math.sqrt(max(0.0, 1 - (t / pairs) ** 2))) / bessel_i0(beta)
+        c.append(math.sin(math.pi * t) / (math.pi * t) * window)
+    gain = 2 * sum(c)
+    q = [int(round(x * ONE / gain)) for x in c]
+    q[0] += ONE // 2 - sum(q)
+    return q
+
+
+## Respuesta de una etapa de medio banda, relativa a la de continua
+#  @param f Frecuencia en fracción de la frecuencia de salida de la etapa.
+def halfband_response(c, f):
+    return abs(1 + sum(2 * ck / ONE * math.cos(2 * math.pi * f * (2 * k + 1)) for k, ck in enumerate(c))) / 2
+
+
+## Caída del CIC de orden CIC_ORDER y factor r a la frecuencia f de su entrada
+def cic_response(f, r):
+    return abs(math.sin(math.pi * f) / (r * math.sin(math.pi * f / r))) ** CIC_ORDER
+
+
+## Coeficiente a de la compensación (en Q15) para que la caída del CIC en el borde de la banda de
+#  paso quede en 0 dB
+def design_compensation(r):
+    f = CHAIN_PASSBAND / 4
+    droop = cic_response(f, r)
+    a = (1 / droop - 1) / (2 * (1 - math.cos(2 * math.pi * f)))
+    return int(round(a * 32768)), droop
+
+
+## Imprime valores como arreglo de C, doce por línea como las tablas de siggen/
+def print_array(declaration, values):
+    print("static const int16_t %s = {" % declaration)
+    for i in range(0, len(values), 12):
+        line = ", ".join(str(v) for v in values[i:i + 12])
+        print("    %s%s" % (line, "," if i + 12 < len(values) else ""))
+    print("};")
+
+
+## Imprime un banco como arreglo de C
+def print_bank(name, rows):
+    print_array("%s[(POLYPHASE_PHASES + 1) * %d]" % (name, len(rows[0])), [c for row in rows for c in row])
+
+
+## Punto de entrada
+def main():
+    for name, taps, beta in BANKS:
+        rows = design(taps, beta)
+        passband = min(response(rows, PASSBAND * i / 50) for i in range(51))
+        image = max(response(rows, 1 - PASSBAND + 2 * PASSBAND * i / 200) for i in range(201))
+        print("// %s: %d coeficientes por fase, beta %.1f; con contenido hasta %.2f de la frecuencia de la tabla, "
+              "caída %.2f dB e imágenes a %.1f dB" % (name, taps, beta, PASSBAND, 20 * math.log10(passband),
+                                                     20 * math.log10(image)), file=sys.stderr)
+        print_bank(name, rows)
+        print()
+
+    edge = CHAIN_PASSBAND / 2
+    for name, pairs, beta in HALFBANDS:
+        c = design_halfband(pairs, beta)
+        ripple = max(abs(20 * math.log10(halfband_response(c, edge * i / 50))) for i in range(51))
+        image = max(halfband_response(c, 0.5 - edge + edge * i / 100) for i in range(101))
+        print("// %s: %d pares, beta %.1f; con contenido hasta %.4f de la frecuencia de salida, ondulación %.3f dB "
+              "e imágenes a %.1f dB" % (name, pairs, beta, edge, ripple, 20 * math.log10(image)), file=sys.stderr)
+        print_array("%s[%d]" % (name, pairs), c)
+        print()
+        edge /= 2
+
+    comp = [0]
+    for shift in range(1, CIC_MAX_SHIFT + 1):
+        a, droop = design_compensation(1 << shift)
+        comp.append(a)
+        print("// CIC x%d: caída %.2f dB en el borde, a = %.4f" % (1 << shift, 20 * math.log10(droop), a / 32768),
+              file=sys.stderr)
+    print_array("cic_comp[INTERP_CHAIN_CIC_MAX_SHIFT + 1]", comp)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,101 @@
+## @package mem_budget
+#  Verifica el consumo de SRAM y flash de cada subsistema contra su presupuesto.
+#
+#  Lee el mapa del enlazador (main.elf.map) con el mismo analizador que ram_report.py y asigna
+#  cada sección de entrada al primer subsistema de tools/mem_budget.txt cuyo patrón coincida con
+#  "objeto:sección". Las arenas estáticas (siggen/arena.h) ocupan cada una su propia sección
+#  .bss.arena_<nombre>_storage, así que pueden tener presupuesto propio. Imprime una tabla con el
+#  uso y el límite de cada subsistema y termina con código 1 si alguno se excede, lo que hace
+#  fallar la compilación cuando se ejecuta como paso POST_BUILD. También avisa si el enlazador
+#  incluyó malloc(), que el firmware no debe usar después del arranque.
+#
+#  @section usage Uso
+#  - python3 tools/mem_budget.py build/main.elf.map tools/mem_budget.txt
+#
+#  @section author Autores
+#  - Santiago Giraldo Tabares & Ana María Velasco Montenegro.
+
+import fnmatch
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from ram_report import parse_map, region_of, short_object
+
+
+## Lee el archivo de presupuestos
+#  @param path Ruta del archivo.
+#  @return Lista de (subsistema, límite de SRAM, límite de flash, patrones) en orden.
+def read_budgets(path):
+    budgets = []
+    with open(path, encoding="utf-8") as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            fields = line.split()
+            if len(fields) != 4:
+                raise ValueError("%s:%d: se esperan 4 campos" % (path, number))
+            budgets.append((fields[0], int(fields[1]), int(fields[2]), fields[3].split(",")))
+    return budgets
+
+
+## Devuelve el subsistema de una sección, o None si ningún patrón coincide
+#  @param budgets Presupuestos en orden.
+#  @param key Cadena "objeto:sección".
+def subsystem_of(budgets, key):
+    for name, _, _, patterns in budgets:
+        if any(fnmatch.fnmatchcase(key, p) for p in patterns):
+            return name
+    return None
+
+
+## Punto de entrada: imprime la tabla y devuelve 1 si algún presupuesto se excede
+def main():
+    if len(sys.argv) < 3:
+        print("Uso: mem_budget.py main.elf.map mem_budget.txt")
+        return 2
+    budgets = read_budgets(sys.argv[2])
+    sections = parse_map(sys.argv[1])
+
+    used = {name: {"SRAM": 0, "FLASH": 0} for name, _, _, _ in budgets}
+    malloc_users = set()
+    for section, addr, size, obj in sections:
+        region = region_of(addr)
+        if region is None:
+            continue
+        kind = "FLASH" if region == "FLASH" else "SRAM"
+        key = "%s:%s" % (short_object(obj), section)
+        name = subsystem_of(budgets, key)
+        if name is None:
+            continue
+        used[name][kind] += size
+        # El código y los datos inicializados en SRAM también ocupan su imagen en la flash
+        if kind == "SRAM" and not section.startswith((".bss", ".uninitialized", ".stack", ".heap")):
+            used[name]["FLASH"] += size
+        if section in (".text.malloc", ".text._malloc_r"):
+            malloc_users.add(short_object(obj))
+
+    status = 0
+    print("%-12s %9s %9s %9s %9s" % ("subsistema", "SRAM", "limite", "FLASH", "limite"))
+    for name, sram_max, flash_max, _ in budgets:
+        sram = used[name]["SRAM"]
+        flash = used[name]["FLASH"]
+        over = []
+        if sram > sram_max:
+            over.append("SRAM")
+        if flash > flash_max:
+            over.append("FLASH")
+        print("%-12s %9d %9d %9d %9d%s" % (name, sram, sram_max, flash, flash_max,
+                                           "  EXCEDIDO: " + ", ".join(over) if over else ""))
+        if over:
+            status = 1
+    if malloc_users:
+        print("aviso: malloc() enlazado desde %s" % ", ".join(sorted(malloc_users)))
+    if status:
+        print("mem_budget: presupuesto de memoria excedido (ver %s)" % sys.argv[2], file=sys.stderr)
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,112 @@
+## @package ram_report
+#  Reporte de qué quedó en SRAM según el mapa del enlazador (main.elf.map).
+#
+#  Recorre las secciones de entrada del mapa generado por el SDK de la Pico y las agrupa por banco
+#  de memoria según su dirección: flash (XIP), SRAM principal intercalada (SRAM0-3), SCRATCH_X
+#  (SRAM4) y SCRATCH_Y (SRAM5). Para cada banco de SRAM lista el código (.time_critical, .text) y
+#  los datos, de mayor a menor, para verificar que el camino crítico de síntesis quedó fuera de
+#  la flash.
+#
+#  @section usage Uso
+#  - python3 tools/ram_report.py build/main.elf.map [--all]
+#
+#  @section author Autores
+#  - Santiago Giraldo Tabares & Ana María Velasco Montenegro.
+
+import re
+import sys
+
+## Bancos de memoria del RP2040: (nombre, inicio, fin)
+REGIONS = [
+    ("FLASH", 0x10000000, 0x11000000),
+    ("SRAM", 0x20000000, 0x20040000),
+    ("SCRATCH_X", 0x20040000, 0x20041000),
+    ("SCRATCH_Y", 0x20041000, 0x20042000),
+]
+
+## Línea de sección de entrada, con o sin la dirección en la misma línea
+SECTION_RE = re.compile(r"^ (\.[\w.$]+)(?:\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(.*))?$")
+## Continuación con dirección, tamaño y objeto en la línea siguiente
+CONT_RE = re.compile(r"^\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(.*)$")
+
+
+## Devuelve el banco al que pertenece una dirección, o None
+#  @param addr Dirección absoluta.
+def region_of(addr):
+    for name, start, end in REGIONS:
+        if start <= addr < end:
+            return name
+    return None
+
+
+## Extrae (sección, dirección, tamaño, objeto) de cada sección de entrada no vacía del mapa
+#  @param path Ruta del archivo .map.
+def parse_map(path):
+    sections = []
+    pending = None
+    in_memory_map = False
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Linker script and memory map"):
+                in_memory_map = True
+                continue
+            if not in_memory_map:
+                continue
+            if pending:
+                m = CONT_RE.match(line)
+                if m:
+                    sections.append((pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3)))
+                pending = None
+                continue
+            m = SECTION_RE.match(line)
+            if not m:
+                continue
+            if m.group(2) is None:
+                pending = m.group(1)
+            else:
+                sections.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+    return [s for s in sections if s[2] > 0]
+
+
+## Nombre corto del objeto: "CMakeFiles/main.dir/siggen/synth.c.obj" -> "siggen/synth.c"
+#  @param obj Ruta del objeto en el mapa.
+def short_object(obj):
+    obj = re.sub(r".*\.dir/", "", obj)
+    return re.sub(r"\.obj$|\.o$", "", obj)
+
+
+## Punto de entrada: imprime el reporte
+def main():
+    if len(sys.argv) < 2:
+        print("Uso: ram_report.py main.elf.map [--all]")
+        return 2
+    show_all = "--all" in sys.argv[2:]
+    sections = parse_map(sys.argv[1])
+
+    totals = {}
+    by_region = {}
+    for name, addr, size, obj in sections:
+        region = region_of(addr)
+        if region is None:
+            continue
+        kind = "codigo" if name.startswith((".time_critical", ".text")) else "datos"
+        totals[(region, kind)] = totals.get((region, kind), 0) + size
+        by_region.setdefault(region, []).append((size, kind, name, addr, short_object(obj)))
+
+    for region, _, _ in REGIONS:
+        print("%-10s codigo %7d B, datos %7d B" % (region, totals.get((region, "codigo"), 0),
+                                                   totals.get((region, "datos"), 0)))
+    for region in ("SRAM", "SCRATCH_X", "SCRATCH_Y"):
+        entries = sorted(by_region.get(region, []), reverse=True)
+        # Sin --all solo se listan el código en RAM y los datos propios del proyecto
+        if not show_all:
+            entries = [e for e in entries if e[1] == "codigo" or "pico-sdk" not in e[4]]
+        print("\n[%s]" % region)
+        for size, kind, name, addr, obj in entries:
+            print("  0x%08x %6d %-6s %-40s %s" % (addr, size, kind, name, obj))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,120 @@
+## @package trace_to_chrome
+#  Convierte las trazas de siggen/trace.h al formato JSON de Chrome (chrome://tracing, Perfetto).
+#
+#  Lee sesiones serie del firmware (comando !trace, compilado con TRACE=ON) o archivos de
+#  host/gds_replay -t; el resto de las líneas se ignora. Cada volcado (línea @TRH) se convierte en
+#  un proceso y cada núcleo en un hilo. Las marcas de tiempo son ciclos de cada núcleo; se pasan a
+#  microsegundos con la frecuencia del encabezado y se alinean entre núcleos con el ancla
+#  (ciclos, uS) de cada uno. Los finales sin inicio, que quedan cuando el anillo sobrescribió el
+#  inicio, se descartan.
+#
+#  @section usage Uso
+#  - python3 tools/trace_to_chrome.py sesion.txt > traza.json
+#  - python3 tools/trace_to_chrome.py -o traza.json sesion.txt otra.txt
+#
+#  @section author Autores
+#  - Santiago Giraldo Tabares & Ana María Velasco Montenegro.
+
+import argparse
+import json
+import sys
+
+
+## Convierte una diferencia de 32 bits sin signo en un entero con signo
+def signed32(value):
+    value &= 0xFFFFFFFF
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+## Lee los volcados de un archivo
+#  @param path Ruta del archivo.
+#  @return Lista de volcados {"hz", "names", "anchors", "events"}.
+def read_dumps(path):
+    dumps = []
+    current = None
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            start = line.find("@TR")
+            if start < 0:
+                continue
+            fields = line[start:].strip().split(",")
+            kind = fields[0]
+            try:
+                if kind == "@TRH":
+                    current = {"hz": int(fields[1]), "names": {}, "anchors": {}, "events": []}
+                    dumps.append(current)
+                elif current is None:
+                    continue
+                elif kind == "@TRN":
+                    current["names"][int(fields[1])] = fields[2]
+                elif kind == "@TRA":
+                    current["anchors"][int(fields[1])] = (int(fields[2]), int(fields[3]))
+                elif kind == "@TR":
+                    current["events"].append((int(fields[1]), fields[2], int(fields[3]),
+                                              int(fields[4]), int(fields[5])))
+            except (IndexError, ValueError):
+                continue
+    return dumps
+
+
+## Convierte un volcado en eventos de Chrome
+#  @param dump Volcado leído con read_dumps().
+#  @param pid Identificador de proceso para este volcado.
+#  @param label Nombre del proceso.
+def convert(dump, pid, label):
+    out = [{"name": "process_name", "ph": "M", "pid": pid, "args": {"name": label}}]
+    cycles_per_us = dump["hz"] / 1e6
+    open_slices = {}
+
+    for core in sorted({e[0] for e in dump["events"]}):
+        out.append({"name": "thread_name", "ph": "M", "pid": pid, "tid": core,
+                    "args": {"name": "núcleo %d" % core}})
+
+    for core, phase, ident, ts, value in dump["events"]:
+        anchor_cycles, anchor_us = dump["anchors"].get(core, (0, 0))
+        us = anchor_us + signed32(ts - anchor_cycles) / cycles_per_us
+        name = dump["names"].get(ident, "id%d" % ident)
+        event = {"name": name, "ph": phase, "ts": round(us, 3), "pid": pid, "tid": core}
+        key = (core, ident)
+        if phase == "B":
+            open_slices[key] = open_slices.get(key, 0) + 1
+        elif phase == "E":
+            if not open_slices.get(key):
+                continue
+            open_slices[key] -= 1
+        elif phase == "C":
+            event["args"] = {"valor": value}
+        elif phase == "i":
+            event["s"] = "t"
+        out.append(event)
+    return out
+
+
+## Punto de entrada
+def main():
+    parser = argparse.ArgumentParser(description="Convierte trazas de siggen al formato de Chrome")
+    parser.add_argument("-o", "--output", help="archivo JSON de salida (por defecto, la salida estándar)")
+    parser.add_argument("inputs", nargs="+", help="sesiones capturadas")
+    args = parser.parse_args()
+
+    events = []
+    pid = 0
+    for path in args.inputs:
+        for index, dump in enumerate(read_dumps(path)):
+            events += convert(dump, pid, "%s #%d" % (path, index + 1))
+            pid += 1
+    if not pid:
+        print("trace_to_chrome: no hay volcados @TRH en la entrada", file=sys.stderr)
+        return 1
+
+    result = {"traceEvents": events, "displayTimeUnit": "ns"}
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            json.dump(result, f)
+    else:
+        json.dump(result, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,42 @@
+/**
+ * @file trace_port.h
+ *
+ * @brief Reloj y sección crítica de siggen/trace.h en la Pico.
+ *
+ * Las marcas de tiempo son ciclos del SysTick del núcleo que registra el evento, que
+ * stackmon_init_core() deja contando libremente en 24 bits. El SysTick cuenta hacia abajo; su
+ * complemento es un contador ascendente.
+ */
+
+#ifndef TRACE_PORT_H
+#define TRACE_PORT_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/structs/sio.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+
+#define TRACE_PORT_CLOCK_MASK 0xFFFFFFu ///< Bits del contador de trace_port_clock()
+
+static inline uint32_t trace_port_clock(void) {
+    return ~systick_hw->cvr;
+}
+
+static inline uint32_t trace_port_time_us(void) {
+    return time_us_32();
+}
+
+static inline uint32_t trace_port_core(void) {
+    return sio_hw->cpuid;
+}
+
+static inline uint32_t trace_port_lock(void) {
+    return save_and_disable_interrupts();
+}
+
+static inline void trace_port_unlock(uint32_t key) {
+    restore_interrupts(key);
+}
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * @file tusb_config.h
+ *
+ * @brief Configuración de TinyUSB para el dispositivo compuesto de usb_dev.c.
+ *
+ * Al enlazar tinyusb_device en el firmware, pico_stdio_usb deja de tener descriptores propios y usa
+ * la primera interfaz CDC de estos; la pila la atiende la tarea USB del planificador.
+ */
+
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+#ifndef CFG_TUSB_RHPORT0_MODE
+#define CFG_TUSB_RHPORT0_MODE OPT_MODE_DEVICE
+#endif
+
+#ifndef CFG_TUSB_OS
+#define CFG_TUSB_OS OPT_OS_PICO
+#endif
+
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_CDC 1 ///< Consola (pico_stdio_usb)
+#define CFG_TUD_MSC 1 ///< Disco para importar formas de onda (msc_disk.h)
+#define CFG_TUD_HID 0
+#define CFG_TUD_MIDI 0
+#define CFG_TUD_VENDOR 0
+
+#define CFG_TUD_CDC_RX_BUFSIZE 256
+#define CFG_TUD_CDC_TX_BUFSIZE 1024 ///< Los reportes de la consola salen en ráfagas
+
+// Cada llamada a tud_msc_write10_cb() recibe hasta esta cantidad de bytes; varios sectores por
+// llamada reducen las vueltas del importador
+#define CFG_TUD_MSC_EP_BUFSIZE 4096
+
+#endif
@@ -0,0 +1,317 @@
+/**
+ * @file usb_audio.c
+ *
+ * @brief Controlador de la clase de audio 1.0 (parlante) para TinyUSB y remuestreo en el núcleo 1.
+ */
+
+#include "usb_audio.h"
+#include "usb_dev.h"
+#include "siggen/arena.h"
+#include "siggen/rate_match.h"
+#include "siggen/platform.h"
+#include "hardware/structs/systick.h"
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+#include <stdio.h>
+
+#define AUDIO_REQ_SET_CUR 0x01 ///< Pedido de clase SET_CUR
+#define AUDIO_REQ_GET_CUR 0x81 ///< Pedido de clase GET_CUR
+#define AUDIO_EP_SAMPLING_FREQ 0x01 ///< Control de frecuencia de muestreo del endpoint
+#define AUDIO_SUBCLASS_CONTROL 0x01
+#define AUDIO_SUBCLASS_STREAMING 0x02
+#define AUDIO_DEFAULT_RATE 48000 ///< Frecuencia hasta que el host elija otra
+
+usb_audio_stats_t usb_audio_stats;
+
+ARENA_DEFINE(arena_audio, "audio", sizeof(rate_match_t) + RATE_MATCH_SLOT_SAMPLES * sizeof(int16_t), 8);
+
+static rate_match_t *audio_queue; ///< Paquetes recibidos, entre la pila USB y el núcleo 1
+static int16_t *audio_drop; ///< Destino de los paquetes que no entran en la cola
+
+/**
+ * Estado del controlador, en el núcleo 0.
+ */
+static struct {
+    uint8_t itf_stream; ///< Interfaz de transmisión
+    uint8_t ep; ///< Endpoint OUT
+    const tusb_desc_endpoint_t *ep_desc; ///< Su descriptor, para abrirlo al elegir la alternativa 1
+    uint8_t alt; ///< Alternativa actual de la interfaz de transmisión
+    bool ep_open; ///< El endpoint está abierto (se abre una vez por enumeración)
+    bool busy; ///< Hay una transferencia programada
+    bool to_queue; ///< La transferencia programada es sobre un paquete de la cola
+    uint32_t rate; ///< Frecuencia de muestreo elegida por el host (Hz)
+    uint8_t freq[3]; ///< Dato de SET_CUR/GET_CUR de la frecuencia
+    uint32_t packets; ///< Paquetes recibidos
+} audio;
+
+/**
+ * Toma la cola de arena_audio y la prepara. Debe llamarse durante el arranque, antes de
+ * arena_seal().
+ * @param sample_rate Frecuencia de muestreo del DAC (Hz).
+ */
+void usb_audio_init(uint32_t sample_rate) {
+    audio_queue = arena_alloc(&arena_audio, sizeof(*audio_queue), 8);
+    audio_drop = arena_alloc(&arena_audio, RATE_MATCH_SLOT_SAMPLES * sizeof(int16_t), 4);
+    if (!audio_queue || !audio_drop) {
+        panic("arena audio agotada");
+    }
+    rate_match_init(audio_queue, sample_rate);
+    audio.rate = AUDIO_DEFAULT_RATE;
+}
+
+/**
+ * Programa la recepción del próximo paquete directamente sobre la cola, o sobre audio_drop si está
+ * llena.
+ */
+static void arm(uint8_t rhport) {
+    int16_t *slot = rate_match_slot(audio_queue);
+
+    audio.to_queue = slot != NULL;
+    audio.busy = usbd_edpt_xfer(rhport, audio.ep, (uint8_t *)(slot ? slot : audio_drop), USB_AUDIO_EP_SIZE);
+}
+
+/**
+ * El host eligió una alternativa de la interfaz de transmisión: 1 empieza el flujo y 0 lo termina.
+ * El endpoint no se cierra con la alternativa 0: cerrarlo y volver a abrirlo gasta memoria del
+ * controlador en cada vuelta, y una transferencia programada sin datos no molesta.
+ */
+static void set_alt(uint8_t rhport, uint8_t alt) {
+    audio.alt = alt;
+    if (!alt) {
+        rate_match_stop(audio_queue);
+        return;
+    }
+    if (!audio.ep_open && audio.ep_desc) {
+        audio.ep_open = usbd_edpt_open(rhport, audio.ep_desc);
+    }
+    rate_match_start(audio_queue, audio.rate);
+    if (audio.ep_open && !audio.busy) {
+        arm(rhport);
+    }
+}
+
+static void audio_driver_init(void) {
+}
+
+static void audio_driver_reset(uint8_t rhport) {
+    (void)rhport;
+    rate_match_stop(audio_queue);
+    audio.alt = 0;
+    audio.ep_open = false;
+    audio.busy = false;
+}
+
+/**
+ * Toma la interfaz de control de audio y las de transmisión que le siguen.
+ * @return Bytes de descriptores tomados, o 0 si la interfaz no es de audio.
+ */
+static uint16_t audio_driver_open(uint8_t rhport, const tusb_desc_interface_t *itf, uint16_t max_len) {
+    const uint8_t *p = (const uint8_t *)itf;
+    const uint8_t *end = p + max_len;
+
+    (void)rhport;
+    if (itf->bInterfaceClass != TUSB_CLASS_AUDIO || itf->bInterfaceSubClass != AUDIO_SUBCLASS_CONTROL) {
+        return 0;
+    }
+    audio.itf_stream = itf->bInterfaceNumber + 1;
+    for (p = tu_desc_next(p); p < end; p = tu_desc_next(p)) {
+        if (tu_desc_type(p) == TUSB_DESC_INTERFACE_ASSOCIATION) {
+            break;
+        }
+        if (tu_desc_type(p) == TUSB_DESC_INTERFACE) {
+            const tusb_desc_interface_t *d = (const tusb_desc_interface_t *)p;
+            if (d->bInterfaceClass != TUSB_CLASS_AUDIO || d->bInterfaceSubClass != AUDIO_SUBCLASS_STREAMING) {
+                break;
+            }
+        } else if (tu_desc_type(p) == TUSB_DESC_ENDPOINT) {
+            audio.ep_desc = (const tusb_desc_endpoint_t *)p;
+            audio.ep = audio.ep_desc->bEndpointAddress;
+        }
+    }
+    return (uint16_t)(p - (const uint8_t *)itf);
+}
+
+/**
+ * Pedidos de control: la alternativa de la interfaz de transmisión y la frecuencia de muestreo
+ * del endpoint (UAC 1.0, 5.2.3.2.3.1). Los que no se atienden los resuelve la pila o los rechaza.
+ */
+static bool audio_driver_control(uint8_t rhport, uint8_t stage, const tusb_control_request_t *req) {
+    if (req->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD &&
+        req->bmRequestType_bit.recipient == TUSB_REQ_RCPT_INTERFACE) {
+        // La interfaz de control no tiene alternativas: la pila responde por ella
+        if (tu_u16_low(req->wIndex) != audio.itf_stream) {
+            return false;
+        }
+        if (stage != CONTROL_STAGE_SETUP) {
+            return true;
+        }
+        if (req->bRequest == TUSB_REQ_SET_INTERFACE) {
+            set_alt(rhport, (uint8_t)req->wValue);
+            return tud_control_status(rhport, req);
+        }
+        if (req->bRequest == TUSB_REQ_GET_INTERFACE) {
+            return tud_control_xfer(rhport, req, &audio.alt, 1);
+        }
+        return false;
+    }
+
+    if (req->bmRequestType_bit.type != TUSB_REQ_TYPE_CLASS ||
+        req->bmRequestType_bit.recipient != TUSB_REQ_RCPT_ENDPOINT ||
+        tu_u16_high(req->wValue) != AUDIO_EP_SAMPLING_FREQ) {
+        return false;
+    }
+    if (req->bRequest == AUDIO_REQ_SET_CUR) {
+        if (stage == CONTROL_STAGE_SETUP) {
+            return tud_control_xfer(rhport, req, audio.freq, sizeof(audio.freq));
+        }
+        if (stage == CONTROL_STAGE_DATA) {
+            uint32_t rate = audio.freq[0] | (uint32_t)audio.freq[1] << 8 | (uint32_t)audio.freq[2] << 16;
+            if (rate == 44100 || rate == 48000) {
+                audio.rate = rate;
+                if (audio.alt) {
+                    rate_match_start(audio_queue, rate);
+                }
+            }
+        }
+        return true;
+    }
+    if (req->bRequest == AUDIO_REQ_GET_CUR) {
+        if (stage == CONTROL_STAGE_SETUP) {
+            audio.freq[0] = (uint8_t)audio.rate;
+            audio.freq[1] = (uint8_t)(audio.rate >> 8);
+            audio.freq[2] = (uint8_t)(audio.rate >> 16);
+            return tud_control_xfer(rhport, req, audio.freq, sizeof(audio.freq));
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Terminó la recepción de un paquete: se publica en la cola y se programa el siguiente.
+ */
+static bool audio_driver_xfer(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+    if (ep_addr != audio.ep) {
+        return false;
+    }
+    audio.busy = false;
+    if (result == XFER_RESULT_SUCCESS && audio.to_queue && audio.alt) {
+        rate_match_push(audio_queue, xferred_bytes / sizeof(int16_t));
+        audio.packets++;
+    }
+    if (audio.alt) {
+        arm(rhport);
+    }
+    return true;
+}
+
+#if USB_AUDIO_ENABLED
+const usbd_class_driver_t usb_audio_driver = {
+#if CFG_TUSB_DEBUG >= 2
+    .name = "UAC1",
+#endif
+    .init = audio_driver_init,
+    .reset = audio_driver_reset,
+    .open = audio_driver_open,
+    .control_xfer_cb = audio_driver_control,
+    .xfer_cb = audio_driver_xfer,
+    .sof = NULL,
+};
+#endif
+
+/**
+ * Núcleo 1: llena el bloque con el audio USB si hay un flujo.
+ * @return false si no hay flujo; el bloque lo llena otra fuente.
+ */
+bool SIGGEN_HOT(usb_audio_render)(uint8_t *block, size_t n) {
+    uint32_t start = systick_hw->cvr;
+
+    if (!rate_match_render(audio_queue, block, n)) {
+        return false;
+    }
+    // El SysTick cuenta hacia abajo en 24 bits
+    uint32_t cycles = (start - systick_hw->cvr) & 0xFFFFFF;
+    usb_audio_stats.total_cycles += cycles;
+    usb_audio_stats.samples += n;
+    if (cycles > usb_audio_stats.max_cycles) {
+        usb_audio_stats.max_cycles = cycles;
+    }
+    return true;
+}
+
+bool usb_audio_active(void) {
+    return audio_queue->state != RATE_MATCH_IDLE;
+}
+
+/**
+ * Elige la interpolación del remuestreo; el núcleo 1 la toma en el próximo bloque.
+ */
+void usb_audio_set_quality(polyphase_quality_t quality) {
+    rate_match_set_quality(audio_queue, quality);
+}
+
+/**
+ * Elige el factor de la cadena de interpolación que sube el audio antes del remuestreo; el núcleo
+ * 1 lo toma en el próximo bloque.
+ * @return false si el factor no es una potencia de 2 entre 1 e INTERP_CHAIN_MAX_FACTOR.
+ */
+bool usb_audio_set_chain(uint32_t factor) {
+    return rate_match_set_chain(audio_queue, factor);
+}
+
+/**
+ * Factor efectivo de la cadena de interpolación: el pedido, reducido para que la frecuencia del
+ * flujo por el factor quede por debajo de la del DAC.
+ */
+uint32_t usb_audio_chain_factor(void) {
+    return audio_queue->factor;
+}
+
+void usb_audio_reset_stats(void) {
+    usb_audio_stats.max_cycles = 0;
+    usb_audio_stats.total_cycles = 0;
+    usb_audio_stats.samples = 0;
+}
+
+/**
+ * Ciclos por muestra de salida, por 100, desde el último reporte.
+ */
+static uint32_t cycles_x100(void) {
+    uint32_t samples = usb_audio_stats.samples;
+
+    return samples ? (uint32_t)(usb_audio_stats.total_cycles * 100 / samples) : 0;
+}
+
+/**
+ * Imprime el estado del flujo, el nivel de la cola, la cadena de interpolación y el costo del
+ * remuestreo.
+ */
+void usb_audio_print(void) {
+    const rate_match_t *q = audio_queue;
+    uint32_t cost = cycles_x100();
+
+    if (!USB_AUDIO_ENABLED) {
+        printf("Audio USB deshabilitado (opción USB_AUDIO de CMake).\n");
+        return;
+    }
+    printf("Audio USB: %s, %lu Hz -> %lu Hz, cola %lu muestras (objetivo %lu), corrección %+ld ppm, vaciados %lu, "
+           "descartados %lu, paquetes %lu, cadena x%lu, remuestreo %s, %lu.%02lu ciclos por muestra (peor bloque %lu)\n",
+           rate_match_state_name(q->state), (unsigned long)audio.rate, (unsigned long)q->out_rate,
+           (unsigned long)q->fill, (unsigned long)q->target, (long)rate_match_ppm(q), (unsigned long)q->underruns,
+           (unsigned long)q->overruns, (unsigned long)audio.packets, (unsigned long)q->factor,
+           q->quality == POLYPHASE_NEAREST ? "lineal" : polyphase_quality_name(q->quality),
+           (unsigned long)(cost / 100), (unsigned long)(cost % 100), (unsigned long)usb_audio_stats.max_cycles);
+}
+
+/**
+ * Imprime el estado para herramientas de la máquina anfitriona:
+ * "@AUDIO,<estado>,<Hz>,<nivel>,<objetivo>,<ppm>,<vaciados>,<descartados>,<ciclos por muestra x100>".
+ */
+void usb_audio_print_record(void) {
+    const rate_match_t *q = audio_queue;
+
+    printf("@AUDIO,%d,%lu,%lu,%lu,%ld,%lu,%lu,%lu\n", (int)q->state, (unsigned long)audio.rate, (unsigned long)q->fill,
+           (unsigned long)q->target, (long)rate_match_ppm(q), (unsigned long)q->underruns, (unsigned long)q->overruns,
+           (unsigned long)cycles_x100());
+}
@@ -0,0 +1,91 @@
+/**
+ * @file usb_audio.h
+ *
+ * @brief Parlante USB Audio Class 1.0: el audio de la PC sale por el DAC.
+ *
+ * Con la opción USB_AUDIO=ON de CMake el dispositivo compuesto (usb_dev.h) agrega un parlante
+ * mono de 16 bits a 44,1 o 48 kHz, que todos los sistemas reconocen sin controlador. La versión
+ * de TinyUSB del SDK solo trae la clase de audio 2.0, así que la 1.0 la implementa este módulo
+ * como controlador de clase de la aplicación (usb_audio_driver, que usb_dev.c entrega a la pila).
+ *
+ * El endpoint isócrono es adaptativo: la PC manda las muestras a su propio ritmo y la Pico se
+ * adapta. Cada transferencia se programa directamente sobre el próximo paquete libre de la cola
+ * de siggen/rate_match.h, y el núcleo 1 la remuestrea a la frecuencia del DAC corrigiendo la
+ * deriva entre los relojes, con interpolación lineal o con el filtro polifásico que se elija con
+ * usb_audio_set_quality() (!interp en la consola). Antes del remuestreo, la cadena de
+ * interpolación de siggen/interp_chain.h puede subir el flujo por un factor entero
+ * (usb_audio_set_chain(), !chain): la PC sigue mandando a 48 kHz y el filtro fraccionario trabaja
+ * sobre una señal ya sobremuestreada. Mientras la PC reproduce, el audio reemplaza a la imagen de
+ * formas de onda y a la síntesis; al cerrar el flujo vuelven solas.
+ *
+ * La telemetría (!audio, @AUDIO y el reporte periódico) informa el nivel de la cola, la corrección
+ * del paso en ppm, los vaciados y paquetes descartados y el costo del remuestreo por muestra.
+ */
+
+#ifndef USB_AUDIO_H
+#define USB_AUDIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "siggen/polyphase.h"
+
+#define USB_AUDIO_DESC_LEN 102 ///< Bytes de USB_AUDIO_DESCRIPTOR()
+#define USB_AUDIO_EP_SIZE 100 ///< Bytes máximos por paquete: 50 muestras de 16 bits
+
+/**
+ * Descriptores de la función de audio: asociación de interfaces, control (terminal de entrada USB
+ * y parlante, sin unidad de volumen) y transmisión con la alternativa 0 sin endpoint y la 1 con el
+ * endpoint isócrono adaptativo.
+ * @param itf Primera de las dos interfaces.
+ * @param str Cadena del nombre.
+ * @param ep Endpoint OUT.
+ */
+#define USB_AUDIO_DESCRIPTOR(itf, str, ep) \
+    /* Asociación de las dos interfaces */ \
+    8, TUSB_DESC_INTERFACE_ASSOCIATION, itf, 2, TUSB_CLASS_AUDIO, 0x00, 0x00, str, \
+    /* Control */ \
+    9, TUSB_DESC_INTERFACE, itf, 0, 0, TUSB_CLASS_AUDIO, 0x01, 0x00, str, \
+    9, TUSB_DESC_CS_INTERFACE, 0x01, 0x00, 0x01, 30, 0, 1, (itf) + 1, \
+    12, TUSB_DESC_CS_INTERFACE, 0x02, 1, 0x01, 0x01, 0, 1, 0x00, 0x00, 0, 0, \
+    9, TUSB_DESC_CS_INTERFACE, 0x03, 2, 0x01, 0x03, 0, 1, 0, \
+    /* Transmisión: alternativa 0 sin ancho de banda */ \
+    9, TUSB_DESC_INTERFACE, (itf) + 1, 0, 0, TUSB_CLASS_AUDIO, 0x02, 0x00, 0, \
+    /* Alternativa 1: PCM mono de 16 bits a 44100 o 48000 Hz */ \
+    9, TUSB_DESC_INTERFACE, (itf) + 1, 1, 1, TUSB_CLASS_AUDIO, 0x02, 0x00, 0, \
+    7, TUSB_DESC_CS_INTERFACE, 0x01, 1, 1, 0x01, 0x00, \
+    14, TUSB_DESC_CS_INTERFACE, 0x02, 0x01, 1, 2, 16, 2, 0x44, 0xAC, 0x00, 0x80, 0xBB, 0x00, \
+    /* Endpoint isócrono adaptativo de 1 ms, con control de frecuencia de muestreo */ \
+    9, TUSB_DESC_ENDPOINT, ep, 0x09, USB_AUDIO_EP_SIZE, 0, 1, 0, 0, \
+    7, TUSB_DESC_CS_ENDPOINT, 0x01, 0x01, 0, 0, 0
+
+/**
+ * Costo del remuestreo en ciclos del reloj del sistema, medido con el SysTick del núcleo 1.
+ */
+typedef struct {
+    volatile uint32_t max_cycles; ///< Peor bloque desde el último reporte
+    volatile uint64_t total_cycles; ///< Suma desde el último reporte
+    volatile uint32_t samples; ///< Muestras de salida desde el último reporte
+} usb_audio_stats_t;
+
+extern usb_audio_stats_t usb_audio_stats;
+
+void usb_audio_init(uint32_t sample_rate);
+
+bool usb_audio_render(uint8_t *block, size_t n);
+
+bool usb_audio_active(void);
+
+void usb_audio_set_quality(polyphase_quality_t quality);
+
+bool usb_audio_set_chain(uint32_t factor);
+
+uint32_t usb_audio_chain_factor(void);
+
+void usb_audio_print(void);
+
+void usb_audio_print_record(void);
+
+void usb_audio_reset_stats(void);
+
+#endif
@@ -0,0 +1,262 @@
+/**
+ * @file usb_bulk.c
+ *
+ * @brief Controlador de la interfaz bulk del fabricante y modo binario de la consola.
+ */
+
+#include "usb_bulk.h"
+#include "wave_store.h"
+#include "siggen/arena.h"
+#include "siggen/bulk_proto.h"
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+#include <stdio.h>
+#include <string.h>
+
+ARENA_DEFINE(arena_bulk, "bulk", 2 * sizeof(bulk_proto_t), 8);
+
+static bulk_proto_t *usb_proto; ///< Receptor del endpoint OUT
+static bulk_proto_t *cdc_proto; ///< Receptor de la consola en modo binario
+
+/**
+ * Estado de los dos transportes, en el núcleo 0.
+ */
+static struct {
+    uint32_t sample_rate; ///< Frecuencia de muestreo del DAC (Hz)
+    uint8_t ep_out; ///< Endpoint OUT
+    uint8_t ep_in; ///< Endpoint IN
+    bool out_busy; ///< Hay una transferencia OUT programada
+    bool in_busy; ///< Hay una respuesta en camino
+    bool reply_pending; ///< Terminó una trama mientras la respuesta anterior estaba en camino
+    uint32_t replies_lost; ///< Respuestas reemplazadas por otra antes de enviarse
+    uint8_t in_buf[BULK_REPLY_LEN]; ///< Respuesta en camino
+    bool cdc; ///< La consola está en modo binario
+    uint32_t cdc_last_us; ///< Último dato de la consola en modo binario
+} bulk;
+
+/**
+ * TABLE: la carga va a la flash como una tabla importada, como las del disco USB.
+ */
+static bool table_begin(void *ctx, const bulk_header_t *head) {
+    (void)ctx;
+    if (!head->len) {
+        return false;
+    }
+    wave_store_import_begin();
+    return true;
+}
+
+static uint8_t *table_window(void *ctx, size_t *len) {
+    (void)ctx;
+    return wave_store_import_window(len);
+}
+
+static void table_commit(void *ctx, size_t len) {
+    (void)ctx;
+    wave_store_import_commit(len);
+}
+
+static bool table_end(void *ctx, const bulk_header_t *head, bool ok) {
+    (void)ctx;
+    if (!ok) {
+        wave_store_import_abort();
+        return false;
+    }
+    // Con frecuencia de muestreo, la tabla suena a esa velocidad; sin ella, una muestra por muestra de salida
+    uint64_t inc = head->arg ? ((uint64_t)head->arg << 16) / bulk.sample_rate : 1u << 16;
+    if (!wave_store_import_end(bulk.sample_rate, inc > UINT32_MAX ? UINT32_MAX : inc ? (uint32_t)inc : 1)) {
+        return false;
+    }
+    wave_store_select(0);
+    return true;
+}
+
+static const bulk_target_t table_target = {
+    .begin = table_begin,
+    .window = table_window,
+    .commit = table_commit,
+    .end = table_end,
+};
+
+/**
+ * Toma los dos receptores de arena_bulk y los prepara. Debe llamarse durante el arranque, antes de
+ * arena_seal().
+ * @param sample_rate Frecuencia de muestreo del DAC (Hz), para las tablas con frecuencia propia.
+ */
+void usb_bulk_init(uint32_t sample_rate) {
+    usb_proto = arena_alloc(&arena_bulk, sizeof(*usb_proto), 8);
+    cdc_proto = arena_alloc(&arena_bulk, sizeof(*cdc_proto), 8);
+    if (!usb_proto || !cdc_proto) {
+        panic("arena bulk agotada");
+    }
+    bulk.sample_rate = sample_rate;
+    bulk_proto_init(usb_proto, false);
+    bulk_proto_set_target(usb_proto, BULK_OP_TABLE, &table_target, NULL);
+    bulk_proto_init(cdc_proto, true);
+    bulk_proto_set_target(cdc_proto, BULK_OP_TABLE, &table_target, NULL);
+}
+
+/**
+ * Programa la próxima transferencia OUT donde el receptor la pida.
+ */
+static void arm_out(uint8_t rhport) {
+    size_t len;
+    uint8_t *dst = bulk_proto_rx_buf(usb_proto, &len);
+
+    bulk.out_busy = usbd_edpt_xfer(rhport, bulk.ep_out, dst, (uint16_t)len);
+}
+
+/**
+ * Envía la última respuesta, o la deja pendiente si la anterior todavía está en camino.
+ */
+static void send_reply(uint8_t rhport) {
+    if (bulk.in_busy) {
+        bulk.replies_lost += bulk.reply_pending;
+        bulk.reply_pending = true;
+        return;
+    }
+    bulk.reply_pending = false;
+    memcpy(bulk.in_buf, usb_proto->reply, sizeof(bulk.in_buf));
+    bulk.in_busy = usbd_edpt_xfer(rhport, bulk.ep_in, bulk.in_buf, sizeof(bulk.in_buf));
+}
+
+static void bulk_driver_init(void) {
+}
+
+static void bulk_driver_reset(uint8_t rhport) {
+    (void)rhport;
+    bulk_proto_abort(usb_proto);
+    bulk.out_busy = false;
+    bulk.in_busy = false;
+    bulk.reply_pending = false;
+}
+
+/**
+ * Toma la interfaz del fabricante con sus dos endpoints bulk y programa la primera recepción.
+ * @return Bytes de descriptores tomados, o 0 si la interfaz no es esta.
+ */
+static uint16_t bulk_driver_open(uint8_t rhport, const tusb_desc_interface_t *itf, uint16_t max_len) {
+    uint16_t len = sizeof(tusb_desc_interface_t) + 2 * sizeof(tusb_desc_endpoint_t);
+
+    if (itf->bInterfaceClass != TUSB_CLASS_VENDOR_SPECIFIC || itf->bNumEndpoints != 2 || max_len < len) {
+        return 0;
+    }
+    if (!usbd_open_edpt_pair(rhport, tu_desc_next(itf), 2, TUSB_XFER_BULK, &bulk.ep_out, &bulk.ep_in)) {
+        return 0;
+    }
+    arm_out(rhport);
+    return len;
+}
+
+static bool bulk_driver_control(uint8_t rhport, uint8_t stage, const tusb_control_request_t *req) {
+    (void)rhport;
+    (void)stage;
+    (void)req;
+    return false;
+}
+
+static bool bulk_driver_xfer(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+    if (ep_addr == bulk.ep_out) {
+        bulk.out_busy = false;
+        if (result == XFER_RESULT_SUCCESS && bulk_proto_rx_done(usb_proto, xferred_bytes, time_us_32())) {
+            send_reply(rhport);
+        }
+        arm_out(rhport);
+        return true;
+    }
+    if (ep_addr == bulk.ep_in) {
+        bulk.in_busy = false;
+        if (bulk.reply_pending) {
+            send_reply(rhport);
+        }
+        return true;
+    }
+    return false;
+}
+
+const usbd_class_driver_t usb_bulk_driver = {
+#if CFG_TUSB_DEBUG >= 2
+    .name = "GDS bulk",
+#endif
+    .init = bulk_driver_init,
+    .reset = bulk_driver_reset,
+    .open = bulk_driver_open,
+    .control_xfer_cb = bulk_driver_control,
+    .xfer_cb = bulk_driver_xfer,
+    .sof = NULL,
+};
+
+/**
+ * Pasa la consola a modo binario. La tarea de la consola deja de leer hasta que termine.
+ */
+void usb_bulk_cdc_start(void) {
+    bulk_proto_abort(cdc_proto);
+    bulk.cdc_last_us = time_us_32();
+    bulk.cdc = true;
+}
+
+bool usb_bulk_cdc_active(void) {
+    return bulk.cdc;
+}
+
+/**
+ * Tarea USB, después de tud_task(): en modo binario entrega lo que llegó por la consola al
+ * receptor y contesta cada trama por la misma consola, sin pasar por stdio.
+ */
+void usb_bulk_poll(void) {
+    uint32_t now = time_us_32();
+
+    if (!bulk.cdc) {
+        return;
+    }
+    while (tud_cdc_available()) {
+        size_t len;
+        uint8_t *dst = bulk_proto_rx_buf(cdc_proto, &len);
+        uint32_t n = tud_cdc_read(dst, (uint32_t)len);
+        if (!n) {
+            break;
+        }
+        now = time_us_32();
+        bulk.cdc_last_us = now;
+        if (bulk_proto_rx_done(cdc_proto, n, now)) {
+            tud_cdc_write(cdc_proto->reply, BULK_REPLY_LEN);
+            tud_cdc_write_flush();
+            if (cdc_proto->last.op == BULK_OP_END) {
+                bulk.cdc = false;
+                return;
+            }
+        }
+    }
+    if (now - bulk.cdc_last_us > USB_BULK_CDC_IDLE_US) {
+        bulk_proto_abort(cdc_proto);
+        bulk.cdc = false;
+    }
+}
+
+static void print_proto(const char *name, const bulk_proto_t *p) {
+    const bulk_reply_t *r = &p->last;
+
+    printf("%s: tramas %lu, errores %lu, %llu bytes (%llu copiados), última: operación %u, %s, %lu bytes en %lu us "
+           "(%lu kB/s)\n", name, (unsigned long)p->frames, (unsigned long)p->errors, (unsigned long long)p->bytes,
+           (unsigned long long)p->bounced_bytes, r->op, bulk_status_name(r->status), (unsigned long)r->count,
+           (unsigned long)r->elapsed_us, r->elapsed_us ? (unsigned long)((uint64_t)r->count * 1000 / r->elapsed_us) : 0);
+}
+
+/**
+ * Imprime las tramas recibidas por cada camino y el caudal de la última: una línea para leer por
+ * camino y otra para programas, @BULK,tramas,errores,bytes,copiados,estado,bytes_última,us_última
+ * del endpoint.
+ */
+void usb_bulk_print(void) {
+    const bulk_reply_t *r = &usb_proto->last;
+
+    print_proto("Endpoint bulk", usb_proto);
+    print_proto("Consola", cdc_proto);
+    if (bulk.replies_lost) {
+        printf("Respuestas perdidas: %lu (el host no las leyó a tiempo)\n", (unsigned long)bulk.replies_lost);
+    }
+    printf("@BULK,%lu,%lu,%llu,%llu,%u,%lu,%lu\n", (unsigned long)usb_proto->frames, (unsigned long)usb_proto->errors,
+           (unsigned long long)usb_proto->bytes, (unsigned long long)usb_proto->bounced_bytes, r->status,
+           (unsigned long)r->count, (unsigned long)r->elapsed_us);
+}
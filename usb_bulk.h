@@ -0,0 +1,42 @@
+/**
+ * @file usb_bulk.h
+ *
+ * @brief Interfaz USB del fabricante con un par de endpoints bulk para cargar tablas a la máxima
+ * velocidad, y el mismo protocolo por la consola para comparar.
+ *
+ * La consola CDC pasa cada byte por la FIFO de la clase y por la disciplina de línea del host,
+ * que en modo texto traduce o se come algunos bytes. El dispositivo compuesto (usb_dev.h) agrega
+ * una interfaz de clase 0xFF con un endpoint OUT y uno IN de 64 bytes, atendida por un controlador
+ * de clase de la aplicación que habla el protocolo de siggen/bulk_proto.h: cada transferencia OUT
+ * se programa directamente sobre la página de la flash en construcción (wave_store_import_window())
+ * o, para SINK, sobre un búfer que se descarta; el único paso intermedio es la copia de la memoria
+ * del controlador USB que hace la pila.
+ *
+ * Con "!bulk cdc" la consola pasa a recibir las mismas tramas en binario, copiadas desde la FIFO
+ * de la clase CDC, hasta una trama END o USB_BULK_CDC_IDLE_US sin datos; host/gds_bulk mide el
+ * caudal de los dos caminos. "!bulk" informa las tramas, errores, bytes y el caudal de la última.
+ *
+ * En Linux la interfaz se usa con libusb sin controlador (hace falta permiso sobre el dispositivo,
+ * por ejemplo con una regla de udev); en Windows hay que asociarle WinUSB, por ejemplo con Zadig.
+ */
+
+#ifndef USB_BULK_H
+#define USB_BULK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define USB_BULK_EP_SIZE 64 ///< Bytes por paquete de los dos endpoints
+#define USB_BULK_CDC_IDLE_US 2000000 ///< Sin datos durante este tiempo, la consola vuelve al modo texto
+
+void usb_bulk_init(uint32_t sample_rate);
+
+void usb_bulk_poll(void);
+
+void usb_bulk_cdc_start(void);
+
+bool usb_bulk_cdc_active(void);
+
+void usb_bulk_print(void);
+
+#endif
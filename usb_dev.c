@@ -0,0 +1,199 @@
+/**
+ * @file usb_dev.c
+ *
+ * @brief Descriptores del dispositivo compuesto y tarea que atiende la pila TinyUSB.
+ */
+
+#include "usb_dev.h"
+#include "msc_disk.h"
+#include "usb_audio.h"
+#include "usb_bulk.h"
+#include "pico/stdlib.h"
+#include "pico/unique_id.h"
+#include "tusb.h"
+#include "device/usbd_pvt.h"
+#include <string.h>
+
+/**
+ * Interfaces. La consola va primero: pico_stdio_usb usa la interfaz CDC 0.
+ */
+enum {
+    ITF_CDC, ///< Control de la consola
+    ITF_CDC_DATA, ///< Datos de la consola
+    ITF_MSC, ///< Disco
+    ITF_BULK, ///< Tramas binarias
+#if USB_AUDIO_ENABLED
+    ITF_AUDIO_CTRL, ///< Control del parlante
+    ITF_AUDIO_STREAM, ///< Audio del parlante
+#endif
+    ITF_COUNT,
+};
+
+/**
+ * Cadenas de los descriptores.
+ */
+enum {
+    STR_LANGUAGE,
+    STR_MANUFACTURER,
+    STR_PRODUCT,
+    STR_SERIAL,
+    STR_CDC,
+    STR_MSC,
+    STR_BULK,
+    STR_AUDIO,
+};
+
+#define EP_CDC_NOTIF 0x81 ///< Notificaciones de la consola
+#define EP_CDC_OUT 0x02 ///< Datos de la consola, del host
+#define EP_CDC_IN 0x82 ///< Datos de la consola, al host
+#define EP_MSC_OUT 0x03 ///< Comandos y datos del disco, del host
+#define EP_MSC_IN 0x83 ///< Respuestas y datos del disco, al host
+#define EP_AUDIO_OUT 0x04 ///< Audio del parlante, del host
+#define EP_BULK_OUT 0x05 ///< Tramas binarias, del host
+#define EP_BULK_IN 0x85 ///< Respuestas a las tramas, al host
+
+#if USB_AUDIO_ENABLED
+#define CONFIG_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN + TUD_VENDOR_DESC_LEN + USB_AUDIO_DESC_LEN)
+#else
+#define CONFIG_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN + TUD_VENDOR_DESC_LEN)
+#endif
+
+extern const usbd_class_driver_t usb_bulk_driver; ///< usb_bulk.c
+#if USB_AUDIO_ENABLED
+extern const usbd_class_driver_t usb_audio_driver; ///< usb_audio.c
+#endif
+
+static task_t *usb_task; ///< Tarea que llama a tud_task()
+
+static const tusb_desc_device_t device_desc = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    // Con IAD, la clase la define cada interfaz
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_DEV_VID,
+    .idProduct = USB_DEV_PID,
+    .bcdDevice = USB_DEV_BCD,
+    .iManufacturer = STR_MANUFACTURER,
+    .iProduct = STR_PRODUCT,
+    .iSerialNumber = STR_SERIAL,
+    .bNumConfigurations = 1,
+};
+
+static const uint8_t config_desc[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_COUNT, 0, CONFIG_LEN, 0, 250),
+    TUD_CDC_DESCRIPTOR(ITF_CDC, STR_CDC, EP_CDC_NOTIF, 8, EP_CDC_OUT, EP_CDC_IN, 64),
+    TUD_MSC_DESCRIPTOR(ITF_MSC, STR_MSC, EP_MSC_OUT, EP_MSC_IN, 64),
+    TUD_VENDOR_DESCRIPTOR(ITF_BULK, STR_BULK, EP_BULK_OUT, EP_BULK_IN, USB_BULK_EP_SIZE),
+#if USB_AUDIO_ENABLED
+    USB_AUDIO_DESCRIPTOR(ITF_AUDIO_CTRL, STR_AUDIO, EP_AUDIO_OUT),
+#endif
+};
+
+static const char *const strings[] = {
+    [STR_MANUFACTURER] = "Raspberry Pi",
+    [STR_PRODUCT] = "Generador de señales GDS",
+    [STR_CDC] = "Consola GDS",
+    [STR_MSC] = "Disco de formas de onda GDS",
+    [STR_BULK] = "Tramas binarias GDS",
+    [STR_AUDIO] = "Parlante GDS",
+};
+
+/**
+ * Prepara la pila. Debe llamarse antes de stdio_init_all(), que espera encontrarla iniciada.
+ * @param self Tarea del planificador que ejecuta usb_dev_task().
+ */
+void usb_dev_init(task_t *self) {
+    usb_task = self;
+    tusb_init();
+}
+
+/**
+ * Tarea USB: procesa los eventos pendientes de la pila y los plazos del disco.
+ */
+void usb_dev_task(void *ctx) {
+    (void)ctx;
+
+    tud_task();
+    usb_bulk_poll();
+    msc_disk_poll();
+    sched_wake_at(usb_task, time_us_32() + USB_DEV_POLL_US);
+}
+
+/**
+ * La pila encoló un evento, casi siempre desde la interrupción del controlador: se despierta la
+ * tarea para atenderlo sin esperar al próximo periodo.
+ */
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
+    (void)rhport;
+    (void)eventid;
+    (void)in_isr;
+    if (usb_task) {
+        sched_wake(usb_task, time_us_32());
+    }
+}
+
+/**
+ * Controladores de clase propios, que TinyUSB prueba antes que los suyos: la interfaz bulk y el
+ * parlante.
+ */
+const usbd_class_driver_t *usbd_app_driver_get_cb(uint8_t *driver_count) {
+    static usbd_class_driver_t drivers[2];
+    uint8_t count = 0;
+
+    drivers[count++] = usb_bulk_driver;
+#if USB_AUDIO_ENABLED
+    drivers[count++] = usb_audio_driver;
+#endif
+    *driver_count = count;
+    return drivers;
+}
+
+const uint8_t *tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&device_desc;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return config_desc;
+}
+
+/**
+ * Descriptor de cadena en UTF-16. Los textos están en UTF-8; basta con decodificar las secuencias
+ * de dos bytes (hasta U+07FF), que cubren los acentos y la eñe.
+ */
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    static uint16_t desc[40];
+    char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    const char *text;
+    size_t len = 0;
+
+    (void)langid;
+    if (index == STR_LANGUAGE) {
+        desc[1] = 0x0409;
+        len = 1;
+    } else {
+        if (index == STR_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            text = serial;
+        } else if (index < sizeof(strings) / sizeof(strings[0]) && strings[index]) {
+            text = strings[index];
+        } else {
+            return NULL;
+        }
+        for (const uint8_t *p = (const uint8_t *)text; *p && len < sizeof(desc) / sizeof(desc[0]) - 1; ++p) {
+            uint16_t c = *p;
+            if ((c & 0xE0) == 0xC0 && (p[1] & 0xC0) == 0x80) {
+                c = (uint16_t)((c & 0x1F) << 6 | (p[1] & 0x3F));
+                ++p;
+            }
+            desc[1 + len++] = c;
+        }
+    }
+    // Primer elemento: largo total en bytes y tipo de descriptor
+    desc[0] = (uint16_t)(TUSB_DESC_STRING << 8 | (2 * len + 2));
+    return desc;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file usb_dev.h
+ *
+ * @brief Dispositivo USB compuesto: la consola (CDC), el disco de formas de onda (MSC), la interfaz
+ * bulk del fabricante (usb_bulk.h) y, con la opción USB_AUDIO de CMake, el parlante (usb_audio.h).
+ *
+ * El firmware enlaza tinyusb_device y define sus propios descriptores, así que pico_stdio_usb ya
+ * no atiende la pila: lo hace usb_dev_task() desde el planificador del núcleo 0. Cada evento de la
+ * pila la despierta (tud_event_hook_cb()) y, además, corre cada USB_DEV_POLL_US para los plazos de
+ * msc_disk.c. Todas las retrollamadas de las clases, incluida la escritura de la flash del
+ * importador, se ejecutan dentro de tud_task(), en el núcleo 0 y fuera de interrupciones.
+ */
+
+#ifndef USB_DEV_H
+#define USB_DEV_H
+
+#include "siggen/sched.h"
+
+#ifndef USB_AUDIO_ENABLED
+#define USB_AUDIO_ENABLED 0 ///< Agregar el parlante USB (opción USB_AUDIO de CMake)
+#endif
+
+#define USB_DEV_VID 0x2E8A ///< Raspberry Pi
+#define USB_DEV_PID 0x000A ///< El mismo que la consola de pico_stdio_usb
+#if USB_AUDIO_ENABLED
+#define USB_DEV_BCD 0x0121 ///< Versión del dispositivo; distingue cada composición en la caché de Windows
+#else
+#define USB_DEV_BCD 0x0120 ///< Versión del dispositivo; distingue cada composición en la caché de Windows
+#endif
+#define USB_DEV_POLL_US 1000 ///< Periodo mínimo de la tarea USB, como el de pico_stdio_usb
+
+void usb_dev_init(task_t *self);
+
+void usb_dev_task(void *ctx);
+
+#endif
@@ -0,0 +1,324 @@
+/**
+ * @file wave_store.c
+ *
+ * @brief Validación de la imagen de formas de onda de la flash y reproducción desde el núcleo de
+ * síntesis.
+ */
+
+#include "wave_store.h"
+#include "pico/multicore.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "siggen/arena.h"
+#include "siggen/crc32.h"
+#include "siggen/platform.h"
+#include "siggen/wavepack.h"
+#include <stdio.h>
+#include <string.h>
+
+#define WAVE_STORE_STOP_TIMEOUT_US 10000 ///< Espera a que el núcleo 1 deje de leer la imagen (varios bloques)
+
+static wavepack_t pack; ///< Imagen de la flash
+static wavepack_result_t pack_result = WAVEPACK_ERR_MAGIC; ///< Resultado de la validación al arrancar
+static volatile int32_t requested = -1; ///< Secuencia pedida desde el núcleo 0; -1 = síntesis
+static volatile int32_t playing = -1; ///< Secuencia que reproduce el núcleo 1
+static volatile uint32_t playing_since_us; ///< Instante en que el núcleo 1 empezó la secuencia en curso
+static wavepack_player_t player; ///< Reproductor de la secuencia en curso
+static volatile polyphase_quality_t quality; ///< Filtro de los pasos fraccionarios, pedido desde el núcleo 0
+
+/**
+ * Importación en curso. La página 0 (encabezado, directorio y primeras muestras) se guarda en
+ * first_page y se programa al final, así que una importación interrumpida no deja una imagen que
+ * parezca válida.
+ */
+typedef struct {
+    uint8_t first_page[FLASH_PAGE_SIZE]; ///< Página 0 de la imagen
+    uint8_t page[FLASH_PAGE_SIZE]; ///< Página en construcción
+    uint32_t page_offset; ///< Posición de page en la imagen
+    uint32_t fill; ///< Bytes escritos en page
+    uint32_t erased; ///< Bytes borrados desde el principio de la región
+    uint32_t count; ///< Muestras de la tabla
+    uint32_t crc; ///< CRC-32 de la tabla
+} import_t;
+
+ARENA_DEFINE(arena_wave, "wave", sizeof(import_t), 4);
+
+static import_t *import; ///< Tomada de arena_wave en wave_store_init()
+
+/**
+ * Valida la imagen, incluido el CRC de cada carga (del orden de 150 ns por byte). Debe llamarse antes de
+ * arrancar el núcleo 1. Toma el estado de la importación de arena_wave.
+ */
+void wave_store_init(void) {
+    import = arena_alloc(&arena_wave, sizeof(*import), 4);
+    if (!import) {
+        panic("arena wave agotada");
+    }
+    pack_result = wavepack_open(&pack, (const void *)WAVE_STORE_ADDR, WAVE_STORE_SIZE, true);
+}
+
+/**
+ * Pide reproducir una secuencia de la imagen desde su primer paso, o volver a la síntesis con -1.
+ * El núcleo de síntesis la toma en el próximo bloque.
+ * @return false si no hay imagen válida o la secuencia no existe.
+ */
+bool wave_store_select(int32_t sequence) {
+    if (sequence >= 0 && (pack_result != WAVEPACK_OK || sequence >= pack.header->sequence_count)) {
+        return false;
+    }
+    requested = sequence;
+    return true;
+}
+
+/**
+ * Rellena un bloque con la secuencia en curso. Se llama desde el núcleo de síntesis.
+ * @return false si no hay secuencia elegida; el bloque queda sin tocar para la síntesis.
+ */
+bool SIGGEN_HOT(wave_store_render)(uint8_t *block, size_t n) {
+    int32_t want = requested;
+
+    if (want != playing) {
+        if (want >= 0) {
+            wavepack_player_init(&player, &pack, (uint32_t)want);
+            playing_since_us = time_us_32();
+        }
+        playing = want;
+    }
+    if (playing < 0) {
+        return false;
+    }
+    wavepack_player_set_quality(&player, quality);
+    wavepack_player_render(&player, block, n);
+    return true;
+}
+
+/**
+ * Elige cómo se leen las tablas en los pasos fraccionarios (siggen/polyphase.h). El núcleo de
+ * síntesis lo toma en el próximo bloque, sin reiniciar la secuencia.
+ */
+void wave_store_set_quality(polyphase_quality_t q) {
+    quality = q;
+}
+
+/**
+ * Imprime el estado de la imagen, sus tablas y secuencias y lo que se está reproduciendo.
+ */
+void wave_store_print(void) {
+    printf("Imagen de formas de onda en 0x%08lx: %s", (unsigned long)WAVE_STORE_ADDR, wavepack_result_name(pack_result));
+    if (pack_result == WAVEPACK_ERR_ENTRY || pack_result == WAVEPACK_ERR_CHUNK_CRC) {
+        printf(" (entrada %lu)", (unsigned long)pack.bad_entry);
+    }
+    if (pack_result != WAVEPACK_OK) {
+        printf("\n");
+        return;
+    }
+
+    const wavepack_header_t *h = pack.header;
+    printf(", %lu bytes, %u tablas, %u secuencias, %lu Hz\n", (unsigned long)h->image_size, h->table_count,
+           h->sequence_count, (unsigned long)h->sample_rate);
+    for (uint32_t i = 0; i < h->table_count; ++i) {
+        uint32_t len;
+        wavepack_table(&pack, i, &len);
+        printf("  tabla %lu: %lu muestras\n", (unsigned long)i, (unsigned long)len);
+    }
+    for (uint32_t i = 0; i < h->sequence_count; ++i) {
+        uint32_t count;
+        wavepack_sequence(&pack, i, &count);
+        printf("  secuencia %lu: %lu pasos\n", (unsigned long)i, (unsigned long)count);
+    }
+    if (requested >= 0) {
+        printf("Reproduciendo la secuencia %ld, pasos fraccionarios %s.\n", (long)requested,
+               polyphase_quality_name(quality));
+    } else {
+        printf("Reproduciendo la síntesis.\n");
+    }
+}
+
+/**
+ * Indica si el núcleo 1 está reproduciendo una secuencia de la imagen.
+ * @param since_us Recibe el instante (time_us_32()) en que la empezó.
+ */
+bool wave_store_playing(uint32_t *since_us) {
+    *since_us = playing_since_us;
+    return playing >= 0;
+}
+
+/**
+ * Borra o programa la región con el núcleo 1 detenido y las interrupciones deshabilitadas, como
+ * persist_save().
+ */
+static void flash_op(uint32_t offset, const uint8_t *data, size_t len) {
+    multicore_lockout_start_blocking();
+    uint32_t irq = save_and_disable_interrupts();
+    if (data) {
+        flash_range_program(WAVE_STORE_OFFSET + offset, data, len);
+    } else {
+        flash_range_erase(WAVE_STORE_OFFSET + offset, len);
+    }
+    restore_interrupts(irq);
+    multicore_lockout_end_blocking();
+}
+
+/**
+ * Borra lo que falta hasta end: de a bloque de 64 KB cuando está alineado (unas tres veces más
+ * rápido por byte) y si no de a sector.
+ */
+static void erase_until(uint32_t end) {
+    while (import->erased < end) {
+        uint32_t len = (WAVE_STORE_OFFSET + import->erased) % FLASH_BLOCK_SIZE == 0 &&
+                       import->erased + FLASH_BLOCK_SIZE <= WAVE_STORE_SIZE ? FLASH_BLOCK_SIZE : FLASH_SECTOR_SIZE;
+        flash_op(import->erased, NULL, len);
+        import->erased += len;
+    }
+}
+
+/**
+ * Cierra la página en construcción: la 0 se guarda para el final y las demás se programan.
+ */
+static void page_done(void) {
+    if (import->page_offset == 0) {
+        memcpy(import->first_page, import->page, FLASH_PAGE_SIZE);
+    } else {
+        erase_until(import->page_offset + FLASH_PAGE_SIZE);
+        flash_op(import->page_offset, import->page, FLASH_PAGE_SIZE);
+    }
+    import->page_offset += FLASH_PAGE_SIZE;
+    import->fill = 0;
+    memset(import->page, 0xFF, sizeof(import->page));
+}
+
+static void append(const void *data, size_t len) {
+    const uint8_t *src = (const uint8_t *)data;
+
+    while (len) {
+        size_t chunk = FLASH_PAGE_SIZE - import->fill < len ? FLASH_PAGE_SIZE - import->fill : len;
+        memcpy(import->page + import->fill, src, chunk);
+        import->fill += (uint32_t)chunk;
+        src += chunk;
+        len -= chunk;
+        if (import->fill == FLASH_PAGE_SIZE) {
+            page_done();
+        }
+    }
+}
+
+/**
+ * Empieza a importar una tabla: vuelve a la síntesis, espera a que el núcleo 1 deje de leer la
+ * imagen y borra su primer sector, así que la imagen anterior deja de valer desde aquí. Debe
+ * llamarse desde el núcleo 0 y fuera de interrupciones, igual que el resto de las funciones de
+ * importación.
+ */
+void wave_store_import_begin(void) {
+    uint32_t start = time_us_32();
+
+    requested = -1;
+    while (playing >= 0 && time_us_32() - start < WAVE_STORE_STOP_TIMEOUT_US) {
+        tight_loop_contents();
+    }
+    pack_result = WAVEPACK_ERR_MAGIC;
+    memset(import, 0, sizeof(*import));
+    memset(import->page, 0xFF, sizeof(import->page));
+    // El encabezado se completa al final
+    import->fill = WAVE_STORE_IMPORT_TABLE;
+    erase_until(FLASH_SECTOR_SIZE);
+}
+
+/**
+ * Agrega muestras a la tabla.
+ * @return false si no entraron todas (la región se llenó); las que sobran se descartan.
+ */
+bool wave_store_import_put(const uint8_t *codes, size_t count) {
+    size_t room = WAVE_STORE_IMPORT_MAX - import->count;
+    bool fits = count <= room;
+
+    count = fits ? count : room;
+    import->crc = crc32_update(import->crc, codes, count);
+    import->count += (uint32_t)count;
+    append(codes, count);
+    return fits;
+}
+
+/**
+ * Parte libre de la página en construcción, para recibir ahí las próximas muestras sin copia
+ * intermedia (usb_bulk.c). Lo que se escriba se confirma con wave_store_import_commit().
+ * @param len Bytes libres, acotados a lo que todavía entra en la tabla (0 si se llenó).
+ */
+uint8_t *wave_store_import_window(size_t *len) {
+    size_t room = WAVE_STORE_IMPORT_MAX - import->count;
+    size_t free = FLASH_PAGE_SIZE - import->fill;
+
+    *len = free < room ? free : room;
+    return import->page + import->fill;
+}
+
+/**
+ * Confirma count muestras escritas en la ventana de wave_store_import_window(); la página se
+ * programa cuando se completa.
+ */
+void wave_store_import_commit(size_t count) {
+    import->crc = crc32_update(import->crc, import->page + import->fill, count);
+    import->count += (uint32_t)count;
+    import->fill += (uint32_t)count;
+    if (import->fill == FLASH_PAGE_SIZE) {
+        page_done();
+    }
+}
+
+/**
+ * Termina la importación: agrega una secuencia de un paso que recorre la tabla sin fin, programa el
+ * resto y el encabezado, y vuelve a validar la imagen.
+ * @param sample_rate Frecuencia de muestreo de la salida (Hz).
+ * @param phase_inc   Muestras de la tabla por muestra de salida, en Q16.16.
+ * @return false si la tabla está vacía o la imagen no quedó válida.
+ */
+bool wave_store_import_end(uint32_t sample_rate, uint32_t phase_inc) {
+    if (!import->count) {
+        wave_store_import_abort();
+        return false;
+    }
+    uint32_t seq_offset = WAVE_STORE_IMPORT_TABLE + (import->count + WAVEPACK_ALIGN - 1) / WAVEPACK_ALIGN * WAVEPACK_ALIGN;
+    wavepack_step_t step = { .table = 0, .phase_inc = phase_inc ? phase_inc : 1, .samples = 0 };
+
+    // El relleno hasta la alineación queda en 0xFF, como la flash borrada; no cruza de página
+    import->fill += seq_offset - (import->page_offset + import->fill);
+    if (import->fill == FLASH_PAGE_SIZE) {
+        page_done();
+    }
+    append(&step, sizeof(step));
+    if (import->fill) {
+        page_done();
+    }
+
+    struct {
+        wavepack_header_t header;
+        wavepack_chunk_t dir[2];
+    } head = {
+        .header = {
+            .magic = WAVEPACK_MAGIC,
+            .version = WAVEPACK_VERSION,
+            .header_size = sizeof(wavepack_header_t),
+            .image_size = seq_offset + sizeof(step),
+            .sample_rate = sample_rate,
+            .table_count = 1,
+            .sequence_count = 1,
+        },
+        .dir = {
+            { WAVEPACK_TABLE, WAVE_STORE_IMPORT_TABLE, import->count, import->crc },
+            { WAVEPACK_SEQUENCE, seq_offset, 1, crc32_compute(&step, sizeof(step)) },
+        },
+    };
+    head.header.crc = crc32_update(crc32_compute(&head.header, offsetof(wavepack_header_t, crc)), head.dir, sizeof(head.dir));
+    memcpy(import->first_page, &head, sizeof(head));
+    flash_op(0, import->first_page, FLASH_PAGE_SIZE);
+
+    wave_store_init();
+    return pack_result == WAVEPACK_OK;
+}
+
+/**
+ * Abandona la importación. La región queda sin imagen válida.
+ */
+void wave_store_import_abort(void) {
+    pack_result = WAVEPACK_ERR_MAGIC;
+    memset(import, 0, sizeof(*import));
+}
@@ -0,0 +1,65 @@
+/**
+ * @file wave_store.h
+ *
+ * @brief Imagen wavepack (siggen/wavepack.h) guardada en la flash y reproducción de sus
+ * secuencias en lugar de la síntesis.
+ *
+ * La imagen ocupa WAVE_STORE_SIZE bytes justo antes del sector de persist.c y se graba junto con
+ * el firmware con el UF2 que genera host/gds_pack (dirección por defecto WAVE_STORE_ADDR). Se
+ * valida una vez al arrancar y después se lee en su lugar por XIP: las tablas no se copian a la
+ * SRAM.
+ *
+ * El disco USB (msc_disk.h) también escribe la región: wave_store_import_begin() detiene la
+ * reproducción de la imagen y borra su principio, las muestras se programan de a página a medida
+ * que llegan (borrando por adelantado de a sector, o de a bloque de 64 KB cuando está alineado) y
+ * wave_store_import_end() agrega una secuencia que recorre la tabla sin fin y escribe el
+ * encabezado, que está en la primera página, al final. Como en persist.c, cada operación detiene
+ * el núcleo 1 y las interrupciones del núcleo 0, así que la salida se congela mientras se importa.
+ * El endpoint bulk (usb_bulk.h) recibe las muestras directamente en la página en construcción con
+ * wave_store_import_window() y wave_store_import_commit().
+ *
+ * Los pasos con avance fraccionario leen la muestra más cercana, como el DDS, o pasan por el
+ * remuestreo polifásico de siggen/polyphase.h según wave_store_set_quality() (!interp).
+ */
+
+#ifndef WAVE_STORE_H
+#define WAVE_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "siggen/wavepack.h"
+
+#define WAVE_STORE_SIZE (512 * 1024) ///< Bytes reservados para la imagen
+#define WAVE_STORE_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE - WAVE_STORE_SIZE) ///< Desplazamiento dentro de la flash
+#define WAVE_STORE_ADDR (XIP_BASE + WAVE_STORE_OFFSET) ///< Dirección de la imagen en el mapa de memoria
+#define WAVE_STORE_IMPORT_TABLE 64 ///< Posición de la tabla importada: después del encabezado y dos entradas
+#define WAVE_STORE_IMPORT_MAX (WAVE_STORE_SIZE - WAVE_STORE_IMPORT_TABLE - WAVEPACK_ALIGN - 12) ///< Muestras importables, dejando lugar al paso de la secuencia
+
+void wave_store_init(void);
+
+bool wave_store_select(int32_t sequence);
+
+bool wave_store_render(uint8_t *block, size_t n);
+
+void wave_store_set_quality(polyphase_quality_t q);
+
+void wave_store_print(void);
+
+bool wave_store_playing(uint32_t *since_us);
+
+void wave_store_import_begin(void);
+
+bool wave_store_import_put(const uint8_t *codes, size_t count);
+
+uint8_t *wave_store_import_window(size_t *len);
+
+void wave_store_import_commit(size_t count);
+
+bool wave_store_import_end(uint32_t sample_rate, uint32_t phase_inc);
+
+void wave_store_import_abort(void);
+
+#endif